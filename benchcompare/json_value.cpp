@@ -0,0 +1,297 @@
+#include "json_value.h"
+#include <cstdlib>
+#include <sstream>
+
+// Recursive descent over the whole document, positions are byte offsets for error messages
+class JsonParser
+{
+public:
+    explicit JsonParser(std::string_view Text) noexcept : Text(Text) {}
+
+    JsonValue ParseDocument()
+    {
+        JsonValue Value = ParseValue();
+        SkipWhitespace();
+        if (Position != Text.size())
+        {
+            throw JSON_EXCEPT("Trailing characters after the document", Position);
+        }
+        return Value;
+    }
+private:
+    JsonValue ParseValue()
+    {
+        SkipWhitespace();
+        if (Position == Text.size())
+        {
+            throw JSON_EXCEPT("Unexpected end of document", Position);
+        }
+
+        JsonValue Value;
+        switch (Text[Position])
+        {
+            case '{':
+            {
+                Value.Kind = JsonValue::Type::Object;
+                Position++;
+                if (!Consume('}'))
+                {
+                    do
+                    {
+                        SkipWhitespace();
+                        std::string Key = ParseString();
+                        Expect(':');
+                        Value.Object.emplace_back(std::move(Key), ParseValue());
+                    } while (Consume(','));
+                    Expect('}');
+                }
+            } break;
+
+            case '[':
+            {
+                Value.Kind = JsonValue::Type::Array;
+                Position++;
+                if (!Consume(']'))
+                {
+                    do
+                    {
+                        Value.Array.push_back(ParseValue());
+                    } while (Consume(','));
+                    Expect(']');
+                }
+            } break;
+
+            case '"':
+            {
+                Value.Kind = JsonValue::Type::String;
+                Value.String = ParseString();
+            } break;
+
+            case 't':
+            case 'f':
+            {
+                Value.Kind = JsonValue::Type::Bool;
+                Value.Bool = Text[Position] == 't';
+                ExpectWord(Value.Bool ? "true" : "false");
+            } break;
+
+            case 'n':
+            {
+                ExpectWord("null");
+            } break;
+
+            default:
+            {
+                Value.Kind = JsonValue::Type::Number;
+                Value.Number = ParseNumber();
+            } break;
+        }
+        return Value;
+    }
+
+    std::string ParseString()
+    {
+        if (Position == Text.size() || Text[Position] != '"')
+        {
+            throw JSON_EXCEPT("Expected a string", Position);
+        }
+        Position++;
+
+        std::string Result;
+        while (Position < Text.size() && Text[Position] != '"')
+        {
+            char c = Text[Position++];
+            if (c == '\\')
+            {
+                if (Position == Text.size())
+                {
+                    break;
+                }
+                switch (c = Text[Position++])
+                {
+                    case 'b': c = '\b'; break;
+                    case 'f': c = '\f'; break;
+                    case 'n': c = '\n'; break;
+                    case 'r': c = '\r'; break;
+                    case 't': c = '\t'; break;
+                    case 'u':
+                    {
+                        // Reports only contain ASCII, anything else becomes '?'
+                        if (Text.size() - Position < 4u)
+                        {
+                            throw JSON_EXCEPT("Truncated unicode escape", Position);
+                        }
+                        const unsigned long Code = std::strtoul(std::string(Text.substr(Position, 4u)).c_str(), nullptr, 16);
+                        Position += 4u;
+                        c = Code < 0x80u ? static_cast<char>(Code) : '?';
+                    } break;
+                    default: break;
+                }
+            }
+            Result.push_back(c);
+        }
+        if (Position == Text.size())
+        {
+            throw JSON_EXCEPT("Unterminated string", Position);
+        }
+        Position++;
+        return Result;
+    }
+
+    double ParseNumber()
+    {
+        const size_t Begin = Position;
+        while (Position < Text.size() && std::string_view("+-0123456789.eE").find(Text[Position]) != std::string_view::npos)
+        {
+            Position++;
+        }
+        const std::string Number(Text.substr(Begin, Position - Begin));
+        char* End = nullptr;
+        const double Value = std::strtod(Number.c_str(), &End);
+        if (Number.empty() || End != Number.c_str() + Number.size())
+        {
+            throw JSON_EXCEPT("Invalid value", Begin);
+        }
+        return Value;
+    }
+
+    void SkipWhitespace() noexcept
+    {
+        while (Position < Text.size() && (Text[Position] == ' ' || Text[Position] == '\t' || Text[Position] == '\n' || Text[Position] == '\r'))
+        {
+            Position++;
+        }
+    }
+
+    bool Consume(char c) noexcept
+    {
+        SkipWhitespace();
+        if (Position < Text.size() && Text[Position] == c)
+        {
+            Position++;
+            return true;
+        }
+        return false;
+    }
+
+    void Expect(char c)
+    {
+        if (!Consume(c))
+        {
+            throw JSON_EXCEPT(std::string("Expected '") + c + "'", Position);
+        }
+    }
+
+    void ExpectWord(std::string_view Word)
+    {
+        if (Text.substr(Position, Word.size()) != Word)
+        {
+            throw JSON_EXCEPT("Invalid value", Position);
+        }
+        Position += Word.size();
+    }
+private:
+    std::string_view Text;
+    size_t Position = 0u;
+};
+
+JsonValue JsonValue::Parse(std::string_view Text)
+{
+    return JsonParser(Text).ParseDocument();
+}
+
+JsonValue::Type JsonValue::GetType() const noexcept
+{
+    return Kind;
+}
+
+bool JsonValue::IsNull() const noexcept
+{
+    return Kind == Type::Null;
+}
+
+bool JsonValue::AsBool() const
+{
+    if (Kind != Type::Bool)
+    {
+        throw JSON_EXCEPT("Value is not a boolean", 0u);
+    }
+    return Bool;
+}
+
+double JsonValue::AsNumber() const
+{
+    if (Kind != Type::Number)
+    {
+        throw JSON_EXCEPT("Value is not a number", 0u);
+    }
+    return Number;
+}
+
+const std::string& JsonValue::AsString() const
+{
+    if (Kind != Type::String)
+    {
+        throw JSON_EXCEPT("Value is not a string", 0u);
+    }
+    return String;
+}
+
+const std::vector<JsonValue>& JsonValue::AsArray() const
+{
+    if (Kind != Type::Array)
+    {
+        throw JSON_EXCEPT("Value is not an array", 0u);
+    }
+    return Array;
+}
+
+const std::vector<JsonValue::Member>& JsonValue::AsObject() const
+{
+    if (Kind != Type::Object)
+    {
+        throw JSON_EXCEPT("Value is not an object", 0u);
+    }
+    return Object;
+}
+
+const JsonValue* JsonValue::Find(std::string_view Key) const noexcept
+{
+    for (const auto& [Name, Value] : Object)
+    {
+        if (Name == Key)
+        {
+            return &Value;
+        }
+    }
+    return nullptr;
+}
+
+const JsonValue& JsonValue::operator[](std::string_view Key) const
+{
+    if (const JsonValue* Value = Find(Key))
+    {
+        return *Value;
+    }
+    throw JSON_EXCEPT("Missing member \"" + std::string(Key) + "\"", 0u);
+}
+
+// JSON exceptions
+JsonValue::Exception::Exception(int Line, const char* File, std::string Reason, size_t Offset) noexcept
+    : MyException(Line, File), Reason(std::move(Reason)), Offset(Offset) {}
+
+const char* JsonValue::Exception::what() const noexcept
+{
+    std::ostringstream oss;
+    oss << GetType() << std::endl
+        << "[Reason] " << Reason << std::endl
+        << "[Offset] " << Offset << std::endl
+        << GetOriginString();
+    whatBuffer = oss.str();
+    return whatBuffer.c_str();
+}
+
+const char* JsonValue::Exception::GetType() const noexcept
+{
+    return "JSON Exception";
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+#include "exceptions.h"
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Parsed JSON document. Just enough for reading benchmark reports: objects keep their
+// member order, numbers are doubles.
+class JsonValue
+{
+public:
+    class Exception : public MyException
+    {
+    public:
+        Exception(int Line, const char* File, std::string Reason, size_t Offset) noexcept;
+        const char* what() const noexcept override;
+        const char* GetType() const noexcept override;
+    private:
+        std::string Reason;
+        size_t Offset;
+    };
+    enum class Type
+    {
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object
+    };
+    using Member = std::pair<std::string, JsonValue>;
+public:
+    static JsonValue Parse(std::string_view Text);
+
+    Type GetType() const noexcept;
+    bool IsNull() const noexcept;
+    // The accessors throw when the value has another type
+    bool AsBool() const;
+    double AsNumber() const;
+    const std::string& AsString() const;
+    const std::vector<JsonValue>& AsArray() const;
+    const std::vector<Member>& AsObject() const;
+    // Null when the member is missing or this is not an object
+    const JsonValue* Find(std::string_view Key) const noexcept;
+    // Throws when the member is missing
+    const JsonValue& operator[](std::string_view Key) const;
+private:
+    friend class JsonParser;
+    Type Kind = Type::Null;
+    bool Bool = false;
+    double Number = 0.0;
+    std::string String;
+    std::vector<JsonValue> Array;
+    std::vector<Member> Object;
+};
+
+#define JSON_EXCEPT(Reason, Offset) JsonValue::Exception(__LINE__, __FILE__, (Reason), (Offset))
\ No newline at end of file
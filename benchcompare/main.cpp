@@ -0,0 +1,134 @@
+#include "regression_gate.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+// Exit codes, so a build script can tell a regression from a broken invocation
+namespace
+{
+    constexpr int NoRegressions = 0;
+    constexpr int Regressions = 1;
+    constexpr int Failure = 2;
+
+    JsonValue LoadReport(const std::filesystem::path& Path)
+    {
+        std::ifstream File(Path, std::ios::binary);
+        if (!File)
+        {
+            throw std::runtime_error("Failed to open " + Path.string());
+        }
+        std::ostringstream Text;
+        Text << File.rdbuf();
+        return JsonValue::Parse(Text.str());
+    }
+
+    // "metric=percent"
+    void ParseThreshold(const std::string& Arg, RegressionGate::Settings& Config)
+    {
+        const size_t Split = Arg.find('=');
+        if (Split == std::string::npos)
+        {
+            throw std::invalid_argument("Expected -threshold <metric>=<percent>");
+        }
+        const std::string Metric = Arg.substr(0u, Split);
+        const double Percent = std::stod(Arg.substr(Split + 1u));
+        if (Metric == "default")
+        {
+            Config.DefaultThreshold = Percent;
+        }
+        else
+        {
+            Config.Thresholds[Metric] = Percent;
+        }
+    }
+
+    void PrintUsage()
+    {
+        std::cerr << "usage: benchcompare [options] <baseline> <current>" << std::endl
+            << "  <baseline> and <current> are benchmark reports, or directories whose" << std::endl
+            << "  reports are paired by file name" << std::endl
+            << "  -alpha <p>                    significance level of the frame time tests (0.01)" << std::endl
+            << "  -threshold <metric>=<percent> allowed change of one metric, 'default' for the rest" << std::endl
+            << "                                (frame_time=3, frame_time_p99=10, default=1)" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        RegressionGate::Settings Config;
+        std::vector<std::filesystem::path> Paths;
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string Arg = argv[i];
+            if (Arg == "-alpha" && i + 1 < argc)
+            {
+                Config.Alpha = std::stod(argv[++i]);
+            }
+            else if (Arg == "-threshold" && i + 1 < argc)
+            {
+                ParseThreshold(argv[++i], Config);
+            }
+            else if (!Arg.empty() && Arg[0] != '-')
+            {
+                Paths.emplace_back(Arg);
+            }
+            else
+            {
+                PrintUsage();
+                return Failure;
+            }
+        }
+        if (Paths.size() != 2u)
+        {
+            PrintUsage();
+            return Failure;
+        }
+
+        RegressionGate Gate(Config);
+        const std::filesystem::path& Baseline = Paths[0];
+        const std::filesystem::path& Current = Paths[1];
+        if (std::filesystem::is_directory(Baseline))
+        {
+            for (const auto& Entry : std::filesystem::directory_iterator(Baseline))
+            {
+                if (Entry.path().extension() != ".json")
+                {
+                    continue;
+                }
+                const std::filesystem::path Match = Current / Entry.path().filename();
+                if (!std::filesystem::exists(Match))
+                {
+                    std::cerr << "No current report for " << Entry.path().string() << std::endl;
+                    return Regressions;
+                }
+                Gate.Compare(LoadReport(Entry.path()), LoadReport(Match));
+            }
+        }
+        else
+        {
+            Gate.Compare(LoadReport(Baseline), LoadReport(Current));
+        }
+
+        Gate.WriteReport(std::cout);
+        return Gate.HasRegressions() ? Regressions : NoRegressions;
+    }
+    catch (const MyException& e)
+    {
+        std::cerr << e.GetType() << std::endl << e.what() << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Standard Exception" << std::endl << e.what() << std::endl;
+    }
+    catch (...)
+    {
+        std::cerr << "Unknown Exception" << std::endl << "No details available" << std::endl;
+    }
+
+    return Failure;
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#include "mann_whitney.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+MannWhitneyResult MannWhitneyU(const std::vector<double>& First, const std::vector<double>& Second)
+{
+    MannWhitneyResult Result;
+    const double n1 = static_cast<double>(First.size());
+    const double n2 = static_cast<double>(Second.size());
+    if (First.empty() || Second.empty())
+    {
+        return Result;
+    }
+
+    // Pool both samples, remembering which side each value came from
+    std::vector<std::pair<double, bool>> Pooled;
+    Pooled.reserve(First.size() + Second.size());
+    for (const double v : First)
+    {
+        Pooled.emplace_back(v, false);
+    }
+    for (const double v : Second)
+    {
+        Pooled.emplace_back(v, true);
+    }
+    std::sort(Pooled.begin(), Pooled.end());
+
+    // Tied values share their average rank, the tie term shrinks the variance
+    double SecondRanks = 0.0;
+    double TieTerm = 0.0;
+    for (size_t i = 0; i < Pooled.size();)
+    {
+        size_t j = i + 1u;
+        while (j < Pooled.size() && Pooled[j].first == Pooled[i].first)
+        {
+            j++;
+        }
+        const double Rank = (static_cast<double>(i + 1u) + static_cast<double>(j)) * 0.5;
+        for (size_t k = i; k < j; k++)
+        {
+            SecondRanks += Pooled[k].second ? Rank : 0.0;
+        }
+        const double t = static_cast<double>(j - i);
+        TieTerm += t * t * t - t;
+        i = j;
+    }
+
+    const double N = n1 + n2;
+    Result.U = SecondRanks - n2 * (n2 + 1.0) * 0.5;
+    Result.Effect = Result.U / (n1 * n2);
+
+    const double Mean = n1 * n2 * 0.5;
+    const double Variance = n1 * n2 / 12.0 * ((N + 1.0) - TieTerm / (N * (N - 1.0)));
+    if (Variance <= 0.0)
+    {
+        // Every value is identical, nothing to tell apart
+        return Result;
+    }
+    const double Deviation = std::sqrt(Variance);
+    Result.Z = (Result.U - Mean) / Deviation;
+    // Upper tail of the standard normal, each side with its own continuity correction
+    Result.PGreater = 0.5 * std::erfc((Result.U - Mean - 0.5) / Deviation / std::sqrt(2.0));
+    Result.PLess = 0.5 * std::erfc((Mean - Result.U - 0.5) / Deviation / std::sqrt(2.0));
+    Result.PGreater = std::min(Result.PGreater, 1.0);
+    Result.PLess = std::min(Result.PLess, 1.0);
+    return Result;
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+#include <vector>
+
+// Mann-Whitney U test of two independent samples. Frame times are skewed and heavy
+// tailed, ranks make no assumption about their distribution.
+struct MannWhitneyResult
+{
+    double U = 0.0;             // U statistic of the second sample
+    double Z = 0.0;             // Normal approximation, positive when the second sample is larger
+    double PGreater = 1.0;      // One sided p-value for "second sample is stochastically larger"
+    double PLess = 1.0;         // One sided p-value for "second sample is stochastically smaller"
+    // Probability that a random value of the second sample exceeds one of the first, 0.5 is no effect
+    double Effect = 0.5;
+};
+
+// The normal approximation with tie and continuity correction, accurate from roughly
+// twenty samples per side which every benchmark run exceeds
+MannWhitneyResult MannWhitneyU(const std::vector<double>& First, const std::vector<double>& Second);
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include "quantile_test.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    double LogChoose(double n, double k) noexcept
+    {
+        return std::lgamma(n + 1.0) - std::lgamma(k + 1.0) - std::lgamma(n - k + 1.0);
+    }
+}
+
+QuantileTestResult QuantileTest(const std::vector<double>& First, const std::vector<double>& Second, double Quantile)
+{
+    QuantileTestResult Result;
+    if (First.empty() || Second.empty())
+    {
+        return Result;
+    }
+
+    std::vector<double> Pooled(First);
+    Pooled.insert(Pooled.end(), Second.begin(), Second.end());
+    const size_t N = Pooled.size();
+    const size_t Rank = std::min(static_cast<size_t>(std::ceil(Quantile * static_cast<double>(N))), N);
+    std::nth_element(Pooled.begin(), Pooled.begin() + (Rank > 0u ? Rank - 1u : 0u), Pooled.end());
+    Result.Cut = Pooled[Rank > 0u ? Rank - 1u : 0u];
+
+    // Values tied with the cut count as below it, on both sides alike
+    const auto Above = [&Result](double v) { return v > Result.Cut; };
+    Result.FirstAbove = static_cast<size_t>(std::count_if(First.begin(), First.end(), Above));
+    Result.SecondAbove = static_cast<size_t>(std::count_if(Second.begin(), Second.end(), Above));
+    const size_t Total = Result.FirstAbove + Result.SecondAbove;
+    if (Total == 0u)
+    {
+        return Result;
+    }
+
+    // Without a difference the values above the cut are a random draw from the pooled
+    // samples, so the second sample's share of them is hypergeometric
+    const double n1 = static_cast<double>(First.size());
+    const double n2 = static_cast<double>(Second.size());
+    const double K = static_cast<double>(Total);
+    const double LogAll = LogChoose(n1 + n2, K);
+    const size_t Lowest = Total > First.size() ? Total - First.size() : 0u;
+    const size_t Highest = std::min(Total, Second.size());
+    double PGreater = 0.0;
+    double PLess = 0.0;
+    for (size_t x = Lowest; x <= Highest; x++)
+    {
+        const double k = static_cast<double>(x);
+        const double p = std::exp(LogChoose(n2, k) + LogChoose(n1, K - k) - LogAll);
+        PGreater += x >= Result.SecondAbove ? p : 0.0;
+        PLess += x <= Result.SecondAbove ? p : 0.0;
+    }
+    Result.PGreater = std::min(PGreater, 1.0);
+    Result.PLess = std::min(PLess, 1.0);
+    return Result;
+}
\ No newline at end of file
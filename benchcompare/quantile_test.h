@@ -0,0 +1,20 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// Test of the upper tails of two independent samples. Both are split at a quantile of the
+// pooled values and Fisher's exact test compares how many of each side lie above it. Like
+// the Mann-Whitney test it assumes nothing about the distribution, but it only looks at
+// the tail, so hitches are found even when the median does not move.
+struct QuantileTestResult
+{
+    double Cut = 0.0;           // Pooled quantile the samples are split at
+    size_t FirstAbove = 0u;
+    size_t SecondAbove = 0u;
+    double PGreater = 1.0;      // One sided p-value for "second sample lies above the cut more often"
+    double PLess = 1.0;         // One sided p-value for "second sample lies above the cut less often"
+};
+
+// Quantile is in (0, 1), e.g. 0.99 for the p99 tail. The p-values are exact. With 500
+// values per side the p99 cut leaves about ten above it, which bounds them at about 0.001.
+QuantileTestResult QuantileTest(const std::vector<double>& First, const std::vector<double>& Second, double Quantile);
\ No newline at end of file
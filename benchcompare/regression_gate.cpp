@@ -0,0 +1,319 @@
+#include "regression_gate.h"
+#include "benchmark.h"
+#include "mann_whitney.h"
+#include "quantile_test.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    double RelativeChange(double Baseline, double Current) noexcept
+    {
+        if (Baseline == 0.0)
+        {
+            return Current == 0.0 ? 0.0 : std::numeric_limits<double>::infinity();
+        }
+        return (Current - Baseline) / Baseline * 100.0;
+    }
+
+    std::vector<double> ReadSamples(const JsonValue& Run)
+    {
+        std::vector<double> Samples;
+        for (const JsonValue& Sample : Run["samples"]["frame_time_ms"].AsArray())
+        {
+            Samples.push_back(Sample.AsNumber());
+        }
+        return Samples;
+    }
+
+    std::string Describe(const JsonValue& Value)
+    {
+        switch (Value.GetType())
+        {
+            case JsonValue::Type::String: return Value.AsString();
+            case JsonValue::Type::Number:
+            {
+                std::ostringstream oss;
+                oss << Value.AsNumber();
+                return oss.str();
+            }
+            default: return "?";
+        }
+    }
+}
+
+RegressionGate::RegressionGate(Settings Config) : Config(std::move(Config)) {}
+
+void RegressionGate::CheckVersion(const JsonValue& Report)
+{
+    // Versions since MinVersion only added fields the gate does not read, so any two compare
+    const JsonValue* Version = Report.Find("version");
+    const double Number = Version != nullptr && Version->GetType() == JsonValue::Type::Number ? Version->AsNumber() : 0.0;
+    if (!(Number >= MinVersion && Number <= BenchmarkReport::Version) || Number != std::floor(Number))
+    {
+        throw std::runtime_error("Unsupported benchmark report version " + (Version != nullptr ? Describe(*Version) : std::string("(missing)")) +
+            ", benchcompare reads versions " + std::to_string(MinVersion) + " to " + std::to_string(BenchmarkReport::Version));
+    }
+}
+
+void RegressionGate::Compare(const JsonValue& Baseline, const JsonValue& Current)
+{
+    CheckVersion(Baseline);
+    CheckVersion(Current);
+    CompareSettings(Baseline["settings"], Current["settings"]);
+
+    const std::vector<JsonValue>& CurrentRuns = Current["runs"].AsArray();
+    for (const JsonValue& Run : Baseline["runs"].AsArray())
+    {
+        const std::string& Scene = Run["scene"].AsString();
+        const auto Match = std::find_if(CurrentRuns.begin(), CurrentRuns.end(),
+            [&Scene](const JsonValue& Candidate) { return Candidate["scene"].AsString() == Scene; });
+        if (Match == CurrentRuns.end())
+        {
+            Finding Missing;
+            Missing.Scene = Scene;
+            Missing.Metric = "run";
+            Missing.Result = Verdict::Missing;
+            Findings.push_back(std::move(Missing));
+            continue;
+        }
+        CompareRun(Scene, Run, *Match);
+    }
+
+    for (const JsonValue& Run : CurrentRuns)
+    {
+        const std::string& Scene = Run["scene"].AsString();
+        const std::vector<JsonValue>& BaselineRuns = Baseline["runs"].AsArray();
+        if (std::none_of(BaselineRuns.begin(), BaselineRuns.end(),
+            [&Scene](const JsonValue& Candidate) { return Candidate["scene"].AsString() == Scene; }))
+        {
+            Warnings.push_back("Scene \"" + Scene + "\" has no baseline");
+        }
+    }
+}
+
+void RegressionGate::CompareRun(const std::string& Scene, const JsonValue& Baseline, const JsonValue& Current)
+{
+    CompareFrameTimes(Scene, Baseline, Current);
+
+    const JsonValue& BaselineAllocations = Baseline["allocations"];
+    const JsonValue& CurrentAllocations = Current["allocations"];
+    if (BaselineAllocations["tracking"].AsBool() && CurrentAllocations["tracking"].AsBool())
+    {
+        CompareValue(Scene, "allocations.count", BaselineAllocations["per_frame"]["count"].AsNumber(), CurrentAllocations["per_frame"]["count"].AsNumber());
+        CompareValue(Scene, "allocations.bytes", BaselineAllocations["per_frame"]["bytes"].AsNumber(), CurrentAllocations["per_frame"]["bytes"].AsNumber());
+    }
+    else
+    {
+        Warnings.push_back("Scene \"" + Scene + "\" was run without allocation tracking, allocations are not compared");
+    }
+
+    const JsonValue& CurrentCounters = Current["counters"];
+    for (const auto& [Name, Counter] : Baseline["counters"].AsObject())
+    {
+        const JsonValue* Match = CurrentCounters.Find(Name);
+        if (Match == nullptr)
+        {
+            Warnings.push_back("Scene \"" + Scene + "\" no longer reports counter \"" + Name + "\"");
+            continue;
+        }
+        CompareValue(Scene, Name, Counter["per_frame"].AsNumber(), (*Match)["per_frame"].AsNumber());
+    }
+}
+
+void RegressionGate::CompareFrameTimes(const std::string& Scene, const JsonValue& Baseline, const JsonValue& Current)
+{
+    const std::vector<double> BaselineSamples = ReadSamples(Baseline);
+    const std::vector<double> CurrentSamples = ReadSamples(Current);
+    const BenchmarkRun::Distribution Before = BenchmarkRun::Summarize(BaselineSamples);
+    const BenchmarkRun::Distribution After = BenchmarkRun::Summarize(CurrentSamples);
+    const MannWhitneyResult Test = MannWhitneyU(BaselineSamples, CurrentSamples);
+
+    // The median moves with the bulk of the distribution, the mean would follow a few hitches
+    Finding Median;
+    Median.Scene = Scene;
+    Median.Metric = "frame_time";
+    Median.Baseline = Before.P50;
+    Median.Current = After.P50;
+    Median.ChangePercent = RelativeChange(Before.P50, After.P50);
+    const double Threshold = GetThreshold(Median.Metric);
+    if (Median.ChangePercent > Threshold)
+    {
+        Median.PValue = Test.PGreater;
+        Median.Result = Test.PGreater < Config.Alpha ? Verdict::Regressed : Verdict::Unchanged;
+    }
+    else if (Median.ChangePercent < -Threshold)
+    {
+        Median.PValue = Test.PLess;
+        Median.Result = Test.PLess < Config.Alpha ? Verdict::Improved : Verdict::Unchanged;
+    }
+    else
+    {
+        Median.PValue = std::min(Test.PGreater, Test.PLess);
+    }
+    Findings.push_back(std::move(Median));
+
+    // Hitches show up in the tail long before they move the median. The p99 of a few
+    // hundred frames rests on a handful of them and easily moves by the threshold on its
+    // own, so the tail needs a significant shift across the pooled p99 as well.
+    const QuantileTestResult TailTest = QuantileTest(BaselineSamples, CurrentSamples, 0.99);
+    Finding Tail;
+    Tail.Scene = Scene;
+    Tail.Metric = "frame_time_p99";
+    Tail.Baseline = Before.P99;
+    Tail.Current = After.P99;
+    Tail.ChangePercent = RelativeChange(Before.P99, After.P99);
+    const double TailThreshold = GetThreshold(Tail.Metric);
+    if (Tail.ChangePercent > TailThreshold)
+    {
+        Tail.PValue = TailTest.PGreater;
+        Tail.Result = TailTest.PGreater < Config.Alpha ? Verdict::Regressed : Verdict::Unchanged;
+    }
+    else if (Tail.ChangePercent < -TailThreshold)
+    {
+        Tail.PValue = TailTest.PLess;
+        Tail.Result = TailTest.PLess < Config.Alpha ? Verdict::Improved : Verdict::Unchanged;
+    }
+    else
+    {
+        Tail.PValue = std::min(TailTest.PGreater, TailTest.PLess);
+    }
+    Findings.push_back(std::move(Tail));
+}
+
+void RegressionGate::CompareValue(const std::string& Scene, const std::string& Metric, double Baseline, double Current)
+{
+    Finding Value;
+    Value.Scene = Scene;
+    Value.Metric = Metric;
+    Value.Baseline = Baseline;
+    Value.Current = Current;
+    Value.ChangePercent = RelativeChange(Baseline, Current);
+
+    const double Threshold = GetThreshold(Metric);
+    if (std::abs(Value.ChangePercent) > Threshold)
+    {
+        // Scene counters describe the workload itself, a change means the runs measure different things
+        if (Metric.rfind("scene.", 0u) == 0u)
+        {
+            Value.Result = Verdict::Changed;
+            Warnings.push_back("Scene \"" + Scene + "\" workload changed (" + Metric + "), timings are not comparable");
+        }
+        else
+        {
+            Value.Result = Value.ChangePercent > 0.0 ? Verdict::Regressed : Verdict::Improved;
+        }
+    }
+    Findings.push_back(std::move(Value));
+}
+
+void RegressionGate::CompareSettings(const JsonValue& Baseline, const JsonValue& Current)
+{
+    for (const auto& [Name, Value] : Baseline.AsObject())
+    {
+        // Warm-up only decides which frames are measured
+        if (Name == "warmup_frames")
+        {
+            continue;
+        }
+        const JsonValue* Match = Current.Find(Name);
+        const std::string Before = Describe(Value);
+        const std::string After = Match != nullptr ? Describe(*Match) : "missing";
+        if (Before != After)
+        {
+            Warnings.push_back("Setting \"" + Name + "\" differs: " + Before + " in the baseline, " + After + " now");
+        }
+    }
+}
+
+double RegressionGate::GetThreshold(const std::string& Metric) const noexcept
+{
+    const auto Found = Config.Thresholds.find(Metric);
+    return Found != Config.Thresholds.end() ? Found->second : Config.DefaultThreshold;
+}
+
+const std::vector<RegressionGate::Finding>& RegressionGate::GetFindings() const noexcept
+{
+    return Findings;
+}
+
+const std::vector<std::string>& RegressionGate::GetWarnings() const noexcept
+{
+    return Warnings;
+}
+
+bool RegressionGate::HasRegressions() const noexcept
+{
+    return std::any_of(Findings.begin(), Findings.end(),
+        [](const Finding& f) { return f.Result == Verdict::Regressed || f.Result == Verdict::Missing; });
+}
+
+void RegressionGate::WriteReport(std::ostream& Out) const
+{
+    const std::string* Scene = nullptr;
+    for (const Finding& f : Findings)
+    {
+        if (Scene == nullptr || *Scene != f.Scene)
+        {
+            Scene = &f.Scene;
+            Out << std::endl << "Scene " << f.Scene << std::endl;
+            Out << "  " << std::left << std::setw(28) << "metric" << std::right
+                << std::setw(16) << "baseline" << std::setw(16) << "current"
+                << std::setw(11) << "change" << std::setw(11) << "p-value" << "  verdict" << std::endl;
+        }
+        if (f.Result == Verdict::Missing)
+        {
+            Out << "  " << std::left << std::setw(28) << f.Metric << std::right << std::setw(65) << "" << "  " << GetVerdictName(f.Result) << std::endl;
+            continue;
+        }
+
+        std::ostringstream Change;
+        Change << std::showpos << std::fixed << std::setprecision(2) << f.ChangePercent << "%";
+        std::ostringstream PValue;
+        if (f.PValue >= 0.0)
+        {
+            PValue << std::setprecision(3) << f.PValue;
+        }
+        else
+        {
+            PValue << "-";
+        }
+        Out << "  " << std::left << std::setw(28) << f.Metric << std::right << std::setprecision(6)
+            << std::setw(16) << f.Baseline << std::setw(16) << f.Current
+            << std::setw(11) << (std::isinf(f.ChangePercent) ? std::string("new") : Change.str())
+            << std::setw(11) << PValue.str() << "  " << GetVerdictName(f.Result) << std::endl;
+    }
+
+    if (!Warnings.empty())
+    {
+        Out << std::endl;
+        for (const std::string& Warning : Warnings)
+        {
+            Out << "warning: " << Warning << std::endl;
+        }
+    }
+
+    const size_t Regressions = std::count_if(Findings.begin(), Findings.end(),
+        [](const Finding& f) { return f.Result == Verdict::Regressed || f.Result == Verdict::Missing; });
+    const size_t Improvements = std::count_if(Findings.begin(), Findings.end(),
+        [](const Finding& f) { return f.Result == Verdict::Improved; });
+    Out << std::endl << Regressions << " regression(s), " << Improvements << " improvement(s)" << std::endl;
+}
+
+const char* RegressionGate::GetVerdictName(Verdict Result) noexcept
+{
+    switch (Result)
+    {
+        case Verdict::Unchanged: return "ok";
+        case Verdict::Improved: return "improved";
+        case Verdict::Regressed: return "REGRESSED";
+        case Verdict::Changed: return "changed";
+        case Verdict::Missing: return "MISSING";
+        default: return "unknown";
+    }
+}
\ No newline at end of file
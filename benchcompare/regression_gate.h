@@ -0,0 +1,71 @@
+#pragma once
+#include "json_value.h"
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Compares benchmark reports against a stored baseline. Frame times are judged on
+// their whole distribution: a Mann-Whitney test decides whether the shift is real and a
+// per-metric threshold whether it is large enough to matter. The p99 gets the same
+// treatment with a test of the values above the pooled p99. Allocation and counter
+// averages are deterministic for the benchmark scenes and only use the threshold.
+class RegressionGate
+{
+public:
+    enum class Verdict
+    {
+        Unchanged,
+        Improved,
+        Regressed,
+        Changed,        // Scene workload counters, neither better nor worse but the runs are not comparable
+        Missing         // Scene in the baseline without a current run
+    };
+    struct Settings
+    {
+        // Significance level of the frame time tests
+        double Alpha = 0.01;
+        // Relative change in percent a metric may move before it counts, by metric name.
+        // Metrics without an entry use DefaultThreshold.
+        std::map<std::string, double> Thresholds = { {"frame_time", 3.0}, {"frame_time_p99", 10.0} };
+        double DefaultThreshold = 1.0;
+    };
+    struct Finding
+    {
+        std::string Scene;
+        std::string Metric;
+        double Baseline = 0.0;
+        double Current = 0.0;
+        double ChangePercent = 0.0;
+        double PValue = -1.0;       // Negative when the metric is not tested
+        Verdict Result = Verdict::Unchanged;
+    };
+
+    // Oldest report layout the gate reads, newer ones up to BenchmarkReport::Version
+    static constexpr unsigned int MinVersion = 1u;
+public:
+    explicit RegressionGate(Settings Config);
+
+    // May be called once per report pair, findings accumulate. Throws std::runtime_error
+    // for report versions outside [MinVersion, BenchmarkReport::Version].
+    void Compare(const JsonValue& Baseline, const JsonValue& Current);
+
+    const std::vector<Finding>& GetFindings() const noexcept;
+    const std::vector<std::string>& GetWarnings() const noexcept;
+    bool HasRegressions() const noexcept;
+    void WriteReport(std::ostream& Out) const;
+
+    static const char* GetVerdictName(Verdict Result) noexcept;
+private:
+    static void CheckVersion(const JsonValue& Report);
+    void CompareRun(const std::string& Scene, const JsonValue& Baseline, const JsonValue& Current);
+    void CompareFrameTimes(const std::string& Scene, const JsonValue& Baseline, const JsonValue& Current);
+    // Lower is better for every averaged metric
+    void CompareValue(const std::string& Scene, const std::string& Metric, double Baseline, double Current);
+    void CompareSettings(const JsonValue& Baseline, const JsonValue& Current);
+    double GetThreshold(const std::string& Metric) const noexcept;
+private:
+    Settings Config;
+    std::vector<Finding> Findings;
+    std::vector<std::string> Warnings;
+};
\ No newline at end of file
@@ -0,0 +1,298 @@
+#include "alloc_tracker.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+
+namespace
+{
+    constexpr size_t TagCount = static_cast<size_t>(AllocTag::Count);
+
+    struct TagCounters
+    {
+        std::atomic<size_t> Count{0u};
+        std::atomic<size_t> Bytes{0u};
+        std::atomic<size_t> Frees{0u};
+        std::atomic<bool> Strict{false};
+        // Allocations inside this tag's strict scope, whichever tag they were counted for
+        std::atomic<size_t> Violations{0u};
+        std::atomic<size_t> ViolationBytes{0u};
+    };
+
+    // Plain arrays of atomics so that nothing here needs dynamic initialization
+    TagCounters Counters[TagCount];
+    thread_local AllocTag CurrentTag = AllocTag::Untagged;
+    // Outermost strict scope open on this thread, Count when there is none
+    thread_local AllocTag StrictTag = AllocTag::Count;
+}
+
+AllocTracker::FrameStats AllocTracker::EndFrame()
+{
+    FrameStats Frame;
+    for (size_t i = 0; i < TagCount; i++)
+    {
+        auto& s = Frame.Tags[i];
+        s.Count = Counters[i].Count.exchange(0u, std::memory_order_relaxed);
+        s.Bytes = Counters[i].Bytes.exchange(0u, std::memory_order_relaxed);
+        s.Frees = Counters[i].Frees.exchange(0u, std::memory_order_relaxed);
+        Frame.Total.Count += s.Count;
+        Frame.Total.Bytes += s.Bytes;
+        Frame.Total.Frees += s.Frees;
+    }
+
+    // Every tag starts the next frame clean, the first violation is reported
+    size_t Violating = TagCount;
+    Stats Violations;
+    for (size_t i = 0; i < TagCount; i++)
+    {
+        const size_t Count = Counters[i].Violations.exchange(0u, std::memory_order_relaxed);
+        const size_t Bytes = Counters[i].ViolationBytes.exchange(0u, std::memory_order_relaxed);
+        if (Count > 0u && Violating == TagCount)
+        {
+            Violating = i;
+            Violations.Count = Count;
+            Violations.Bytes = Bytes;
+        }
+    }
+    if (Violating != TagCount)
+    {
+        throw ALLOC_EXCEPT(static_cast<AllocTag>(Violating), Violations.Count, Violations.Bytes);
+    }
+    return Frame;
+}
+
+void AllocTracker::SetStrict(AllocTag Tag, bool Strict) noexcept
+{
+    Counters[static_cast<size_t>(Tag)].Strict.store(Strict, std::memory_order_relaxed);
+}
+
+bool AllocTracker::IsStrict(AllocTag Tag) noexcept
+{
+    return Counters[static_cast<size_t>(Tag)].Strict.load(std::memory_order_relaxed);
+}
+
+const char* AllocTracker::GetTagName(AllocTag Tag) noexcept
+{
+    switch (Tag)
+    {
+        case AllocTag::Untagged: return "Untagged";
+        case AllocTag::Frame: return "Frame";
+        case AllocTag::Graphics: return "Graphics";
+        case AllocTag::Window: return "Window";
+        case AllocTag::Exception: return "Exception";
+        default: return "Unknown";
+    }
+}
+
+AllocTag AllocTracker::RecordAlloc(size_t Bytes) noexcept
+{
+    auto& c = Counters[static_cast<size_t>(CurrentTag)];
+    c.Count.fetch_add(1u, std::memory_order_relaxed);
+    c.Bytes.fetch_add(Bytes, std::memory_order_relaxed);
+    if (StrictTag != AllocTag::Count)
+    {
+        auto& s = Counters[static_cast<size_t>(StrictTag)];
+        s.Violations.fetch_add(1u, std::memory_order_relaxed);
+        s.ViolationBytes.fetch_add(Bytes, std::memory_order_relaxed);
+    }
+    return CurrentTag;
+}
+
+void AllocTracker::RecordFree(AllocTag Tag) noexcept
+{
+    Counters[static_cast<size_t>(Tag)].Frees.fetch_add(1u, std::memory_order_relaxed);
+}
+
+AllocScope::AllocScope(AllocTag Tag) noexcept : Previous(CurrentTag), PreviousStrict(StrictTag)
+{
+    CurrentTag = Tag;
+    if (StrictTag == AllocTag::Count && AllocTracker::IsStrict(Tag))
+    {
+        StrictTag = Tag;
+    }
+}
+
+AllocScope::~AllocScope()
+{
+    CurrentTag = Previous;
+    StrictTag = PreviousStrict;
+}
+
+// Allocation tracker exceptions
+AllocTracker::Exception::Exception(int Line, const char* File, AllocTag Tag, size_t Count, size_t Bytes) noexcept
+    : MyException(Line, File), Tag(Tag), Count(Count), Bytes(Bytes) {}
+
+const char* AllocTracker::Exception::what() const noexcept
+{
+    std::ostringstream oss;
+    oss << GetType() << std::endl
+        << "[Tag] " << GetTagName(Tag) << std::endl
+        << "[Allocations] " << Count << " (" << Bytes << " bytes)" << std::endl
+        << GetOriginString();
+    whatBuffer = oss.str();
+    return whatBuffer.c_str();
+}
+
+const char* AllocTracker::Exception::GetType() const noexcept
+{
+    return "Allocation Tracker Exception [Strict Tag Allocated]";
+}
+
+AllocTag AllocTracker::Exception::GetTag() const noexcept
+{
+    return Tag;
+}
+
+// Global new/delete hooks
+#ifdef ALLOC_TRACKING
+namespace
+{
+    // Every block starts with a header that holds the tag it was counted for, so the free
+    // goes to the same tag wherever it happens. The header keeps the block's alignment.
+    constexpr size_t HeaderSize = alignof(std::max_align_t);
+
+    void* WriteHeader(void* Block, size_t Offset, AllocTag Charged) noexcept
+    {
+        if (!Block)
+        {
+            return nullptr;
+        }
+        unsigned char* const Memory = static_cast<unsigned char*>(Block) + Offset;
+        Memory[-1] = static_cast<unsigned char>(Charged);
+        return Memory;
+    }
+
+    void* ReadHeader(void* Memory, size_t Offset) noexcept
+    {
+        unsigned char* const Bytes = static_cast<unsigned char*>(Memory);
+        AllocTracker::RecordFree(static_cast<AllocTag>(Bytes[-1]));
+        return Bytes - Offset;
+    }
+
+    void* TrackedAlloc(size_t Size) noexcept
+    {
+        if (Size > SIZE_MAX - HeaderSize)
+        {
+            return nullptr;
+        }
+        const AllocTag Charged = AllocTracker::RecordAlloc(Size);
+        return WriteHeader(std::malloc(HeaderSize + Size), HeaderSize, Charged);
+    }
+
+    void* TrackedAlignedAlloc(size_t Size, size_t Alignment) noexcept
+    {
+        // A whole alignment step in front keeps the block aligned, it is at least HeaderSize
+        const size_t Offset = Alignment > HeaderSize ? Alignment : HeaderSize;
+        if (Size > SIZE_MAX - Offset - Alignment)
+        {
+            return nullptr;
+        }
+        const AllocTag Charged = AllocTracker::RecordAlloc(Size);
+#ifdef _MSC_VER
+        return WriteHeader(_aligned_malloc(Offset + Size, Alignment), Offset, Charged);
+#else
+        return WriteHeader(std::aligned_alloc(Alignment, (Offset + Size + Alignment - 1u) / Alignment * Alignment), Offset, Charged);
+#endif
+    }
+
+    void TrackedFree(void* Memory) noexcept
+    {
+        if (Memory)
+        {
+            std::free(ReadHeader(Memory, HeaderSize));
+        }
+    }
+
+    void TrackedAlignedFree(void* Memory, size_t Alignment) noexcept
+    {
+        if (Memory)
+        {
+            void* const Block = ReadHeader(Memory, Alignment > HeaderSize ? Alignment : HeaderSize);
+#ifdef _MSC_VER
+            _aligned_free(Block);
+#else
+            std::free(Block);
+#endif
+        }
+    }
+}
+
+void* operator new(size_t Size)
+{
+    if (void* Memory = TrackedAlloc(Size))
+    {
+        return Memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t Size)
+{
+    return operator new(Size);
+}
+
+void* operator new(size_t Size, std::align_val_t Alignment)
+{
+    if (void* Memory = TrackedAlignedAlloc(Size, static_cast<size_t>(Alignment)))
+    {
+        return Memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t Size, std::align_val_t Alignment)
+{
+    return operator new(Size, Alignment);
+}
+
+void* operator new(size_t Size, const std::nothrow_t&) noexcept
+{
+    return TrackedAlloc(Size);
+}
+
+void* operator new[](size_t Size, const std::nothrow_t&) noexcept
+{
+    return TrackedAlloc(Size);
+}
+
+void operator delete(void* Memory) noexcept
+{
+    TrackedFree(Memory);
+}
+
+void operator delete[](void* Memory) noexcept
+{
+    TrackedFree(Memory);
+}
+
+void operator delete(void* Memory, size_t) noexcept
+{
+    TrackedFree(Memory);
+}
+
+void operator delete[](void* Memory, size_t) noexcept
+{
+    TrackedFree(Memory);
+}
+
+void operator delete(void* Memory, std::align_val_t Alignment) noexcept
+{
+    TrackedAlignedFree(Memory, static_cast<size_t>(Alignment));
+}
+
+void operator delete[](void* Memory, std::align_val_t Alignment) noexcept
+{
+    TrackedAlignedFree(Memory, static_cast<size_t>(Alignment));
+}
+
+void operator delete(void* Memory, size_t, std::align_val_t Alignment) noexcept
+{
+    TrackedAlignedFree(Memory, static_cast<size_t>(Alignment));
+}
+
+void operator delete[](void* Memory, size_t, std::align_val_t Alignment) noexcept
+{
+    TrackedAlignedFree(Memory, static_cast<size_t>(Alignment));
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+#include "exceptions.h"
+#include <array>
+#include <cstddef>
+
+// Subsystems that allocations are attributed to. Allocations made outside any
+// AllocScope are counted as Untagged.
+enum class AllocTag : unsigned char
+{
+    Untagged,
+    Frame,
+    Graphics,
+    Window,
+    Exception,
+    Count
+};
+
+// Counts heap allocations per subsystem and per frame. The global new/delete hooks
+// are only compiled in when ALLOC_TRACKING is defined, otherwise every counter stays 0.
+class AllocTracker
+{
+public:
+    class Exception : public MyException
+    {
+    public:
+        Exception(int Line, const char* File, AllocTag Tag, size_t Count, size_t Bytes) noexcept;
+        const char* what() const noexcept override;
+        const char* GetType() const noexcept override;
+        AllocTag GetTag() const noexcept;
+    private:
+        AllocTag Tag;
+        size_t Count;
+        size_t Bytes;
+    };
+    struct Stats
+    {
+        size_t Count = 0u;
+        size_t Bytes = 0u;
+        size_t Frees = 0u;
+    };
+    struct FrameStats
+    {
+        std::array<Stats, static_cast<size_t>(AllocTag::Count)> Tags;
+        Stats Total;
+    };
+public:
+    static constexpr bool IsEnabled() noexcept
+    {
+#ifdef ALLOC_TRACKING
+        return true;
+#else
+        return false;
+#endif
+    }
+    // Returns what was allocated since the previous call and starts a new frame.
+    // Throws if anything allocated inside a strict scope during the frame.
+    static FrameStats EndFrame();
+    // Strict tags are hot paths that must not allocate at all. Strictness is decided by
+    // the outermost strict scope, so Graphics work inside a Frame scope still counts as
+    // Graphics but fails the frame.
+    static void SetStrict(AllocTag Tag, bool Strict = true) noexcept;
+    static bool IsStrict(AllocTag Tag) noexcept;
+    static const char* GetTagName(AllocTag Tag) noexcept;
+
+    // Returns the tag the allocation was counted for, its free has to be recorded with it
+    static AllocTag RecordAlloc(size_t Bytes) noexcept;
+    static void RecordFree(AllocTag Tag) noexcept;
+};
+
+// Attributes every allocation on this thread to Tag until the scope ends. Opening a
+// strict tag's scope makes the thread strict until it closes, whatever is nested in it.
+class AllocScope
+{
+public:
+    explicit AllocScope(AllocTag Tag) noexcept;
+    ~AllocScope();
+    AllocScope(const AllocScope&) = delete;
+    AllocScope& operator=(const AllocScope&) = delete;
+private:
+    AllocTag Previous;
+    AllocTag PreviousStrict;
+};
+
+#define ALLOC_EXCEPT(Tag, Count, Bytes) AllocTracker::Exception(__LINE__, __FILE__, (Tag), (Count), (Bytes))
\ No newline at end of file
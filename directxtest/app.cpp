@@ -1,26 +1,221 @@
 #include "app.h"
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
+#include <iterator>
+#include <fstream>
+#include <stdexcept>
+#include <cmath>
 
-App::App() : MainWindow(800, 600, L"D3DEngine") {}
+App::App(const AppConfig& Config) : Config(Config), Pipeline(Config.PipelineDepth)
+{
+#ifdef ALLOC_TRACKING_STRICT
+    AllocTracker::SetStrict(AllocTag::Frame);
+#endif
+    if (Config.Benchmark)
+    {
+        OffscreenGFX = std::make_unique<Graphics>(Config.Backend, Config.Width, Config.Height, Config.CapturePath);
+        GFX = OffscreenGFX.get();
+    }
+    else
+    {
+        MainWindow = std::make_unique<Window>(static_cast<int>(Config.Width), static_cast<int>(Config.Height), L"D3DEngine", Config.CapturePath);
+        GFX = &MainWindow->GetGFX();
+    }
+
+    if (!Config.ReplayPath.empty())
+    {
+        // Benchmarks measure the replay itself, never the recorded pacing
+        const auto Pacing = Config.Benchmark ? CaptureReplayer::Pacing::Unpaced : Config.ReplayPacing;
+        Replayer = std::make_unique<CaptureReplayer>(*GFX, Config.ReplayPath, Pacing);
+    }
+    else
+    {
+        ActiveScene = CreateScene(Config.Scene, Config.Seed);
+        if (!ActiveScene)
+        {
+            throw std::invalid_argument("Unknown scene");
+        }
+        ActiveScene->Load(*GFX);
+    }
+}
+
+App::~App()
+{
+    StopSimulation();
+}
 
 int App::Run()
 {
+    if (Config.Benchmark)
+    {
+        return RunBenchmark();
+    }
+
+    if (Pipeline.GetDepth() > 1u && !Replayer)
+    {
+        SimulationThread = std::thread(&App::SimulationLoop, this);
+    }
+
     while (true)
     {
         if (const auto ecode = Window::ProcessMessages())
         {
+            StopSimulation();
             return *ecode;
         }
         
-        DoFrame();
+        if (!DoFrame())
+        {
+            PostQuitMessage(0);
+        }
     }
 }
 
-void App::DoFrame()
+int App::RunBenchmark()
 {
-    const float c = sin(MyTimer.Peek()) / 2.0f + 0.5f;
-    MainWindow.GetGFX().ClearBuffer(c, c, 1.0f);
-    MainWindow.GetGFX().DrawTestTriangle();
-    MainWindow.GetGFX().EndFrame();
+    BenchmarkReport::Settings Settings;
+    Settings.Backend = Graphics::GetBackendName(Config.Backend);
+    Settings.Width = Config.Width;
+    Settings.Height = Config.Height;
+    Settings.Seed = Config.Seed;
+    Settings.PipelineDepth = Pipeline.GetDepth();
+    Settings.WarmupFrames = Config.WarmupFrames;
+    BenchmarkReport Report(Settings);
+
+    BenchmarkRun& Result = Report.AddRun(ActiveScene ? ActiveScene->GetName() : "replay");
+
+    if (Pipeline.GetDepth() > 1u && !Replayer)
+    {
+        SimulationThread = std::thread(&App::SimulationLoop, this);
+    }
+
+    // Frame time is measured from the end of one frame to the end of the next, the same
+    // interval a presenting app sees
+    Timer FrameTimer;
+    for (unsigned int i = 0; i < Config.WarmupFrames + Config.Frames; i++)
+    {
+        if (!DoFrame())
+        {
+            break;
+        }
+        const float Seconds = FrameTimer.Mark();
+        if (i < Config.WarmupFrames)
+        {
+            continue;
+        }
+
+        const Graphics::FrameCounters& Counters = GFX->GetFrameCounters();
+        Result.AddFrame(Seconds, FrameAllocations);
+        Result.AddCounter("draws", Counters.Draws);
+        Result.AddCounter("command_lists", Counters.CommandLists);
+        Result.AddCounter("pipeline_changes", Counters.PipelineChanges);
+        Result.AddCounter("upload_bytes", static_cast<double>(Counters.UploadBytes));
+        Result.AddCounter("arena_bytes", static_cast<double>(Counters.ArenaBytes));
+        for (size_t v = 0; v < SceneStatistics.Count; v++)
+        {
+            Result.AddCounter(std::string("scene.") + SceneStatistics.Values[v].Name, SceneStatistics.Values[v].Amount);
+        }
+    }
+    StopSimulation();
+    Result.AddPeak("arena_bytes", static_cast<double>(GFX->GetFrameArenaHighWaterMark()));
+
+    std::ofstream Out(Config.OutputPath);
+    if (!Out)
+    {
+        throw std::runtime_error("Cannot create benchmark output file");
+    }
+    Report.WriteJson(Out);
+    return 0;
+}
+
+bool App::DoFrame()
+{
+    if (Replayer)
+    {
+        const bool Replayed = Replayer->ReplayFrame();
+        FrameAllocations = AllocTracker::EndFrame();
+        return Replayed;
+    }
+
+    // In sequential mode the render thread simulates the frame itself
+    if (!SimulationThread.joinable())
+    {
+        FramePacket* const Next = Pipeline.BeginSimulate();
+        if (!Next)
+        {
+            return false;
+        }
+        Simulate(*Next);
+        Pipeline.EndSimulate(*Next);
+    }
+
+    FramePacket* const Packet = Pipeline.BeginRender();
+    if (!Packet)
+    {
+        return false;
+    }
+    Render(*Packet);
+    Pipeline.EndRender(*Packet);
+    FrameAllocations = AllocTracker::EndFrame();
+    return true;
+}
+
+void App::Simulate(FramePacket& Packet)
+{
+    AllocScope Scope(AllocTag::Frame);
+    // Benchmarks step a fixed 60 Hz so every run simulates the same frames. The clock
+    // stays double until here, a float session time would already be rounded to
+    // milliseconds after a few hours.
+    const double Seconds = Config.Benchmark ? static_cast<double>(Packet.Index) / 60.0 : MyTimer.Peek();
+    const float t = static_cast<float>(Seconds);
+    const float c = static_cast<float>(std::sin(Seconds) / 2.0 + 0.5);
+    Packet.ClearColor[0] = c;
+    Packet.ClearColor[1] = c;
+    Packet.ClearColor[2] = 1.0f;
+
+    // Tint and time, matches FrameConstants in the shaders
+    const float FrameData[] = {1.0f, 1.0f - c, c, 1.0f, t, 0.0f, 0.0f, 0.0f};
+    std::copy(std::begin(FrameData), std::end(FrameData), Packet.FrameConstants);
+    ActiveScene->Simulate(Packet, t, Jobs);
+}
+
+void App::Render(FramePacket& Packet)
+{
+    AllocScope Scope(AllocTag::Frame);
+    GFX->ClearBuffer(Packet.ClearColor[0], Packet.ClearColor[1], Packet.ClearColor[2]);
+    GFX->SetFrameConstants(Packet.FrameConstants, sizeof(Packet.FrameConstants));
+    GFX->SetViewConstants(Packet.ViewConstants, sizeof(Packet.ViewConstants));
+    GFX->Submit(Packet.Draws, 0u);
+    for (size_t i = 0; i < Packet.Chunks.size(); i++)
+    {
+        GFX->Submit(Packet.Chunks[i], static_cast<uint32_t>(i + 1u));
+    }
+    GFX->EndFrame();
+    SceneStatistics = Packet.Statistics;
+}
+
+void App::SimulationLoop() noexcept
+{
+    try
+    {
+        while (FramePacket* const Packet = Pipeline.BeginSimulate())
+        {
+            Simulate(*Packet);
+            Pipeline.EndSimulate(*Packet);
+        }
+    }
+    catch (...)
+    {
+        Pipeline.Fail(std::current_exception());
+    }
+}
+
+void App::StopSimulation() noexcept
+{
+    Pipeline.Stop();
+    if (SimulationThread.joinable())
+    {
+        SimulationThread.join();
+    }
 }
\ No newline at end of file
@@ -1,15 +1,71 @@
 #pragma once
 #include "win_class.h"
 #include "timer.h"
+#include "alloc_tracker.h"
+#include "frame_pipeline.h"
+#include "capture_replay.h"
+#include "benchmark.h"
+#include "scene.h"
+#include "job_system.h"
+#include <memory>
+#include <string>
+#include <thread>
+
+struct AppConfig
+{
+    // A pipeline depth above 1 simulates the next frames on a separate thread while
+    // the current one is submitted
+    unsigned int PipelineDepth = 1u;
+    unsigned int Width = 800u;
+    unsigned int Height = 600u;
+    // Records every Graphics call into this file
+    std::wstring CapturePath;
+    // Plays this capture instead of simulating, the app quits when it ends
+    std::wstring ReplayPath;
+    CaptureReplayer::Pacing ReplayPacing = CaptureReplayer::Pacing::Unpaced;
+    // Benchmark mode runs without a window on the chosen backend, simulates with a fixed
+    // time step and writes a JSON report (see benchmark.h) instead of running until closed
+    bool Benchmark = false;
+    // triangle, tiny_draws, huge_meshes, overdraw, state_changes, streaming, culling, occlusion, lod or meshlets
+    std::wstring Scene = L"triangle";
+    unsigned int Frames = 1000u;
+    unsigned int WarmupFrames = 30u;
+    Graphics::Backend Backend = Graphics::Backend::Hardware;
+    uint32_t Seed = 1u;
+    std::wstring OutputPath = L"benchmark.json";
+    // Times the input, timer and error paths instead of rendering, Frames and WarmupFrames
+    // count batches of BatchSize calls (see microbenchmark.h)
+    bool MicroBenchmark = false;
+    unsigned int BatchSize = 1000u;
+};
 
 class App
 {
 public:
-    App();
+    explicit App(const AppConfig& Config = {});
+    ~App();
     int Run();
 private:
-    void DoFrame();
+    int RunBenchmark();
+    // False once there is nothing left to render
+    bool DoFrame();
+    void Simulate(FramePacket& Packet);
+    void Render(FramePacket& Packet);
+    void SimulationLoop() noexcept;
+    void StopSimulation() noexcept;
 private:
-    Window MainWindow;
+    AppConfig Config;
+    // Null in benchmark mode, which renders offscreen
+    std::unique_ptr<Window> MainWindow;
+    std::unique_ptr<Graphics> OffscreenGFX;
+    Graphics* GFX = nullptr;
     Timer MyTimer;
+    AllocTracker::FrameStats FrameAllocations;
+    JobSystem Jobs;
+    std::unique_ptr<Scene> ActiveScene;
+    // Statistics of the packet rendered last
+    FrameStatistics SceneStatistics;
+    FramePipeline Pipeline;
+    std::thread SimulationThread;
+    std::unique_ptr<CaptureReplayer> Replayer;
 };
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include "benchmark.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <numeric>
+
+namespace
+{
+    // Linear interpolation between the closest ranks of a sorted sample
+    double Percentile(const std::vector<double>& Sorted, double Fraction) noexcept
+    {
+        const double Rank = Fraction * static_cast<double>(Sorted.size() - 1u);
+        const size_t Below = static_cast<size_t>(Rank);
+        const size_t Above = std::min(Below + 1u, Sorted.size() - 1u);
+        return Sorted[Below] + (Sorted[Above] - Sorted[Below]) * (Rank - static_cast<double>(Below));
+    }
+
+    void WriteStats(std::ostream& Out, const AllocTracker::Stats& Stats)
+    {
+        Out << "{\"count\": " << Stats.Count << ", \"bytes\": " << Stats.Bytes << ", \"frees\": " << Stats.Frees << "}";
+    }
+}
+
+BenchmarkRun::BenchmarkRun(std::string Scene) : Scene(std::move(Scene)), Allocations{} {}
+
+void BenchmarkRun::AddFrame(float Seconds, const AllocTracker::FrameStats& Frame)
+{
+    FrameTimes.push_back(Seconds);
+
+    const auto Add = [](AllocTracker::Stats& Sum, const AllocTracker::Stats& Value)
+    {
+        Sum.Count += Value.Count;
+        Sum.Bytes += Value.Bytes;
+        Sum.Frees += Value.Frees;
+    };
+    for (size_t i = 0; i < Allocations.Tags.size(); i++)
+    {
+        Add(Allocations.Tags[i], Frame.Tags[i]);
+    }
+    Add(Allocations.Total, Frame.Total);
+}
+
+void BenchmarkRun::AddCounter(const std::string& Name, double Value)
+{
+    Counters[Name] += Value;
+}
+
+void BenchmarkRun::AddPeak(const std::string& Name, double Value)
+{
+    const auto [Peak, Added] = Peaks.emplace(Name, Value);
+    Peak->second = std::max(Peak->second, Value);
+}
+
+const std::string& BenchmarkRun::GetScene() const noexcept
+{
+    return Scene;
+}
+
+const std::vector<float>& BenchmarkRun::GetFrameTimes() const noexcept
+{
+    return FrameTimes;
+}
+
+BenchmarkRun::Distribution BenchmarkRun::Summarize(std::vector<double> Samples)
+{
+    Distribution Result;
+    if (Samples.empty())
+    {
+        return Result;
+    }
+
+    std::sort(Samples.begin(), Samples.end());
+    const double Count = static_cast<double>(Samples.size());
+    Result.Mean = std::accumulate(Samples.begin(), Samples.end(), 0.0) / Count;
+    double Squares = 0.0;
+    for (const double s : Samples)
+    {
+        Squares += (s - Result.Mean) * (s - Result.Mean);
+    }
+    Result.StdDev = Samples.size() > 1u ? std::sqrt(Squares / (Count - 1.0)) : 0.0;
+    Result.Min = Samples.front();
+    Result.P50 = Percentile(Samples, 0.50);
+    Result.P90 = Percentile(Samples, 0.90);
+    Result.P95 = Percentile(Samples, 0.95);
+    Result.P99 = Percentile(Samples, 0.99);
+    Result.Max = Samples.back();
+    return Result;
+}
+
+void BenchmarkRun::WriteJson(std::ostream& Out) const
+{
+    std::vector<double> Milliseconds(FrameTimes.size());
+    std::transform(FrameTimes.begin(), FrameTimes.end(), Milliseconds.begin(), [](float s) { return s * 1000.0; });
+    const double TotalSeconds = std::accumulate(FrameTimes.begin(), FrameTimes.end(), 0.0);
+    const double Frames = static_cast<double>(FrameTimes.size());
+    const Distribution Times = Summarize(Milliseconds);
+
+    Out << "    {\n"
+        << "      \"scene\": \"" << Scene << "\",\n"
+        << "      \"frames\": " << FrameTimes.size() << ",\n"
+        << "      \"total_seconds\": " << TotalSeconds << ",\n"
+        << "      \"frames_per_second\": " << (TotalSeconds > 0.0 ? Frames / TotalSeconds : 0.0) << ",\n"
+        << "      \"frame_time_ms\": {\"mean\": " << Times.Mean << ", \"stddev\": " << Times.StdDev
+        << ", \"min\": " << Times.Min << ", \"p50\": " << Times.P50 << ", \"p90\": " << Times.P90
+        << ", \"p95\": " << Times.P95 << ", \"p99\": " << Times.P99 << ", \"max\": " << Times.Max << "},\n";
+
+    Out << "      \"allocations\": {\n"
+        << "        \"tracking\": " << (AllocTracker::IsEnabled() ? "true" : "false") << ",\n"
+        << "        \"total\": ";
+    WriteStats(Out, Allocations.Total);
+    Out << ",\n"
+        << "        \"per_frame\": {\"count\": " << (Frames > 0.0 ? Allocations.Total.Count / Frames : 0.0)
+        << ", \"bytes\": " << (Frames > 0.0 ? Allocations.Total.Bytes / Frames : 0.0) << "},\n"
+        << "        \"tags\": {";
+    for (size_t i = 0; i < Allocations.Tags.size(); i++)
+    {
+        Out << (i ? ", " : "") << "\"" << AllocTracker::GetTagName(static_cast<AllocTag>(i)) << "\": ";
+        WriteStats(Out, Allocations.Tags[i]);
+    }
+    Out << "}\n"
+        << "      },\n";
+
+    // Per-second values are the throughput of the measured frames
+    Out << "      \"counters\": {";
+    bool First = true;
+    for (const auto& [Name, Total] : Counters)
+    {
+        Out << (First ? "\n" : ",\n")
+            << "        \"" << Name << "\": {\"total\": " << Total
+            << ", \"per_frame\": " << (Frames > 0.0 ? Total / Frames : 0.0)
+            << ", \"per_second\": " << (TotalSeconds > 0.0 ? Total / TotalSeconds : 0.0) << "}";
+        First = false;
+    }
+    Out << (First ? "},\n" : "\n      },\n");
+
+    Out << "      \"peaks\": {";
+    First = true;
+    for (const auto& [Name, Peak] : Peaks)
+    {
+        Out << (First ? "" : ", ") << "\"" << Name << "\": " << Peak;
+        First = false;
+    }
+    Out << "},\n";
+
+    // Raw samples so runs can be compared as distributions
+    Out << "      \"samples\": {\"frame_time_ms\": [";
+    for (size_t i = 0; i < Milliseconds.size(); i++)
+    {
+        Out << (i ? ", " : "") << Milliseconds[i];
+    }
+    Out << "]}\n"
+        << "    }";
+}
+
+BenchmarkReport::BenchmarkReport(Settings Config) : Config(std::move(Config)) {}
+
+BenchmarkRun& BenchmarkReport::AddRun(std::string Scene)
+{
+    return Runs.emplace_back(std::move(Scene));
+}
+
+void BenchmarkReport::WriteJson(std::ostream& Out) const
+{
+    const auto Flags = Out.flags();
+    const auto Precision = Out.precision(9);
+
+    Out << "{\n"
+        << "  \"version\": " << Version << ",\n"
+        << "  \"settings\": {\"backend\": \"" << Config.Backend << "\", \"width\": " << Config.Width
+        << ", \"height\": " << Config.Height << ", \"seed\": " << Config.Seed
+        << ", \"pipeline_depth\": " << Config.PipelineDepth << ", \"warmup_frames\": " << Config.WarmupFrames << "},\n"
+        << "  \"runs\": [\n";
+    for (size_t i = 0; i < Runs.size(); i++)
+    {
+        Runs[i].WriteJson(Out);
+        Out << (i + 1u < Runs.size() ? ",\n" : "\n");
+    }
+    Out << "  ]\n"
+        << "}\n";
+
+    Out.precision(Precision);
+    Out.flags(Flags);
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+#include "alloc_tracker.h"
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Frame times, allocations and counters of one benchmark run
+class BenchmarkRun
+{
+public:
+    struct Distribution
+    {
+        double Mean = 0.0;
+        double StdDev = 0.0;
+        double Min = 0.0;
+        double P50 = 0.0;
+        double P90 = 0.0;
+        double P95 = 0.0;
+        double P99 = 0.0;
+        double Max = 0.0;
+    };
+public:
+    explicit BenchmarkRun(std::string Scene);
+
+    void AddFrame(float Seconds, const AllocTracker::FrameStats& Allocations);
+    // Counters are summed over the measured frames, e.g. draws or uploaded bytes
+    void AddCounter(const std::string& Name, double Value);
+    // Only the largest value is kept, e.g. the frame arena's high-water mark
+    void AddPeak(const std::string& Name, double Value);
+
+    const std::string& GetScene() const noexcept;
+    const std::vector<float>& GetFrameTimes() const noexcept;
+    void WriteJson(std::ostream& Out) const;
+
+    static Distribution Summarize(std::vector<double> Samples);
+private:
+    std::string Scene;
+    std::vector<float> FrameTimes;
+    AllocTracker::FrameStats Allocations;
+    // Ordered so the output is stable between runs
+    std::map<std::string, double> Counters;
+    std::map<std::string, double> Peaks;
+};
+
+// Everything one benchmark invocation writes out. The JSON layout is read back by
+// the benchcompare tool, bump Version when it changes. Version 2 added the per-run peaks.
+class BenchmarkReport
+{
+public:
+    static constexpr unsigned int Version = 2u;
+    struct Settings
+    {
+        std::string Backend;
+        unsigned int Width = 0u;
+        unsigned int Height = 0u;
+        uint32_t Seed = 0u;
+        unsigned int PipelineDepth = 1u;
+        unsigned int WarmupFrames = 0u;
+    };
+public:
+    explicit BenchmarkReport(Settings Config);
+
+    // References stay valid as more runs are added
+    BenchmarkRun& AddRun(std::string Scene);
+    void WriteJson(std::ostream& Out) const;
+private:
+    Settings Config;
+    std::deque<BenchmarkRun> Runs;
+};
\ No newline at end of file
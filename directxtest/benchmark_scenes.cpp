@@ -0,0 +1,850 @@
+#include "benchmark_scenes.h"
+#include "simd_math.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+namespace
+{
+    struct Vertex
+    {
+        float X;
+        float Y;
+    };
+
+    // Unit triangle and unit quad (two triangles) around the origin
+    constexpr Vertex TriangleVertices[] = {{0.0f, 1.0f}, {0.87f, -0.5f}, {-0.87f, -0.5f}};
+    constexpr Vertex QuadVertices[] =
+    {
+        {-1.0f, 1.0f}, {1.0f, 1.0f}, {-1.0f, -1.0f},
+        {-1.0f, -1.0f}, {1.0f, 1.0f}, {1.0f, -1.0f}
+    };
+
+    // The triangle and the quad again at z = 0, for the mesh pipeline and as occluders
+    constexpr Vec3 TriangleCorners[] = {{0.0f, 1.0f, 0.0f}, {0.87f, -0.5f, 0.0f}, {-0.87f, -0.5f, 0.0f}};
+    constexpr Vec3 QuadCorners[] =
+    {
+        {-1.0f, 1.0f, 0.0f}, {1.0f, 1.0f, 0.0f}, {-1.0f, -1.0f, 0.0f},
+        {-1.0f, -1.0f, 0.0f}, {1.0f, 1.0f, 0.0f}, {1.0f, -1.0f, 0.0f}
+    };
+    constexpr uint32_t QuadIndices[] = {0u, 1u, 2u, 3u, 4u, 5u};
+
+    size_t GetChunkCount(size_t Count, size_t PerChunk) noexcept
+    {
+        return (Count + PerChunk - 1u) / PerChunk;
+    }
+
+    // Scenes drawn with the mesh pipeline pass their camera as the view constants
+    void SetViewProjection(FramePacket& Packet, const Mat4& ViewProjection) noexcept
+    {
+        static_assert(sizeof(Packet.ViewConstants) == sizeof(Mat4));
+        std::memcpy(Packet.ViewConstants, &ViewProjection, sizeof(Mat4));
+    }
+
+    // Unit sphere as the six faces of a cube with Size x Size cells each, pushed out to
+    // radius 1. Faces do not share vertices. Triangles are wound so the cross product of
+    // their edges points out, which D3D draws as front faces.
+    void AddCubeSphere(uint32_t Size, std::vector<Vec3>& Positions, std::vector<uint32_t>& Indices)
+    {
+        // Normal and the two directions across each face
+        const Vec3 Faces[6][3] =
+        {
+            {{1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f, 0.0f}},
+            {{-1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f, 0.0f}},
+            {{0.0f, 1.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f}},
+            {{0.0f, -1.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f}},
+            {{0.0f, 0.0f, 1.0f}, {1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}},
+            {{0.0f, 0.0f, -1.0f}, {1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}}
+        };
+        const float Cell = 2.0f / static_cast<float>(Size);
+        for (const auto& Face : Faces)
+        {
+            const uint32_t First = static_cast<uint32_t>(Positions.size());
+            for (uint32_t b = 0; b <= Size; b++)
+            {
+                for (uint32_t a = 0; a <= Size; a++)
+                {
+                    Positions.push_back(Normalize(Face[0] + Face[1] * (a * Cell - 1.0f) + Face[2] * (b * Cell - 1.0f)));
+                }
+            }
+            for (uint32_t b = 0; b < Size; b++)
+            {
+                for (uint32_t a = 0; a < Size; a++)
+                {
+                    const uint32_t i = First + b * (Size + 1u) + a;
+                    uint32_t Quad[] = {i, i + 1u, i + Size + 1u, i + Size + 1u, i + 1u, i + Size + 2u};
+                    for (size_t t = 0; t < std::size(Quad); t += 3u)
+                    {
+                        const Vec3& p0 = Positions[Quad[t]];
+                        if (Dot(Cross(Positions[Quad[t + 1u]] - p0, Positions[Quad[t + 2u]] - p0), p0) < 0.0f)
+                        {
+                            std::swap(Quad[t + 1u], Quad[t + 2u]);
+                        }
+                    }
+                    Indices.insert(Indices.end(), std::begin(Quad), std::end(Quad));
+                }
+            }
+        }
+    }
+}
+
+// Triangle
+
+const char* TriangleScene::GetName() const noexcept
+{
+    return "triangle";
+}
+
+void TriangleScene::Load(Graphics& GFX)
+{
+    this->GFX = &GFX;
+}
+
+void TriangleScene::Simulate(FramePacket& Packet, float Time, JobSystem&)
+{
+    GFX->DrawTestTriangle(Packet.Draws, Time);
+    Packet.Statistics.Add("objects", 1.0);
+}
+
+// Tiny draws
+
+TinyDrawsScene::TinyDrawsScene(uint32_t Seed)
+{
+    SceneRandom Random(Seed);
+    X.resize(ObjectCount);
+    Y.resize(ObjectCount);
+    Scale.resize(ObjectCount);
+    Spin.resize(ObjectCount);
+    for (size_t i = 0; i < ObjectCount; i++)
+    {
+        X[i] = Random.NextFloat(-1.0f, 1.0f);
+        Y[i] = Random.NextFloat(-1.0f, 1.0f);
+        Scale[i] = Random.NextFloat(0.005f, 0.02f);
+        Spin[i] = Random.NextFloat(-4.0f, 4.0f);
+    }
+}
+
+const char* TinyDrawsScene::GetName() const noexcept
+{
+    return "tiny_draws";
+}
+
+void TinyDrawsScene::Load(Graphics& GFX)
+{
+    State = GFX.CreatePipelineState(LoadDefaultPipeline(GFX))->Id;
+    Vertices = CreateStaticBuffer(GFX, D3D11_BIND_VERTEX_BUFFER, TriangleVertices, sizeof(TriangleVertices));
+}
+
+void TinyDrawsScene::Simulate(FramePacket& Packet, float Time, JobSystem& Jobs)
+{
+    Packet.Chunks.resize(GetChunkCount(ObjectCount, ObjectsPerChunk));
+    Jobs.ParallelFor(ObjectCount, ObjectsPerChunk, [&](size_t Begin, size_t End, unsigned int)
+    {
+        CommandList& List = Packet.Chunks[Begin / ObjectsPerChunk];
+        List.SetPipelineState(State);
+        List.SetVertexBuffer(Vertices, sizeof(Vertex));
+
+        // The whole chunk's transforms in one batch, then one draw each
+        const size_t Count = End - Begin;
+        float Angles[ObjectsPerChunk];
+        Mat4 Transforms[ObjectsPerChunk];
+        for (size_t i = 0; i < Count; i++)
+        {
+            Angles[i] = Spin[Begin + i] * Time;
+        }
+        ComposeTransforms2D(&X[Begin], &Y[Begin], &Scale[Begin], Angles, Transforms, Count);
+        for (size_t i = 0; i < Count; i++)
+        {
+            List.SetDrawConstants(&Transforms[i], sizeof(Mat4));
+            List.Draw((UINT)std::size(TriangleVertices));
+        }
+    });
+
+    Packet.Statistics.Add("objects", static_cast<double>(ObjectCount));
+}
+
+// Huge meshes
+
+HugeMeshScene::HugeMeshScene(uint32_t Seed) : Seed(Seed) {}
+
+const char* HugeMeshScene::GetName() const noexcept
+{
+    return "huge_meshes";
+}
+
+void HugeMeshScene::Load(Graphics& GFX)
+{
+    State = GFX.CreatePipelineState(LoadDefaultPipeline(GFX))->Id;
+
+    // All meshes share the grid topology and differ in their jittered vertices
+    constexpr uint32_t Side = GridSize + 1u;
+    std::vector<uint32_t> GridIndices;
+    GridIndices.reserve(static_cast<size_t>(GridSize) * GridSize * 6u);
+    for (uint32_t y = 0; y < GridSize; y++)
+    {
+        for (uint32_t x = 0; x < GridSize; x++)
+        {
+            const uint32_t i = y * Side + x;
+            const uint32_t Quad[] = {i, i + 1u, i + Side, i + Side, i + 1u, i + Side + 1u};
+            GridIndices.insert(GridIndices.end(), std::begin(Quad), std::end(Quad));
+        }
+    }
+    IndexCount = static_cast<uint32_t>(GridIndices.size());
+    Indices = CreateStaticBuffer(GFX, D3D11_BIND_INDEX_BUFFER, GridIndices.data(), GridIndices.size() * sizeof(uint32_t));
+
+    SceneRandom Random(Seed);
+    std::vector<Vertex> GridVertices(static_cast<size_t>(Side) * Side);
+    const float Cell = 2.0f / GridSize;
+    for (BufferHandle& Mesh : Vertices)
+    {
+        for (uint32_t y = 0; y < Side; y++)
+        {
+            for (uint32_t x = 0; x < Side; x++)
+            {
+                // Jitter stays within a quarter cell so triangles never flip
+                Vertex& v = GridVertices[static_cast<size_t>(y) * Side + x];
+                v.X = -1.0f + x * Cell + Random.NextFloat(-0.25f, 0.25f) * Cell;
+                v.Y = 1.0f - y * Cell + Random.NextFloat(-0.25f, 0.25f) * Cell;
+            }
+        }
+        Mesh = CreateStaticBuffer(GFX, D3D11_BIND_VERTEX_BUFFER, GridVertices.data(), GridVertices.size() * sizeof(Vertex));
+    }
+}
+
+void HugeMeshScene::Simulate(FramePacket& Packet, float Time, JobSystem&)
+{
+    CommandList& List = Packet.Draws;
+    List.SetPipelineState(State);
+    List.SetIndexBuffer(Indices, true);
+    for (size_t m = 0; m < MeshCount; m++)
+    {
+        // One mesh per quadrant, turning slowly
+        const float X = (m % 2u) ? 0.5f : -0.5f;
+        const float Y = (m / 2u) ? -0.5f : 0.5f;
+        const Mat4 Transform = Mat4::Transform2D(X, Y, 0.45f, 0.1f * Time * static_cast<float>(m + 1u));
+        List.SetVertexBuffer(Vertices[m], sizeof(Vertex));
+        List.SetDrawConstants(&Transform, sizeof(Transform));
+        List.DrawIndexed(IndexCount);
+    }
+
+    Packet.Statistics.Add("meshes", static_cast<double>(MeshCount));
+    Packet.Statistics.Add("triangles", static_cast<double>(MeshCount) * (IndexCount / 3u));
+}
+
+// Overdraw
+
+OverdrawScene::OverdrawScene(uint32_t Seed)
+{
+    SceneRandom Random(Seed);
+    Layers.resize(LayerCount);
+    for (Layer& l : Layers)
+    {
+        l.X = Random.NextFloat(-0.2f, 0.2f);
+        l.Y = Random.NextFloat(-0.2f, 0.2f);
+        l.Scale = Random.NextFloat(0.8f, 1.2f);
+    }
+}
+
+const char* OverdrawScene::GetName() const noexcept
+{
+    return "overdraw";
+}
+
+void OverdrawScene::Load(Graphics& GFX)
+{
+    PipelineStateDesc Desc = LoadDefaultPipeline(GFX);
+    Desc.Blend = BlendMode::Additive;
+    Desc.Cull = CullMode::None;
+    State = GFX.CreatePipelineState(Desc)->Id;
+    Vertices = CreateStaticBuffer(GFX, D3D11_BIND_VERTEX_BUFFER, QuadVertices, sizeof(QuadVertices));
+}
+
+void OverdrawScene::Simulate(FramePacket& Packet, float Time, JobSystem&)
+{
+    CommandList& List = Packet.Draws;
+    List.SetPipelineState(State);
+    List.SetVertexBuffer(Vertices, sizeof(Vertex));
+
+    // Sum of the on-screen area of every layer, in screens
+    double Coverage = 0.0;
+    for (size_t i = 0; i < Layers.size(); i++)
+    {
+        const Layer& l = Layers[i];
+        const float Drift = 0.05f * Sin(Time + static_cast<float>(i));
+        const float X = l.X + Drift;
+        const float Y = l.Y - Drift;
+        const Mat4 Transform = Mat4::Transform2D(X, Y, l.Scale, 0.0f);
+        List.SetDrawConstants(&Transform, sizeof(Transform));
+        List.Draw((UINT)std::size(QuadVertices));
+
+        const float Width = std::min(X + l.Scale, 1.0f) - std::max(X - l.Scale, -1.0f);
+        const float Height = std::min(Y + l.Scale, 1.0f) - std::max(Y - l.Scale, -1.0f);
+        Coverage += std::max(Width, 0.0f) * std::max(Height, 0.0f) / 4.0;
+    }
+
+    Packet.Statistics.Add("layers", static_cast<double>(Layers.size()));
+    Packet.Statistics.Add("overdraw", Coverage);
+}
+
+// State changes
+
+StateChangeScene::StateChangeScene(uint32_t Seed) : Seed(Seed) {}
+
+const char* StateChangeScene::GetName() const noexcept
+{
+    return "state_changes";
+}
+
+void StateChangeScene::Load(Graphics& GFX)
+{
+    const PipelineStateDesc Base = LoadDefaultPipeline(GFX);
+    for (size_t b = 0; b < static_cast<size_t>(BlendMode::Count); b++)
+    {
+        for (size_t c = 0; c < static_cast<size_t>(CullMode::Count); c++)
+        {
+            for (size_t f = 0; f < static_cast<size_t>(FillMode::Count); f++)
+            {
+                for (size_t d = 0; d < static_cast<size_t>(DepthMode::Count); d++)
+                {
+                    PipelineStateDesc Desc = Base;
+                    Desc.Blend = static_cast<BlendMode>(b);
+                    Desc.Cull = static_cast<CullMode>(c);
+                    Desc.Fill = static_cast<FillMode>(f);
+                    Desc.Depth = static_cast<DepthMode>(d);
+                    States.push_back(GFX.CreatePipelineState(Desc)->Id);
+                }
+            }
+        }
+    }
+    Vertices = CreateStaticBuffer(GFX, D3D11_BIND_VERTEX_BUFFER, TriangleVertices, sizeof(TriangleVertices));
+
+    // Consecutive draws never share a state
+    SceneRandom Random(Seed);
+    Draws.resize(DrawCount);
+    uint32_t Previous = 0u;
+    for (Draw& d : Draws)
+    {
+        d.X = Random.NextFloat(-1.0f, 1.0f);
+        d.Y = Random.NextFloat(-1.0f, 1.0f);
+        d.State = (Previous + 1u + static_cast<uint32_t>(Random.Next() % (States.size() - 1u))) % States.size();
+        Previous = d.State;
+    }
+}
+
+void StateChangeScene::Simulate(FramePacket& Packet, float Time, JobSystem& Jobs)
+{
+    Packet.Chunks.resize(GetChunkCount(Draws.size(), DrawsPerChunk));
+    Jobs.ParallelFor(Draws.size(), DrawsPerChunk, [&](size_t Begin, size_t End, unsigned int)
+    {
+        CommandList& List = Packet.Chunks[Begin / DrawsPerChunk];
+        List.SetVertexBuffer(Vertices, sizeof(Vertex));
+        for (size_t i = Begin; i < End; i++)
+        {
+            const Draw& d = Draws[i];
+            const Mat4 Transform = Mat4::Transform2D(d.X, d.Y, 0.03f, Time);
+            List.SetPipelineState(States[d.State]);
+            List.SetDrawConstants(&Transform, sizeof(Transform));
+            List.Draw((UINT)std::size(TriangleVertices));
+        }
+    });
+
+    Packet.Statistics.Add("pipeline_states", static_cast<double>(States.size()));
+    Packet.Statistics.Add("objects", static_cast<double>(Draws.size()));
+}
+
+// Streaming
+
+StreamingScene::StreamingScene(uint32_t Seed)
+{
+    SceneRandom Random(Seed);
+    Ribbons.resize(RibbonCount);
+    for (size_t i = 0; i < Ribbons.size(); i++)
+    {
+        Ribbon& r = Ribbons[i];
+        r.Y = -1.0f + 2.0f * (static_cast<float>(i) + 0.5f) / RibbonCount;
+        r.Amplitude = Random.NextFloat(0.01f, 0.05f);
+        r.Frequency = Random.NextFloat(2.0f, 12.0f);
+        r.Phase = Random.NextFloat(0.0f, 2.0f * Pi);
+    }
+}
+
+const char* StreamingScene::GetName() const noexcept
+{
+    return "streaming";
+}
+
+void StreamingScene::Load(Graphics& GFX)
+{
+    PipelineStateDesc Desc = LoadDefaultPipeline(GFX);
+    Desc.PrimitiveTopology = Topology::TriangleStrip;
+    Desc.Cull = CullMode::None;
+    State = GFX.CreatePipelineState(Desc)->Id;
+}
+
+void StreamingScene::Simulate(FramePacket& Packet, float Time, JobSystem& Jobs)
+{
+    Packet.Chunks.resize(GetChunkCount(Ribbons.size(), RibbonsPerChunk));
+    Jobs.ParallelFor(Ribbons.size(), RibbonsPerChunk, [&](size_t Begin, size_t End, unsigned int)
+    {
+        CommandList& List = Packet.Chunks[Begin / RibbonsPerChunk];
+        const Mat4 Identity = Mat4::Identity();
+        List.SetPipelineState(State);
+        List.SetDrawConstants(&Identity, sizeof(Identity));
+
+        // Strip of vertex pairs across the screen, half a row high
+        const float HalfWidth = 0.5f / RibbonCount;
+        constexpr size_t Columns = RibbonVertices / 2u;
+        Vertex Strip[RibbonVertices];
+        float Phases[Columns];
+        float Sines[Columns];
+        float Cosines[Columns];
+        for (size_t i = Begin; i < End; i++)
+        {
+            const Ribbon& r = Ribbons[i];
+            for (size_t v = 0; v < Columns; v++)
+            {
+                Strip[2u * v].X = -1.0f + 2.0f * static_cast<float>(v) / (Columns - 1u);
+                Phases[v] = r.Frequency * Strip[2u * v].X + r.Phase + Time;
+            }
+            SinCos(Phases, Sines, Cosines, Columns);
+            for (size_t v = 0; v < Columns; v++)
+            {
+                const float X = Strip[2u * v].X;
+                const float Y = r.Y + r.Amplitude * Sines[v];
+                Strip[2u * v] = {X, Y + HalfWidth};
+                Strip[2u * v + 1u] = {X, Y - HalfWidth};
+            }
+            List.StreamVertices(Strip, sizeof(Strip), sizeof(Vertex));
+            List.Draw((UINT)RibbonVertices);
+        }
+    });
+
+    Packet.Statistics.Add("ribbons", static_cast<double>(Ribbons.size()));
+    Packet.Statistics.Add("streamed_bytes", static_cast<double>(Ribbons.size() * RibbonVertices * sizeof(Vertex)));
+}
+
+// Culling
+
+CullingScene::CullingScene(uint32_t Seed)
+{
+    SceneRandom Random(Seed);
+    X.resize(ObjectCount);
+    Y.resize(ObjectCount);
+    Z.assign(ObjectCount, 0.0f);
+    Radius.resize(ObjectCount);
+    Spin.resize(ObjectCount);
+    Visible.resize(ObjectCount);
+    for (size_t i = 0; i < ObjectCount; i++)
+    {
+        X[i] = Random.NextFloat(-WorldExtent, WorldExtent);
+        Y[i] = Random.NextFloat(-WorldExtent, WorldExtent);
+        Radius[i] = Random.NextFloat(0.01f, 0.04f);
+        Spin[i] = Random.NextFloat(-4.0f, 4.0f);
+    }
+}
+
+const char* CullingScene::GetName() const noexcept
+{
+    return "culling";
+}
+
+void CullingScene::Load(Graphics& GFX)
+{
+    State = GFX.CreatePipelineState(LoadDefaultPipeline(GFX))->Id;
+    Vertices = CreateStaticBuffer(GFX, D3D11_BIND_VERTEX_BUFFER, TriangleVertices, sizeof(TriangleVertices));
+}
+
+void CullingScene::Simulate(FramePacket& Packet, float Time, JobSystem& Jobs)
+{
+    // The camera sweeps a Lissajous curve that stays inside the world
+    const float CameraX = (WorldExtent - 1.0f) * Sin(0.05f * Time);
+    const float CameraY = (WorldExtent - 1.0f) * Sin(0.031f * Time + 1.0f);
+    const Mat4 ViewProjection = Multiply(Mat4::Translation(-CameraX, -CameraY, 0.0f), Mat4::Orthographic(2.0f, 2.0f, -1.0f, 1.0f));
+
+    const SphereStreams Bounds = {X.data(), Y.data(), Z.data(), Radius.data()};
+    const size_t VisibleCount = Culler.CullSpheres(Jobs, Frustum::FromMatrix(ViewProjection), Bounds, ObjectCount, Visible.data());
+    const size_t DrawCount = std::min(VisibleCount, MaxDraws);
+
+    Packet.Chunks.resize(GetChunkCount(DrawCount, ObjectsPerChunk));
+    Jobs.ParallelFor(DrawCount, ObjectsPerChunk, [&](size_t Begin, size_t End, unsigned int)
+    {
+        CommandList& List = Packet.Chunks[Begin / ObjectsPerChunk];
+        List.SetPipelineState(State);
+        List.SetVertexBuffer(Vertices, sizeof(Vertex));
+
+        // Gather the visible objects of the chunk into batch form
+        const size_t Count = End - Begin;
+        float ChunkX[ObjectsPerChunk];
+        float ChunkY[ObjectsPerChunk];
+        float Scales[ObjectsPerChunk];
+        float Angles[ObjectsPerChunk];
+        Mat4 Transforms[ObjectsPerChunk];
+        for (size_t i = 0; i < Count; i++)
+        {
+            const uint32_t Object = Visible[Begin + i];
+            ChunkX[i] = X[Object];
+            ChunkY[i] = Y[Object];
+            Scales[i] = Radius[Object];
+            Angles[i] = Spin[Object] * Time;
+        }
+        ComposeTransforms2D(ChunkX, ChunkY, Scales, Angles, Transforms, Count);
+        MultiplyMatrices(Transforms, ViewProjection, Transforms, Count);
+        for (size_t i = 0; i < Count; i++)
+        {
+            List.SetDrawConstants(&Transforms[i], sizeof(Mat4));
+            List.Draw((UINT)std::size(TriangleVertices));
+        }
+    });
+
+    Packet.Statistics.Add("objects", static_cast<double>(ObjectCount));
+    Packet.Statistics.Add("visible", static_cast<double>(VisibleCount));
+    Packet.Statistics.Add("drawn", static_cast<double>(DrawCount));
+}
+
+// Occlusion
+
+OcclusionScene::OcclusionScene(uint32_t Seed)
+    : Occlusion(256u, 192u)
+{
+    SceneRandom Random(Seed);
+    X.resize(ObjectCount);
+    Y.resize(ObjectCount);
+    Z.resize(ObjectCount);
+    Extent.resize(ObjectCount);
+    Spin.resize(ObjectCount);
+    Visible.resize(ObjectCount);
+    for (size_t i = 0; i < ObjectCount; i++)
+    {
+        // Spread over roughly what the camera sees at that distance
+        Z[i] = Random.NextFloat(30.0f, 200.0f);
+        X[i] = Random.NextFloat(-0.7f, 0.7f) * Z[i];
+        Y[i] = Random.NextFloat(-0.5f, 0.5f) * Z[i];
+        Extent[i] = Random.NextFloat(0.3f, 1.0f);
+        Spin[i] = Random.NextFloat(-4.0f, 4.0f);
+    }
+    for (size_t i = 0; i < WallCount; i++)
+    {
+        const Mat4 Size = Mat4::Scaling(Random.NextFloat(2.0f, 5.0f), Random.NextFloat(1.5f, 4.0f), 1.0f);
+        const Mat4 Place = Mat4::Translation(Random.NextFloat(-15.0f, 15.0f), Random.NextFloat(-10.0f, 10.0f), Random.NextFloat(15.0f, 25.0f));
+        Walls.push_back(Multiply(Size, Place));
+    }
+}
+
+const char* OcclusionScene::GetName() const noexcept
+{
+    return "occlusion";
+}
+
+void OcclusionScene::Load(Graphics& GFX)
+{
+    State = GFX.CreatePipelineState(LoadMeshPipeline(GFX))->Id;
+    Triangle = CreateStaticBuffer(GFX, D3D11_BIND_VERTEX_BUFFER, TriangleCorners, sizeof(TriangleCorners));
+    Quad = CreateStaticBuffer(GFX, D3D11_BIND_VERTEX_BUFFER, QuadCorners, sizeof(QuadCorners));
+}
+
+void OcclusionScene::Simulate(FramePacket& Packet, float Time, JobSystem& Jobs)
+{
+    // The camera sways sideways and turns a little, so objects keep moving behind the walls
+    const Vec3 Eye = {4.0f * Sin(0.3f * Time), 2.0f * Sin(0.23f * Time), 0.0f};
+    const Vec3 Target = {Eye.X + 3.0f * Sin(0.17f * Time), Eye.Y, 10.0f};
+    const Mat4 ViewProjection = Multiply(Mat4::LookAt(Eye, Target, {0.0f, 1.0f, 0.0f}), Mat4::Perspective(1.0f, 4.0f / 3.0f, 0.5f, 250.0f));
+
+    const BoxStreams Bounds = {X.data(), Y.data(), Z.data(), Extent.data(), Extent.data(), Extent.data()};
+    const size_t InFrustum = Culler.CullBoxes(Jobs, Frustum::FromMatrix(ViewProjection), Bounds, ObjectCount, Visible.data());
+
+    Occlusion.Begin(ViewProjection);
+    for (const Mat4& Wall : Walls)
+    {
+        Occlusion.AddOccluder(QuadCorners, QuadIndices, std::size(QuadIndices), Wall);
+    }
+    Occlusion.Rasterize(&Jobs);
+    const size_t Unoccluded = Occlusion.CullBoxes(Bounds, Visible.data(), InFrustum, Visible.data(), &Jobs);
+    const size_t DrawCount = std::min(Unoccluded, MaxDraws);
+    SetViewProjection(Packet, ViewProjection);
+
+    // The walls go in the first chunk, so the depth test rejects what peeks out least
+    Packet.Chunks.resize(GetChunkCount(DrawCount, ObjectsPerChunk) + 1u);
+    CommandList& WallList = Packet.Chunks[0];
+    WallList.SetPipelineState(State);
+    WallList.SetVertexBuffer(Quad, sizeof(Vec3));
+    for (const Mat4& Wall : Walls)
+    {
+        WallList.SetDrawConstants(&Wall, sizeof(Mat4));
+        WallList.Draw((UINT)std::size(QuadCorners));
+    }
+
+    Jobs.ParallelFor(DrawCount, ObjectsPerChunk, [&](size_t Begin, size_t End, unsigned int)
+    {
+        CommandList& List = Packet.Chunks[Begin / ObjectsPerChunk + 1u];
+        List.SetPipelineState(State);
+        List.SetVertexBuffer(Triangle, sizeof(Vec3));
+
+        const size_t Count = End - Begin;
+        float ChunkX[ObjectsPerChunk];
+        float ChunkY[ObjectsPerChunk];
+        float Scales[ObjectsPerChunk];
+        float Angles[ObjectsPerChunk];
+        Mat4 Worlds[ObjectsPerChunk];
+        for (size_t i = 0; i < Count; i++)
+        {
+            const uint32_t Object = Visible[Begin + i];
+            ChunkX[i] = X[Object];
+            ChunkY[i] = Y[Object];
+            Scales[i] = Extent[Object];
+            Angles[i] = Spin[Object] * Time;
+        }
+        ComposeTransforms2D(ChunkX, ChunkY, Scales, Angles, Worlds, Count);
+        for (size_t i = 0; i < Count; i++)
+        {
+            // Transform2D leaves the object at z = 0
+            Worlds[i].M[3][2] = Z[Visible[Begin + i]];
+            List.SetDrawConstants(&Worlds[i], sizeof(Mat4));
+            List.Draw((UINT)std::size(TriangleCorners));
+        }
+    });
+
+    Packet.Statistics.Add("objects", static_cast<double>(ObjectCount));
+    Packet.Statistics.Add("in_frustum", static_cast<double>(InFrustum));
+    Packet.Statistics.Add("unoccluded", static_cast<double>(Unoccluded));
+    Packet.Statistics.Add("drawn", static_cast<double>(DrawCount));
+}
+
+// Level of detail
+
+LodScene::LodScene(uint32_t Seed)
+    : Lods({1.0f, 0.2f, TriangleBudget}), Seed(Seed)
+{
+    SceneRandom Random(Seed);
+    X.resize(ObjectCount);
+    Y.resize(ObjectCount);
+    Z.resize(ObjectCount);
+    Radius.resize(ObjectCount);
+    Spin.resize(ObjectCount);
+    MeshOf.assign(ObjectCount, 0u);
+    Visible.resize(ObjectCount);
+    for (size_t i = 0; i < ObjectCount; i++)
+    {
+        Z[i] = Random.NextFloat(5.0f, 400.0f);
+        X[i] = Random.NextFloat(-0.9f, 0.9f) * (Z[i] + 30.0f);
+        Y[i] = Random.NextFloat(-0.5f, 0.5f) * (Z[i] + 30.0f);
+        Radius[i] = Random.NextFloat(0.5f, 2.0f);
+        Spin[i] = Random.NextFloat(-1.0f, 1.0f);
+    }
+
+    // Level l joins every 2^l-th vertex, so a coarse quad spans 2^l cells and misses the
+    // jitter of the vertices inside. Errors are over the grid's radius, sqrt(2).
+    constexpr uint32_t Side = GridSize + 1u;
+    const float Cell = 2.0f / GridSize;
+    LodLevel Levels[LevelCount];
+    for (uint32_t l = 0; l < LevelCount; l++)
+    {
+        const uint32_t Stride = 1u << l;
+        Levels[l].FirstIndex = static_cast<uint32_t>(GridIndices.size());
+        for (uint32_t y = 0; y < GridSize; y += Stride)
+        {
+            for (uint32_t x = 0; x < GridSize; x += Stride)
+            {
+                const uint32_t i = y * Side + x;
+                const uint32_t Down = Stride * Side;
+                const uint32_t Quad[] = {i, i + Stride, i + Down, i + Down, i + Stride, i + Down + Stride};
+                GridIndices.insert(GridIndices.end(), std::begin(Quad), std::end(Quad));
+            }
+        }
+        Levels[l].IndexCount = static_cast<uint32_t>(GridIndices.size()) - Levels[l].FirstIndex;
+        Levels[l].Error = l == 0u ? 0.0f : 0.25f * Cell * static_cast<float>(Stride) / std::sqrt(2.0f);
+    }
+    Lods.AddMesh(Levels, LevelCount);
+}
+
+const char* LodScene::GetName() const noexcept
+{
+    return "lod";
+}
+
+void LodScene::Load(Graphics& GFX)
+{
+    State = GFX.CreatePipelineState(LoadMeshPipeline(GFX))->Id;
+    Indices = CreateStaticBuffer(GFX, D3D11_BIND_INDEX_BUFFER, GridIndices.data(), GridIndices.size() * sizeof(uint32_t));
+
+    // Jitter stays within a quarter cell so triangles never flip, as in HugeMeshScene
+    constexpr uint32_t Side = GridSize + 1u;
+    const float Cell = 2.0f / GridSize;
+    SceneRandom Random(Seed);
+    std::vector<Vec3> GridVertices(static_cast<size_t>(Side) * Side);
+    for (uint32_t y = 0; y < Side; y++)
+    {
+        for (uint32_t x = 0; x < Side; x++)
+        {
+            Vec3& v = GridVertices[static_cast<size_t>(y) * Side + x];
+            v.X = -1.0f + x * Cell + Random.NextFloat(-0.25f, 0.25f) * Cell;
+            v.Y = 1.0f - y * Cell + Random.NextFloat(-0.25f, 0.25f) * Cell;
+            v.Z = 0.0f;
+        }
+    }
+    Vertices = CreateStaticBuffer(GFX, D3D11_BIND_VERTEX_BUFFER, GridVertices.data(), GridVertices.size() * sizeof(Vec3));
+}
+
+void LodScene::Simulate(FramePacket& Packet, float Time, JobSystem& Jobs)
+{
+    // Flying along the field makes objects cross the level thresholds in both directions
+    const Vec3 Eye = {0.0f, 0.0f, -25.0f + 25.0f * Sin(0.2f * Time)};
+    const Mat4 Projection = Mat4::Perspective(1.0f, 16.0f / 9.0f, 0.5f, 500.0f);
+    const Mat4 ViewProjection = Multiply(Mat4::LookAt(Eye, {Eye.X, Eye.Y, Eye.Z + 1.0f}, {0.0f, 1.0f, 0.0f}), Projection);
+
+    const SphereStreams Bounds = {X.data(), Y.data(), Z.data(), Radius.data()};
+    const float PixelScale = LodSelector::GetPixelScale(Projection, ReferenceHeight);
+    const size_t VisibleCount = Lods.CullAndSelect(Jobs, Frustum::FromMatrix(ViewProjection), Eye, PixelScale, Bounds, MeshOf.data(), ObjectCount, Visible.data());
+    const uint8_t* const Levels = Lods.GetLevels();
+    SetViewProjection(Packet, ViewProjection);
+
+    Packet.Chunks.resize(GetChunkCount(VisibleCount, ObjectsPerChunk));
+    Jobs.ParallelFor(VisibleCount, ObjectsPerChunk, [&](size_t Begin, size_t End, unsigned int)
+    {
+        CommandList& List = Packet.Chunks[Begin / ObjectsPerChunk];
+        List.SetPipelineState(State);
+        List.SetVertexBuffer(Vertices, sizeof(Vec3));
+        List.SetIndexBuffer(Indices, true);
+
+        const size_t Count = End - Begin;
+        float ChunkX[ObjectsPerChunk];
+        float ChunkY[ObjectsPerChunk];
+        float Scales[ObjectsPerChunk];
+        float Angles[ObjectsPerChunk];
+        Mat4 Worlds[ObjectsPerChunk];
+        for (size_t i = 0; i < Count; i++)
+        {
+            // The grid's bounding sphere has radius sqrt(2)
+            const uint32_t Object = Visible[Begin + i];
+            ChunkX[i] = X[Object];
+            ChunkY[i] = Y[Object];
+            Scales[i] = Radius[Object] * 0.70710678f;
+            Angles[i] = Spin[Object] * Time;
+        }
+        ComposeTransforms2D(ChunkX, ChunkY, Scales, Angles, Worlds, Count);
+        for (size_t i = 0; i < Count; i++)
+        {
+            const LodLevel& Level = Lods.GetLevel(0u, Levels[Visible[Begin + i]]);
+            Worlds[i].M[3][2] = Z[Visible[Begin + i]];
+            List.SetDrawConstants(&Worlds[i], sizeof(Mat4));
+            List.DrawIndexed(Level.IndexCount, Level.FirstIndex);
+        }
+    });
+
+    Packet.Statistics.Add("objects", static_cast<double>(ObjectCount));
+    Packet.Statistics.Add("visible", static_cast<double>(VisibleCount));
+    Packet.Statistics.Add("triangles", static_cast<double>(Lods.GetTriangleCount()));
+    Packet.Statistics.Add("full_detail_triangles", static_cast<double>(VisibleCount) * GridSize * GridSize * 2.0);
+    Packet.Statistics.Add("pixel_error", static_cast<double>(Lods.GetPixelError()));
+}
+
+// Meshlets
+
+MeshletScene::MeshletScene(uint32_t Seed)
+    : Occlusion(384u, 216u)
+{
+    // Bumps keep the surface between radius 0.92 and 1, the shell at 0.9 stays inside it
+    // and inside the flat triangles between its vertices. The shell is coarse so its
+    // triangles cover whole pixels of the depth buffer even on distant spheres.
+    std::vector<uint32_t> SphereIndices;
+    AddCubeSphere(FaceSize, Positions, SphereIndices);
+    for (Vec3& p : Positions)
+    {
+        const float Bump = Sin(7.0f * p.X) * Sin(6.0f * p.Y + 1.0f) * Sin(5.0f * p.Z + 2.0f);
+        p = p * (0.96f + 0.04f * Bump);
+    }
+    Meshlets = BuildMeshlets(Positions.data(), Positions.size(), SphereIndices.data(), SphereIndices.size());
+    AddCubeSphere(ShellFaceSize, ShellPositions, ShellIndices);
+    for (Vec3& p : ShellPositions)
+    {
+        p = p * 0.9f;
+    }
+
+    SceneRandom Random(Seed);
+    X.resize(InstanceCount);
+    Y.resize(InstanceCount);
+    Z.resize(InstanceCount);
+    Radius.resize(InstanceCount);
+    Spin.resize(InstanceCount);
+    Worlds.resize(InstanceCount);
+    Visible.resize(InstanceCount);
+    for (size_t i = 0; i < InstanceCount; i++)
+    {
+        // Every other row shifts by half a column, so the gaps of one row show the next
+        const size_t Row = i / Columns;
+        const size_t Column = i % Columns;
+        X[i] = (static_cast<float>(Column) - 0.5f * static_cast<float>(Columns) + ((Row & 1u) ? 0.5f : 0.0f)) * 6.0f;
+        Y[i] = Random.NextFloat(-1.0f, 1.0f);
+        Z[i] = 20.0f + static_cast<float>(Row) * 6.0f;
+        Radius[i] = Random.NextFloat(2.0f, 3.0f);
+        Spin[i] = Random.NextFloat(-0.5f, 0.5f);
+    }
+}
+
+const char* MeshletScene::GetName() const noexcept
+{
+    return "meshlets";
+}
+
+void MeshletScene::Load(Graphics& GFX)
+{
+    State = GFX.CreatePipelineState(LoadMeshPipeline(GFX))->Id;
+    Vertices = CreateStaticBuffer(GFX, D3D11_BIND_VERTEX_BUFFER, Positions.data(), Positions.size() * sizeof(Vec3));
+    Indices = CreateStaticBuffer(GFX, D3D11_BIND_INDEX_BUFFER, Meshlets.Indices.data(), Meshlets.Indices.size() * sizeof(uint32_t));
+}
+
+void MeshletScene::Simulate(FramePacket& Packet, float Time, JobSystem& Jobs)
+{
+    // The camera sways across the front row at about the spheres' height, so the rows
+    // behind hide each other and other sides of the spheres turn to it
+    const Vec3 Eye = {20.0f * Sin(0.15f * Time), 1.0f + 1.5f * Sin(0.21f * Time), 0.0f};
+    const Mat4 ViewProjection = Multiply(Mat4::LookAt(Eye, {0.0f, 0.0f, 45.0f}, {0.0f, 1.0f, 0.0f}), Mat4::Perspective(1.0f, 16.0f / 9.0f, 0.5f, 200.0f));
+    for (size_t i = 0; i < InstanceCount; i++)
+    {
+        Worlds[i] = Mat4::Compose({X[i], Y[i], Z[i]}, Quat::FromAxisAngle({0.0f, 1.0f, 0.0f}, Spin[i] * Time), {Radius[i], Radius[i], Radius[i]});
+    }
+
+    // Shells of the spheres in view fill the depth buffer
+    const SphereStreams Bounds = {X.data(), Y.data(), Z.data(), Radius.data()};
+    const size_t InView = CullSpheres(Frustum::FromMatrix(ViewProjection), Bounds, InstanceCount, Visible.data());
+    Occlusion.Begin(ViewProjection);
+    for (size_t i = 0; i < InView; i++)
+    {
+        Occlusion.AddOccluder(ShellPositions.data(), ShellIndices.data(), ShellIndices.size(), Worlds[Visible[i]]);
+    }
+    Occlusion.Rasterize(&Jobs);
+
+    const size_t RangeCount = Culler.Cull(Meshlets, Worlds.data(), InstanceCount, ViewProjection, Eye, &Occlusion, &Jobs);
+    const MeshletCuller::DrawRange* Ranges = Culler.GetRanges();
+    const size_t DrawCount = std::min(RangeCount, MaxDraws);
+    SetViewProjection(Packet, ViewProjection);
+
+    Packet.Chunks.resize(GetChunkCount(DrawCount, RangesPerChunk));
+    Jobs.ParallelFor(DrawCount, RangesPerChunk, [&](size_t Begin, size_t End, unsigned int)
+    {
+        CommandList& List = Packet.Chunks[Begin / RangesPerChunk];
+        List.SetPipelineState(State);
+        List.SetVertexBuffer(Vertices, sizeof(Vec3));
+        List.SetIndexBuffer(Indices, true);
+        for (size_t i = Begin; i < End; i++)
+        {
+            // Ranges come grouped by placement, its world matrix stays bound until the next one
+            if (i == Begin || Ranges[i].Instance != Ranges[i - 1u].Instance)
+            {
+                List.SetDrawConstants(&Worlds[Ranges[i].Instance], sizeof(Mat4));
+            }
+            List.DrawIndexed(Ranges[i].IndexCount, Ranges[i].FirstIndex);
+        }
+    });
+
+    const MeshletCuller::Counts& Counts = Culler.GetCounts();
+    Packet.Statistics.Add("meshlets", static_cast<double>(Counts.Meshlets));
+    Packet.Statistics.Add("in_frustum", static_cast<double>(Counts.InFrustum));
+    Packet.Statistics.Add("front_facing", static_cast<double>(Counts.FrontFacing));
+    Packet.Statistics.Add("unoccluded", static_cast<double>(Counts.Unoccluded));
+    Packet.Statistics.Add("triangles", static_cast<double>(Counts.Triangles));
+    Packet.Statistics.Add("mesh_triangles", static_cast<double>(InstanceCount * (Meshlets.Indices.size() / 3u)));
+    Packet.Statistics.Add("ranges", static_cast<double>(RangeCount));
+    Packet.Statistics.Add("drawn", static_cast<double>(DrawCount));
+}
\ No newline at end of file
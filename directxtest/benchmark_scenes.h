@@ -0,0 +1,278 @@
+#pragma once
+#include "scene.h"
+#include "culling.h"
+#include "occlusion.h"
+#include "lod.h"
+#include "meshlet.h"
+#include <vector>
+
+// The original spinning triangle
+class TriangleScene : public Scene
+{
+public:
+    const char* GetName() const noexcept override;
+    void Load(Graphics& GFX) override;
+    void Simulate(FramePacket& Packet, float Time, JobSystem& Jobs) override;
+private:
+    const Graphics* GFX = nullptr;
+};
+
+// Thousands of small objects, one draw and one constant block each. Stresses per-draw
+// CPU cost: recording, constant streaming and command execution.
+class TinyDrawsScene : public Scene
+{
+public:
+    // Bounded by the per-draw constant ring, which holds FramesInFlight frames of blocks
+    static constexpr size_t ObjectCount = 4096u;
+    static constexpr size_t ObjectsPerChunk = 256u;
+public:
+    explicit TinyDrawsScene(uint32_t Seed);
+    const char* GetName() const noexcept override;
+    void Load(Graphics& GFX) override;
+    void Simulate(FramePacket& Packet, float Time, JobSystem& Jobs) override;
+private:
+    // Structure of arrays, the layout ComposeTransforms2D reads
+    std::vector<float> X;
+    std::vector<float> Y;
+    std::vector<float> Scale;
+    std::vector<float> Spin;
+    uint32_t State = 0u;
+    BufferHandle Vertices;
+};
+
+// A handful of dense static grids. Stresses vertex throughput with almost no CPU work.
+class HugeMeshScene : public Scene
+{
+public:
+    static constexpr size_t MeshCount = 4u;
+    static constexpr uint32_t GridSize = 512u;     // Quads per side, 2 * 512^2 triangles per mesh
+public:
+    explicit HugeMeshScene(uint32_t Seed);
+    const char* GetName() const noexcept override;
+    void Load(Graphics& GFX) override;
+    void Simulate(FramePacket& Packet, float Time, JobSystem& Jobs) override;
+private:
+    uint32_t Seed;
+    uint32_t State = 0u;
+    BufferHandle Vertices[MeshCount];
+    BufferHandle Indices;
+    uint32_t IndexCount = 0u;
+};
+
+// Stacked screen-sized quads with additive blending. Stresses fill rate and blending.
+class OverdrawScene : public Scene
+{
+public:
+    static constexpr size_t LayerCount = 64u;
+public:
+    explicit OverdrawScene(uint32_t Seed);
+    const char* GetName() const noexcept override;
+    void Load(Graphics& GFX) override;
+    void Simulate(FramePacket& Packet, float Time, JobSystem& Jobs) override;
+private:
+    struct Layer
+    {
+        float X;
+        float Y;
+        float Scale;
+    };
+    std::vector<Layer> Layers;
+    uint32_t State = 0u;
+    BufferHandle Vertices;
+};
+
+// Small draws that switch pipeline state every time, cycling through every blend, cull,
+// fill and depth combination. Stresses state validation and the PSO delta path.
+class StateChangeScene : public Scene
+{
+public:
+    static constexpr size_t DrawCount = 2048u;
+    static constexpr size_t DrawsPerChunk = 256u;
+public:
+    explicit StateChangeScene(uint32_t Seed);
+    const char* GetName() const noexcept override;
+    void Load(Graphics& GFX) override;
+    void Simulate(FramePacket& Packet, float Time, JobSystem& Jobs) override;
+private:
+    struct Draw
+    {
+        float X;
+        float Y;
+        uint32_t State;
+    };
+    uint32_t Seed;
+    std::vector<Draw> Draws;
+    std::vector<uint32_t> States;
+    BufferHandle Vertices;
+};
+
+// Ribbons regenerated on the CPU every frame and streamed through the dynamic vertex
+// ring. Stresses vertex generation, payload copies and buffer mapping.
+class StreamingScene : public Scene
+{
+public:
+    static constexpr size_t RibbonCount = 256u;
+    static constexpr size_t RibbonVertices = 512u;
+    static constexpr size_t RibbonsPerChunk = 16u;
+public:
+    explicit StreamingScene(uint32_t Seed);
+    const char* GetName() const noexcept override;
+    void Load(Graphics& GFX) override;
+    void Simulate(FramePacket& Packet, float Time, JobSystem& Jobs) override;
+private:
+    struct Ribbon
+    {
+        float Y;
+        float Amplitude;
+        float Frequency;
+        float Phase;
+    };
+    std::vector<Ribbon> Ribbons;
+    uint32_t State = 0u;
+};
+
+// A million small objects spread over a world far larger than the screen, seen by a
+// camera that pans across it. Frustum culling runs between the update and the draw
+// recording, so only the few visible objects are recorded. Stresses the culling stage.
+class CullingScene : public Scene
+{
+public:
+    static constexpr size_t ObjectCount = 1u << 20u;
+    // The world spans [-WorldExtent, WorldExtent] on both axes, the screen covers 2 x 2
+    static constexpr float WorldExtent = 32.0f;
+    // Same bound as TinyDrawsScene, the per-draw constant ring
+    static constexpr size_t MaxDraws = 4096u;
+    static constexpr size_t ObjectsPerChunk = 256u;
+public:
+    explicit CullingScene(uint32_t Seed);
+    const char* GetName() const noexcept override;
+    void Load(Graphics& GFX) override;
+    void Simulate(FramePacket& Packet, float Time, JobSystem& Jobs) override;
+private:
+    // Bounding spheres, the radius doubles as the object's scale
+    std::vector<float> X;
+    std::vector<float> Y;
+    std::vector<float> Z;
+    std::vector<float> Radius;
+    std::vector<float> Spin;
+    std::vector<uint32_t> Visible;
+    FrustumCuller Culler;
+    uint32_t State = 0u;
+    BufferHandle Vertices;
+};
+
+// Small objects scattered deep in front of a perspective camera, with a row of large
+// walls between them. After frustum culling the walls are rasterized into a software
+// depth buffer and every remaining object is tested against it, so only objects that
+// peek past the walls are recorded. Everything draws with the depth-tested mesh
+// pipeline, walls first. Stresses the occlusion stage.
+class OcclusionScene : public Scene
+{
+public:
+    static constexpr size_t ObjectCount = 1u << 16u;
+    static constexpr size_t WallCount = 24u;
+    static constexpr size_t MaxDraws = 4096u;
+    static constexpr size_t ObjectsPerChunk = 256u;
+public:
+    explicit OcclusionScene(uint32_t Seed);
+    const char* GetName() const noexcept override;
+    void Load(Graphics& GFX) override;
+    void Simulate(FramePacket& Packet, float Time, JobSystem& Jobs) override;
+private:
+    // Bounding boxes, the extent doubles as the object's scale
+    std::vector<float> X;
+    std::vector<float> Y;
+    std::vector<float> Z;
+    std::vector<float> Extent;
+    std::vector<float> Spin;
+    std::vector<Mat4> Walls;
+    std::vector<uint32_t> Visible;
+    FrustumCuller Culler;
+    OcclusionBuffer Occlusion;
+    uint32_t State = 0u;
+    BufferHandle Triangle;
+    BufferHandle Quad;
+};
+
+// Jittered grid meshes spread deep in front of a camera that flies back and forth. The
+// grid has a level of detail per power of two stride, picked for every object in the
+// culling pass from its error on screen and kept under a triangle budget. The statistics
+// show the triangles it saves over full detail, the lod.* microbenchmark cases time the
+// selection at scale. The grids are flat but placed in depth with the mesh pipeline.
+class LodScene : public Scene
+{
+public:
+    // Every object can be drawn, the per-draw constant ring bounds the count
+    static constexpr size_t ObjectCount = 4096u;
+    static constexpr uint32_t GridSize = 64u;
+    // Strides 1 to 32
+    static constexpr uint32_t LevelCount = 6u;
+    static constexpr uint64_t TriangleBudget = 1u << 16u;
+    // Viewport height the pixel error refers to
+    static constexpr uint32_t ReferenceHeight = 720u;
+    static constexpr size_t ObjectsPerChunk = 256u;
+public:
+    explicit LodScene(uint32_t Seed);
+    const char* GetName() const noexcept override;
+    void Load(Graphics& GFX) override;
+    void Simulate(FramePacket& Packet, float Time, JobSystem& Jobs) override;
+private:
+    // Bounding spheres, the radius doubles as the object's scale
+    std::vector<float> X;
+    std::vector<float> Y;
+    std::vector<float> Z;
+    std::vector<float> Radius;
+    std::vector<float> Spin;
+    std::vector<uint32_t> MeshOf;
+    std::vector<uint32_t> Visible;
+    LodSelector Lods;
+    uint32_t Seed;
+    uint32_t State = 0u;
+    // Every level's indices one after the other, uploaded by Load
+    std::vector<uint32_t> GridIndices;
+    BufferHandle Vertices;
+    BufferHandle Indices;
+};
+
+// Bumpy spheres in rows in front of a camera that sways around them, all placements of
+// one mesh of about 28k triangles split into meshlets. Every frame the meshlets are culled
+// by frustum, by normal cone and against a depth buffer holding a coarse shell inside
+// each sphere, and the surviving index ranges are drawn straight from the static index
+// buffer with the depth-tested mesh pipeline. Most of each sphere faces away or hides
+// behind the row in front.
+class MeshletScene : public Scene
+{
+public:
+    // Cells along the side of each cube face the sphere is made of
+    static constexpr uint32_t FaceSize = 48u;
+    static constexpr uint32_t ShellFaceSize = 2u;
+    static constexpr size_t Columns = 12u;
+    static constexpr size_t Rows = 8u;
+    static constexpr size_t InstanceCount = Columns * Rows;
+    static constexpr size_t MaxDraws = 4096u;
+    static constexpr size_t RangesPerChunk = 256u;
+public:
+    explicit MeshletScene(uint32_t Seed);
+    const char* GetName() const noexcept override;
+    void Load(Graphics& GFX) override;
+    void Simulate(FramePacket& Packet, float Time, JobSystem& Jobs) override;
+private:
+    std::vector<Vec3> Positions;
+    MeshletMesh Meshlets;
+    // Occluder inside the unit sphere every placement is scaled from
+    std::vector<Vec3> ShellPositions;
+    std::vector<uint32_t> ShellIndices;
+    // Bounding spheres of the placements
+    std::vector<float> X;
+    std::vector<float> Y;
+    std::vector<float> Z;
+    std::vector<float> Radius;
+    std::vector<float> Spin;
+    std::vector<Mat4> Worlds;
+    std::vector<uint32_t> Visible;
+    MeshletCuller Culler;
+    OcclusionBuffer Occlusion;
+    uint32_t State = 0u;
+    BufferHandle Vertices;
+    BufferHandle Indices;
+};
\ No newline at end of file
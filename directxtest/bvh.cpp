@@ -0,0 +1,793 @@
+#include "bvh.h"
+#include "simd_lanes.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+    using Box = Bvh::Box;
+
+    constexpr float Infinity = std::numeric_limits<float>::infinity();
+    // Unused node slots keep this box, every overlap or plane test fails on it
+    constexpr Box EmptyBox = {{Infinity, Infinity, Infinity}, {-Infinity, -Infinity, -Infinity}};
+
+#if defined(SIMD_MATH_AVX2) || defined(SIMD_MATH_SSE)
+    using SlotLanes = SseLanes;
+#else
+    using SlotLanes = ScalarLanes;
+#endif
+
+    // Grows b to contain Other
+    void Grow(Box& b, const Box& Other) noexcept
+    {
+        b.Min.X = std::min(b.Min.X, Other.Min.X);
+        b.Min.Y = std::min(b.Min.Y, Other.Min.Y);
+        b.Min.Z = std::min(b.Min.Z, Other.Min.Z);
+        b.Max.X = std::max(b.Max.X, Other.Max.X);
+        b.Max.Y = std::max(b.Max.Y, Other.Max.Y);
+        b.Max.Z = std::max(b.Max.Z, Other.Max.Z);
+    }
+
+    float Area(const Box& b) noexcept
+    {
+        const float x = std::max(b.Max.X - b.Min.X, 0.0f);
+        const float y = std::max(b.Max.Y - b.Min.Y, 0.0f);
+        const float z = std::max(b.Max.Z - b.Min.Z, 0.0f);
+        return 2.0f * (x * y + y * z + z * x);
+    }
+
+    // Twice the center, the factor does not matter for binning
+    float Centroid(const Box& b, uint32_t Axis) noexcept
+    {
+        return Axis == 0u ? b.Min.X + b.Max.X : Axis == 1u ? b.Min.Y + b.Max.Y : b.Min.Z + b.Max.Z;
+    }
+
+    bool IsInside(const Frustum& View, const Box& b) noexcept
+    {
+        for (const Vec4& p : View.Planes)
+        {
+            const float x = p.X > 0.0f ? b.Max.X : b.Min.X;
+            const float y = p.Y > 0.0f ? b.Max.Y : b.Min.Y;
+            const float z = p.Z > 0.0f ? b.Max.Z : b.Min.Z;
+            if (p.X * x + p.Y * y + p.Z * z + p.W < 0.0f)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool Overlaps(const Box& a, const Box& b) noexcept
+    {
+        return a.Min.X <= b.Max.X && a.Max.X >= b.Min.X &&
+            a.Min.Y <= b.Max.Y && a.Max.Y >= b.Min.Y &&
+            a.Min.Z <= b.Max.Z && a.Max.Z >= b.Min.Z;
+    }
+
+    // Bit i set for every slot of the node whose box is not fully outside a plane of View
+    template<typename NodeType>
+    uint32_t FrustumSlots(const NodeType& n, const Frustum& View) noexcept
+    {
+        using L = SlotLanes;
+        uint32_t Mask = 0u;
+        for (size_t i = 0; i < 4u; i += L::Width)
+        {
+            uint32_t Inside = (1u << L::Width) - 1u;
+            for (const Vec4& p : View.Planes)
+            {
+                // Corner farthest along the normal
+                const L x = L::Load((p.X > 0.0f ? n.MaxX : n.MinX) + i);
+                const L y = L::Load((p.Y > 0.0f ? n.MaxY : n.MinY) + i);
+                const L z = L::Load((p.Z > 0.0f ? n.MaxZ : n.MinZ) + i);
+                Inside &= MaskGreaterEqual(x * L::Set(p.X) + y * L::Set(p.Y) + z * L::Set(p.Z) + L::Set(p.W), L::Set(0.0f));
+            }
+            Mask |= Inside << i;
+        }
+        return Mask;
+    }
+
+    // Bit i set for every slot of the node whose box overlaps Region
+    template<typename NodeType>
+    uint32_t OverlapSlots(const NodeType& n, const Box& Region) noexcept
+    {
+        using L = SlotLanes;
+        uint32_t Mask = 0u;
+        for (size_t i = 0; i < 4u; i += L::Width)
+        {
+            const uint32_t x = MaskGreaterEqual(L::Set(Region.Max.X), L::Load(n.MinX + i)) & MaskGreaterEqual(L::Load(n.MaxX + i), L::Set(Region.Min.X));
+            const uint32_t y = MaskGreaterEqual(L::Set(Region.Max.Y), L::Load(n.MinY + i)) & MaskGreaterEqual(L::Load(n.MaxY + i), L::Set(Region.Min.Y));
+            const uint32_t z = MaskGreaterEqual(L::Set(Region.Max.Z), L::Load(n.MinZ + i)) & MaskGreaterEqual(L::Load(n.MaxZ + i), L::Set(Region.Min.Z));
+            Mask |= (x & y & z) << i;
+        }
+        return Mask;
+    }
+
+    // Bit i set for every slot of the node whose box the ray enters within [0, MaxDistance],
+    // Entry[i] receives where it enters. The near side of each slab is picked by the sign
+    // of the direction, which also makes unused slots fail.
+    template<typename NodeType>
+    uint32_t RaySlots(const NodeType& n, const Vec3& Origin, const Vec3& InverseDirection, float MaxDistance, float* Entry) noexcept
+    {
+        using L = SlotLanes;
+        uint32_t Mask = 0u;
+        for (size_t i = 0; i < 4u; i += L::Width)
+        {
+            const L NearX = (L::Load((InverseDirection.X >= 0.0f ? n.MinX : n.MaxX) + i) - L::Set(Origin.X)) * L::Set(InverseDirection.X);
+            const L NearY = (L::Load((InverseDirection.Y >= 0.0f ? n.MinY : n.MaxY) + i) - L::Set(Origin.Y)) * L::Set(InverseDirection.Y);
+            const L NearZ = (L::Load((InverseDirection.Z >= 0.0f ? n.MinZ : n.MaxZ) + i) - L::Set(Origin.Z)) * L::Set(InverseDirection.Z);
+            const L FarX = (L::Load((InverseDirection.X >= 0.0f ? n.MaxX : n.MinX) + i) - L::Set(Origin.X)) * L::Set(InverseDirection.X);
+            const L FarY = (L::Load((InverseDirection.Y >= 0.0f ? n.MaxY : n.MinY) + i) - L::Set(Origin.Y)) * L::Set(InverseDirection.Y);
+            const L FarZ = (L::Load((InverseDirection.Z >= 0.0f ? n.MaxZ : n.MinZ) + i) - L::Set(Origin.Z)) * L::Set(InverseDirection.Z);
+            const L Near = Max(Max(NearX, NearY), Max(NearZ, L::Set(0.0f)));
+            const L Far = Min(Min(FarX, FarY), Min(FarZ, L::Set(MaxDistance)));
+            Near.Store(Entry + i);
+            Mask |= MaskGreaterEqual(Far, Near) << i;
+        }
+        return Mask;
+    }
+
+    // Axis-parallel rays get a huge but finite inverse, so no slab computes 0 * infinity
+    float InverseOf(float d) noexcept
+    {
+        return 1.0f / (std::fabs(d) > 1e-30f ? d : std::copysign(1e-30f, d));
+    }
+
+    // Item counts and bounds per bin along the split axis
+    struct Bins
+    {
+        Box Bounds[Bvh::BinCount];
+        uint32_t Counts[Bvh::BinCount];
+    };
+
+    // Accumulate(Partial, Begin, End) over slices of [Begin, End), on the job system for
+    // large ranges, then Merge(Total, Partial) in slice order
+    template<typename T, typename A, typename M>
+    T Reduce(JobSystem* Jobs, size_t Begin, size_t End, const T& Zero, A&& Accumulate, M&& Merge)
+    {
+        const size_t Count = End - Begin;
+        T Total = Zero;
+        if (Jobs == nullptr || Count <= Bvh::Grain)
+        {
+            Accumulate(Total, Begin, End);
+            return Total;
+        }
+        std::vector<T> Partials((Count + Bvh::Grain - 1u) / Bvh::Grain, Zero);
+        Jobs->ParallelFor(Count, Bvh::Grain, [&](size_t SliceBegin, size_t SliceEnd, unsigned int)
+        {
+            Accumulate(Partials[SliceBegin / Bvh::Grain], Begin + SliceBegin, Begin + SliceEnd);
+        });
+        for (const T& Partial : Partials)
+        {
+            Merge(Total, Partial);
+        }
+        return Total;
+    }
+}
+
+void Bvh::Build(const Box* Bounds, size_t Count, JobSystem* Jobs)
+{
+    if (Count >= LeafBit)
+    {
+        throw std::length_error("Too many objects for a Bvh");
+    }
+    Items.resize(Count);
+    const auto Fill = [&](size_t Begin, size_t End)
+    {
+        for (size_t i = Begin; i < End; i++)
+        {
+            Items[i] = {Bounds[i], static_cast<uint32_t>(i)};
+        }
+    };
+    if (Jobs != nullptr)
+    {
+        Jobs->ParallelFor(Count, Grain, [&](size_t Begin, size_t End, unsigned int)
+        {
+            Fill(Begin, End);
+        });
+    }
+    else
+    {
+        Fill(0u, Count);
+    }
+    LeafNode.resize(Count);
+    PositionOf.resize(Count);
+    BuildAll(Jobs);
+}
+
+void Bvh::Refit(const Box* Bounds, const uint32_t* Moved, size_t MovedCount)
+{
+    for (size_t i = 0; i < MovedCount; i++)
+    {
+        const uint32_t Position = PositionOf[Moved[i]];
+        Items[Position].Bounds = Bounds[Moved[i]];
+        for (uint32_t n = LeafNode[Position]; n != NoParent && !Dirty[n]; n = Info[n].Parent)
+        {
+            Dirty[n] = 1u;
+            DirtyNodes.push_back(n);
+        }
+    }
+
+    // Children always come after their parent
+    std::sort(DirtyNodes.begin(), DirtyNodes.end(), std::greater<uint32_t>());
+    for (const uint32_t n : DirtyNodes)
+    {
+        RefitNode(n);
+        Dirty[n] = 0u;
+    }
+    DirtyNodes.clear();
+}
+
+void Bvh::Refit(const Box* Bounds, JobSystem* Jobs)
+{
+    const auto Gather = [&](size_t Begin, size_t End)
+    {
+        for (size_t i = Begin; i < End; i++)
+        {
+            Items[i].Bounds = Bounds[Items[i].Object];
+        }
+    };
+    if (Jobs != nullptr)
+    {
+        Jobs->ParallelFor(Items.size(), Grain, [&](size_t Begin, size_t End, unsigned int)
+        {
+            Gather(Begin, End);
+        });
+    }
+    else
+    {
+        Gather(0u, Items.size());
+    }
+
+    for (size_t n = Nodes.size(); n-- > 0u;)
+    {
+        if (Info[n].Live)
+        {
+            RefitNode(static_cast<uint32_t>(n));
+        }
+    }
+}
+
+size_t Bvh::RebuildDegraded(JobSystem* Jobs)
+{
+    if (Nodes.empty())
+    {
+        return 0u;
+    }
+
+    // Topmost degraded subtrees, a single node of leaves gains nothing from a rebuild
+    std::vector<uint32_t> Degraded;
+    std::vector<uint32_t> Stack = {0u};
+    while (!Stack.empty())
+    {
+        const uint32_t n = Stack.back();
+        Stack.pop_back();
+        if (Info[n].End - Info[n].Begin <= 4u * LeafSize)
+        {
+            continue;
+        }
+        if (Area(GetNodeBounds(n)) > RebuildGrowth * Info[n].BuildArea)
+        {
+            Degraded.push_back(n);
+            continue;
+        }
+        for (size_t Slot = 0; Slot < 4u; Slot++)
+        {
+            if (!(Nodes[n].Child[Slot] & LeafBit))
+            {
+                Stack.push_back(Nodes[n].Child[Slot]);
+            }
+        }
+    }
+    if (Degraded.empty())
+    {
+        return 0u;
+    }
+    if (Degraded.front() == 0u)
+    {
+        BuildAll(Jobs);
+        return 1u;
+    }
+
+    for (const uint32_t n : Degraded)
+    {
+        const NodeInfo Old = Info[n];
+        const Range Whole = {Old.Begin, Old.End, GetNodeBounds(n)};
+        MarkDead(n);
+        const uint32_t Root = BuildSubtree(Whole, Old.Depth, Old.Parent, Jobs);
+        Node& Parent = Nodes[Old.Parent];
+        *std::find(Parent.Child, Parent.Child + 4, n) = Root;
+        IndexItems(Root);
+    }
+    Dirty.resize(Nodes.size(), 0u);
+
+    // Rebuilt subtrees are appended, so compact once most of the array is unreachable
+    if (DeadNodes > Nodes.size() - DeadNodes)
+    {
+        BuildAll(Jobs);
+    }
+    return Degraded.size();
+}
+
+size_t Bvh::CullFrustum(const Frustum& View, uint32_t* Visible) const noexcept
+{
+    return Traverse([&](const Node& n)
+    {
+        return FrustumSlots(n, View);
+    },
+    [&](const Box& b)
+    {
+        return IsInside(View, b);
+    }, Visible);
+}
+
+size_t Bvh::QueryBox(const Box& Region, uint32_t* Found) const noexcept
+{
+    return Traverse([&](const Node& n)
+    {
+        return OverlapSlots(n, Region);
+    },
+    [&](const Box& b)
+    {
+        return Overlaps(Region, b);
+    }, Found);
+}
+
+void Bvh::BeginRay(RayWalk& Walk, const Vec3& Origin, const Vec3& Direction, float MaxDistance) const noexcept
+{
+    Walk.MaxDistance = MaxDistance;
+    Walk.Origin = Origin;
+    Walk.InverseDirection = {InverseOf(Direction.X), InverseOf(Direction.Y), InverseOf(Direction.Z)};
+    Walk.Top = 0u;
+    if (!Nodes.empty())
+    {
+        Walk.Stack[Walk.Top++] = {0u, 0u, 0.0f};
+    }
+}
+
+size_t Bvh::NextLeaf(RayWalk& Walk, uint32_t* Objects) const noexcept
+{
+    while (Walk.Top > 0u)
+    {
+        const RayWalk::Entry Next = Walk.Stack[--Walk.Top];
+        // A hit found after the push may have put the box out of reach
+        if (Next.Distance > Walk.MaxDistance)
+        {
+            continue;
+        }
+        if (Next.Child & LeafBit)
+        {
+            const uint32_t First = Next.Child & ~LeafBit;
+            for (uint32_t i = 0; i < Next.Count; i++)
+            {
+                Objects[i] = Items[First + i].Object;
+            }
+            return Next.Count;
+        }
+
+        // Children go on the stack farthest first, so the nearest one is popped next
+        const Node& Current = Nodes[Next.Child];
+        float Entry[4];
+        const size_t Bottom = Walk.Top;
+        for (uint32_t Mask = RaySlots(Current, Walk.Origin, Walk.InverseDirection, Walk.MaxDistance, Entry); Mask != 0u; Mask &= Mask - 1u)
+        {
+            const uint32_t Slot = static_cast<uint32_t>(std::countr_zero(Mask));
+            const RayWalk::Entry Child = {Current.Child[Slot], Current.Count[Slot], Entry[Slot]};
+            size_t j = Walk.Top++;
+            for (; j > Bottom && Walk.Stack[j - 1u].Distance < Child.Distance; j--)
+            {
+                Walk.Stack[j] = Walk.Stack[j - 1u];
+            }
+            Walk.Stack[j] = Child;
+        }
+    }
+    return 0u;
+}
+
+size_t Bvh::GetObjectCount() const noexcept
+{
+    return Items.size();
+}
+
+size_t Bvh::GetNodeCount() const noexcept
+{
+    return Nodes.size() - DeadNodes;
+}
+
+float Bvh::GetSahCost() const noexcept
+{
+    if (Nodes.empty())
+    {
+        return 0.0f;
+    }
+    // One unit per node test and per item test, weighted by the chance of reaching it
+    const float RootArea = std::max(Area(GetNodeBounds(0u)), std::numeric_limits<float>::min());
+    float Cost = 0.0f;
+    std::vector<uint32_t> Stack = {0u};
+    while (!Stack.empty())
+    {
+        const Node& n = Nodes[Stack.back()];
+        Cost += Area(GetNodeBounds(Stack.back())) / RootArea;
+        Stack.pop_back();
+        for (size_t Slot = 0; Slot < 4u; Slot++)
+        {
+            if (!(n.Child[Slot] & LeafBit))
+            {
+                Stack.push_back(n.Child[Slot]);
+            }
+            else if (n.Count[Slot] > 0u)
+            {
+                const Box Bounds = {{n.MinX[Slot], n.MinY[Slot], n.MinZ[Slot]}, {n.MaxX[Slot], n.MaxY[Slot], n.MaxZ[Slot]}};
+                Cost += Area(Bounds) / RootArea * static_cast<float>(n.Count[Slot]);
+            }
+        }
+    }
+    return Cost;
+}
+
+void Bvh::BuildAll(JobSystem* Jobs)
+{
+    Nodes.clear();
+    Info.clear();
+    DeadNodes = 0u;
+    if (!Items.empty())
+    {
+        Range Whole = {0u, static_cast<uint32_t>(Items.size()), EmptyBox};
+        Whole.Bounds = Reduce(Jobs, 0u, Items.size(), EmptyBox, [&](Box& Total, size_t Begin, size_t End)
+        {
+            for (size_t i = Begin; i < End; i++)
+            {
+                Grow(Total, Items[i].Bounds);
+            }
+        },
+        [](Box& Total, const Box& Partial)
+        {
+            Grow(Total, Partial);
+        });
+        BuildSubtree(Whole, 0u, NoParent, Jobs);
+        IndexItems(0u);
+    }
+    Dirty.assign(Nodes.size(), 0u);
+}
+
+uint32_t Bvh::BuildSubtree(const Range& Whole, uint32_t Depth, uint32_t Parent, JobSystem* Jobs)
+{
+    std::vector<Task> Tasks;
+    const uint32_t Root = BuildNode(Nodes, Info, Whole, Depth, Parent, Jobs, Jobs != nullptr ? &Tasks : nullptr);
+    if (Tasks.empty())
+    {
+        return Root;
+    }
+
+    Jobs->ParallelFor(Tasks.size(), 1u, [&](size_t Begin, size_t End, unsigned int)
+    {
+        for (size_t i = Begin; i < End; i++)
+        {
+            Task& t = Tasks[i];
+            BuildNode(t.Nodes, t.Info, t.Items, t.Depth, NoParent, nullptr, nullptr);
+        }
+    });
+
+    // Append every job's nodes and point the slots it was built for at them
+    for (Task& t : Tasks)
+    {
+        const uint32_t Offset = static_cast<uint32_t>(Nodes.size());
+        for (Node& n : t.Nodes)
+        {
+            for (uint32_t& Child : n.Child)
+            {
+                Child += (Child & LeafBit) ? 0u : Offset;
+            }
+        }
+        for (NodeInfo& i : t.Info)
+        {
+            i.Parent = i.Parent == NoParent ? t.Parent : i.Parent + Offset;
+        }
+        Nodes.insert(Nodes.end(), t.Nodes.begin(), t.Nodes.end());
+        Info.insert(Info.end(), t.Info.begin(), t.Info.end());
+        Nodes[t.Parent].Child[t.Slot] = Offset;
+    }
+    return Root;
+}
+
+uint32_t Bvh::BuildNode(std::vector<Node>& Out, std::vector<NodeInfo>& OutInfo, const Range& r, uint32_t Depth, uint32_t Parent, JobSystem* Jobs, std::vector<Task>* Deferred)
+{
+    const uint32_t Index = static_cast<uint32_t>(Out.size());
+    Node Empty;
+    std::fill(std::begin(Empty.MinX), std::end(Empty.MinX), Infinity);
+    std::fill(std::begin(Empty.MinY), std::end(Empty.MinY), Infinity);
+    std::fill(std::begin(Empty.MinZ), std::end(Empty.MinZ), Infinity);
+    std::fill(std::begin(Empty.MaxX), std::end(Empty.MaxX), -Infinity);
+    std::fill(std::begin(Empty.MaxY), std::end(Empty.MaxY), -Infinity);
+    std::fill(std::begin(Empty.MaxZ), std::end(Empty.MaxZ), -Infinity);
+    std::fill(std::begin(Empty.Child), std::end(Empty.Child), LeafBit);
+    std::fill(std::begin(Empty.Count), std::end(Empty.Count), 0u);
+    Out.push_back(Empty);
+    OutInfo.push_back({Parent, Depth, r.Begin, r.End, Area(r.Bounds), true});
+
+    // Three binary splits make the four children, always splitting the largest one
+    Range Children[4] = {r};
+    uint32_t ChildCount = 1u;
+    while (ChildCount < 4u)
+    {
+        uint32_t Largest = ChildCount;
+        float LargestArea = -1.0f;
+        for (uint32_t i = 0; i < ChildCount; i++)
+        {
+            if (Children[i].End - Children[i].Begin > LeafSize && Area(Children[i].Bounds) > LargestArea)
+            {
+                Largest = i;
+                LargestArea = Area(Children[i].Bounds);
+            }
+        }
+        if (Largest == ChildCount)
+        {
+            break;
+        }
+        const Range Whole = Children[Largest];
+        Split(Whole, Depth, Jobs, Children[Largest], Children[ChildCount]);
+        ChildCount++;
+    }
+
+    for (uint32_t i = 0; i < ChildCount; i++)
+    {
+        const Range& c = Children[i];
+        Node& n = Out[Index];
+        n.MinX[i] = c.Bounds.Min.X;
+        n.MinY[i] = c.Bounds.Min.Y;
+        n.MinZ[i] = c.Bounds.Min.Z;
+        n.MaxX[i] = c.Bounds.Max.X;
+        n.MaxY[i] = c.Bounds.Max.Y;
+        n.MaxZ[i] = c.Bounds.Max.Z;
+        const uint32_t Count = c.End - c.Begin;
+        if (Count <= LeafSize)
+        {
+            n.Child[i] = LeafBit | c.Begin;
+            n.Count[i] = Count;
+        }
+        else if (Deferred != nullptr && Count <= Grain)
+        {
+            Deferred->push_back({Index, i, Depth + 1u, c, {}, {}});
+        }
+        else
+        {
+            const uint32_t Child = BuildNode(Out, OutInfo, c, Depth + 1u, Index, Jobs, Deferred);
+            Out[Index].Child[i] = Child;
+        }
+    }
+    return Index;
+}
+
+void Bvh::Split(const Range& r, uint32_t Depth, JobSystem* Jobs, Range& Left, Range& Right)
+{
+    const auto Begin = Items.begin() + r.Begin;
+    const auto End = Items.begin() + r.End;
+    const Box Centroids = Reduce(Jobs, r.Begin, r.End, EmptyBox, [&](Box& Total, size_t First, size_t Last)
+    {
+        for (size_t i = First; i < Last; i++)
+        {
+            const Box& b = Items[i].Bounds;
+            const Vec3 c = {b.Min.X + b.Max.X, b.Min.Y + b.Max.Y, b.Min.Z + b.Max.Z};
+            Grow(Total, {c, c});
+        }
+    },
+    [](Box& Total, const Box& Partial)
+    {
+        Grow(Total, Partial);
+    });
+    const float Extent[3] = {Centroids.Max.X - Centroids.Min.X, Centroids.Max.Y - Centroids.Min.Y, Centroids.Max.Z - Centroids.Min.Z};
+    const float Start[3] = {Centroids.Min.X, Centroids.Min.Y, Centroids.Min.Z};
+    const uint32_t Axis = Extent[0] >= Extent[1] && Extent[0] >= Extent[2] ? 0u : Extent[1] >= Extent[2] ? 1u : 2u;
+
+    // Binning along the longest axis only costs a third of trying all three and the
+    // trees are nearly as good
+    if (Depth < MaxSahDepth && Extent[Axis] > 0.0f)
+    {
+        const float Scale = static_cast<float>(BinCount) * 0.9999f / Extent[Axis];
+        const auto BinOf = [&](const Box& b)
+        {
+            return std::min(static_cast<uint32_t>((Centroid(b, Axis) - Start[Axis]) * Scale), BinCount - 1u);
+        };
+
+        Bins Zero;
+        std::fill(std::begin(Zero.Bounds), std::end(Zero.Bounds), EmptyBox);
+        std::fill(std::begin(Zero.Counts), std::end(Zero.Counts), 0u);
+        const Bins Binned = Reduce(Jobs, r.Begin, r.End, Zero, [&](Bins& Total, size_t First, size_t Last)
+        {
+            for (size_t i = First; i < Last; i++)
+            {
+                const Box& b = Items[i].Bounds;
+                const uint32_t Bin = BinOf(b);
+                Grow(Total.Bounds[Bin], b);
+                Total.Counts[Bin]++;
+            }
+        },
+        [](Bins& Total, const Bins& Partial)
+        {
+            for (uint32_t Bin = 0; Bin < BinCount; Bin++)
+            {
+                Grow(Total.Bounds[Bin], Partial.Bounds[Bin]);
+                Total.Counts[Bin] += Partial.Counts[Bin];
+            }
+        });
+
+        // Cheapest split after bin s, by area times item count of both sides. The first
+        // and last bins are never empty, so every split is valid.
+        Box RightBounds[BinCount];
+        uint32_t RightCounts[BinCount];
+        Box Accumulated = EmptyBox;
+        uint32_t Count = 0u;
+        for (uint32_t Bin = BinCount; Bin-- > 1u;)
+        {
+            Grow(Accumulated, Binned.Bounds[Bin]);
+            Count += Binned.Counts[Bin];
+            RightBounds[Bin] = Accumulated;
+            RightCounts[Bin] = Count;
+        }
+        float BestCost = Infinity;
+        uint32_t BestSplit = 0u;
+        Box BestLeft = EmptyBox;
+        Accumulated = EmptyBox;
+        Count = 0u;
+        for (uint32_t Split = 0; Split + 1u < BinCount; Split++)
+        {
+            Grow(Accumulated, Binned.Bounds[Split]);
+            Count += Binned.Counts[Split];
+            const float Cost = Area(Accumulated) * static_cast<float>(Count) + Area(RightBounds[Split + 1u]) * static_cast<float>(RightCounts[Split + 1u]);
+            if (Cost < BestCost)
+            {
+                BestCost = Cost;
+                BestSplit = Split;
+                BestLeft = Accumulated;
+            }
+        }
+
+        const auto Middle = std::partition(Begin, End, [&](const Item& i)
+        {
+            return BinOf(i.Bounds) <= BestSplit;
+        });
+        const uint32_t Mid = static_cast<uint32_t>(Middle - Items.begin());
+        Left = {r.Begin, Mid, BestLeft};
+        Right = {Mid, r.End, RightBounds[BestSplit + 1u]};
+        return;
+    }
+
+    // Too deep or all centroids in one place, halve the items along the longest axis
+    const auto Middle = Begin + (End - Begin) / 2;
+    std::nth_element(Begin, Middle, End, [&](const Item& a, const Item& b)
+    {
+        return Centroid(a.Bounds, Axis) < Centroid(b.Bounds, Axis);
+    });
+    const uint32_t Mid = static_cast<uint32_t>(Middle - Items.begin());
+    Box LeftBounds = EmptyBox;
+    Box RightBounds = EmptyBox;
+    for (auto i = Begin; i != Middle; ++i)
+    {
+        Grow(LeftBounds, i->Bounds);
+    }
+    for (auto i = Middle; i != End; ++i)
+    {
+        Grow(RightBounds, i->Bounds);
+    }
+    Left = {r.Begin, Mid, LeftBounds};
+    Right = {Mid, r.End, RightBounds};
+}
+
+void Bvh::RefitNode(uint32_t n) noexcept
+{
+    for (uint32_t Slot = 0; Slot < 4u; Slot++)
+    {
+        const uint32_t Child = Nodes[n].Child[Slot];
+        Box Bounds = EmptyBox;
+        if (Child & LeafBit)
+        {
+            const uint32_t First = Child & ~LeafBit;
+            if (Nodes[n].Count[Slot] == 0u)
+            {
+                continue;
+            }
+            for (uint32_t i = First; i < First + Nodes[n].Count[Slot]; i++)
+            {
+                Grow(Bounds, Items[i].Bounds);
+            }
+        }
+        else
+        {
+            Bounds = GetNodeBounds(Child);
+        }
+        Node& Current = Nodes[n];
+        Current.MinX[Slot] = Bounds.Min.X;
+        Current.MinY[Slot] = Bounds.Min.Y;
+        Current.MinZ[Slot] = Bounds.Min.Z;
+        Current.MaxX[Slot] = Bounds.Max.X;
+        Current.MaxY[Slot] = Bounds.Max.Y;
+        Current.MaxZ[Slot] = Bounds.Max.Z;
+    }
+}
+
+Bvh::Box Bvh::GetNodeBounds(uint32_t n) const noexcept
+{
+    const Node& Current = Nodes[n];
+    Box Bounds = EmptyBox;
+    for (uint32_t Slot = 0; Slot < 4u; Slot++)
+    {
+        Grow(Bounds, {{Current.MinX[Slot], Current.MinY[Slot], Current.MinZ[Slot]}, {Current.MaxX[Slot], Current.MaxY[Slot], Current.MaxZ[Slot]}});
+    }
+    return Bounds;
+}
+
+void Bvh::MarkDead(uint32_t n) noexcept
+{
+    Info[n].Live = false;
+    DeadNodes++;
+    for (const uint32_t Child : Nodes[n].Child)
+    {
+        if (!(Child & LeafBit))
+        {
+            MarkDead(Child);
+        }
+    }
+}
+
+void Bvh::IndexItems(uint32_t Root) noexcept
+{
+    std::vector<uint32_t> Stack = {Root};
+    while (!Stack.empty())
+    {
+        const uint32_t n = Stack.back();
+        Stack.pop_back();
+        for (uint32_t Slot = 0; Slot < 4u; Slot++)
+        {
+            const uint32_t Child = Nodes[n].Child[Slot];
+            if (!(Child & LeafBit))
+            {
+                Stack.push_back(Child);
+                continue;
+            }
+            const uint32_t First = Child & ~LeafBit;
+            for (uint32_t i = First; i < First + Nodes[n].Count[Slot]; i++)
+            {
+                LeafNode[i] = n;
+                PositionOf[Items[i].Object] = i;
+            }
+        }
+    }
+}
+
+template<typename N, typename O>
+size_t Bvh::Traverse(N&& TestNode, O&& TestObject, uint32_t* Found) const noexcept
+{
+    if (Nodes.empty())
+    {
+        return 0u;
+    }
+    // Every level pops one node and pushes at most four
+    uint32_t Stack[3u * MaxDepth + 1u];
+    size_t Top = 0u;
+    Stack[Top++] = 0u;
+    size_t n = 0u;
+    while (Top > 0u)
+    {
+        const Node& Current = Nodes[Stack[--Top]];
+        for (uint32_t Mask = TestNode(Current); Mask != 0u; Mask &= Mask - 1u)
+        {
+            const uint32_t Slot = static_cast<uint32_t>(std::countr_zero(Mask));
+            const uint32_t Child = Current.Child[Slot];
+            if (!(Child & LeafBit))
+            {
+                Stack[Top++] = Child;
+                continue;
+            }
+            const uint32_t First = Child & ~LeafBit;
+            for (uint32_t i = First; i < First + Current.Count[Slot]; i++)
+            {
+                Found[n] = Items[i].Object;
+                n += TestObject(Items[i].Bounds) ? 1u : 0u;
+            }
+        }
+    }
+    return n;
+}
\ No newline at end of file
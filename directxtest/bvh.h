@@ -0,0 +1,162 @@
+#pragma once
+#include "simd_math.h"
+#include "culling.h"
+#include "job_system.h"
+#include <cstdint>
+#include <vector>
+
+// Bounding volume hierarchy over object boxes for culling, picking and proximity queries.
+// Nodes are 4 wide: the boxes of all four children sit in one node as component arrays,
+// so a traversal step tests them together and touches two cache lines. The tree is built
+// top-down with binned SAH; the top levels bin over the job system and the subtrees
+// below them are built as separate jobs.
+//
+// Moving objects only refits the boxes on their path to the root. Refits let the tree
+// degrade, so RebuildDegraded rebuilds subtrees whose box grew well past its size at
+// build time, and falls back to a full build once rebuilt subtrees have left too many
+// unreachable nodes behind. Objects are the indices 0..Count-1 of the Build call.
+class Bvh
+{
+public:
+    struct Box
+    {
+        Vec3 Min;
+        Vec3 Max;
+    };
+    static constexpr uint32_t LeafSize = 4u;
+    static constexpr uint32_t BinCount = 16u;
+    // Ranges larger than this bin over the job system, smaller ones become one build job
+    static constexpr size_t Grain = 16384u;
+    // Deeper nodes split at the median, which bounds the traversal stack
+    static constexpr uint32_t MaxSahDepth = 32u;
+    static constexpr uint32_t MaxDepth = 64u;
+    // Subtree box area over its area at build time that triggers a rebuild
+    static constexpr float RebuildGrowth = 2.0f;
+
+    // State of a walk along a ray that hands out leaves nearest box first, see BeginRay.
+    // It holds its own stack, so a walk can stop after any leaf and carry on later as
+    // long as the tree is not changed in between.
+    class RayWalk
+    {
+        friend class Bvh;
+    public:
+        // Boxes entered past this distance are skipped. Lower it to the nearest hit
+        // found so far and the rest of the walk only visits leaves that could beat it.
+        float MaxDistance = 0.0f;
+    private:
+        struct Entry
+        {
+            // Node, or the first item of a leaf with LeafBit set
+            uint32_t Child;
+            uint32_t Count;
+            // Where the ray enters the child's box
+            float Distance;
+        };
+        Vec3 Origin = {};
+        Vec3 InverseDirection = {};
+        // Every level pops one node and pushes at most four
+        Entry Stack[3u * MaxDepth + 1u];
+        size_t Top = 0u;
+    };
+public:
+    void Build(const Box* Bounds, size_t Count, JobSystem* Jobs = nullptr);
+    // Bounds holds every object's box, only the listed objects moved
+    void Refit(const Box* Bounds, const uint32_t* Moved, size_t MovedCount);
+    // Every object may have moved
+    void Refit(const Box* Bounds, JobSystem* Jobs = nullptr);
+    // Returns the number of subtrees rebuilt
+    size_t RebuildDegraded(JobSystem* Jobs = nullptr);
+
+    // The queries write object indices in tree order and need room for every object.
+    // They only read the tree, so several may run at once.
+    size_t CullFrustum(const Frustum& View, uint32_t* Visible) const noexcept;
+    size_t QueryBox(const Box& Region, uint32_t* Found) const noexcept;
+    // Starts a walk along Origin + t Direction for t in [0, MaxDistance]. Direction need
+    // not be unit length, distances are in multiples of it.
+    void BeginRay(RayWalk& Walk, const Vec3& Origin, const Vec3& Direction, float MaxDistance) const noexcept;
+    // Writes the objects of the next leaf whose box the ray enters, at most LeafSize, and
+    // returns their count. Returns 0 once the walk is over.
+    size_t NextLeaf(RayWalk& Walk, uint32_t* Objects) const noexcept;
+
+    size_t GetObjectCount() const noexcept;
+    // Reachable nodes only
+    size_t GetNodeCount() const noexcept;
+    // Expected cost of a random query relative to testing the root, lower is better
+    float GetSahCost() const noexcept;
+private:
+    static constexpr uint32_t LeafBit = 0x80000000u;
+    static constexpr uint32_t NoParent = ~0u;
+    struct alignas(64) Node
+    {
+        float MinX[4];
+        float MinY[4];
+        float MinZ[4];
+        float MaxX[4];
+        float MaxY[4];
+        float MaxZ[4];
+        // Child node, or the first item of a leaf with LeafBit set
+        uint32_t Child[4];
+        // Items in a leaf, 0 for inner children and unused slots
+        uint32_t Count[4];
+    };
+    // Build and refit bookkeeping, kept out of the nodes queries walk
+    struct NodeInfo
+    {
+        uint32_t Parent;
+        uint32_t Depth;
+        // Items of the subtree
+        uint32_t Begin;
+        uint32_t End;
+        float BuildArea;
+        bool Live;
+    };
+    struct Item
+    {
+        Box Bounds;
+        uint32_t Object;
+    };
+    struct Range
+    {
+        uint32_t Begin;
+        uint32_t End;
+        Box Bounds;
+    };
+    // Subtree left for a job by the serial top of a build
+    struct Task
+    {
+        uint32_t Parent;
+        uint32_t Slot;
+        uint32_t Depth;
+        Range Items;
+        std::vector<Node> Nodes;
+        std::vector<NodeInfo> Info;
+    };
+private:
+    // Builds the whole tree again from the items, dropping unreachable nodes
+    void BuildAll(JobSystem* Jobs);
+    // Builds the items of Whole and returns the root's index in Nodes
+    uint32_t BuildSubtree(const Range& Whole, uint32_t Depth, uint32_t Parent, JobSystem* Jobs);
+    // Appends a node for r and its descendants to Out. Children of at most Grain items
+    // are left in Deferred when it is not null.
+    uint32_t BuildNode(std::vector<Node>& Out, std::vector<NodeInfo>& OutInfo, const Range& r, uint32_t Depth, uint32_t Parent, JobSystem* Jobs, std::vector<Task>* Deferred);
+    // Partitions r's items in two, Jobs may be null
+    void Split(const Range& r, uint32_t Depth, JobSystem* Jobs, Range& Left, Range& Right);
+    void RefitNode(uint32_t n) noexcept;
+    Box GetNodeBounds(uint32_t n) const noexcept;
+    void MarkDead(uint32_t n) noexcept;
+    // Points LeafNode and PositionOf at the items of the reachable leaves
+    void IndexItems(uint32_t Root) noexcept;
+    // Walks the nodes TestNode keeps and writes the objects of their leaves TestObject keeps
+    template<typename N, typename O>
+    size_t Traverse(N&& TestNode, O&& TestObject, uint32_t* Found) const noexcept;
+private:
+    std::vector<Node> Nodes;
+    std::vector<NodeInfo> Info;
+    std::vector<Item> Items;
+    // Node holding each item's leaf, and each object's item
+    std::vector<uint32_t> LeafNode;
+    std::vector<uint32_t> PositionOf;
+    std::vector<uint8_t> Dirty;
+    std::vector<uint32_t> DirtyNodes;
+    size_t DeadNodes = 0u;
+};
\ No newline at end of file
@@ -0,0 +1,254 @@
+#include "capture.h"
+#include "alloc_tracker.h"
+#include <sstream>
+
+namespace
+{
+    constexpr uint32_t CaptureMagic = 0x50435844u;    // "DXCP"
+    constexpr uint32_t CaptureVersion = 1u;
+
+    struct BlobHash
+    {
+        uint64_t Low;
+        uint64_t High;
+    };
+
+    uint64_t RotateLeft(uint64_t x, int Bits) noexcept
+    {
+        return (x << Bits) | (x >> (64 - Bits));
+    }
+
+    uint64_t Finalize(uint64_t k) noexcept
+    {
+        k ^= k >> 33;
+        k *= 0xff51afd7ed558ccdull;
+        k ^= k >> 33;
+        k *= 0xc4ceb9fe1a85ec53ull;
+        k ^= k >> 33;
+        return k;
+    }
+
+    // MurmurHash3 x64 128 with seed 0, the length is mixed in as well
+    BlobHash HashBlob(const void* Data, size_t Size) noexcept
+    {
+        constexpr uint64_t c1 = 0x87c37b91114253d5ull;
+        constexpr uint64_t c2 = 0x4cf5ad432745937full;
+        const unsigned char* const Bytes = static_cast<const unsigned char*>(Data);
+        const auto Mix1 = [](uint64_t k) { return RotateLeft(k * c1, 31) * c2; };
+        const auto Mix2 = [](uint64_t k) { return RotateLeft(k * c2, 33) * c1; };
+
+        uint64_t h1 = 0u;
+        uint64_t h2 = 0u;
+        const size_t Blocks = Size / 16u;
+        for (size_t i = 0; i < Blocks; i++)
+        {
+            uint64_t k1, k2;
+            std::memcpy(&k1, Bytes + 16u * i, sizeof(k1));
+            std::memcpy(&k2, Bytes + 16u * i + 8u, sizeof(k2));
+            h1 ^= Mix1(k1);
+            h1 = (RotateLeft(h1, 27) + h2) * 5u + 0x52dce729u;
+            h2 ^= Mix2(k2);
+            h2 = (RotateLeft(h2, 31) + h1) * 5u + 0x38495ab5u;
+        }
+
+        // Up to 15 trailing bytes, little endian, a zero half mixes to zero
+        const unsigned char* const Tail = Bytes + 16u * Blocks;
+        uint64_t k1 = 0u;
+        uint64_t k2 = 0u;
+        for (size_t i = Size % 16u; i > 0u; i--)
+        {
+            uint64_t& k = i > 8u ? k2 : k1;
+            k = (k << 8) | Tail[i - 1u];
+        }
+        h1 ^= Mix1(k1);
+        h2 ^= Mix2(k2);
+
+        h1 ^= static_cast<uint64_t>(Size);
+        h2 ^= static_cast<uint64_t>(Size);
+        h1 += h2;
+        h2 += h1;
+        h1 = Finalize(h1);
+        h2 = Finalize(h2);
+        h1 += h2;
+        h2 += h1;
+        return {h1, h2};
+    }
+}
+
+CaptureException::CaptureException(int Line, const char* File, std::string Reason) noexcept
+    : MyException(Line, File), Reason(std::move(Reason)) {}
+
+const char* CaptureException::what() const noexcept
+{
+    AllocScope Scope(AllocTag::Exception);
+    std::ostringstream oss;
+    oss << GetType() << std::endl
+        << "[Reason] " << Reason << std::endl
+        << GetOriginString();
+    whatBuffer = oss.str();
+    return whatBuffer.c_str();
+}
+
+const char* CaptureException::GetType() const noexcept
+{
+    return "Capture Exception";
+}
+
+CaptureWriter::CaptureWriter(const std::filesystem::path& Path)
+    : Stream(Path, std::ios::binary | std::ios::trunc), Start(std::chrono::steady_clock::now())
+{
+    if (!Stream)
+    {
+        throw CAPTURE_EXCEPT("Cannot create capture file");
+    }
+    Write(CaptureMagic);
+    Write(CaptureVersion);
+}
+
+void CaptureWriter::Begin(CaptureOp Op) noexcept
+{
+    Write(Op);
+}
+
+void CaptureWriter::WriteString(const char* String) noexcept
+{
+    const uint32_t Length = String ? static_cast<uint32_t>(std::strlen(String)) : 0u;
+    Write(Length);
+    Stream.write(String, Length);
+}
+
+void CaptureWriter::WriteBlob(const void* Data, size_t Size)
+{
+    // Id 0 is the empty payload, new ids are handed out in order so the reader can
+    // tell a definition from a reference
+    if (!Data || Size == 0u)
+    {
+        Write(0u);
+        return;
+    }
+
+    const BlobHash Hash = HashBlob(Data, Size);
+    const auto [First, Last] = BlobIds.equal_range(Hash.Low);
+    for (auto It = First; It != Last; ++It)
+    {
+        if (It->second.High == Hash.High && It->second.Size == Size)
+        {
+            Write(It->second.Id);
+            DeduplicatedBytes += Size;
+            return;
+        }
+    }
+
+    const uint32_t Id = ++BlobCount;
+    BlobIds.emplace(Hash.Low, BlobKey{Hash.High, static_cast<uint64_t>(Size), Id});
+    Write(Id);
+    Write(static_cast<uint64_t>(Size));
+    Stream.write(static_cast<const char*>(Data), static_cast<std::streamsize>(Size));
+}
+
+void CaptureWriter::EndFrame()
+{
+    const auto Elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Start);
+    Begin(CaptureOp::EndFrame);
+    Write(static_cast<uint64_t>(Elapsed.count()));
+    Frames++;
+
+    // Records are written without checks, a failed write leaves the stream failed for good
+    if (!Stream)
+    {
+        throw CAPTURE_EXCEPT("Cannot write capture file");
+    }
+}
+
+uint64_t CaptureWriter::GetFrameCount() const noexcept
+{
+    return Frames;
+}
+
+uint64_t CaptureWriter::GetDeduplicatedBytes() const noexcept
+{
+    return DeduplicatedBytes;
+}
+
+CaptureReader::CaptureReader(const std::filesystem::path& Path)
+{
+    std::ifstream Stream(Path, std::ios::binary | std::ios::ate);
+    if (!Stream)
+    {
+        throw CAPTURE_EXCEPT("Cannot open capture file");
+    }
+    Data.resize(static_cast<size_t>(Stream.tellg()));
+    Stream.seekg(0);
+    Stream.read(reinterpret_cast<char*>(Data.data()), static_cast<std::streamsize>(Data.size()));
+
+    if (Read<uint32_t>() != CaptureMagic)
+    {
+        throw CAPTURE_EXCEPT("Not a capture file");
+    }
+    if (Read<uint32_t>() != CaptureVersion)
+    {
+        throw CAPTURE_EXCEPT("Unsupported capture version");
+    }
+}
+
+bool CaptureReader::Next(CaptureOp& Op)
+{
+    if (Cursor == Data.size())
+    {
+        return false;
+    }
+    Op = Read<CaptureOp>();
+    if (Op >= CaptureOp::Count)
+    {
+        throw CAPTURE_EXCEPT("Unknown capture record");
+    }
+    return true;
+}
+
+std::string CaptureReader::ReadString()
+{
+    const uint32_t Length = Read<uint32_t>();
+    const unsigned char* Chars = Consume(Length);
+    return std::string(reinterpret_cast<const char*>(Chars), Length);
+}
+
+CaptureReader::Blob CaptureReader::ReadBlob()
+{
+    const uint32_t Id = Read<uint32_t>();
+    if (Id == 0u)
+    {
+        return {};
+    }
+    if (Id <= Blobs.size())
+    {
+        return Blobs[Id - 1u];
+    }
+    if (Id != Blobs.size() + 1u)
+    {
+        throw CAPTURE_EXCEPT("Payload referenced before its definition");
+    }
+
+    Blob Defined;
+    Defined.Size = static_cast<size_t>(Read<uint64_t>());
+    Defined.Data = Consume(Defined.Size);
+    Blobs.push_back(Defined);
+    return Defined;
+}
+
+void CaptureReader::Rewind() noexcept
+{
+    // Payload ids are defined again on the next pass
+    Cursor = 2u * sizeof(uint32_t);
+    Blobs.clear();
+}
+
+const unsigned char* CaptureReader::Consume(size_t Size)
+{
+    if (Size > Data.size() - Cursor)
+    {
+        throw CAPTURE_EXCEPT("Truncated capture stream");
+    }
+    const unsigned char* Bytes = Data.data() + Cursor;
+    Cursor += Size;
+    return Bytes;
+}
\ No newline at end of file
@@ -0,0 +1,146 @@
+#pragma once
+#include "exceptions.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// Graphics calls in a capture stream. Every record starts with its op followed by the
+// arguments listed here, "blob" is a deduplicated payload (see CaptureWriter::WriteBlob).
+// Handles, PSO ids and streamed ranges are the values seen at capture time, the replayer
+// maps them to whatever the replaying Graphics hands out.
+enum class CaptureOp : uint8_t
+{
+    CreateVertexShader,     // handle, bytecode blob
+    CreatePixelShader,      // handle, bytecode blob
+    CreateInputLayout,      // handle, vertex shader, count, count * (semantic, index, format, slot, offset, class, step rate)
+    CreateBuffer,           // handle, D3D11_BUFFER_DESC, initial data blob
+    CreateShaderView,       // handle, buffer, D3D11_SHADER_RESOURCE_VIEW_DESC
+    Release,                // CaptureResource, handle
+    BindVertexBuffer,       // buffer, stride, offset
+    BindIndexBuffer,        // buffer, format, offset
+    BindShaderView,         // slot, view
+    CreatePipelineState,    // PSO id, PipelineStateDesc
+    SetPipelineState,       // PSO id
+    ClearBuffer,            // red, green, blue
+    SetFrameConstants,      // blob, offset
+    SetViewConstants,       // blob, offset
+    StreamVertices,         // blob, stride, range offset, range size
+    StreamIndices,          // blob, range offset, range size
+    BindStreamedVertices,   // range offset, range size, stride
+    BindStreamedIndices,    // range offset, range size, format
+    StreamDrawConstants,    // blob, size, count, first constant, constant count
+    BindDrawConstants,      // first constant, constant count, index
+    ExecuteCommandList,     // command count, count * (Command, blob for payload commands)
+    EndFrame,               // nanoseconds since the capture started
+    Count
+};
+
+// Resource kinds for CaptureOp::Release, each kind has its own handle space
+enum class CaptureResource : uint8_t
+{
+    VertexShader,
+    PixelShader,
+    InputLayout,
+    Buffer,
+    ShaderView,
+    Count
+};
+
+class CaptureException : public MyException
+{
+public:
+    CaptureException(int Line, const char* File, std::string Reason) noexcept;
+    const char* what() const noexcept override;
+    const char* GetType() const noexcept override;
+private:
+    std::string Reason;
+};
+
+#define CAPTURE_EXCEPT(Reason) CaptureException(__LINE__, __FILE__, (Reason))
+
+// Appends records to a capture file. Not thread-safe, calls are recorded from the thread
+// that drives Graphics.
+class CaptureWriter
+{
+public:
+    explicit CaptureWriter(const std::filesystem::path& Path);
+    CaptureWriter(const CaptureWriter&) = delete;
+    CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+    void Begin(CaptureOp Op) noexcept;
+    template<typename T>
+    void Write(const T& Value) noexcept
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Only raw values can be captured");
+        Stream.write(reinterpret_cast<const char*>(&Value), sizeof(T));
+    }
+    void WriteString(const char* String) noexcept;
+    // The first occurrence of a payload is written inline, every repeat only stores its id.
+    // Payloads are matched by size and a 128-bit hash of their content alone, so the
+    // writer keeps a few bytes per distinct payload rather than the payload itself.
+    void WriteBlob(const void* Data, size_t Size);
+    // Throws if anything written since the capture started failed
+    void EndFrame();
+
+    uint64_t GetFrameCount() const noexcept;
+    // Payload bytes that were not written again thanks to deduplication
+    uint64_t GetDeduplicatedBytes() const noexcept;
+private:
+    std::ofstream Stream;
+    std::chrono::steady_clock::time_point Start;
+    struct BlobKey
+    {
+        uint64_t High;      // Upper half of the hash, the lower half is the map key
+        uint64_t Size;
+        uint32_t Id;
+    };
+    // Payloads by the lower half of their hash
+    std::unordered_multimap<uint64_t, BlobKey> BlobIds;
+    uint32_t BlobCount = 0u;
+    uint64_t Frames = 0u;
+    uint64_t DeduplicatedBytes = 0u;
+};
+
+// Reads a capture file into memory and walks its records. Blobs point into the file
+// buffer and stay valid for the reader's lifetime.
+class CaptureReader
+{
+public:
+    struct Blob
+    {
+        const unsigned char* Data = nullptr;
+        size_t Size = 0u;
+    };
+public:
+    explicit CaptureReader(const std::filesystem::path& Path);
+    CaptureReader(const CaptureReader&) = delete;
+    CaptureReader& operator=(const CaptureReader&) = delete;
+
+    // False at the end of the stream
+    bool Next(CaptureOp& Op);
+    template<typename T>
+    T Read()
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Only raw values can be captured");
+        T Value;
+        std::memcpy(&Value, Consume(sizeof(T)), sizeof(T));
+        return Value;
+    }
+    std::string ReadString();
+    Blob ReadBlob();
+    // Back to the first record, e.g. to loop a replay
+    void Rewind() noexcept;
+private:
+    const unsigned char* Consume(size_t Size);
+private:
+    std::vector<unsigned char> Data;
+    size_t Cursor = 0u;
+    std::vector<Blob> Blobs;
+};
\ No newline at end of file
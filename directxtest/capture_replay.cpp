@@ -0,0 +1,338 @@
+#include "capture_replay.h"
+#include <thread>
+
+CaptureReplayer::CaptureReplayer(Graphics& GFX, const std::filesystem::path& Path, Pacing Mode)
+    : GFX(GFX), Reader(Path), Mode(Mode)
+{
+    GFX.SetSyncInterval(Mode == Pacing::Unpaced ? 0u : 1u);
+}
+
+bool CaptureReplayer::ReplayFrame()
+{
+    if (Frames == 0u)
+    {
+        Start = std::chrono::steady_clock::now();
+    }
+
+    CaptureOp Op;
+    while (Reader.Next(Op))
+    {
+        switch (Op)
+        {
+            case CaptureOp::CreateVertexShader:
+            {
+                const uint32_t Captured = Reader.Read<uint32_t>();
+                const CaptureReader::Blob Bytecode = Reader.ReadBlob();
+                MapHandle(CaptureResource::VertexShader, Captured, GFX.CreateVertexShader(Bytecode.Data, Bytecode.Size).Value);
+            } break;
+
+            case CaptureOp::CreatePixelShader:
+            {
+                const uint32_t Captured = Reader.Read<uint32_t>();
+                const CaptureReader::Blob Bytecode = Reader.ReadBlob();
+                MapHandle(CaptureResource::PixelShader, Captured, GFX.CreatePixelShader(Bytecode.Data, Bytecode.Size).Value);
+            } break;
+
+            case CaptureOp::CreateInputLayout:
+            {
+                const uint32_t Captured = Reader.Read<uint32_t>();
+                const auto Shader = GetHandle<VertexShaderHandle>(CaptureResource::VertexShader, Reader.Read<uint32_t>());
+                const UINT Count = Reader.Read<UINT>();
+                std::vector<std::string> Semantics(Count);
+                std::vector<D3D11_INPUT_ELEMENT_DESC> Elements(Count);
+                for (UINT i = 0; i < Count; i++)
+                {
+                    Semantics[i] = Reader.ReadString();
+                    D3D11_INPUT_ELEMENT_DESC& e = Elements[i];
+                    e.SemanticIndex = Reader.Read<UINT>();
+                    e.Format = Reader.Read<DXGI_FORMAT>();
+                    e.InputSlot = Reader.Read<UINT>();
+                    e.AlignedByteOffset = Reader.Read<UINT>();
+                    e.InputSlotClass = Reader.Read<D3D11_INPUT_CLASSIFICATION>();
+                    e.InstanceDataStepRate = Reader.Read<UINT>();
+                }
+                for (UINT i = 0; i < Count; i++)
+                {
+                    Elements[i].SemanticName = Semantics[i].c_str();
+                }
+                MapHandle(CaptureResource::InputLayout, Captured, GFX.CreateInputLayout(Elements.data(), Count, Shader).Value);
+            } break;
+
+            case CaptureOp::CreateBuffer:
+            {
+                const uint32_t Captured = Reader.Read<uint32_t>();
+                const auto Desc = Reader.Read<D3D11_BUFFER_DESC>();
+                const CaptureReader::Blob InitialData = Reader.ReadBlob();
+                MapHandle(CaptureResource::Buffer, Captured, GFX.CreateBuffer(Desc, InitialData.Data).Value);
+            } break;
+
+            case CaptureOp::CreateShaderView:
+            {
+                const uint32_t Captured = Reader.Read<uint32_t>();
+                const auto Buffer = GetHandle<BufferHandle>(CaptureResource::Buffer, Reader.Read<uint32_t>());
+                const auto Desc = Reader.Read<D3D11_SHADER_RESOURCE_VIEW_DESC>();
+                MapHandle(CaptureResource::ShaderView, Captured, GFX.CreateShaderView(Buffer, Desc).Value);
+            } break;
+
+            case CaptureOp::Release:
+            {
+                const auto Kind = Reader.Read<CaptureResource>();
+                const uint32_t Captured = Reader.Read<uint32_t>();
+                switch (Kind)
+                {
+                    case CaptureResource::VertexShader: GFX.Release(GetHandle<VertexShaderHandle>(Kind, Captured)); break;
+                    case CaptureResource::PixelShader: GFX.Release(GetHandle<PixelShaderHandle>(Kind, Captured)); break;
+                    case CaptureResource::InputLayout: GFX.Release(GetHandle<InputLayoutHandle>(Kind, Captured)); break;
+                    case CaptureResource::Buffer: GFX.Release(GetHandle<BufferHandle>(Kind, Captured)); break;
+                    case CaptureResource::ShaderView: GFX.Release(GetHandle<ShaderViewHandle>(Kind, Captured)); break;
+                    default: throw CAPTURE_EXCEPT("Unknown resource kind");
+                }
+                Handles[static_cast<size_t>(Kind)].erase(Captured);
+            } break;
+
+            case CaptureOp::BindVertexBuffer:
+            {
+                const auto Buffer = GetHandle<BufferHandle>(CaptureResource::Buffer, Reader.Read<uint32_t>());
+                const UINT Stride = Reader.Read<UINT>();
+                GFX.BindVertexBuffer(Buffer, Stride, Reader.Read<UINT>());
+            } break;
+
+            case CaptureOp::BindIndexBuffer:
+            {
+                const auto Buffer = GetHandle<BufferHandle>(CaptureResource::Buffer, Reader.Read<uint32_t>());
+                const auto Format = Reader.Read<DXGI_FORMAT>();
+                GFX.BindIndexBuffer(Buffer, Format, Reader.Read<UINT>());
+            } break;
+
+            case CaptureOp::BindShaderView:
+            {
+                const UINT Slot = Reader.Read<UINT>();
+                GFX.BindShaderView(Slot, GetHandle<ShaderViewHandle>(CaptureResource::ShaderView, Reader.Read<uint32_t>()));
+            } break;
+
+            case CaptureOp::CreatePipelineState:
+            {
+                const uint32_t Captured = Reader.Read<uint32_t>();
+                auto Desc = Reader.Read<PipelineStateDesc>();
+                Desc.VertexShader = GetHandle<VertexShaderHandle>(CaptureResource::VertexShader, Desc.VertexShader.Value);
+                Desc.PixelShader = GetHandle<PixelShaderHandle>(CaptureResource::PixelShader, Desc.PixelShader.Value);
+                Desc.InputLayout = GetHandle<InputLayoutHandle>(CaptureResource::InputLayout, Desc.InputLayout.Value);
+                PipelineStates[Captured] = GFX.CreatePipelineState(Desc);
+            } break;
+
+            case CaptureOp::SetPipelineState:
+            {
+                GFX.SetPipelineState(GetPipelineState(Reader.Read<uint32_t>()));
+            } break;
+
+            case CaptureOp::ClearBuffer:
+            {
+                const float Red = Reader.Read<float>();
+                const float Green = Reader.Read<float>();
+                GFX.ClearBuffer(Red, Green, Reader.Read<float>());
+            } break;
+
+            case CaptureOp::SetFrameConstants:
+            case CaptureOp::SetViewConstants:
+            {
+                const CaptureReader::Blob Data = Reader.ReadBlob();
+                const UINT Offset = Reader.Read<UINT>();
+                if (Op == CaptureOp::SetFrameConstants)
+                {
+                    GFX.SetFrameConstants(Data.Data, static_cast<UINT>(Data.Size), Offset);
+                }
+                else
+                {
+                    GFX.SetViewConstants(Data.Data, static_cast<UINT>(Data.Size), Offset);
+                }
+            } break;
+
+            case CaptureOp::StreamVertices:
+            {
+                const CaptureReader::Blob Data = Reader.ReadBlob();
+                const UINT Stride = Reader.Read<UINT>();
+                const UINT Offset = Reader.Read<UINT>();
+                Reader.Read<UINT>();
+                VertexRanges[Offset] = GFX.StreamVertices(Data.Data, static_cast<UINT>(Data.Size), Stride);
+            } break;
+
+            case CaptureOp::StreamIndices:
+            {
+                const CaptureReader::Blob Data = Reader.ReadBlob();
+                const UINT Offset = Reader.Read<UINT>();
+                Reader.Read<UINT>();
+                IndexRanges[Offset] = GFX.StreamIndices(Data.Data, static_cast<UINT>(Data.Size));
+            } break;
+
+            case CaptureOp::BindStreamedVertices:
+            {
+                const UINT Offset = Reader.Read<UINT>();
+                Reader.Read<UINT>();
+                GFX.BindStreamedVertices(GetRange(VertexRanges, Offset), Reader.Read<UINT>());
+            } break;
+
+            case CaptureOp::BindStreamedIndices:
+            {
+                const UINT Offset = Reader.Read<UINT>();
+                Reader.Read<UINT>();
+                GFX.BindStreamedIndices(GetRange(IndexRanges, Offset), Reader.Read<DXGI_FORMAT>());
+            } break;
+
+            case CaptureOp::StreamDrawConstants:
+            {
+                const CaptureReader::Blob Data = Reader.ReadBlob();
+                const UINT Size = Reader.Read<UINT>();
+                const UINT Count = Reader.Read<UINT>();
+                const UINT First = Reader.Read<UINT>();
+                Reader.Read<UINT>();
+                DrawConstants[First] = GFX.StreamDrawConstants(Data.Data, Size, Count);
+            } break;
+
+            case CaptureOp::BindDrawConstants:
+            {
+                const UINT First = Reader.Read<UINT>();
+                Reader.Read<UINT>();
+                const UINT Index = Reader.Read<UINT>();
+                const auto Location = DrawConstants.find(First);
+                if (Location == DrawConstants.end())
+                {
+                    throw CAPTURE_EXCEPT("Draw constants bound before they were streamed");
+                }
+                GFX.BindDrawConstants(Location->second, Index);
+            } break;
+
+            case CaptureOp::ExecuteCommandList:
+            {
+                ReplayCommandList();
+            } break;
+
+            case CaptureOp::EndFrame:
+            {
+                const std::chrono::nanoseconds Recorded(Reader.Read<uint64_t>());
+                if (Mode == Pacing::Recorded)
+                {
+                    std::this_thread::sleep_until(Start + Recorded);
+                }
+                GFX.EndFrame();
+                VertexRanges.clear();
+                IndexRanges.clear();
+                DrawConstants.clear();
+                Frames++;
+                return true;
+            }
+
+            default:
+            {
+                throw CAPTURE_EXCEPT("Unknown capture record");
+            }
+        }
+    }
+    return false;
+}
+
+uint64_t CaptureReplayer::GetFrameCount() const noexcept
+{
+    return Frames;
+}
+
+void CaptureReplayer::ReplayCommandList()
+{
+    List.Reset();
+    const uint32_t Count = Reader.Read<uint32_t>();
+    for (uint32_t i = 0; i < Count; i++)
+    {
+        const auto c = Reader.Read<Command>();
+        switch (c.Type)
+        {
+            case CommandType::SetPipelineState:
+            {
+                List.SetPipelineState(GetPipelineState(c.Args[0])->Id);
+            } break;
+
+            case CommandType::SetVertexBuffer:
+            {
+                List.SetVertexBuffer(GetHandle<BufferHandle>(CaptureResource::Buffer, c.Args[0]), c.Args[1], c.Args[2]);
+            } break;
+
+            case CommandType::SetIndexBuffer:
+            {
+                List.SetIndexBuffer(GetHandle<BufferHandle>(CaptureResource::Buffer, c.Args[0]), c.Args[1] != 0u, c.Args[2]);
+            } break;
+
+            case CommandType::StreamVertices:
+            {
+                const CaptureReader::Blob Data = Reader.ReadBlob();
+                List.StreamVertices(Data.Data, static_cast<uint32_t>(Data.Size), c.Args[2]);
+            } break;
+
+            case CommandType::StreamIndices:
+            {
+                const CaptureReader::Blob Data = Reader.ReadBlob();
+                List.StreamIndices(Data.Data, static_cast<uint32_t>(Data.Size), c.Args[2] != 0u);
+            } break;
+
+            case CommandType::SetDrawConstants:
+            {
+                const CaptureReader::Blob Data = Reader.ReadBlob();
+                List.SetDrawConstants(Data.Data, static_cast<uint32_t>(Data.Size));
+            } break;
+
+            case CommandType::Draw:
+            {
+                List.Draw(c.Args[0], c.Args[1]);
+            } break;
+
+            case CommandType::DrawIndexed:
+            {
+                List.DrawIndexed(c.Args[0], c.Args[1], static_cast<int32_t>(c.Args[2]));
+            } break;
+
+            default:
+            {
+                throw CAPTURE_EXCEPT("Unknown command in captured list");
+            }
+        }
+    }
+    GFX.ExecuteCommandList(List);
+}
+
+void CaptureReplayer::MapHandle(CaptureResource Kind, uint32_t Captured, uint32_t Replayed)
+{
+    Handles[static_cast<size_t>(Kind)][Captured] = Replayed;
+}
+
+uint32_t CaptureReplayer::GetHandleValue(CaptureResource Kind, uint32_t Captured) const
+{
+    // The null handle stays null, e.g. a PSO without pixel shader
+    if (Captured == 0u)
+    {
+        return 0u;
+    }
+    const auto& Map = Handles[static_cast<size_t>(Kind)];
+    const auto Replayed = Map.find(Captured);
+    if (Replayed == Map.end())
+    {
+        throw CAPTURE_EXCEPT("Record references a resource that was never created");
+    }
+    return Replayed->second;
+}
+
+const Graphics::PipelineState* CaptureReplayer::GetPipelineState(uint32_t Captured) const
+{
+    const auto State = PipelineStates.find(Captured);
+    if (State == PipelineStates.end())
+    {
+        throw CAPTURE_EXCEPT("Record references a pipeline state that was never created");
+    }
+    return State->second;
+}
+
+Graphics::DynamicRange CaptureReplayer::GetRange(const std::unordered_map<UINT, Graphics::DynamicRange>& Ranges, UINT CapturedOffset) const
+{
+    const auto Range = Ranges.find(CapturedOffset);
+    if (Range == Ranges.end())
+    {
+        throw CAPTURE_EXCEPT("Streamed range bound before it was streamed");
+    }
+    return Range->second;
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+#include "graphics.h"
+#include "capture.h"
+#include <chrono>
+#include <filesystem>
+#include <unordered_map>
+
+// Plays a capture stream back through a Graphics. Handles, PSO ids and streamed ranges
+// are mapped to the replaying instance, so it may run on another device or driver type
+// and may have created resources of its own.
+class CaptureReplayer
+{
+public:
+    enum class Pacing
+    {
+        Unpaced,    // As fast as the device goes, presents don't wait for vertical blank
+        Recorded    // Each frame ends no earlier than it did during capture
+    };
+public:
+    CaptureReplayer(Graphics& GFX, const std::filesystem::path& Path, Pacing Mode);
+    CaptureReplayer(const CaptureReplayer&) = delete;
+    CaptureReplayer& operator=(const CaptureReplayer&) = delete;
+
+    // Replays the records up to and including the next EndFrame, false at the end of the stream
+    bool ReplayFrame();
+    uint64_t GetFrameCount() const noexcept;
+private:
+    void ReplayCommandList();
+    void MapHandle(CaptureResource Kind, uint32_t Captured, uint32_t Replayed);
+    template<typename HandleT>
+    HandleT GetHandle(CaptureResource Kind, uint32_t Captured) const
+    {
+        return HandleT{GetHandleValue(Kind, Captured)};
+    }
+    uint32_t GetHandleValue(CaptureResource Kind, uint32_t Captured) const;
+    const Graphics::PipelineState* GetPipelineState(uint32_t Captured) const;
+    Graphics::DynamicRange GetRange(const std::unordered_map<UINT, Graphics::DynamicRange>& Ranges, UINT CapturedOffset) const;
+private:
+    Graphics& GFX;
+    CaptureReader Reader;
+    Pacing Mode;
+    CommandList List;
+    std::unordered_map<uint32_t, uint32_t> Handles[static_cast<size_t>(CaptureResource::Count)];
+    std::unordered_map<uint32_t, const Graphics::PipelineState*> PipelineStates;
+    // Streamed data only lives for one frame, keyed by the offset seen at capture time
+    std::unordered_map<UINT, Graphics::DynamicRange> VertexRanges;
+    std::unordered_map<UINT, Graphics::DynamicRange> IndexRanges;
+    std::unordered_map<UINT, ConstantLocation> DrawConstants;
+    std::chrono::steady_clock::time_point Start;
+    uint64_t Frames = 0u;
+};
\ No newline at end of file
@@ -0,0 +1,80 @@
+#include "command_list.h"
+#include <cstring>
+
+void CommandList::Reset() noexcept
+{
+    Commands.clear();
+    Payload.clear();
+    DrawCount = 0u;
+}
+
+void CommandList::SetPipelineState(uint32_t Id)
+{
+    Commands.push_back({CommandType::SetPipelineState, {Id, 0u, 0u}});
+}
+
+void CommandList::SetVertexBuffer(BufferHandle Buffer, uint32_t Stride, uint32_t Offset)
+{
+    Commands.push_back({CommandType::SetVertexBuffer, {Buffer.Value, Stride, Offset}});
+}
+
+void CommandList::SetIndexBuffer(BufferHandle Buffer, bool Index32, uint32_t Offset)
+{
+    Commands.push_back({CommandType::SetIndexBuffer, {Buffer.Value, Index32 ? 1u : 0u, Offset}});
+}
+
+void CommandList::StreamVertices(const void* Data, uint32_t Size, uint32_t Stride)
+{
+    Commands.push_back({CommandType::StreamVertices, {PushPayload(Data, Size), Size, Stride}});
+}
+
+void CommandList::StreamIndices(const void* Data, uint32_t Size, bool Index32)
+{
+    Commands.push_back({CommandType::StreamIndices, {PushPayload(Data, Size), Size, Index32 ? 1u : 0u}});
+}
+
+void CommandList::SetDrawConstants(const void* Data, uint32_t Size)
+{
+    Commands.push_back({CommandType::SetDrawConstants, {PushPayload(Data, Size), Size, 0u}});
+}
+
+void CommandList::Draw(uint32_t VertexCount, uint32_t StartVertex)
+{
+    Commands.push_back({CommandType::Draw, {VertexCount, StartVertex, 0u}});
+    DrawCount++;
+}
+
+void CommandList::DrawIndexed(uint32_t IndexCount, uint32_t StartIndex, int32_t BaseVertex)
+{
+    Commands.push_back({CommandType::DrawIndexed, {IndexCount, StartIndex, static_cast<uint32_t>(BaseVertex)}});
+    DrawCount++;
+}
+
+const std::vector<Command>& CommandList::GetCommands() const noexcept
+{
+    return Commands;
+}
+
+const void* CommandList::GetPayload(uint32_t Offset) const noexcept
+{
+    return Payload.data() + Offset;
+}
+
+size_t CommandList::GetPayloadSize() const noexcept
+{
+    return Payload.size();
+}
+
+uint32_t CommandList::GetDrawCount() const noexcept
+{
+    return DrawCount;
+}
+
+uint32_t CommandList::PushPayload(const void* Data, uint32_t Size)
+{
+    // 16 byte aligned so constants can be read straight from the payload
+    const size_t Offset = (Payload.size() + 15u) & ~size_t(15u);
+    Payload.resize(Offset + Size);
+    std::memcpy(Payload.data() + Offset, Data, Size);
+    return static_cast<uint32_t>(Offset);
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+#include "handle_pool.h"
+#include <cstdint>
+#include <vector>
+
+enum class CommandType : uint8_t
+{
+    SetPipelineState,   // PSO id
+    SetVertexBuffer,    // buffer handle, stride, byte offset
+    SetIndexBuffer,     // buffer handle, 32-bit indices, byte offset
+    StreamVertices,     // payload offset, size, stride
+    StreamIndices,      // payload offset, size, 32-bit indices
+    SetDrawConstants,   // payload offset, size
+    Draw,               // vertex count, start vertex
+    DrawIndexed         // index count, start index, base vertex
+};
+
+struct Command
+{
+    CommandType Type;
+    uint32_t Args[3];
+};
+
+// Backend independent list of draw commands. Recording never touches the device, so any
+// number of lists can be recorded on worker threads and executed by Graphics later.
+// Geometry and constants are copied into the list's payload and uploaded at execution.
+// Reset() keeps the capacity, so a recycled list stops allocating once it has warmed up.
+class CommandList
+{
+public:
+    void Reset() noexcept;
+
+    void SetPipelineState(uint32_t Id);
+    void SetVertexBuffer(BufferHandle Buffer, uint32_t Stride, uint32_t Offset = 0u);
+    void SetIndexBuffer(BufferHandle Buffer, bool Index32 = false, uint32_t Offset = 0u);
+    void StreamVertices(const void* Data, uint32_t Size, uint32_t Stride);
+    void StreamIndices(const void* Data, uint32_t Size, bool Index32 = false);
+    void SetDrawConstants(const void* Data, uint32_t Size);
+    void Draw(uint32_t VertexCount, uint32_t StartVertex = 0u);
+    void DrawIndexed(uint32_t IndexCount, uint32_t StartIndex = 0u, int32_t BaseVertex = 0);
+
+    const std::vector<Command>& GetCommands() const noexcept;
+    const void* GetPayload(uint32_t Offset) const noexcept;
+    size_t GetPayloadSize() const noexcept;
+    uint32_t GetDrawCount() const noexcept;
+private:
+    uint32_t PushPayload(const void* Data, uint32_t Size);
+private:
+    std::vector<Command> Commands;
+    std::vector<unsigned char> Payload;
+    uint32_t DrawCount = 0u;
+};
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include "constant_buffer.h"
+#include <algorithm>
+#include <cstring>
+
+void ConstantPacking::Pack(void* Dest, const void* Src, size_t Size, size_t Count) noexcept
+{
+    const size_t BlockSize = GetBlockSize(Size);
+    auto* Out = static_cast<unsigned char*>(Dest);
+    const auto* In = static_cast<const unsigned char*>(Src);
+    for (size_t i = 0; i < Count; i++)
+    {
+        std::memcpy(Out + i * BlockSize, In + i * Size, Size);
+    }
+}
+
+ConstantLocation ConstantPacking::Locate(size_t ByteOffset, size_t Size, size_t Index) noexcept
+{
+    const size_t BlockSize = GetBlockSize(Size);
+    return {static_cast<unsigned int>((ByteOffset + Index * BlockSize) / ConstantSize),
+            static_cast<unsigned int>(BlockSize / ConstantSize)};
+}
+
+ConstantShadow::ConstantShadow(size_t Size)
+    : Data((Size + ConstantPacking::ConstantSize - 1u) / ConstantPacking::ConstantSize * ConstantPacking::ConstantSize),
+      DirtyBegin(Data.size()), DirtyEnd(0u) {}
+
+void ConstantShadow::Write(size_t Offset, const void* Src, size_t Size) noexcept
+{
+    Size = std::min(Size, Data.size() - std::min(Offset, Data.size()));
+    if (Size == 0u)
+    {
+        return;
+    }
+
+    std::memcpy(Data.data() + Offset, Src, Size);
+    const size_t Begin = Offset / ConstantPacking::ConstantSize * ConstantPacking::ConstantSize;
+    const size_t End = (Offset + Size + ConstantPacking::ConstantSize - 1u) / ConstantPacking::ConstantSize * ConstantPacking::ConstantSize;
+    DirtyBegin = std::min(DirtyBegin, Begin);
+    DirtyEnd = std::max(DirtyEnd, End);
+}
+
+const void* ConstantShadow::GetData() const noexcept
+{
+    return Data.data();
+}
+
+size_t ConstantShadow::GetSize() const noexcept
+{
+    return Data.size();
+}
+
+bool ConstantShadow::IsDirty() const noexcept
+{
+    return DirtyBegin < DirtyEnd;
+}
+
+size_t ConstantShadow::GetDirtyBegin() const noexcept
+{
+    return DirtyBegin;
+}
+
+size_t ConstantShadow::GetDirtyEnd() const noexcept
+{
+    return DirtyEnd;
+}
+
+void ConstantShadow::ClearDirty() noexcept
+{
+    DirtyBegin = Data.size();
+    DirtyEnd = 0u;
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// Register slot of each update frequency, shared by all shader stages
+enum class ConstantFrequency : unsigned int
+{
+    Frame = 0u,
+    View = 1u,
+    Draw = 2u,
+    Count
+};
+
+// Position of a constant block inside a large constant buffer, in 16 byte constants.
+// D3D11.1 offsetting needs both values to be multiples of 16 constants (256 bytes).
+struct ConstantLocation
+{
+    unsigned int FirstConstant;
+    unsigned int NumConstants;
+};
+
+namespace ConstantPacking
+{
+    constexpr size_t ConstantSize = 16u;
+    constexpr size_t BlockAlignment = 256u;
+
+    // Size of one packed block, rounded up so every block starts on a 256 byte boundary
+    constexpr size_t GetBlockSize(size_t Size) noexcept
+    {
+        return (Size + BlockAlignment - 1u) / BlockAlignment * BlockAlignment;
+    }
+    // Copies Count blocks of Size bytes from Src (Size apart) to Dest (GetBlockSize(Size) apart)
+    void Pack(void* Dest, const void* Src, size_t Size, size_t Count) noexcept;
+    // Location of block Index of a packed run that starts at ByteOffset
+    ConstantLocation Locate(size_t ByteOffset, size_t Size, size_t Index) noexcept;
+}
+
+// CPU-side copy of a constant buffer. Writes only touch the shadow and widen the dirty
+// range, the GPU copy is updated once before the next draw.
+class ConstantShadow
+{
+public:
+    explicit ConstantShadow(size_t Size);
+
+    void Write(size_t Offset, const void* Data, size_t Size) noexcept;
+    const void* GetData() const noexcept;
+    size_t GetSize() const noexcept;
+    bool IsDirty() const noexcept;
+    // Dirty range widened to whole constants, [Begin, End) in bytes
+    size_t GetDirtyBegin() const noexcept;
+    size_t GetDirtyEnd() const noexcept;
+    void ClearDirty() noexcept;
+private:
+    std::vector<unsigned char> Data;
+    size_t DirtyBegin;
+    size_t DirtyEnd;
+};
\ No newline at end of file
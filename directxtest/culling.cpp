@@ -0,0 +1,200 @@
+#include "culling.h"
+#include "simd_lanes.h"
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+#if defined(SIMD_MATH_AVX2)
+    // Lane numbers of the set bits of every 8-bit mask, so one permute packs the kept lanes
+    struct PackTable
+    {
+        alignas(32) int32_t Lanes[256][8];
+    };
+    constexpr PackTable MakePackTable() noexcept
+    {
+        PackTable Table = {};
+        for (uint32_t Mask = 0; Mask < 256u; Mask++)
+        {
+            int32_t n = 0;
+            for (int32_t Lane = 0; Lane < 8; Lane++)
+            {
+                if (Mask & (1u << Lane))
+                {
+                    Table.Lanes[Mask][n++] = Lane;
+                }
+            }
+        }
+        return Table;
+    }
+    constexpr PackTable Pack = MakePackTable();
+#endif
+
+    // Appends Base + j for every set bit j of Mask at Visible[n] and returns the new count.
+    // Whole groups are written unconditionally, n never exceeds Base - FirstIndex so the
+    // stores stay within the group's own part of Visible.
+    template<size_t Width>
+    size_t Append(uint32_t Mask, uint32_t Base, uint32_t* Visible, size_t n) noexcept
+    {
+#if defined(SIMD_MATH_AVX2)
+        if constexpr (Width == 8u)
+        {
+            const __m256i Lanes = _mm256_load_si256(reinterpret_cast<const __m256i*>(Pack.Lanes[Mask]));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(Visible + n), _mm256_add_epi32(Lanes, _mm256_set1_epi32(static_cast<int>(Base))));
+            return n + static_cast<size_t>(std::popcount(Mask));
+        }
+        else
+#endif
+        {
+            for (uint32_t j = 0; j < Width; j++)
+            {
+                Visible[n] = Base + j;
+                n += (Mask >> j) & 1u;
+            }
+            return n;
+        }
+    }
+
+    // Distance(Lanes, i) returns the smallest signed distance of each object to a plane,
+    // counting its extent, so objects with a negative value are fully outside one plane
+    template<typename F>
+    size_t Cull(size_t Count, uint32_t* Visible, uint32_t FirstIndex, MathPath Path, F&& Distance) noexcept
+    {
+        size_t n = 0u;
+        ForEachLane(Count, Path, [&](auto Tag, size_t i)
+        {
+            using L = decltype(Tag);
+            const uint32_t Mask = MaskGreaterEqual(Distance(Tag, i), L::Set(0.0f));
+            n = Append<L::Width>(Mask, FirstIndex + static_cast<uint32_t>(i), Visible, n);
+        });
+        return n;
+    }
+
+    template<typename L>
+    L PlaneDistance(const Vec4& Plane, L x, L y, L z) noexcept
+    {
+        return x * L::Set(Plane.X) + y * L::Set(Plane.Y) + z * L::Set(Plane.Z) + L::Set(Plane.W);
+    }
+}
+
+Frustum Frustum::FromMatrix(const Mat4& ViewProjection) noexcept
+{
+    // Clip coordinates are p * M, so each one is p dotted with a column of M
+    const auto Column = [&](size_t c)
+    {
+        return Vec4{ViewProjection.M[0][c], ViewProjection.M[1][c], ViewProjection.M[2][c], ViewProjection.M[3][c]};
+    };
+    const Vec4 X = Column(0u);
+    const Vec4 Y = Column(1u);
+    const Vec4 Z = Column(2u);
+    const Vec4 W = Column(3u);
+
+    Frustum Result;
+    Result.Planes[Left] = W + X;
+    Result.Planes[Right] = W - X;
+    Result.Planes[Bottom] = W + Y;
+    Result.Planes[Top] = W - Y;
+    Result.Planes[Near] = Z;
+    Result.Planes[Far] = W - Z;
+    for (Vec4& Plane : Result.Planes)
+    {
+        const float NormalLength = Length(Vec3{Plane.X, Plane.Y, Plane.Z});
+        if (NormalLength > 0.0f)
+        {
+            Plane = Plane * (1.0f / NormalLength);
+        }
+    }
+    return Result;
+}
+
+size_t CullSpheres(const Frustum& View, const SphereStreams& Spheres, size_t Count, uint32_t* Visible, uint32_t FirstIndex, MathPath Path) noexcept
+{
+    return Cull(Count, Visible, FirstIndex, Path, [&](auto Tag, size_t i)
+    {
+        using L = decltype(Tag);
+        const L x = L::Load(Spheres.X + i);
+        const L y = L::Load(Spheres.Y + i);
+        const L z = L::Load(Spheres.Z + i);
+        const L r = L::Load(Spheres.Radius + i);
+        L Nearest = PlaneDistance(View.Planes[0], x, y, z);
+        for (size_t p = 1; p < Frustum::SideCount; p++)
+        {
+            Nearest = Min(Nearest, PlaneDistance(View.Planes[p], x, y, z));
+        }
+        return Nearest + r;
+    });
+}
+
+size_t CullBoxes(const Frustum& View, const BoxStreams& Boxes, size_t Count, uint32_t* Visible, uint32_t FirstIndex, MathPath Path) noexcept
+{
+    return Cull(Count, Visible, FirstIndex, Path, [&](auto Tag, size_t i)
+    {
+        using L = decltype(Tag);
+        const L x = L::Load(Boxes.CenterX + i);
+        const L y = L::Load(Boxes.CenterY + i);
+        const L z = L::Load(Boxes.CenterZ + i);
+        const L ex = L::Load(Boxes.ExtentX + i);
+        const L ey = L::Load(Boxes.ExtentY + i);
+        const L ez = L::Load(Boxes.ExtentZ + i);
+        // The box reaches |n| . extent beyond its center towards each plane
+        const auto Distance = [&](const Vec4& Plane)
+        {
+            return PlaneDistance(Plane, x, y, z) + ex * L::Set(std::fabs(Plane.X)) + ey * L::Set(std::fabs(Plane.Y)) + ez * L::Set(std::fabs(Plane.Z));
+        };
+        L Nearest = Distance(View.Planes[0]);
+        for (size_t p = 1; p < Frustum::SideCount; p++)
+        {
+            Nearest = Min(Nearest, Distance(View.Planes[p]));
+        }
+        return Nearest;
+    });
+}
+
+// Parallel culling
+
+size_t FrustumCuller::CullSpheres(JobSystem& Jobs, const Frustum& View, const SphereStreams& Spheres, size_t Count, uint32_t* Visible)
+{
+    return Run(Jobs, Count, Visible, [&](size_t Begin, size_t End)
+    {
+        const SphereStreams Slice = {Spheres.X + Begin, Spheres.Y + Begin, Spheres.Z + Begin, Spheres.Radius + Begin};
+        return ::CullSpheres(View, Slice, End - Begin, Visible + Begin, static_cast<uint32_t>(Begin));
+    });
+}
+
+size_t FrustumCuller::CullBoxes(JobSystem& Jobs, const Frustum& View, const BoxStreams& Boxes, size_t Count, uint32_t* Visible)
+{
+    return Run(Jobs, Count, Visible, [&](size_t Begin, size_t End)
+    {
+        const BoxStreams Slice =
+        {
+            Boxes.CenterX + Begin, Boxes.CenterY + Begin, Boxes.CenterZ + Begin,
+            Boxes.ExtentX + Begin, Boxes.ExtentY + Begin, Boxes.ExtentZ + Begin
+        };
+        return ::CullBoxes(View, Slice, End - Begin, Visible + Begin, static_cast<uint32_t>(Begin));
+    });
+}
+
+template<typename F>
+size_t FrustumCuller::Run(JobSystem& Jobs, size_t Count, uint32_t* Visible, F&& CullSlice)
+{
+    if (Count <= Grain)
+    {
+        return CullSlice(0u, Count);
+    }
+
+    SliceCounts.assign((Count + Grain - 1u) / Grain, 0u);
+    Jobs.ParallelFor(Count, Grain, [&](size_t Begin, size_t End, unsigned int)
+    {
+        SliceCounts[Begin / Grain] = CullSlice(Begin, End);
+    });
+
+    // Slice k was written at k * Grain, close the gaps between them
+    size_t n = SliceCounts[0];
+    for (size_t k = 1; k < SliceCounts.size(); k++)
+    {
+        std::memmove(Visible + n, Visible + k * Grain, SliceCounts[k] * sizeof(uint32_t));
+        n += SliceCounts[k];
+    }
+    return n;
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+#include "simd_math.h"
+#include "job_system.h"
+#include <cstdint>
+#include <vector>
+
+// View frustum as six inward-facing planes (Normal.X, Normal.Y, Normal.Z, Distance), a
+// point p is inside a plane when Dot(Normal, p) + Distance >= 0. Normals are unit length
+// so the same value is the signed distance used for spheres.
+struct Frustum
+{
+    enum Side
+    {
+        Left,
+        Right,
+        Bottom,
+        Top,
+        Near,
+        Far,
+        SideCount
+    };
+    Vec4 Planes[SideCount];
+
+    // Planes of a row-vector view-projection matrix with D3D clip depth 0..1
+    static Frustum FromMatrix(const Mat4& ViewProjection) noexcept;
+};
+
+// Component arrays of Count bounding spheres
+struct SphereStreams
+{
+    const float* X;
+    const float* Y;
+    const float* Z;
+    const float* Radius;
+};
+// Component arrays of Count axis-aligned boxes as center and half extent
+struct BoxStreams
+{
+    const float* CenterX;
+    const float* CenterY;
+    const float* CenterZ;
+    const float* ExtentX;
+    const float* ExtentY;
+    const float* ExtentZ;
+};
+
+// Conservative tests: an object is kept unless it lies fully outside one plane. Visible
+// receives the indices of kept objects in ascending order, offset by FirstIndex, and
+// must have room for Count entries. Returns the number of indices written.
+size_t CullSpheres(const Frustum& View, const SphereStreams& Spheres, size_t Count, uint32_t* Visible, uint32_t FirstIndex = 0u, MathPath Path = MathPath::Native) noexcept;
+size_t CullBoxes(const Frustum& View, const BoxStreams& Boxes, size_t Count, uint32_t* Visible, uint32_t FirstIndex = 0u, MathPath Path = MathPath::Native) noexcept;
+
+// The batch tests above split over the job system. Every job culls its own slice into
+// the matching slice of Visible and the slices are packed together afterwards, so the
+// result is the same ascending list the serial functions produce.
+class FrustumCuller
+{
+public:
+    // Objects per job, smaller batches run on the calling thread
+    static constexpr size_t Grain = 16384u;
+public:
+    size_t CullSpheres(JobSystem& Jobs, const Frustum& View, const SphereStreams& Spheres, size_t Count, uint32_t* Visible);
+    size_t CullBoxes(JobSystem& Jobs, const Frustum& View, const BoxStreams& Boxes, size_t Count, uint32_t* Visible);
+private:
+    template<typename F>
+    size_t Run(JobSystem& Jobs, size_t Count, uint32_t* Visible, F&& CullSlice);
+private:
+    // Visible objects of every slice of the last call
+    std::vector<size_t> SliceCounts;
+};
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include "deferred_release.h"
+
+DeferredReleaseQueue::~DeferredReleaseQueue()
+{
+    RetireAll();
+}
+
+void DeferredReleaseQueue::Enqueue(void* Object, Deleter Delete, uint64_t LastUsedFrame)
+{
+    Node* const n = new Node{Object, Delete, LastUsedFrame, Incoming.load(std::memory_order_relaxed)};
+    while (!Incoming.compare_exchange_weak(n->Next, n, std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+    PendingCount.fetch_add(1u, std::memory_order_relaxed);
+}
+
+size_t DeferredReleaseQueue::Retire(uint64_t CompletedFrame) noexcept
+{
+    CollectIncoming();
+
+    size_t Retired = 0u;
+    Node** Link = &Pending;
+    while (Node* n = *Link)
+    {
+        if (n->Frame <= CompletedFrame)
+        {
+            *Link = n->Next;
+            n->Delete(n->Object);
+            delete n;
+            Retired++;
+        }
+        else
+        {
+            Link = &n->Next;
+        }
+    }
+    PendingTail = Link;
+
+    PendingCount.fetch_sub(Retired, std::memory_order_relaxed);
+    return Retired;
+}
+
+size_t DeferredReleaseQueue::RetireAll() noexcept
+{
+    return Retire(UINT64_MAX);
+}
+
+size_t DeferredReleaseQueue::GetPendingCount() const noexcept
+{
+    return PendingCount.load(std::memory_order_relaxed);
+}
+
+void DeferredReleaseQueue::CollectIncoming() noexcept
+{
+    // The stack is newest first, reversed it continues the pending list
+    Node* n = Incoming.exchange(nullptr, std::memory_order_acquire);
+    Node* Batch = nullptr;
+    Node* BatchLast = n;
+    while (n)
+    {
+        Node* const Next = n->Next;
+        n->Next = Batch;
+        Batch = n;
+        n = Next;
+    }
+    if (Batch)
+    {
+        *PendingTail = Batch;
+        PendingTail = &BatchLast->Next;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Holds objects that may still be referenced by frames in flight and destroys them once
+// the frame that last used them has completed. Enqueue is lock-free and may be called
+// from any thread, Retire is only called by the thread that advances the frame counter.
+class DeferredReleaseQueue
+{
+public:
+    using Deleter = void(*)(void* Object) noexcept;
+public:
+    DeferredReleaseQueue() = default;
+    ~DeferredReleaseQueue();
+    DeferredReleaseQueue(const DeferredReleaseQueue&) = delete;
+    DeferredReleaseQueue& operator=(const DeferredReleaseQueue&) = delete;
+
+    void Enqueue(void* Object, Deleter Delete, uint64_t LastUsedFrame);
+    // Destroys everything last used in CompletedFrame or earlier in the order it was
+    // enqueued, returns how many
+    size_t Retire(uint64_t CompletedFrame) noexcept;
+    // Destroys everything regardless of frame, e.g. on shutdown
+    size_t RetireAll() noexcept;
+    size_t GetPendingCount() const noexcept;
+private:
+    struct Node
+    {
+        void* Object;
+        Deleter Delete;
+        uint64_t Frame;
+        Node* Next;
+    };
+    void CollectIncoming() noexcept;
+private:
+    // Producers push onto a lock-free stack, the consumer takes all of it at once
+    std::atomic<Node*> Incoming{nullptr};
+    // Consumer-owned, oldest first
+    Node* Pending = nullptr;
+    Node** PendingTail = &Pending;
+    std::atomic<size_t> PendingCount{0u};
+};
\ No newline at end of file
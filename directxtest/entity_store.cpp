@@ -0,0 +1,416 @@
+#include "entity_store.h"
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+namespace
+{
+    ComponentRegistry::Info ComponentInfos[ComponentRegistry::MaxTypes];
+    uint32_t ComponentCount = 0u;
+    std::mutex RegistryMutex;
+
+    size_t AlignUp(size_t Value, size_t Alignment) noexcept
+    {
+        return (Value + Alignment - 1u) & ~(Alignment - 1u);
+    }
+}
+
+// Component registry
+uint32_t ComponentRegistry::Register(size_t Size, size_t Alignment)
+{
+    std::lock_guard<std::mutex> Lock(RegistryMutex);
+    if (ComponentCount == MaxTypes)
+    {
+        throw std::length_error("Too many component types");
+    }
+    if (Alignment > EntityStore::ColumnAlignment)
+    {
+        throw std::invalid_argument("Component alignment exceeds the chunk column alignment");
+    }
+    ComponentInfos[ComponentCount] = {Size, Alignment};
+    return ComponentCount++;
+}
+
+const ComponentRegistry::Info& ComponentRegistry::GetInfo(uint32_t Id) noexcept
+{
+    return ComponentInfos[Id];
+}
+
+// Command buffer
+bool CommandBuffer::IsEmpty() const noexcept
+{
+    return Bytes.empty();
+}
+
+void CommandBuffer::Clear() noexcept
+{
+    Bytes.clear();
+}
+
+void CommandBuffer::WriteBytes(const void* Data, size_t Size)
+{
+    const size_t Position = Bytes.size();
+    Bytes.resize(Position + Size);
+    std::memcpy(Bytes.data() + Position, Data, Size);
+}
+
+void CommandBuffer::ReadBytes(size_t& Position, void* Data, size_t Size) const noexcept
+{
+    std::memcpy(Data, Bytes.data() + Position, Size);
+    Position += Size;
+}
+
+// Entity store
+void EntityStore::Destroy(Entity e)
+{
+    CheckStructuralChange();
+    Slot& s = GetSlot(e);
+    EraseRow(*s.Type, s.ChunkIndex, s.Row);
+    s.Type = nullptr;
+
+    // Generation 0 is skipped so that a handle value is never 0
+    s.Generation = (s.Generation + 1u) & Entity::GenerationMask;
+    if (s.Generation == 0u)
+    {
+        s.Generation = 1u;
+    }
+    FreeSlots.push_back(e.GetIndex());
+    EntityCount--;
+}
+
+bool EntityStore::IsAlive(Entity e) const noexcept
+{
+    const uint32_t Index = e.GetIndex();
+    return e.IsValid() && Index < Slots.size() && Slots[Index].Type != nullptr && Slots[Index].Generation == e.GetGeneration();
+}
+
+void EntityStore::Apply(CommandBuffer& Commands)
+{
+    CheckStructuralChange();
+    size_t Position = 0u;
+    while (Position < Commands.Bytes.size())
+    {
+        switch (Commands.Read<CommandBuffer::Op>(Position))
+        {
+            case CommandBuffer::Op::Create:
+            {
+                const uint32_t TypeCount = Commands.Read<uint32_t>(Position);
+                uint32_t Ids[ComponentRegistry::MaxTypes];
+                ComponentMask Mask;
+                for (uint32_t t = 0; t < TypeCount; t++)
+                {
+                    Ids[t] = Commands.Read<uint32_t>(Position);
+                    Mask.set(Ids[t]);
+                }
+                const Entity e = CreateEntity(Mask);
+                for (uint32_t t = 0; t < TypeCount; t++)
+                {
+                    SetComponent(e, Ids[t], Commands.Bytes.data() + Position);
+                    Position += ComponentRegistry::GetInfo(Ids[t]).Size;
+                }
+            } break;
+
+            case CommandBuffer::Op::Destroy:
+            {
+                const Entity e = Commands.Read<Entity>(Position);
+                if (IsAlive(e))
+                {
+                    Destroy(e);
+                }
+            } break;
+
+            case CommandBuffer::Op::Add:
+            {
+                const Entity e = Commands.Read<Entity>(Position);
+                const uint32_t Id = Commands.Read<uint32_t>(Position);
+                if (IsAlive(e))
+                {
+                    AddComponent(e, Id, Commands.Bytes.data() + Position);
+                }
+                Position += ComponentRegistry::GetInfo(Id).Size;
+            } break;
+
+            case CommandBuffer::Op::Remove:
+            {
+                const Entity e = Commands.Read<Entity>(Position);
+                const uint32_t Id = Commands.Read<uint32_t>(Position);
+                if (IsAlive(e))
+                {
+                    RemoveComponent(e, Id);
+                }
+            } break;
+        }
+    }
+    Commands.Clear();
+}
+
+size_t EntityStore::GetEntityCount() const noexcept
+{
+    return EntityCount;
+}
+
+size_t EntityStore::GetArchetypeCount() const noexcept
+{
+    return Archetypes.size();
+}
+
+size_t EntityStore::GetChunkCount() const noexcept
+{
+    size_t Total = 0u;
+    for (const auto& Type : Archetypes)
+    {
+        Total += Type->Chunks.size();
+    }
+    return Total;
+}
+
+Entity EntityStore::CreateEntity(const ComponentMask& Mask)
+{
+    CheckStructuralChange();
+    Archetype& Type = GetArchetype(Mask);
+
+    uint32_t Index;
+    if (!FreeSlots.empty())
+    {
+        Index = FreeSlots.back();
+        FreeSlots.pop_back();
+    }
+    else
+    {
+        if (Slots.size() > Entity::IndexMask)
+        {
+            throw std::length_error("EntityStore is out of entity slots");
+        }
+        Index = static_cast<uint32_t>(Slots.size());
+        Slots.push_back({1u, nullptr, 0u, 0u});
+    }
+
+    const Entity e = Entity::Make(Index, Slots[Index].Generation);
+    Place(e, Type);
+    EntityCount++;
+    return e;
+}
+
+void* EntityStore::GetComponent(Entity e, uint32_t Id) noexcept
+{
+    if (!IsAlive(e))
+    {
+        return nullptr;
+    }
+    const Slot& s = Slots[e.GetIndex()];
+    if (!s.Type->Mask.test(Id))
+    {
+        return nullptr;
+    }
+    return s.Type->Chunks[s.ChunkIndex].Data.get() + s.Type->Offsets[Id] + s.Row * ComponentRegistry::GetInfo(Id).Size;
+}
+
+void EntityStore::SetComponent(Entity e, uint32_t Id, const void* Data) noexcept
+{
+    std::memcpy(GetComponent(e, Id), Data, ComponentRegistry::GetInfo(Id).Size);
+}
+
+void EntityStore::AddComponent(Entity e, uint32_t Id, const void* Data)
+{
+    const Slot& s = GetSlot(e);
+    if (!s.Type->Mask.test(Id))
+    {
+        CheckStructuralChange();
+        Archetype*& To = s.Type->AddEdges[Id];
+        if (!To)
+        {
+            To = &GetArchetype(ComponentMask(s.Type->Mask).set(Id));
+        }
+        Move(e, *To);
+    }
+    SetComponent(e, Id, Data);
+}
+
+void EntityStore::RemoveComponent(Entity e, uint32_t Id)
+{
+    const Slot& s = GetSlot(e);
+    if (s.Type->Mask.test(Id))
+    {
+        CheckStructuralChange();
+        Archetype*& To = s.Type->RemoveEdges[Id];
+        if (!To)
+        {
+            To = &GetArchetype(ComponentMask(s.Type->Mask).reset(Id));
+        }
+        Move(e, *To);
+    }
+}
+
+EntityStore::Slot& EntityStore::GetSlot(Entity e)
+{
+    if (!IsAlive(e))
+    {
+        throw STALE_HANDLE_EXCEPT(e);
+    }
+    return Slots[e.GetIndex()];
+}
+
+void EntityStore::CheckStructuralChange() const
+{
+    if (IterationDepth != 0u)
+    {
+        throw std::logic_error("Structural change while iterating entities, use a CommandBuffer");
+    }
+}
+
+EntityStore::Archetype& EntityStore::GetArchetype(const ComponentMask& Mask)
+{
+    const auto Found = ArchetypeByMask.find(Mask.to_ullong());
+    if (Found != ArchetypeByMask.end())
+    {
+        return *Found->second;
+    }
+
+    auto Type = std::make_unique<Archetype>();
+    Type->Mask = Mask;
+    size_t RowBytes = sizeof(Entity);
+    for (uint32_t Id = 0; Id < ComponentRegistry::MaxTypes; Id++)
+    {
+        if (Mask.test(Id))
+        {
+            Type->Types.push_back(Id);
+            RowBytes += ComponentRegistry::GetInfo(Id).Size;
+        }
+    }
+
+    // Rows per chunk, leaving room to start every column on a cache line
+    const size_t Padding = ColumnAlignment * Type->Types.size();
+    if (ChunkBytes < Padding + RowBytes)
+    {
+        throw std::length_error("Components do not fit in an entity chunk");
+    }
+    Type->Capacity = static_cast<uint32_t>((ChunkBytes - Padding) / RowBytes);
+    size_t Offset = Type->Capacity * sizeof(Entity);
+    for (const uint32_t Id : Type->Types)
+    {
+        Offset = AlignUp(Offset, ColumnAlignment);
+        Type->Offsets[Id] = Offset;
+        Offset += Type->Capacity * ComponentRegistry::GetInfo(Id).Size;
+    }
+
+    Archetype& Created = *Type;
+    Archetypes.push_back(std::move(Type));
+    ArchetypeByMask.emplace(Mask.to_ullong(), &Created);
+    return Created;
+}
+
+void EntityStore::Place(Entity e, Archetype& Type)
+{
+    if (Type.Chunks.empty() || Type.Chunks.back().Count == Type.Capacity)
+    {
+        Chunk Fresh;
+        Fresh.Data.reset(static_cast<std::byte*>(::operator new(ChunkBytes, std::align_val_t(ColumnAlignment))));
+        Fresh.Count = 0u;
+        Type.Chunks.push_back(std::move(Fresh));
+        ChunksVersion++;
+    }
+
+    Chunk& c = Type.Chunks.back();
+    const uint32_t Row = c.Count++;
+    GetEntities(c)[Row] = e;
+    Slot& s = Slots[e.GetIndex()];
+    s.Type = &Type;
+    s.ChunkIndex = static_cast<uint32_t>(Type.Chunks.size() - 1u);
+    s.Row = Row;
+    Type.EntityCount++;
+}
+
+void EntityStore::EraseRow(Archetype& Type, uint32_t ChunkIndex, uint32_t Row) noexcept
+{
+    Chunk& Last = Type.Chunks.back();
+    const uint32_t LastRow = Last.Count - 1u;
+    Chunk& Hole = Type.Chunks[ChunkIndex];
+    if (&Hole != &Last || Row != LastRow)
+    {
+        const Entity Moved = GetEntities(Last)[LastRow];
+        GetEntities(Hole)[Row] = Moved;
+        for (const uint32_t Id : Type.Types)
+        {
+            const size_t Size = ComponentRegistry::GetInfo(Id).Size;
+            std::memcpy(Hole.Data.get() + Type.Offsets[Id] + Row * Size, Last.Data.get() + Type.Offsets[Id] + LastRow * Size, Size);
+        }
+        Slot& s = Slots[Moved.GetIndex()];
+        s.ChunkIndex = ChunkIndex;
+        s.Row = Row;
+    }
+
+    if (--Last.Count == 0u)
+    {
+        Type.Chunks.pop_back();
+        ChunksVersion++;
+    }
+    Type.EntityCount--;
+}
+
+void EntityStore::Move(Entity e, Archetype& To)
+{
+    const Slot& s = Slots[e.GetIndex()];
+    Archetype& From = *s.Type;
+    const uint32_t FromChunk = s.ChunkIndex;
+    const uint32_t FromRow = s.Row;
+
+    Place(e, To);
+    const std::byte* const Source = From.Chunks[FromChunk].Data.get();
+    std::byte* const Target = To.Chunks[s.ChunkIndex].Data.get();
+    for (const uint32_t Id : To.Types)
+    {
+        if (From.Mask.test(Id))
+        {
+            const size_t Size = ComponentRegistry::GetInfo(Id).Size;
+            std::memcpy(Target + To.Offsets[Id] + s.Row * Size, Source + From.Offsets[Id] + FromRow * Size, Size);
+        }
+    }
+    EraseRow(From, FromChunk, FromRow);
+}
+
+EntityStore::Query& EntityStore::FindQuery(const ComponentMask& Mask)
+{
+    Query* Matches = nullptr;
+    for (const auto& Cached : Queries)
+    {
+        if (Cached->Mask == Mask)
+        {
+            Matches = Cached.get();
+            break;
+        }
+    }
+    if (!Matches)
+    {
+        Queries.push_back(std::make_unique<Query>());
+        Matches = Queries.back().get();
+        Matches->Mask = Mask;
+    }
+
+    // Archetypes are never removed, so only the ones created since the last use are new
+    for (; Matches->ArchetypesSeen < Archetypes.size(); Matches->ArchetypesSeen++)
+    {
+        Archetype* Type = Archetypes[Matches->ArchetypesSeen].get();
+        if ((Type->Mask & Mask) == Mask)
+        {
+            Matches->Archetypes.push_back(Type);
+        }
+    }
+    return *Matches;
+}
+
+const std::vector<EntityStore::ChunkRef>& EntityStore::CollectChunks(Query& Matches)
+{
+    if (Matches.ChunksVersion != ChunksVersion)
+    {
+        Matches.Chunks.clear();
+        for (Archetype* Type : Matches.Archetypes)
+        {
+            for (uint32_t c = 0; c < Type->Chunks.size(); c++)
+            {
+                Matches.Chunks.push_back({Type, c});
+            }
+        }
+        Matches.ChunksVersion = ChunksVersion;
+    }
+    return Matches.Chunks;
+}
\ No newline at end of file
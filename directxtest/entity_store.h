@@ -0,0 +1,332 @@
+#pragma once
+#include "handle_pool.h"
+#include "job_system.h"
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// Entity-component storage grouped by archetype. All entities with the same set of
+// component types share an archetype, whose fixed-size chunks hold one tightly packed
+// column per component, so systems walk plain arrays instead of chasing pointers.
+// Queries cache the archetypes they match and only look at archetypes created since.
+//
+// Creating and destroying entities or adding and removing components moves rows between
+// chunks, which is not allowed while iterating. Systems record those changes into a
+// CommandBuffer (one per thread in parallel loops) and the owner applies the buffers at
+// the frame boundary. Components must be trivially copyable, rows are moved with memcpy.
+using Entity = Handle<struct EntityTag>;
+using ComponentMask = std::bitset<64>;
+
+// Process-wide component type ids, assigned on first use
+class ComponentRegistry
+{
+public:
+    static constexpr uint32_t MaxTypes = 64u;
+    struct Info
+    {
+        size_t Size;
+        size_t Alignment;
+    };
+public:
+    template<typename T>
+    static uint32_t GetId()
+    {
+        if constexpr (!std::is_same_v<T, std::remove_cv_t<T>>)
+        {
+            return GetId<std::remove_cv_t<T>>();
+        }
+        else
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Components are moved with memcpy");
+            static const uint32_t Id = Register(sizeof(T), alignof(T));
+            return Id;
+        }
+    }
+    static const Info& GetInfo(uint32_t Id) noexcept;
+private:
+    static uint32_t Register(size_t Size, size_t Alignment);
+};
+
+// Structural changes recorded for later, see EntityStore::Apply
+class CommandBuffer
+{
+public:
+    template<typename... Ts>
+    void Create(const Ts&... Components)
+    {
+        Write(Op::Create);
+        Write(static_cast<uint32_t>(sizeof...(Ts)));
+        (Write(ComponentRegistry::GetId<Ts>()), ...);
+        (Write(Components), ...);
+    }
+    void Destroy(Entity e)
+    {
+        Write(Op::Destroy);
+        Write(e);
+    }
+    template<typename T>
+    void Add(Entity e, const T& Component)
+    {
+        Write(Op::Add);
+        Write(e);
+        Write(ComponentRegistry::GetId<T>());
+        Write(Component);
+    }
+    template<typename T>
+    void Remove(Entity e)
+    {
+        Write(Op::Remove);
+        Write(e);
+        Write(ComponentRegistry::GetId<T>());
+    }
+
+    bool IsEmpty() const noexcept;
+    void Clear() noexcept;
+private:
+    friend class EntityStore;
+    enum class Op : uint8_t
+    {
+        Create,
+        Destroy,
+        Add,
+        Remove
+    };
+private:
+    template<typename T>
+    void Write(const T& Value)
+    {
+        WriteBytes(&Value, sizeof(T));
+    }
+    void WriteBytes(const void* Data, size_t Size);
+    template<typename T>
+    T Read(size_t& Position) const noexcept
+    {
+        T Value;
+        ReadBytes(Position, &Value, sizeof(T));
+        return Value;
+    }
+    void ReadBytes(size_t& Position, void* Data, size_t Size) const noexcept;
+private:
+    std::vector<std::byte> Bytes;
+};
+
+class EntityStore
+{
+public:
+    // Small enough that a system's columns of one chunk stay in L1
+    static constexpr size_t ChunkBytes = 16u * 1024u;
+    // Every column starts on a cache line
+    static constexpr size_t ColumnAlignment = 64u;
+public:
+    EntityStore() = default;
+    ~EntityStore() = default;
+    EntityStore(const EntityStore&) = delete;
+    EntityStore& operator=(const EntityStore&) = delete;
+
+    template<typename... Ts>
+    Entity Create(const Ts&... Components)
+    {
+        const Entity e = CreateEntity(MaskOf<Ts...>());
+        (SetComponent(e, ComponentRegistry::GetId<Ts>(), &Components), ...);
+        return e;
+    }
+    void Destroy(Entity e);
+    // Overwrites the component if the entity already has one
+    template<typename T>
+    void Add(Entity e, const T& Component)
+    {
+        AddComponent(e, ComponentRegistry::GetId<T>(), &Component);
+    }
+    template<typename T>
+    void Remove(Entity e)
+    {
+        RemoveComponent(e, ComponentRegistry::GetId<T>());
+    }
+    bool IsAlive(Entity e) const noexcept;
+    // Null for stale entities and entities without T. Valid until the next structural change.
+    template<typename T>
+    T* Get(Entity e) noexcept
+    {
+        return static_cast<T*>(GetComponent(e, ComponentRegistry::GetId<T>()));
+    }
+
+    // Body(Count, const Entity*, Ts*...) once per chunk of entities that have all of Ts,
+    // the shape for loops the compiler can vectorize. Ts may be const.
+    template<typename... Ts, typename F>
+    void ForEachChunk(F&& Body)
+    {
+        const IterationScope Scope(*this);
+        Query& Matches = FindQuery(MaskOf<Ts...>());
+        for (Archetype* Type : Matches.Archetypes)
+        {
+            for (Chunk& c : Type->Chunks)
+            {
+                Body(static_cast<size_t>(c.Count), GetEntities(c), GetColumn<Ts>(*Type, c)...);
+            }
+        }
+    }
+    // Body(Entity, Ts&...) for every entity that has all of Ts
+    template<typename... Ts, typename F>
+    void ForEach(F&& Body)
+    {
+        ForEachChunk<Ts...>([&](size_t Count, const Entity* Entities, Ts*... Columns)
+        {
+            for (size_t i = 0; i < Count; i++)
+            {
+                Body(Entities[i], Columns[i]...);
+            }
+        });
+    }
+    // ForEachChunk with the chunks spread over the job system, Body gets the thread index last
+    template<typename... Ts, typename F>
+    void ParallelForEachChunk(JobSystem& Jobs, F&& Body)
+    {
+        const IterationScope Scope(*this);
+        const std::vector<ChunkRef>& Chunks = CollectChunks(FindQuery(MaskOf<Ts...>()));
+        Jobs.ParallelFor(Chunks.size(), 1u, [&](size_t Begin, size_t End, unsigned int Thread)
+        {
+            for (size_t i = Begin; i < End; i++)
+            {
+                Archetype& Type = *Chunks[i].Type;
+                Chunk& c = Type.Chunks[Chunks[i].Index];
+                Body(static_cast<size_t>(c.Count), GetEntities(c), GetColumn<Ts>(Type, c)..., Thread);
+            }
+        });
+    }
+    template<typename... Ts>
+    size_t Count()
+    {
+        size_t Total = 0u;
+        for (const Archetype* Type : FindQuery(MaskOf<Ts...>()).Archetypes)
+        {
+            Total += Type->EntityCount;
+        }
+        return Total;
+    }
+
+    // Runs the recorded commands in order and clears the buffer. Commands on entities that
+    // were destroyed in the meantime are skipped.
+    void Apply(CommandBuffer& Commands);
+
+    size_t GetEntityCount() const noexcept;
+    size_t GetArchetypeCount() const noexcept;
+    size_t GetChunkCount() const noexcept;
+private:
+    struct ChunkDeleter
+    {
+        void operator()(std::byte* Data) const noexcept
+        {
+            ::operator delete(Data, std::align_val_t(ColumnAlignment));
+        }
+    };
+    struct Chunk
+    {
+        std::unique_ptr<std::byte, ChunkDeleter> Data;
+        uint32_t Count;
+    };
+    struct Archetype
+    {
+        ComponentMask Mask;
+        std::vector<uint32_t> Types;
+        // Byte offset of each component's column in a chunk, the entity column is at 0
+        size_t Offsets[ComponentRegistry::MaxTypes] = {};
+        uint32_t Capacity = 0u;
+        // Only the last chunk is partially filled
+        std::vector<Chunk> Chunks;
+        size_t EntityCount = 0u;
+        // Archetype reached by adding or removing each component, filled in on first use
+        Archetype* AddEdges[ComponentRegistry::MaxTypes] = {};
+        Archetype* RemoveEdges[ComponentRegistry::MaxTypes] = {};
+    };
+    struct Slot
+    {
+        uint32_t Generation;
+        // Null while the slot is free
+        Archetype* Type;
+        uint32_t ChunkIndex;
+        uint32_t Row;
+    };
+    struct ChunkRef
+    {
+        Archetype* Type;
+        uint32_t Index;
+    };
+    struct Query
+    {
+        ComponentMask Mask;
+        std::vector<Archetype*> Archetypes;
+        size_t ArchetypesSeen = 0u;
+        // Flattened for parallel loops, rebuilt when chunks were added or freed
+        std::vector<ChunkRef> Chunks;
+        uint64_t ChunksVersion = ~0ull;
+    };
+    // Structural changes throw while one of these is alive
+    class IterationScope
+    {
+    public:
+        explicit IterationScope(EntityStore& Store) noexcept : Store(Store)
+        {
+            Store.IterationDepth++;
+        }
+        ~IterationScope()
+        {
+            Store.IterationDepth--;
+        }
+        IterationScope(const IterationScope&) = delete;
+        IterationScope& operator=(const IterationScope&) = delete;
+    private:
+        EntityStore& Store;
+    };
+private:
+    template<typename... Ts>
+    static ComponentMask MaskOf()
+    {
+        ComponentMask Mask;
+        (Mask.set(ComponentRegistry::GetId<Ts>()), ...);
+        return Mask;
+    }
+    static Entity* GetEntities(Chunk& c) noexcept
+    {
+        return reinterpret_cast<Entity*>(c.Data.get());
+    }
+    template<typename T>
+    static T* GetColumn(const Archetype& Type, Chunk& c) noexcept
+    {
+        return reinterpret_cast<T*>(c.Data.get() + Type.Offsets[ComponentRegistry::GetId<T>()]);
+    }
+
+    Entity CreateEntity(const ComponentMask& Mask);
+    void* GetComponent(Entity e, uint32_t Id) noexcept;
+    void SetComponent(Entity e, uint32_t Id, const void* Data) noexcept;
+    void AddComponent(Entity e, uint32_t Id, const void* Data);
+    void RemoveComponent(Entity e, uint32_t Id);
+    // Throws for stale entities
+    Slot& GetSlot(Entity e);
+    void CheckStructuralChange() const;
+
+    Archetype& GetArchetype(const ComponentMask& Mask);
+    // Appends a row for e and points its slot there, component columns are left unset
+    void Place(Entity e, Archetype& Type);
+    // Fills the hole with the archetype's last row
+    void EraseRow(Archetype& Type, uint32_t ChunkIndex, uint32_t Row) noexcept;
+    // Moves e to another archetype, copying the components both have
+    void Move(Entity e, Archetype& To);
+
+    Query& FindQuery(const ComponentMask& Mask);
+    const std::vector<ChunkRef>& CollectChunks(Query& Matches);
+private:
+    std::vector<std::unique_ptr<Archetype>> Archetypes;
+    std::unordered_map<unsigned long long, Archetype*> ArchetypeByMask;
+    std::vector<std::unique_ptr<Query>> Queries;
+    std::vector<Slot> Slots;
+    std::vector<uint32_t> FreeSlots;
+    size_t EntityCount = 0u;
+    // Bumped whenever a chunk is allocated or freed
+    uint64_t ChunksVersion = 0u;
+    unsigned int IterationDepth = 0u;
+};
\ No newline at end of file
@@ -1,10 +1,16 @@
 #include "exceptions.h"
+#include "alloc_tracker.h"
 #include <sstream>
 
-MyException::MyException(int Line, const char* File) noexcept : Line(Line), File(File) {}
+MyException::MyException(int Line, const char* File) noexcept : Line(Line)
+{
+    AllocScope Scope(AllocTag::Exception);
+    this->File = File;
+}
 
 const char* MyException::what() const noexcept
 {
+    AllocScope Scope(AllocTag::Exception);
     std::ostringstream oss;
     oss << GetType() << std::endl << GetOriginString();
     whatBuffer = oss.str();
@@ -0,0 +1,66 @@
+#include "frame_arena.h"
+#include <sstream>
+
+FrameArena::FrameArena(size_t Capacity) : Memory(std::make_unique<std::byte[]>(Capacity)), Capacity(Capacity) {}
+
+void* FrameArena::Allocate(size_t Size, size_t Alignment)
+{
+    // Alignment is always a power of two
+    const size_t Aligned = (Offset + Alignment - 1u) & ~(Alignment - 1u);
+    if (Aligned + Size > Capacity || Aligned + Size < Aligned)
+    {
+        throw FRAME_ARENA_EXCEPT(Size, Offset, Capacity);
+    }
+
+    Offset = Aligned + Size;
+    if (Offset > HighWaterMark)
+    {
+        HighWaterMark = Offset;
+    }
+    return Memory.get() + Aligned;
+}
+
+void FrameArena::Reset() noexcept
+{
+    Offset = 0u;
+}
+
+std::byte* FrameArena::GetData() noexcept
+{
+    return Memory.get();
+}
+
+size_t FrameArena::GetUsed() const noexcept
+{
+    return Offset;
+}
+
+size_t FrameArena::GetCapacity() const noexcept
+{
+    return Capacity;
+}
+
+size_t FrameArena::GetHighWaterMark() const noexcept
+{
+    return HighWaterMark;
+}
+
+// Frame arena exceptions
+FrameArena::Exception::Exception(int Line, const char* File, size_t Requested, size_t Used, size_t Capacity) noexcept
+    : MyException(Line, File), Requested(Requested), Used(Used), Capacity(Capacity) {}
+
+const char* FrameArena::Exception::what() const noexcept
+{
+    std::ostringstream oss;
+    oss << GetType() << std::endl
+        << "[Requested] " << Requested << " bytes" << std::endl
+        << "[Used] " << Used << " / " << Capacity << " bytes" << std::endl
+        << GetOriginString();
+    whatBuffer = oss.str();
+    return whatBuffer.c_str();
+}
+
+const char* FrameArena::Exception::GetType() const noexcept
+{
+    return "Frame Arena Exception [Out Of Memory]";
+}
\ No newline at end of file
@@ -0,0 +1,149 @@
+#pragma once
+#include "exceptions.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Linear (bump) allocator for data that only lives for the duration of a frame.
+// Nothing is freed individually, the whole arena is rewound with Reset().
+class FrameArena
+{
+public:
+    class Exception : public MyException
+    {
+    public:
+        Exception(int Line, const char* File, size_t Requested, size_t Used, size_t Capacity) noexcept;
+        const char* what() const noexcept override;
+        const char* GetType() const noexcept override;
+    private:
+        size_t Requested;
+        size_t Used;
+        size_t Capacity;
+    };
+public:
+    explicit FrameArena(size_t Capacity);
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* Allocate(size_t Size, size_t Alignment = alignof(std::max_align_t));
+    // NOTE: Destructors are never run, so only trivially destructible types are allowed
+    template<typename T, typename... Args>
+    T* New(Args&&... Arguments)
+    {
+        static_assert(std::is_trivially_destructible_v<T>, "FrameArena never runs destructors");
+        return ::new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(Arguments)...);
+    }
+    // Value-initialized, throws when Count elements of T cannot be addressed
+    template<typename T>
+    T* NewArray(size_t Count);
+    void Reset() noexcept;
+    // Start of the memory. Until Reset an allocation can also be found by its offset from
+    // here, for data that is referred to by position rather than by pointer.
+    std::byte* GetData() noexcept;
+
+    size_t GetUsed() const noexcept;
+    size_t GetCapacity() const noexcept;
+    size_t GetHighWaterMark() const noexcept;
+private:
+    std::unique_ptr<std::byte[]> Memory;
+    size_t Capacity;
+    size_t Offset = 0u;
+    size_t HighWaterMark = 0u;
+};
+
+// One arena per frame in flight. Data allocated in frame N stays valid until the
+// ring wraps around to it again, so it can still be read while frame N is consumed.
+template<size_t Frames>
+class FrameArenaRing
+{
+    static_assert(Frames > 0u, "FrameArenaRing needs at least one arena");
+public:
+    explicit FrameArenaRing(size_t CapacityPerFrame)
+        : FrameArenaRing(CapacityPerFrame, std::make_index_sequence<Frames>{}) {}
+    FrameArenaRing(const FrameArenaRing&) = delete;
+    FrameArenaRing& operator=(const FrameArenaRing&) = delete;
+
+    FrameArena& Current() noexcept
+    {
+        return Arenas[Index];
+    }
+    // Move to the next arena and rewind it. Call once at the frame boundary.
+    void NextFrame() noexcept
+    {
+        Index = (Index + 1u) % Frames;
+        Arenas[Index].Reset();
+    }
+    size_t GetHighWaterMark() const noexcept
+    {
+        size_t Mark = 0u;
+        for (const auto& a : Arenas)
+        {
+            Mark = a.GetHighWaterMark() > Mark ? a.GetHighWaterMark() : Mark;
+        }
+        return Mark;
+    }
+private:
+    template<size_t... I>
+    FrameArenaRing(size_t CapacityPerFrame, std::index_sequence<I...>)
+        : Arenas{((void)I, FrameArena(CapacityPerFrame))...} {}
+private:
+    std::array<FrameArena, Frames> Arenas;
+    size_t Index = 0u;
+};
+
+// STL-compatible adapter, e.g. std::vector<Vertex, ArenaAllocator<Vertex>>.
+// Deallocation is a no-op, memory comes back when the arena is reset.
+template<typename T>
+class ArenaAllocator
+{
+public:
+    using value_type = T;
+
+    ArenaAllocator(FrameArena& Arena) noexcept : Arena(&Arena) {}
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& Other) noexcept : Arena(Other.GetArena()) {}
+
+    T* allocate(size_t Count)
+    {
+        if (Count > SIZE_MAX / sizeof(T))
+        {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T*>(Arena->Allocate(sizeof(T) * Count, alignof(T)));
+    }
+    void deallocate(T*, size_t) noexcept {}
+
+    FrameArena* GetArena() const noexcept
+    {
+        return Arena;
+    }
+    template<typename U>
+    bool operator==(const ArenaAllocator<U>& Other) const noexcept
+    {
+        return Arena == Other.GetArena();
+    }
+private:
+    FrameArena* Arena;
+};
+
+#define FRAME_ARENA_EXCEPT(Requested, Used, Capacity) FrameArena::Exception(__LINE__, __FILE__, (Requested), (Used), (Capacity))
+
+template<typename T>
+T* FrameArena::NewArray(size_t Count)
+{
+    static_assert(std::is_trivially_destructible_v<T>, "FrameArena never runs destructors");
+    if (Count > SIZE_MAX / sizeof(T))
+    {
+        throw FRAME_ARENA_EXCEPT(SIZE_MAX, Offset, Capacity);
+    }
+    T* Array = static_cast<T*>(Allocate(sizeof(T) * Count, alignof(T)));
+    for (size_t i = 0; i < Count; i++)
+    {
+        ::new (Array + i) T();
+    }
+    return Array;
+}
\ No newline at end of file
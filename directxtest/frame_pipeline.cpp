@@ -0,0 +1,98 @@
+#include "frame_pipeline.h"
+#include <algorithm>
+
+FramePipeline::FramePipeline(unsigned int Depth) : Packets(std::max(Depth, 1u)) {}
+
+FramePacket* FramePipeline::BeginSimulate()
+{
+    std::unique_lock<std::mutex> Lock(Mutex);
+    Changed.wait(Lock, [this] { return Stopped || Simulated - Rendered < Packets.size(); });
+    if (Error)
+    {
+        std::rethrow_exception(Error);
+    }
+    if (Stopped)
+    {
+        return nullptr;
+    }
+
+    FramePacket& Packet = Packets[Simulated % Packets.size()];
+    Packet.Index = Simulated;
+    Packet.SimulationStart = std::chrono::steady_clock::now();
+    Packet.Draws.Reset();
+    for (CommandList& Chunk : Packet.Chunks)
+    {
+        Chunk.Reset();
+    }
+    Packet.Statistics = {};
+    return &Packet;
+}
+
+void FramePipeline::EndSimulate(FramePacket&)
+{
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        Simulated++;
+    }
+    Changed.notify_all();
+}
+
+FramePacket* FramePipeline::BeginRender()
+{
+    std::unique_lock<std::mutex> Lock(Mutex);
+    Changed.wait(Lock, [this] { return Stopped || Simulated > Rendered; });
+    if (Error)
+    {
+        std::rethrow_exception(Error);
+    }
+    if (Stopped)
+    {
+        return nullptr;
+    }
+    return &Packets[Rendered % Packets.size()];
+}
+
+void FramePipeline::EndRender(FramePacket& Packet)
+{
+    const std::chrono::duration<float> Elapsed = std::chrono::steady_clock::now() - Packet.SimulationStart;
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        Rendered++;
+
+        Latency.Last = Elapsed.count();
+        Latency.Max = std::max(Latency.Max, Latency.Last);
+        Latency.Frames++;
+        Latency.Average += (Latency.Last - Latency.Average) / static_cast<float>(Latency.Frames);
+    }
+    Changed.notify_all();
+}
+
+void FramePipeline::Stop() noexcept
+{
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        Stopped = true;
+    }
+    Changed.notify_all();
+}
+
+void FramePipeline::Fail(std::exception_ptr NewError) noexcept
+{
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        Error = NewError;
+        Stopped = true;
+    }
+    Changed.notify_all();
+}
+
+unsigned int FramePipeline::GetDepth() const noexcept
+{
+    return static_cast<unsigned int>(Packets.size());
+}
+
+FramePipeline::LatencyStats FramePipeline::GetLatency() const
+{
+    std::lock_guard<std::mutex> Lock(Mutex);
+    return Latency;
+}
\ No newline at end of file
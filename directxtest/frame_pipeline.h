@@ -0,0 +1,94 @@
+#pragma once
+#include "command_list.h"
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <vector>
+
+// Named statistics of one frame, fixed size so filling it never allocates
+struct FrameStatistics
+{
+    static constexpr size_t MaxValues = 8u;
+    struct Value
+    {
+        const char* Name = nullptr;
+        double Amount = 0.0;
+    };
+    std::array<Value, MaxValues> Values;
+    size_t Count = 0u;
+
+    void Add(const char* Name, double Amount) noexcept
+    {
+        if (Count < MaxValues)
+        {
+            Values[Count++] = {Name, Amount};
+        }
+    }
+};
+
+// Everything the simulation of one frame hands to rendering
+struct FramePacket
+{
+    uint64_t Index = 0u;
+    std::chrono::steady_clock::time_point SimulationStart;
+    float ClearColor[3] = {0.0f, 0.0f, 0.0f};
+    // Raw per-frame constants, uploaded with Graphics::SetFrameConstants
+    float FrameConstants[16] = {};
+    // Raw per-view constants, uploaded with Graphics::SetViewConstants. 3D scenes put
+    // their row-major view-projection matrix here, 2D scenes leave it alone.
+    float ViewConstants[16] = {};
+    CommandList Draws;
+    // Lists recorded in parallel, submitted after Draws in index order. Their count is up
+    // to the simulation, resetting keeps each list's capacity.
+    std::vector<CommandList> Chunks;
+    FrameStatistics Statistics;
+};
+
+// Ring of frame packets between a simulation thread and the render thread. With a depth
+// of N the simulation may run up to N-1 frames ahead of the frame being submitted, a
+// depth of 1 runs both stages strictly in sequence.
+class FramePipeline
+{
+public:
+    struct LatencyStats
+    {
+        // Seconds from the start of a frame's simulation until its submission finished
+        float Last = 0.0f;
+        float Average = 0.0f;
+        float Max = 0.0f;
+        uint64_t Frames = 0u;
+    };
+public:
+    explicit FramePipeline(unsigned int Depth);
+    FramePipeline(const FramePipeline&) = delete;
+    FramePipeline& operator=(const FramePipeline&) = delete;
+
+    // Simulation side. Blocks while every packet is in use, null once stopped.
+    // Rethrows if the simulation failed.
+    FramePacket* BeginSimulate();
+    void EndSimulate(FramePacket& Packet);
+    // Render side. Blocks until a packet is ready, null once stopped. Rethrows if the
+    // simulation failed.
+    FramePacket* BeginRender();
+    void EndRender(FramePacket& Packet);
+
+    // Wakes both sides, frames simulated but not yet rendered are dropped
+    void Stop() noexcept;
+    // Hands an exception from the simulation thread over to the render thread
+    void Fail(std::exception_ptr Error) noexcept;
+
+    unsigned int GetDepth() const noexcept;
+    LatencyStats GetLatency() const;
+private:
+    std::vector<FramePacket> Packets;
+    mutable std::mutex Mutex;
+    std::condition_variable Changed;
+    uint64_t Simulated = 0u;
+    uint64_t Rendered = 0u;
+    bool Stopped = false;
+    std::exception_ptr Error;
+    LatencyStats Latency;
+};
\ No newline at end of file
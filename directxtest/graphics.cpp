@@ -1,6 +1,13 @@
 #include "graphics.h"
 #include "dxerr.h"
+#include "alloc_tracker.h"
+#include "simd_math.h"
 #include <sstream>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+#include <thread>
 #include <d3dcompiler.h>
 
 namespace wrl = Microsoft::WRL;
@@ -23,7 +30,7 @@ namespace wrl = Microsoft::WRL;
 #define GFX_THROW_INFO_ONLY(call) (call)
 #endif
 
-Graphics::Graphics(HWND WindowHandle)
+Graphics::Graphics(HWND WindowHandle, const std::filesystem::path& CapturePath)
 {
     DXGI_SWAP_CHAIN_DESC SwapDesc = {};
     SwapDesc.BufferDesc.Width = 0;
@@ -55,19 +62,137 @@ Graphics::Graphics(HWND WindowHandle)
                                   &SwapDesc, &SwapChain, 
                                   &Device, nullptr, &Context));
     
+    // The CPU never runs more than FramesInFlight frames ahead, which is what lets
+    // per-frame resources and deferred releases be keyed to the frame counter
+    wrl::ComPtr<IDXGIDevice1> DxgiDevice;
+    if (SUCCEEDED(Device.As(&DxgiDevice)))
+    {
+        DxgiDevice->SetMaximumFrameLatency(FramesInFlight);
+    }
+
     wrl::ComPtr<ID3D11Resource> BackBuffer;
     GFX_THROW_INFO(SwapChain->GetBuffer(0, __uuidof(ID3D11Resource), &BackBuffer));
     GFX_THROW_INFO(Device->CreateRenderTargetView(BackBuffer.Get(),nullptr, &Target));
+
+    DXGI_SWAP_CHAIN_DESC CreatedDesc;
+    GFX_THROW_INFO(SwapChain->GetDesc(&CreatedDesc));
+    Width = CreatedDesc.BufferDesc.Width;
+    Height = CreatedDesc.BufferDesc.Height;
+
+    Initialize(CapturePath);
+}
+
+Graphics::Graphics(Backend Type, UINT Width, UINT Height, const std::filesystem::path& CapturePath)
+    : Width(Width), Height(Height)
+{
+    UINT CreateFlags = 0u;
+
+#ifndef NDEBUG
+    CreateFlags |= D3D11_CREATE_DEVICE_DEBUG;
+#endif
+
+    static constexpr D3D_DRIVER_TYPE DriverTypes[] =
+    {
+        D3D_DRIVER_TYPE_HARDWARE,
+        D3D_DRIVER_TYPE_WARP,
+        D3D_DRIVER_TYPE_NULL
+    };
+
+    HRESULT hr;
+    GFX_THROW_INFO(D3D11CreateDevice(nullptr, DriverTypes[static_cast<size_t>(Type)],
+                                     nullptr, CreateFlags, nullptr, 0,
+                                     D3D11_SDK_VERSION, &Device, nullptr, &Context));
+
+    D3D11_TEXTURE2D_DESC TargetDesc = {};
+    TargetDesc.Width = Width;
+    TargetDesc.Height = Height;
+    TargetDesc.MipLevels = 1u;
+    TargetDesc.ArraySize = 1u;
+    TargetDesc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    TargetDesc.SampleDesc.Count = 1u;
+    TargetDesc.SampleDesc.Quality = 0u;
+    TargetDesc.Usage = D3D11_USAGE_DEFAULT;
+    TargetDesc.BindFlags = D3D11_BIND_RENDER_TARGET;
+    wrl::ComPtr<ID3D11Texture2D> Offscreen;
+    GFX_THROW_INFO(Device->CreateTexture2D(&TargetDesc, nullptr, &Offscreen));
+    GFX_THROW_INFO(Device->CreateRenderTargetView(Offscreen.Get(), nullptr, &Target));
+
+    // The null device never executes anything, so there is nothing to wait for
+    if (Type != Backend::Null)
+    {
+        D3D11_QUERY_DESC QueryDesc = {D3D11_QUERY_EVENT, 0u};
+        for (auto& Query : FrameQueries)
+        {
+            GFX_THROW_INFO(Device->CreateQuery(&QueryDesc, &Query));
+        }
+    }
+
+    Initialize(CapturePath);
+}
+
+void Graphics::Initialize(const std::filesystem::path& CapturePath)
+{
+    CreateDepthTarget();
+    CreateDynamicRing(VertexRing, D3D11_BIND_VERTEX_BUFFER);
+    CreateDynamicRing(IndexRing, D3D11_BIND_INDEX_BUFFER);
+
+    // Constant buffers, per-draw constants are sub-allocated from one large buffer when
+    // the runtime can bind at an offset and map it with NO_OVERWRITE (D3D11.1)
+    if (SUCCEEDED(Context.As(&Context1)))
+    {
+        D3D11_FEATURE_DATA_D3D11_OPTIONS Options = {};
+        if (SUCCEEDED(Device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &Options, sizeof(Options))))
+        {
+            ConstantOffsetting = Options.ConstantBufferOffsetting && Options.MapNoOverwriteOnDynamicConstantBuffer;
+            ConstantPartialUpdate = Options.ConstantBufferPartialUpdate;
+        }
+    }
+
+    CreateConstantBuffer(FrameConstantBuffer, FrameConstantsSize, D3D11_USAGE_DEFAULT);
+    CreateConstantBuffer(ViewConstantBuffer, ViewConstantsSize, D3D11_USAGE_DEFAULT);
+    ID3D11Buffer* const SharedConstants[] = {FrameConstantBuffer.Get(), ViewConstantBuffer.Get()};
+    Context->VSSetConstantBuffers(static_cast<UINT>(ConstantFrequency::Frame), 2u, SharedConstants);
+    Context->PSSetConstantBuffers(static_cast<UINT>(ConstantFrequency::Frame), 2u, SharedConstants);
+
+    if (ConstantOffsetting)
+    {
+        CreateDynamicRing(DrawConstantRing, D3D11_BIND_CONSTANT_BUFFER);
+    }
+    else
+    {
+        CreateConstantBuffer(DrawConstantBuffer, MaxDrawConstantsSize, D3D11_USAGE_DYNAMIC);
+        Context->VSSetConstantBuffers(static_cast<UINT>(ConstantFrequency::Draw), 1u, DrawConstantBuffer.GetAddressOf());
+        Context->PSSetConstantBuffers(static_cast<UINT>(ConstantFrequency::Draw), 1u, DrawConstantBuffer.GetAddressOf());
+    }
+
+    // Everything from here on goes through the public calls and is captured
+    if (!CapturePath.empty())
+    {
+        Capture = std::make_unique<CaptureWriter>(CapturePath);
+    }
+
+    CreateTestTriangleState();
 }
 
 void Graphics::EndFrame()
 {
+    AllocScope Scope(AllocTag::Graphics);
+    ExecuteSubmitted();
+    if (CaptureWriter* const Writer = GetCapture())
+    {
+        Writer->EndFrame();
+    }
+
     HRESULT hr;
 #ifndef NDEBUG
     InfoManager.Set();
 #endif
 
-    if (FAILED(hr = SwapChain->Present(1u, 0u)))
+    if (!SwapChain)
+    {
+        WaitForOffscreenFrame();
+    }
+    else if (FAILED(hr = SwapChain->Present(SyncInterval, 0u)))
     {
         if (hr == DXGI_ERROR_DEVICE_REMOVED)
         {
@@ -78,12 +203,903 @@ void Graphics::EndFrame()
             throw GFX_EXCEPT(hr);
         }
     }
+
+    Counters.ArenaBytes = FrameMemory.Current().GetUsed();
+    FrameMemory.NextFrame();
+    VertexRing.Allocator.EndFrame();
+    IndexRing.Allocator.EndFrame();
+    DrawConstantRing.Allocator.EndFrame();
+    LastCounters = Counters;
+    Counters = {};
+
+    // Everything last used FramesInFlight frames ago or earlier is no longer referenced by the GPU
+    const uint64_t Frame = FrameIndex.fetch_add(1u, std::memory_order_release) + 1u;
+    if (Frame >= FramesInFlight)
+    {
+        ReleaseQueue.Retire(Frame - FramesInFlight);
+    }
 }
 
 void Graphics::ClearBuffer(float Red, float Green, float Blue) noexcept
 {
     const float Colors[] = {Red, Green, Blue, 1.0f};
     Context->ClearRenderTargetView(Target.Get(), Colors);
+    Context->ClearDepthStencilView(DepthTarget.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0u);
+
+    if (CaptureWriter* const Writer = GetCapture())
+    {
+        Writer->Begin(CaptureOp::ClearBuffer);
+        Writer->Write(Red);
+        Writer->Write(Green);
+        Writer->Write(Blue);
+    }
+}
+
+void Graphics::SetSyncInterval(UINT Interval) noexcept
+{
+    SyncInterval = Interval;
+}
+
+// Same guarantee as the swap chain's maximum frame latency: when frame N ends, frame
+// N-FramesInFlight+1 has completed on the GPU
+void Graphics::WaitForOffscreenFrame()
+{
+    const uint64_t Frame = FrameIndex.load(std::memory_order_relaxed);
+    ID3D11Query* const Issued = FrameQueries[Frame % FramesInFlight].Get();
+    if (!Issued)
+    {
+        return;
+    }
+    Context->End(Issued);
+
+    if (Frame + 1u < FramesInFlight)
+    {
+        return;
+    }
+    ID3D11Query* const Oldest = FrameQueries[(Frame + 1u) % FramesInFlight].Get();
+    HRESULT hr;
+    while ((hr = Context->GetData(Oldest, nullptr, 0u, 0u)) == S_FALSE)
+    {
+        std::this_thread::yield();
+    }
+    if (hr == DXGI_ERROR_DEVICE_REMOVED)
+    {
+        throw GFX_DEVICE_REMOVED_EXCEPT(Device->GetDeviceRemovedReason());
+    }
+    else if (FAILED(hr))
+    {
+        throw GFX_EXCEPT(hr);
+    }
+}
+
+FrameArena& Graphics::GetFrameArena() noexcept
+{
+    return FrameMemory.Current();
+}
+
+size_t Graphics::GetFrameArenaHighWaterMark() const noexcept
+{
+    return FrameMemory.GetHighWaterMark();
+}
+
+Graphics::DynamicRange Graphics::StreamVertices(const void* Data, UINT Size, UINT Stride)
+{
+    const DynamicRange Range = StreamToRing(VertexRing, Data, Size, Stride);
+
+    if (CaptureWriter* const Writer = GetCapture())
+    {
+        Writer->Begin(CaptureOp::StreamVertices);
+        Writer->WriteBlob(Data, Size);
+        Writer->Write(Stride);
+        Writer->Write(Range.Offset);
+        Writer->Write(Range.Size);
+    }
+    return Range;
+}
+
+Graphics::DynamicRange Graphics::StreamIndices(const void* Data, UINT Size)
+{
+    const DynamicRange Range = StreamToRing(IndexRing, Data, Size, 4u);
+
+    if (CaptureWriter* const Writer = GetCapture())
+    {
+        Writer->Begin(CaptureOp::StreamIndices);
+        Writer->WriteBlob(Data, Size);
+        Writer->Write(Range.Offset);
+        Writer->Write(Range.Size);
+    }
+    return Range;
+}
+
+void Graphics::BindStreamedVertices(const DynamicRange& Range, UINT Stride) noexcept
+{
+    Context->IASetVertexBuffers(0u, 1u, VertexRing.Buffer.GetAddressOf(), &Stride, &Range.Offset);
+
+    if (CaptureWriter* const Writer = GetCapture())
+    {
+        Writer->Begin(CaptureOp::BindStreamedVertices);
+        Writer->Write(Range.Offset);
+        Writer->Write(Range.Size);
+        Writer->Write(Stride);
+    }
+}
+
+void Graphics::BindStreamedIndices(const DynamicRange& Range, DXGI_FORMAT Format) noexcept
+{
+    Context->IASetIndexBuffer(IndexRing.Buffer.Get(), Format, Range.Offset);
+
+    if (CaptureWriter* const Writer = GetCapture())
+    {
+        Writer->Begin(CaptureOp::BindStreamedIndices);
+        Writer->Write(Range.Offset);
+        Writer->Write(Range.Size);
+        Writer->Write(Format);
+    }
+}
+
+void Graphics::CreateDepthTarget()
+{
+    HRESULT hr;
+    D3D11_TEXTURE2D_DESC Desc = {};
+    Desc.Width = Width;
+    Desc.Height = Height;
+    Desc.MipLevels = 1u;
+    Desc.ArraySize = 1u;
+    Desc.Format = DXGI_FORMAT_D32_FLOAT;
+    Desc.SampleDesc.Count = 1u;
+    Desc.SampleDesc.Quality = 0u;
+    Desc.Usage = D3D11_USAGE_DEFAULT;
+    Desc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
+    wrl::ComPtr<ID3D11Texture2D> Depth;
+    GFX_THROW_INFO(Device->CreateTexture2D(&Desc, nullptr, &Depth));
+    GFX_THROW_INFO(Device->CreateDepthStencilView(Depth.Get(), nullptr, &DepthTarget));
+}
+
+void Graphics::CreateDynamicRing(DynamicRing& Ring, UINT BindFlags)
+{
+    HRESULT hr;
+    D3D11_BUFFER_DESC Desc = {};
+    Desc.ByteWidth = static_cast<UINT>(Ring.Allocator.GetCapacity());
+    Desc.Usage = D3D11_USAGE_DYNAMIC;
+    Desc.BindFlags = BindFlags;
+    Desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    Desc.MiscFlags = 0u;
+    Desc.StructureByteStride = 0u;
+    GFX_THROW_INFO(Device->CreateBuffer(&Desc, nullptr, &Ring.Buffer));
+}
+
+Graphics::DynamicRange Graphics::StreamToRing(DynamicRing& Ring, const void* Data, UINT Size, UINT Alignment)
+{
+    UINT Offset;
+    std::memcpy(MapRing(Ring, Size, Alignment, Offset), Data, Size);
+    Context->Unmap(Ring.Buffer.Get(), 0u);
+    Counters.UploadBytes += Size;
+
+    return {Offset, Size};
+}
+
+// Returns the write pointer for the allocated region, the caller unmaps the buffer
+void* Graphics::MapRing(DynamicRing& Ring, UINT Size, UINT Alignment, UINT& Offset)
+{
+    HRESULT hr;
+    const auto Alloc = Ring.Allocator.Allocate(Size, Alignment);
+    if (!Alloc)
+    {
+        throw GFX_EXCEPT(E_OUTOFMEMORY);
+    }
+
+    // NOTE: NO_OVERWRITE promises the driver we don't touch anything the GPU may still read,
+    // the ring only hands out regions whose frames have completed
+    const D3D11_MAP MapType = Alloc->Mode == RingAllocator::MapMode::Discard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE;
+    D3D11_MAPPED_SUBRESOURCE Mapped;
+    GFX_THROW_INFO(Context->Map(Ring.Buffer.Get(), 0u, MapType, 0u, &Mapped));
+
+    Offset = static_cast<UINT>(Alloc->Offset);
+    return static_cast<unsigned char*>(Mapped.pData) + Alloc->Offset;
+}
+
+void Graphics::SetFrameConstants(const void* Data, UINT Size, UINT Offset)
+{
+    FrameConstants.Write(Offset, Data, Size);
+
+    if (CaptureWriter* const Writer = GetCapture())
+    {
+        Writer->Begin(CaptureOp::SetFrameConstants);
+        Writer->WriteBlob(Data, Size);
+        Writer->Write(Offset);
+    }
+}
+
+void Graphics::SetViewConstants(const void* Data, UINT Size, UINT Offset)
+{
+    ViewConstants.Write(Offset, Data, Size);
+
+    if (CaptureWriter* const Writer = GetCapture())
+    {
+        Writer->Begin(CaptureOp::SetViewConstants);
+        Writer->WriteBlob(Data, Size);
+        Writer->Write(Offset);
+    }
+}
+
+ConstantLocation Graphics::StreamDrawConstants(const void* Data, UINT Size, UINT Count)
+{
+    const size_t PackedSize = ConstantPacking::GetBlockSize(Size) * Count;
+    ConstantLocation Location;
+    Counters.UploadBytes += PackedSize;
+
+    if (ConstantOffsetting)
+    {
+        UINT Offset;
+        void* Dest = MapRing(DrawConstantRing, static_cast<UINT>(PackedSize), static_cast<UINT>(ConstantPacking::BlockAlignment), Offset);
+        ConstantPacking::Pack(Dest, Data, Size, Count);
+        Context->Unmap(DrawConstantRing.Buffer.Get(), 0u);
+        Location = ConstantPacking::Locate(Offset, Size, 0u);
+    }
+    else
+    {
+        if (Size > MaxDrawConstantsSize)
+        {
+            throw GFX_EXCEPT(E_OUTOFMEMORY);
+        }
+        FrameArena& Arena = FrameMemory.Current();
+        std::byte* const Dest = static_cast<std::byte*>(Arena.Allocate(PackedSize, ConstantPacking::ConstantSize));
+        ConstantPacking::Pack(Dest, Data, Size, Count);
+        Location = ConstantPacking::Locate(static_cast<size_t>(Dest - Arena.GetData()), Size, 0u);
+    }
+
+    if (CaptureWriter* const Writer = GetCapture())
+    {
+        Writer->Begin(CaptureOp::StreamDrawConstants);
+        Writer->WriteBlob(Data, static_cast<size_t>(Size) * Count);
+        Writer->Write(Size);
+        Writer->Write(Count);
+        Writer->Write(Location.FirstConstant);
+        Writer->Write(Location.NumConstants);
+    }
+    return Location;
+}
+
+void Graphics::BindDrawConstants(const ConstantLocation& Location, UINT Index)
+{
+    if (CaptureWriter* const Writer = GetCapture())
+    {
+        Writer->Begin(CaptureOp::BindDrawConstants);
+        Writer->Write(Location.FirstConstant);
+        Writer->Write(Location.NumConstants);
+        Writer->Write(Index);
+    }
+
+    const UINT First = Location.FirstConstant + Index * Location.NumConstants;
+    const UINT Slot = static_cast<UINT>(ConstantFrequency::Draw);
+
+    if (ConstantOffsetting)
+    {
+        Context1->VSSetConstantBuffers1(Slot, 1u, DrawConstantRing.Buffer.GetAddressOf(), &First, &Location.NumConstants);
+        Context1->PSSetConstantBuffers1(Slot, 1u, DrawConstantRing.Buffer.GetAddressOf(), &First, &Location.NumConstants);
+        return;
+    }
+
+    HRESULT hr;
+    D3D11_MAPPED_SUBRESOURCE Mapped;
+    GFX_THROW_INFO(Context->Map(DrawConstantBuffer.Get(), 0u, D3D11_MAP_WRITE_DISCARD, 0u, &Mapped));
+    std::memcpy(Mapped.pData, FrameMemory.Current().GetData() + First * ConstantPacking::ConstantSize,
+                Location.NumConstants * ConstantPacking::ConstantSize);
+    Context->Unmap(DrawConstantBuffer.Get(), 0u);
+}
+
+void Graphics::CreateConstantBuffer(wrl::ComPtr<ID3D11Buffer>& Buffer, UINT Size, D3D11_USAGE Usage)
+{
+    HRESULT hr;
+    D3D11_BUFFER_DESC Desc = {};
+    Desc.ByteWidth = Size;
+    Desc.Usage = Usage;
+    Desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    Desc.CPUAccessFlags = Usage == D3D11_USAGE_DYNAMIC ? D3D11_CPU_ACCESS_WRITE : 0u;
+    Desc.MiscFlags = 0u;
+    Desc.StructureByteStride = 0u;
+    GFX_THROW_INFO(Device->CreateBuffer(&Desc, nullptr, &Buffer));
+}
+
+void Graphics::UploadConstants(ID3D11Buffer* Buffer, ConstantShadow& Shadow)
+{
+    if (!Shadow.IsDirty())
+    {
+        return;
+    }
+
+    // Only the dirty constants are sent when the runtime supports partial updates
+    if (ConstantPartialUpdate)
+    {
+        const UINT Begin = static_cast<UINT>(Shadow.GetDirtyBegin());
+        const D3D11_BOX Box = {Begin, 0u, 0u, static_cast<UINT>(Shadow.GetDirtyEnd()), 1u, 1u};
+        Context1->UpdateSubresource1(Buffer, 0u, &Box, static_cast<const unsigned char*>(Shadow.GetData()) + Begin, 0u, 0u, 0u);
+    }
+    else
+    {
+        Context->UpdateSubresource(Buffer, 0u, nullptr, Shadow.GetData(), 0u, 0u);
+    }
+    Counters.UploadBytes += Shadow.GetDirtyEnd() - Shadow.GetDirtyBegin();
+    Shadow.ClearDirty();
+}
+
+void Graphics::FlushConstants()
+{
+    UploadConstants(FrameConstantBuffer.Get(), FrameConstants);
+    UploadConstants(ViewConstantBuffer.Get(), ViewConstants);
+}
+
+VertexShaderHandle Graphics::LoadVertexShader(const wchar_t* Path)
+{
+    if (const auto Loaded = VertexShaders.FindIf([Path](const VertexShaderEntry& e) { return e.Path == Path; }); Loaded.IsValid())
+    {
+        return Loaded;
+    }
+
+    HRESULT hr;
+    wrl::ComPtr<ID3DBlob> Blob;
+    GFX_THROW_INFO(D3DReadFileToBlob(Path, &Blob));
+    const VertexShaderHandle Shader = CreateVertexShader(Blob->GetBufferPointer(), Blob->GetBufferSize());
+    VertexShaders.At(Shader).Path = Path;
+    return Shader;
+}
+
+PixelShaderHandle Graphics::LoadPixelShader(const wchar_t* Path)
+{
+    if (const auto Loaded = PixelShaders.FindIf([Path](const PixelShaderEntry& e) { return e.Path == Path; }); Loaded.IsValid())
+    {
+        return Loaded;
+    }
+
+    HRESULT hr;
+    wrl::ComPtr<ID3DBlob> Blob;
+    GFX_THROW_INFO(D3DReadFileToBlob(Path, &Blob));
+    const PixelShaderHandle Shader = CreatePixelShader(Blob->GetBufferPointer(), Blob->GetBufferSize());
+    PixelShaders.At(Shader).Path = Path;
+    return Shader;
+}
+
+// Input layouts are validated against the vertex shader, so its bytecode is kept around
+VertexShaderHandle Graphics::CreateVertexShader(const void* Bytecode, SIZE_T Size)
+{
+    HRESULT hr;
+    VertexShaderEntry Entry;
+    GFX_THROW_INFO(D3DCreateBlob(Size, &Entry.Bytecode));
+    std::memcpy(Entry.Bytecode->GetBufferPointer(), Bytecode, Size);
+    GFX_THROW_INFO(Device->CreateVertexShader(Bytecode, Size, nullptr, &Entry.Shader));
+    const VertexShaderHandle Shader = VertexShaders.Insert(std::move(Entry));
+
+    if (CaptureWriter* const Writer = GetCapture())
+    {
+        Writer->Begin(CaptureOp::CreateVertexShader);
+        Writer->Write(Shader.Value);
+        Writer->WriteBlob(Bytecode, Size);
+    }
+    return Shader;
+}
+
+PixelShaderHandle Graphics::CreatePixelShader(const void* Bytecode, SIZE_T Size)
+{
+    HRESULT hr;
+    PixelShaderEntry Entry;
+    GFX_THROW_INFO(Device->CreatePixelShader(Bytecode, Size, nullptr, &Entry.Shader));
+    const PixelShaderHandle Shader = PixelShaders.Insert(std::move(Entry));
+
+    if (CaptureWriter* const Writer = GetCapture())
+    {
+        Writer->Begin(CaptureOp::CreatePixelShader);
+        Writer->Write(Shader.Value);
+        Writer->WriteBlob(Bytecode, Size);
+    }
+    return Shader;
+}
+
+InputLayoutHandle Graphics::CreateInputLayout(const D3D11_INPUT_ELEMENT_DESC* Elements, UINT Count, VertexShaderHandle VertexShader)
+{
+    HRESULT hr;
+    ID3DBlob* Bytecode = VertexShaders.At(VertexShader).Bytecode.Get();
+    wrl::ComPtr<ID3D11InputLayout> Layout;
+    GFX_THROW_INFO(Device->CreateInputLayout(Elements, Count, Bytecode->GetBufferPointer(), Bytecode->GetBufferSize(), &Layout));
+    const InputLayoutHandle Created = InputLayouts.Insert(std::move(Layout));
+
+    if (CaptureWriter* const Writer = GetCapture())
+    {
+        Writer->Begin(CaptureOp::CreateInputLayout);
+        Writer->Write(Created.Value);
+        Writer->Write(VertexShader.Value);
+        Writer->Write(Count);
+        for (UINT i = 0; i < Count; i++)
+        {
+            const D3D11_INPUT_ELEMENT_DESC& e = Elements[i];
+            Writer->WriteString(e.SemanticName);
+            Writer->Write(e.SemanticIndex);
+            Writer->Write(e.Format);
+            Writer->Write(e.InputSlot);
+            Writer->Write(e.AlignedByteOffset);
+            Writer->Write(e.InputSlotClass);
+            Writer->Write(e.InstanceDataStepRate);
+        }
+    }
+    return Created;
+}
+
+BufferHandle Graphics::CreateBuffer(const D3D11_BUFFER_DESC& Desc, const void* InitialData)
+{
+    HRESULT hr;
+    D3D11_SUBRESOURCE_DATA Data = {};
+    Data.pSysMem = InitialData;
+    wrl::ComPtr<ID3D11Buffer> Buffer;
+    GFX_THROW_INFO(Device->CreateBuffer(&Desc, InitialData ? &Data : nullptr, &Buffer));
+    const BufferHandle Created = Buffers.Insert(std::move(Buffer));
+
+    if (CaptureWriter* const Writer = GetCapture())
+    {
+        Writer->Begin(CaptureOp::CreateBuffer);
+        Writer->Write(Created.Value);
+        Writer->Write(Desc);
+        Writer->WriteBlob(InitialData, InitialData ? Desc.ByteWidth : 0u);
+    }
+    return Created;
+}
+
+ShaderViewHandle Graphics::CreateShaderView(BufferHandle Buffer, const D3D11_SHADER_RESOURCE_VIEW_DESC& Desc)
+{
+    HRESULT hr;
+    wrl::ComPtr<ID3D11ShaderResourceView> View;
+    GFX_THROW_INFO(Device->CreateShaderResourceView(Buffers.At(Buffer).Get(), &Desc, &View));
+    const ShaderViewHandle Created = ShaderViews.Insert(std::move(View));
+
+    if (CaptureWriter* const Writer = GetCapture())
+    {
+        Writer->Begin(CaptureOp::CreateShaderView);
+        Writer->Write(Created.Value);
+        Writer->Write(Buffer.Value);
+        Writer->Write(Desc);
+    }
+    return Created;
+}
+
+template<typename F>
+void Graphics::EvictPipelineStates(F&& UsesReleased)
+{
+    for (PipelineState& State : PipelineStates)
+    {
+        if (!UsesReleased(State.Desc) || PipelineCache.Remove(State.Desc, HashPipelineState(State.Desc)) == PipelineStateCache::InvalidIndex)
+        {
+            continue;
+        }
+        // The context keeps what is bound alive, but SetPipelineState compares against the
+        // current PSO, so that must not hold pointers that can be reused
+        if (CurrentPipelineState == &State)
+        {
+            Context->VSSetShader(nullptr, nullptr, 0u);
+            Context->PSSetShader(nullptr, nullptr, 0u);
+            Context->IASetInputLayout(nullptr);
+            CurrentPipelineState = nullptr;
+        }
+        DeferRelease(State.VertexShader.Detach());
+        DeferRelease(State.PixelShader.Detach());
+        DeferRelease(State.InputLayout.Detach());
+    }
+}
+
+void Graphics::Release(VertexShaderHandle Shader)
+{
+    DeferRelease(VertexShaders.Remove(Shader).Shader.Detach());
+    EvictPipelineStates([Shader](const PipelineStateDesc& Desc) { return Desc.VertexShader == Shader; });
+    CaptureRelease(CaptureResource::VertexShader, Shader.Value);
+}
+
+void Graphics::Release(PixelShaderHandle Shader)
+{
+    DeferRelease(PixelShaders.Remove(Shader).Shader.Detach());
+    EvictPipelineStates([Shader](const PipelineStateDesc& Desc) { return Desc.PixelShader == Shader; });
+    CaptureRelease(CaptureResource::PixelShader, Shader.Value);
+}
+
+void Graphics::Release(InputLayoutHandle Layout)
+{
+    DeferRelease(InputLayouts.Remove(Layout).Detach());
+    EvictPipelineStates([Layout](const PipelineStateDesc& Desc) { return Desc.InputLayout == Layout; });
+    CaptureRelease(CaptureResource::InputLayout, Layout.Value);
+}
+
+void Graphics::Release(BufferHandle Buffer)
+{
+    DeferRelease(Buffers.Remove(Buffer).Detach());
+    CaptureRelease(CaptureResource::Buffer, Buffer.Value);
+}
+
+void Graphics::Release(ShaderViewHandle View)
+{
+    DeferRelease(ShaderViews.Remove(View).Detach());
+    CaptureRelease(CaptureResource::ShaderView, View.Value);
+}
+
+void Graphics::DeferRelease(IUnknown* Object)
+{
+    if (!Object)
+    {
+        return;
+    }
+    ReleaseQueue.Enqueue(Object, [](void* Unknown) noexcept { static_cast<IUnknown*>(Unknown)->Release(); },
+                         FrameIndex.load(std::memory_order_acquire));
+}
+
+uint64_t Graphics::GetFrameIndex() const noexcept
+{
+    return FrameIndex.load(std::memory_order_acquire);
+}
+
+const Graphics::FrameCounters& Graphics::GetFrameCounters() const noexcept
+{
+    return LastCounters;
+}
+
+const char* Graphics::GetBackendName(Backend Type) noexcept
+{
+    switch (Type)
+    {
+        case Backend::Hardware: return "hw";
+        case Backend::Warp: return "warp";
+        case Backend::Null: return "null";
+        default: return "unknown";
+    }
+}
+
+void Graphics::BindVertexBuffer(BufferHandle Buffer, UINT Stride, UINT Offset)
+{
+    ID3D11Buffer* const Raw = Buffers.At(Buffer).Get();
+    Context->IASetVertexBuffers(0u, 1u, &Raw, &Stride, &Offset);
+
+    if (CaptureWriter* const Writer = GetCapture())
+    {
+        Writer->Begin(CaptureOp::BindVertexBuffer);
+        Writer->Write(Buffer.Value);
+        Writer->Write(Stride);
+        Writer->Write(Offset);
+    }
+}
+
+void Graphics::BindIndexBuffer(BufferHandle Buffer, DXGI_FORMAT Format, UINT Offset)
+{
+    Context->IASetIndexBuffer(Buffers.At(Buffer).Get(), Format, Offset);
+
+    if (CaptureWriter* const Writer = GetCapture())
+    {
+        Writer->Begin(CaptureOp::BindIndexBuffer);
+        Writer->Write(Buffer.Value);
+        Writer->Write(Format);
+        Writer->Write(Offset);
+    }
+}
+
+void Graphics::BindShaderView(UINT Slot, ShaderViewHandle View)
+{
+    ID3D11ShaderResourceView* const Raw = ShaderViews.At(View).Get();
+    Context->PSSetShaderResources(Slot, 1u, &Raw);
+
+    if (CaptureWriter* const Writer = GetCapture())
+    {
+        Writer->Begin(CaptureOp::BindShaderView);
+        Writer->Write(Slot);
+        Writer->Write(View.Value);
+    }
+}
+
+const Graphics::PipelineState* Graphics::CreatePipelineState(const PipelineStateDesc& Desc)
+{
+    const uint64_t Hash = HashPipelineState(Desc);
+    const uint32_t Index = PipelineCache.Find(Desc, Hash);
+    if (Index != PipelineStateCache::InvalidIndex)
+    {
+        return &PipelineStates[Index];
+    }
+
+    static constexpr D3D11_PRIMITIVE_TOPOLOGY Topologies[] =
+    {
+        D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST,
+        D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP,
+        D3D11_PRIMITIVE_TOPOLOGY_LINELIST,
+        D3D11_PRIMITIVE_TOPOLOGY_POINTLIST
+    };
+
+    PipelineState State;
+    State.Id = static_cast<uint32_t>(PipelineStates.size());
+    State.Desc = Desc;
+    if (Desc.VertexShader.IsValid())
+    {
+        State.VertexShader = VertexShaders.At(Desc.VertexShader).Shader;
+    }
+    if (Desc.PixelShader.IsValid())
+    {
+        State.PixelShader = PixelShaders.At(Desc.PixelShader).Shader;
+    }
+    if (Desc.InputLayout.IsValid())
+    {
+        State.InputLayout = InputLayouts.At(Desc.InputLayout);
+    }
+    State.Topology = Topologies[static_cast<size_t>(Desc.PrimitiveTopology)];
+    State.Blend = GetBlendState(Desc.Blend);
+    State.Rasterizer = GetRasterizerState(Desc.Cull, Desc.Fill);
+    State.DepthStencil = GetDepthStencilState(Desc.Depth);
+    State.Sampler = GetSamplerState(Desc.Sampler);
+
+    PipelineStates.push_back(std::move(State));
+    PipelineCache.Insert(Desc, Hash, static_cast<uint32_t>(PipelineStates.size() - 1u));
+
+    if (CaptureWriter* const Writer = GetCapture())
+    {
+        Writer->Begin(CaptureOp::CreatePipelineState);
+        Writer->Write(PipelineStates.back().Id);
+        Writer->Write(Desc);
+    }
+    return &PipelineStates.back();
+}
+
+void Graphics::SetPipelineState(const PipelineState* State) noexcept
+{
+    if (State == CurrentPipelineState)
+    {
+        return;
+    }
+
+    // Only the groups that differ from the previous PSO touch the context, nothing bound
+    // compares equal to the context's default (null) state
+    static const PipelineState Empty = {};
+    const PipelineState& Prev = CurrentPipelineState ? *CurrentPipelineState : Empty;
+    if (State->VertexShader.Get() != Prev.VertexShader.Get())
+    {
+        Context->VSSetShader(State->VertexShader.Get(), nullptr, 0u);
+    }
+    if (State->PixelShader.Get() != Prev.PixelShader.Get())
+    {
+        Context->PSSetShader(State->PixelShader.Get(), nullptr, 0u);
+    }
+    if (State->InputLayout.Get() != Prev.InputLayout.Get())
+    {
+        Context->IASetInputLayout(State->InputLayout.Get());
+    }
+    if (State->Topology != Prev.Topology)
+    {
+        Context->IASetPrimitiveTopology(State->Topology);
+    }
+    if (State->Blend != Prev.Blend)
+    {
+        Context->OMSetBlendState(State->Blend, nullptr, 0xFFFFFFFFu);
+    }
+    if (State->Rasterizer != Prev.Rasterizer)
+    {
+        Context->RSSetState(State->Rasterizer);
+    }
+    if (State->DepthStencil != Prev.DepthStencil)
+    {
+        Context->OMSetDepthStencilState(State->DepthStencil, 0u);
+    }
+    if (State->Sampler != Prev.Sampler)
+    {
+        Context->PSSetSamplers(0u, 1u, &State->Sampler);
+    }
+    CurrentPipelineState = State;
+    Counters.PipelineChanges++;
+
+    if (CaptureWriter* const Writer = GetCapture())
+    {
+        Writer->Begin(CaptureOp::SetPipelineState);
+        Writer->Write(State->Id);
+    }
+}
+
+void Graphics::Submit(const CommandList& List, uint32_t SortKey)
+{
+    std::lock_guard<std::mutex> Lock(SubmitMutex);
+    SubmittedLists.emplace_back(SortKey, &List);
+}
+
+void Graphics::ExecuteCommandList(const CommandList& List)
+{
+    // One record for the whole list, payloads are deduplicated per command so static
+    // geometry is only stored once
+    if (CaptureWriter* const Writer = GetCapture())
+    {
+        Writer->Begin(CaptureOp::ExecuteCommandList);
+        Writer->Write(static_cast<uint32_t>(List.GetCommands().size()));
+        for (const Command& c : List.GetCommands())
+        {
+            Writer->Write(c);
+            const bool HasPayload = c.Type == CommandType::StreamVertices || c.Type == CommandType::StreamIndices ||
+                                    c.Type == CommandType::SetDrawConstants;
+            if (HasPayload)
+            {
+                Writer->WriteBlob(List.GetPayload(c.Args[0]), c.Args[1]);
+            }
+        }
+    }
+
+    struct SuspendCapture
+    {
+        bool& Suspended;
+        const bool Previous = std::exchange(Suspended, true);
+        ~SuspendCapture() { Suspended = Previous; }
+    } Suspend{CaptureSuspended};
+
+    BindRenderTarget();
+    Counters.CommandLists++;
+
+    for (const Command& c : List.GetCommands())
+    {
+        switch (c.Type)
+        {
+            case CommandType::SetPipelineState:
+            {
+                SetPipelineState(&PipelineStates.at(c.Args[0]));
+            } break;
+
+            case CommandType::SetVertexBuffer:
+            {
+                BindVertexBuffer(BufferHandle{c.Args[0]}, c.Args[1], c.Args[2]);
+            } break;
+
+            case CommandType::SetIndexBuffer:
+            {
+                BindIndexBuffer(BufferHandle{c.Args[0]}, c.Args[1] ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT, c.Args[2]);
+            } break;
+
+            case CommandType::StreamVertices:
+            {
+                BindStreamedVertices(StreamVertices(List.GetPayload(c.Args[0]), c.Args[1], c.Args[2]), c.Args[2]);
+            } break;
+
+            case CommandType::StreamIndices:
+            {
+                BindStreamedIndices(StreamIndices(List.GetPayload(c.Args[0]), c.Args[1]),
+                                    c.Args[2] ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT);
+            } break;
+
+            case CommandType::SetDrawConstants:
+            {
+                BindDrawConstants(StreamDrawConstants(List.GetPayload(c.Args[0]), c.Args[1]));
+            } break;
+
+            case CommandType::Draw:
+            {
+                FlushConstants();
+                Context->Draw(c.Args[0], c.Args[1]);
+                Counters.Draws++;
+            } break;
+
+            case CommandType::DrawIndexed:
+            {
+                FlushConstants();
+                Context->DrawIndexed(c.Args[0], c.Args[1], static_cast<INT>(c.Args[2]));
+                Counters.Draws++;
+            } break;
+        }
+    }
+}
+
+void Graphics::ExecuteSubmitted()
+{
+    // Taken into the frame arena so the lock is not held while the lists execute
+    using Submission = std::pair<uint32_t, const CommandList*>;
+    Submission* Lists;
+    size_t Count;
+    {
+        std::lock_guard<std::mutex> Lock(SubmitMutex);
+        Count = SubmittedLists.size();
+        Lists = FrameMemory.Current().NewArray<Submission>(Count);
+        std::copy(SubmittedLists.begin(), SubmittedLists.end(), Lists);
+        SubmittedLists.clear();
+    }
+
+    std::sort(Lists, Lists + Count, [](const Submission& a, const Submission& b) { return a.first < b.first; });
+    for (size_t i = 0; i < Count; i++)
+    {
+        ExecuteCommandList(*Lists[i].second);
+    }
+}
+
+CaptureWriter* Graphics::GetCapture() noexcept
+{
+    return CaptureSuspended ? nullptr : Capture.get();
+}
+
+void Graphics::CaptureRelease(CaptureResource Kind, uint32_t Value) noexcept
+{
+    if (CaptureWriter* const Writer = GetCapture())
+    {
+        Writer->Begin(CaptureOp::Release);
+        Writer->Write(Kind);
+        Writer->Write(Value);
+    }
+}
+
+void Graphics::BindRenderTarget() noexcept
+{
+    Context->OMSetRenderTargets(1u, Target.GetAddressOf(), DepthTarget.Get());
+
+    D3D11_VIEWPORT Viewport;
+    Viewport.Width = static_cast<float>(Width);
+    Viewport.Height = static_cast<float>(Height);
+    Viewport.MinDepth = 0;
+    Viewport.MaxDepth = 1;
+    Viewport.TopLeftX = 0;
+    Viewport.TopLeftY = 0;
+    Context->RSSetViewports(1u, &Viewport);
+}
+
+ID3D11BlendState* Graphics::GetBlendState(BlendMode Mode)
+{
+    auto& State = BlendStates[static_cast<size_t>(Mode)];
+    if (!State)
+    {
+        HRESULT hr;
+        D3D11_BLEND_DESC Desc = {};
+        auto& rt = Desc.RenderTarget[0];
+        rt.BlendEnable = Mode != BlendMode::Opaque;
+        rt.SrcBlend = Mode == BlendMode::Alpha ? D3D11_BLEND_SRC_ALPHA : D3D11_BLEND_ONE;
+        rt.DestBlend = Mode == BlendMode::Alpha ? D3D11_BLEND_INV_SRC_ALPHA : D3D11_BLEND_ONE;
+        rt.BlendOp = D3D11_BLEND_OP_ADD;
+        rt.SrcBlendAlpha = D3D11_BLEND_ONE;
+        rt.DestBlendAlpha = D3D11_BLEND_ZERO;
+        rt.BlendOpAlpha = D3D11_BLEND_OP_ADD;
+        rt.RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+        GFX_THROW_INFO(Device->CreateBlendState(&Desc, &State));
+    }
+    return State.Get();
+}
+
+ID3D11RasterizerState* Graphics::GetRasterizerState(CullMode Cull, FillMode Fill)
+{
+    auto& State = RasterizerStates[static_cast<size_t>(Cull)][static_cast<size_t>(Fill)];
+    if (!State)
+    {
+        HRESULT hr;
+        D3D11_RASTERIZER_DESC Desc = {};
+        Desc.FillMode = Fill == FillMode::Wireframe ? D3D11_FILL_WIREFRAME : D3D11_FILL_SOLID;
+        Desc.CullMode = Cull == CullMode::None ? D3D11_CULL_NONE : (Cull == CullMode::Front ? D3D11_CULL_FRONT : D3D11_CULL_BACK);
+        Desc.FrontCounterClockwise = FALSE;
+        Desc.DepthClipEnable = TRUE;
+        GFX_THROW_INFO(Device->CreateRasterizerState(&Desc, &State));
+    }
+    return State.Get();
+}
+
+ID3D11DepthStencilState* Graphics::GetDepthStencilState(DepthMode Mode)
+{
+    auto& State = DepthStencilStates[static_cast<size_t>(Mode)];
+    if (!State)
+    {
+        HRESULT hr;
+        D3D11_DEPTH_STENCIL_DESC Desc = {};
+        Desc.DepthEnable = Mode != DepthMode::Off;
+        Desc.DepthWriteMask = Mode == DepthMode::TestWrite ? D3D11_DEPTH_WRITE_MASK_ALL : D3D11_DEPTH_WRITE_MASK_ZERO;
+        // Equal passes, so flat scenes at z = 0 still draw in submission order
+        Desc.DepthFunc = D3D11_COMPARISON_LESS_EQUAL;
+        Desc.StencilEnable = FALSE;
+        GFX_THROW_INFO(Device->CreateDepthStencilState(&Desc, &State));
+    }
+    return State.Get();
+}
+
+ID3D11SamplerState* Graphics::GetSamplerState(SamplerMode Mode)
+{
+    auto& State = SamplerStates[static_cast<size_t>(Mode)];
+    if (!State)
+    {
+        HRESULT hr;
+        D3D11_SAMPLER_DESC Desc = {};
+        Desc.Filter = Mode == SamplerMode::Point ? D3D11_FILTER_MIN_MAG_MIP_POINT :
+                      (Mode == SamplerMode::Linear ? D3D11_FILTER_MIN_MAG_MIP_LINEAR : D3D11_FILTER_ANISOTROPIC);
+        Desc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
+        Desc.AddressV = D3D11_TEXTURE_ADDRESS_WRAP;
+        Desc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
+        Desc.MaxAnisotropy = Mode == SamplerMode::Anisotropic ? 16u : 1u;
+        Desc.ComparisonFunc = D3D11_COMPARISON_NEVER;
+        Desc.MaxLOD = D3D11_FLOAT32_MAX;
+        GFX_THROW_INFO(Device->CreateSamplerState(&Desc, &State));
+    }
+    return State.Get();
 }
 
 // Graphics exceptions
@@ -105,6 +1121,7 @@ Exception(Line, File), Result(hr)
 
 const char* Graphics::HrException::what() const noexcept
 {
+    AllocScope Scope(AllocTag::Exception);
     std::ostringstream oss;
     oss << GetType() << std::endl
         << "[Error Code] 0x" << std::hex << std::uppercase << GetErrorCode()
@@ -170,6 +1187,7 @@ Graphics::InfoException::InfoException(int Line, const char* File, std::vector<s
 
 const char* Graphics::InfoException::what() const noexcept
 {
+	AllocScope Scope(AllocTag::Exception);
 	std::ostringstream oss;
 	oss << GetType() << std::endl
 		<< "\n[Error Info]\n" << GetErrorInfo() << std::endl << std::endl;
@@ -190,90 +1208,37 @@ std::string Graphics::InfoException::GetErrorInfo() const noexcept
 
 // DRAWING!!
 
-void Graphics::DrawTestTriangle()
+void Graphics::CreateTestTriangleState()
 {
-        namespace wrl = Microsoft::WRL;
-        HRESULT hr;
+    // Input (vertex) layout (2D position only)
+    const D3D11_INPUT_ELEMENT_DESC InputElementDesc[] =
+    {
+        {"Position", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0}
+    };
 
-        struct Vertex
-        {
-            float X;
-            float Y;
-        };
+    PipelineStateDesc Desc;
+    Desc.VertexShader = LoadVertexShader(L"vertex_shader.cso");
+    Desc.PixelShader = LoadPixelShader(L"pixel_shader.cso");
+    Desc.InputLayout = CreateInputLayout(InputElementDesc, (UINT)std::size(InputElementDesc), Desc.VertexShader);
+    Desc.PrimitiveTopology = Topology::TriangleList;
+    TestTriangleState = CreatePipelineState(Desc);
+}
 
-        const Vertex Vertices[] = 
+// Only records, so it can run on any thread
+void Graphics::DrawTestTriangle(CommandList& List, float Angle) const
+{
+        const Vec2 Vertices[] = 
         {
             {0.0f, 0.5f},
             {0.5f, -0.5f},
             {-0.5f, -0.5f}
         };
 
-        wrl::ComPtr<ID3D11Buffer> VertexBuffer;
-
-        D3D11_BUFFER_DESC VertextBufferDesc = {};
-        VertextBufferDesc.ByteWidth = sizeof(Vertices);
-        VertextBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-        VertextBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-        VertextBufferDesc.CPUAccessFlags = 0u;
-        VertextBufferDesc.MiscFlags = 0u;
-        VertextBufferDesc.StructureByteStride = sizeof(Vertex);
-        
-
-        D3D11_SUBRESOURCE_DATA SubResDesc = {};
-        SubResDesc.pSysMem = Vertices;
-
-        Device->CreateBuffer(&VertextBufferDesc, &SubResDesc, &VertexBuffer);
-
-        // Bind Shaders to the pipeline
-        const UINT Stride = sizeof(Vertex);
-        const UINT Offset = 0u;
-        Context->IASetVertexBuffers(0u, 1u, VertexBuffer.GetAddressOf(), &Stride, &Offset);
+        // Per-draw transform, rotation around Z
+        const Mat4 Transform = Mat4::RotationZ(Angle);
 
-        // Create Pixel Shader
-        wrl::ComPtr<ID3D11PixelShader> PixelShader;
-        wrl::ComPtr<ID3DBlob> Blob;
-        GFX_THROW_INFO(D3DReadFileToBlob(L"pixel_shader.cso", &Blob));
-        GFX_THROW_INFO(Device->CreatePixelShader(Blob->GetBufferPointer(), Blob->GetBufferSize(), nullptr, &PixelShader));
-
-        // Bind Pixel Shader
-        Context->PSSetShader(PixelShader.Get(), nullptr, 0u);
-
-        // Create Vertex Shader
-        wrl::ComPtr<ID3D11VertexShader> VertexShader;
-        GFX_THROW_INFO(D3DReadFileToBlob(L"vertex_shader.cso", &Blob));
-        GFX_THROW_INFO(Device->CreateVertexShader(Blob->GetBufferPointer(), Blob->GetBufferSize(), nullptr, &VertexShader));
-
-        // Bind Vertex Shader
-        Context->VSSetShader(VertexShader.Get(), nullptr, 0u);
-
-        // Input (vertex) layout (2D position only)
-        wrl::ComPtr<ID3D11InputLayout> InputLayout;
-        const D3D11_INPUT_ELEMENT_DESC InputElementDesc[] = 
-        {
-            {"Position", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0}
-        };
-        GFX_THROW_INFO(Device->CreateInputLayout(InputElementDesc, (UINT)std::size(InputElementDesc),
-                                                 Blob->GetBufferPointer(), Blob->GetBufferSize(),
-                                                 &InputLayout));
-
-        // Bind vertex layout
-        Context->IASetInputLayout(InputLayout.Get());
-
-        // Bind Render target
-        Context->OMSetRenderTargets(1u, Target.GetAddressOf(), nullptr);
-
-        // Set Primitive Topology to Triangle list (groups of 3 vertices)
-        Context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-
-        // Configure Viewport
-        D3D11_VIEWPORT Viewport;
-        Viewport.Width = 800;
-        Viewport.Height = 600;
-        Viewport.MinDepth = 0;
-        Viewport.MaxDepth = 1;
-        Viewport.TopLeftX = 0;
-        Viewport.TopLeftY = 0;
-        Context->RSSetViewports(1u, &Viewport);
-
-        GFX_THROW_INFO_ONLY(Context->Draw((UINT)std::size(Vertices), 0u));
+        List.SetPipelineState(TestTriangleState->Id);
+        List.StreamVertices(Vertices, sizeof(Vertices), sizeof(Vec2));
+        List.SetDrawConstants(&Transform, sizeof(Transform));
+        List.Draw((UINT)std::size(Vertices));
 }
\ No newline at end of file
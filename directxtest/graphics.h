@@ -2,8 +2,23 @@
 #include "win_include.h"
 #include "exceptions.h"
 #include <d3d11.h>
+#include <d3d11_1.h>
 #include <wrl.h>
 #include "dxgi_info_manager.h"
+#include "frame_arena.h"
+#include "ring_allocator.h"
+#include "constant_buffer.h"
+#include "pipeline_state.h"
+#include "handle_pool.h"
+#include "deferred_release.h"
+#include "command_list.h"
+#include "capture.h"
+#include <atomic>
+#include <mutex>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <string>
 
 class Graphics
 {
@@ -45,13 +60,159 @@ public:
         std::string Reason;
     };
 public:
-    Graphics(HWND WindowHandle);
+    enum class Backend
+    {
+        Hardware,
+        Warp,   // Software rasterizer, for hosts without a GPU
+        Null    // Validates calls but renders nothing, isolates the CPU cost
+    };
+    // Work submitted during one frame
+    struct FrameCounters
+    {
+        uint32_t Draws = 0u;
+        uint32_t CommandLists = 0u;
+        uint32_t PipelineChanges = 0u;
+        // Streamed geometry and constants
+        uint64_t UploadBytes = 0u;
+        // Frame arena memory in use when the frame ended
+        uint64_t ArenaBytes = 0u;
+    };
+public:
+    // Frames the CPU may run ahead of the GPU, per-frame resources are buffered this many times
+    static constexpr unsigned int FramesInFlight = 3u;
+    // Also holds the staged draw constants when constant buffer offsetting is unavailable
+    static constexpr size_t FrameArenaSize = 4u << 20u;
+    static constexpr UINT DynamicVertexBufferSize = 4u << 20u;
+    static constexpr UINT DynamicIndexBufferSize = 1u << 20u;
+    static constexpr UINT FrameConstantsSize = 256u;
+    static constexpr UINT ViewConstantsSize = 256u;
+    static constexpr UINT DynamicConstantBufferSize = 4u << 20u;
+    // Largest per-draw block, only enforced when constant buffer offsetting is unavailable
+    static constexpr UINT MaxDrawConstantsSize = 4096u;
+    // Byte range written into one of the dynamic streaming buffers
+    struct DynamicRange
+    {
+        UINT Offset;
+        UINT Size;
+    };
+    // Resolved pipeline state. Fixed-function states are shared between PSOs, so applying
+    // one is a pointer comparison per state group against the previous PSO. Shaders and
+    // the layout are referenced, so releasing their handles cannot leave the PSO dangling.
+    struct PipelineState
+    {
+        uint32_t Id;    // Used by CommandList::SetPipelineState
+        PipelineStateDesc Desc;
+        Microsoft::WRL::ComPtr<ID3D11VertexShader> VertexShader;
+        Microsoft::WRL::ComPtr<ID3D11PixelShader> PixelShader;
+        Microsoft::WRL::ComPtr<ID3D11InputLayout> InputLayout;
+        D3D11_PRIMITIVE_TOPOLOGY Topology;
+        ID3D11BlendState* Blend;
+        ID3D11RasterizerState* Rasterizer;
+        ID3D11DepthStencilState* DepthStencil;
+        ID3D11SamplerState* Sampler;
+    };
+public:
+    // With a capture path every call below is recorded from device creation on, see capture.h
+    Graphics(HWND WindowHandle, const std::filesystem::path& CapturePath = {});
+    // Windowless, renders into an offscreen target of the given size
+    Graphics(Backend Type, UINT Width, UINT Height, const std::filesystem::path& CapturePath = {});
     Graphics(const Graphics&) = delete;
     Graphics& operator=(const Graphics&) = delete;
     ~Graphics() = default;
     void EndFrame();
     void ClearBuffer(float Red, float Green, float Blue) noexcept;
-    void DrawTestTriangle();
+    // 0 presents without waiting for vertical blank
+    void SetSyncInterval(UINT Interval) noexcept;
+    void DrawTestTriangle(CommandList& List, float Angle) const;
+    // Scratch memory that is valid until the same frame slot comes around again
+    FrameArena& GetFrameArena() noexcept;
+    // Most any frame slot ever had in use
+    size_t GetFrameArenaHighWaterMark() const noexcept;
+    // Streaming geometry, valid for the current frame only
+    DynamicRange StreamVertices(const void* Data, UINT Size, UINT Stride);
+    DynamicRange StreamIndices(const void* Data, UINT Size);
+    void BindStreamedVertices(const DynamicRange& Range, UINT Stride) noexcept;
+    void BindStreamedIndices(const DynamicRange& Range, DXGI_FORMAT Format = DXGI_FORMAT_R16_UINT) noexcept;
+    // Per-frame and per-view constants are shadowed on the CPU and uploaded before the next draw
+    void SetFrameConstants(const void* Data, UINT Size, UINT Offset = 0u);
+    void SetViewConstants(const void* Data, UINT Size, UINT Offset = 0u);
+    // Packs Count per-draw blocks of Size bytes at once, block i is bound with BindDrawConstants(Location, i)
+    ConstantLocation StreamDrawConstants(const void* Data, UINT Size, UINT Count = 1u);
+    void BindDrawConstants(const ConstantLocation& Location, UINT Index = 0u);
+    // GPU resources are owned by Graphics and referenced by handle. Release invalidates the
+    // handle right away, the object itself is destroyed at the end of the frame.
+    // Shaders are loaded once per path.
+    VertexShaderHandle LoadVertexShader(const wchar_t* Path);
+    PixelShaderHandle LoadPixelShader(const wchar_t* Path);
+    VertexShaderHandle CreateVertexShader(const void* Bytecode, SIZE_T Size);
+    PixelShaderHandle CreatePixelShader(const void* Bytecode, SIZE_T Size);
+    InputLayoutHandle CreateInputLayout(const D3D11_INPUT_ELEMENT_DESC* Elements, UINT Count, VertexShaderHandle VertexShader);
+    BufferHandle CreateBuffer(const D3D11_BUFFER_DESC& Desc, const void* InitialData = nullptr);
+    ShaderViewHandle CreateShaderView(BufferHandle Buffer, const D3D11_SHADER_RESOURCE_VIEW_DESC& Desc);
+    void Release(VertexShaderHandle Shader);
+    void Release(PixelShaderHandle Shader);
+    void Release(InputLayoutHandle Layout);
+    void Release(BufferHandle Buffer);
+    void Release(ShaderViewHandle View);
+    void BindVertexBuffer(BufferHandle Buffer, UINT Stride, UINT Offset = 0u);
+    void BindIndexBuffer(BufferHandle Buffer, DXGI_FORMAT Format = DXGI_FORMAT_R16_UINT, UINT Offset = 0u);
+    void BindShaderView(UINT Slot, ShaderViewHandle View);
+    // Thread-safe. Takes over one reference and releases it once every frame that may still
+    // use the object has completed, e.g. for assets unloaded on a worker thread
+    void DeferRelease(IUnknown* Object);
+    // Number of EndFrame calls so far
+    uint64_t GetFrameIndex() const noexcept;
+    // Counters of the last completed frame
+    const FrameCounters& GetFrameCounters() const noexcept;
+    static const char* GetBackendName(Backend Type) noexcept;
+    // Thread-safe. The list is executed at EndFrame in ascending SortKey order, which keeps
+    // the result independent of which worker finished first. Keys should be unique and
+    // the list has to stay alive until EndFrame returns.
+    void Submit(const CommandList& List, uint32_t SortKey);
+    void ExecuteCommandList(const CommandList& List);
+    // Equal descriptors return the same PSO. Releasing a shader or input layout evicts the
+    // PSOs that use it, their pointers stay valid but they must not be set again.
+    const PipelineState* CreatePipelineState(const PipelineStateDesc& Desc);
+    void SetPipelineState(const PipelineState* State) noexcept;
+private:
+    void Initialize(const std::filesystem::path& CapturePath);
+    void CreateDepthTarget();
+    void WaitForOffscreenFrame();
+    struct DynamicRing
+    {
+        Microsoft::WRL::ComPtr<ID3D11Buffer> Buffer;
+        RingAllocator Allocator;
+    };
+    void CreateDynamicRing(DynamicRing& Ring, UINT BindFlags);
+    DynamicRange StreamToRing(DynamicRing& Ring, const void* Data, UINT Size, UINT Alignment);
+    void* MapRing(DynamicRing& Ring, UINT Size, UINT Alignment, UINT& Offset);
+    void CreateConstantBuffer(Microsoft::WRL::ComPtr<ID3D11Buffer>& Buffer, UINT Size, D3D11_USAGE Usage);
+    void UploadConstants(ID3D11Buffer* Buffer, ConstantShadow& Shadow);
+    void FlushConstants();
+    void BindRenderTarget() noexcept;
+    void ExecuteSubmitted();
+    // Null while not capturing or while a command list executes, the list's own record covers those calls
+    CaptureWriter* GetCapture() noexcept;
+    void CaptureRelease(CaptureResource Kind, uint32_t Value) noexcept;
+    void CreateTestTriangleState();
+    ID3D11BlendState* GetBlendState(BlendMode Mode);
+    ID3D11RasterizerState* GetRasterizerState(CullMode Cull, FillMode Fill);
+    ID3D11DepthStencilState* GetDepthStencilState(DepthMode Mode);
+    ID3D11SamplerState* GetSamplerState(SamplerMode Mode);
+    template<typename F>
+    void EvictPipelineStates(F&& UsesReleased);
+private:
+    struct VertexShaderEntry
+    {
+        std::wstring Path;
+        Microsoft::WRL::ComPtr<ID3D11VertexShader> Shader;
+        Microsoft::WRL::ComPtr<ID3DBlob> Bytecode;
+    };
+    struct PixelShaderEntry
+    {
+        std::wstring Path;
+        Microsoft::WRL::ComPtr<ID3D11PixelShader> Shader;
+    };
 private:
 #ifndef NDEBUG
     DXGIInfoManager InfoManager;
@@ -60,4 +221,50 @@ private:
     Microsoft::WRL::ComPtr<IDXGISwapChain> SwapChain;
     Microsoft::WRL::ComPtr<ID3D11DeviceContext> Context;
     Microsoft::WRL::ComPtr<ID3D11RenderTargetView> Target;
+    // Same size as Target, cleared with it. Only PSOs with a DepthMode other than Off use it.
+    Microsoft::WRL::ComPtr<ID3D11DepthStencilView> DepthTarget;
+    // Offscreen only: one event per frame in flight stands in for the swap chain's frame latency
+    Microsoft::WRL::ComPtr<ID3D11Query> FrameQueries[FramesInFlight];
+    UINT Width = 0u;
+    UINT Height = 0u;
+    UINT SyncInterval = 1u;
+    FrameCounters Counters;
+    FrameCounters LastCounters;
+    FrameArenaRing<FramesInFlight> FrameMemory{FrameArenaSize};
+    DynamicRing VertexRing{nullptr, RingAllocator(DynamicVertexBufferSize, FramesInFlight)};
+    DynamicRing IndexRing{nullptr, RingAllocator(DynamicIndexBufferSize, FramesInFlight)};
+    // D3D11.1 interface, null on runtimes without it
+    Microsoft::WRL::ComPtr<ID3D11DeviceContext1> Context1;
+    bool ConstantOffsetting = false;
+    bool ConstantPartialUpdate = false;
+    ConstantShadow FrameConstants{FrameConstantsSize};
+    ConstantShadow ViewConstants{ViewConstantsSize};
+    Microsoft::WRL::ComPtr<ID3D11Buffer> FrameConstantBuffer;
+    Microsoft::WRL::ComPtr<ID3D11Buffer> ViewConstantBuffer;
+    DynamicRing DrawConstantRing{nullptr, RingAllocator(DynamicConstantBufferSize, FramesInFlight)};
+    // Fallback without offsetting: packed blocks are staged in the frame arena and mapped
+    // one draw at a time. Locations are offsets from the start of the arena.
+    Microsoft::WRL::ComPtr<ID3D11Buffer> DrawConstantBuffer;
+    // Resources behind handles, released objects wait in ReleaseQueue until their frame completed
+    HandlePool<VertexShaderEntry, VertexShaderHandle> VertexShaders;
+    HandlePool<PixelShaderEntry, PixelShaderHandle> PixelShaders;
+    HandlePool<Microsoft::WRL::ComPtr<ID3D11InputLayout>, InputLayoutHandle> InputLayouts;
+    HandlePool<Microsoft::WRL::ComPtr<ID3D11Buffer>, BufferHandle> Buffers;
+    HandlePool<Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>, ShaderViewHandle> ShaderViews;
+    std::atomic<uint64_t> FrameIndex{0u};
+    DeferredReleaseQueue ReleaseQueue;
+    std::mutex SubmitMutex;
+    std::vector<std::pair<uint32_t, const CommandList*>> SubmittedLists;
+    Microsoft::WRL::ComPtr<ID3D11BlendState> BlendStates[static_cast<size_t>(BlendMode::Count)];
+    Microsoft::WRL::ComPtr<ID3D11RasterizerState> RasterizerStates[static_cast<size_t>(CullMode::Count)][static_cast<size_t>(FillMode::Count)];
+    Microsoft::WRL::ComPtr<ID3D11DepthStencilState> DepthStencilStates[static_cast<size_t>(DepthMode::Count)];
+    Microsoft::WRL::ComPtr<ID3D11SamplerState> SamplerStates[static_cast<size_t>(SamplerMode::Count)];
+    // Deque so that PSO pointers stay valid as the cache grows. Evicted PSOs keep their
+    // slot, command lists refer to PSOs by position.
+    std::deque<PipelineState> PipelineStates;
+    PipelineStateCache PipelineCache;
+    const PipelineState* CurrentPipelineState = nullptr;
+    const PipelineState* TestTriangleState = nullptr;
+    std::unique_ptr<CaptureWriter> Capture;
+    bool CaptureSuspended = false;
 };
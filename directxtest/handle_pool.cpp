@@ -0,0 +1,21 @@
+#include "handle_pool.h"
+#include <sstream>
+
+StaleHandleException::StaleHandleException(int Line, const char* File, uint32_t Index, uint32_t Generation) noexcept
+    : MyException(Line, File), Index(Index), Generation(Generation) {}
+
+const char* StaleHandleException::what() const noexcept
+{
+    std::ostringstream oss;
+    oss << GetType() << std::endl
+        << "[Index] " << Index << std::endl
+        << "[Generation] " << Generation << std::endl
+        << GetOriginString();
+    whatBuffer = oss.str();
+    return whatBuffer.c_str();
+}
+
+const char* StaleHandleException::GetType() const noexcept
+{
+    return "Stale Handle Exception";
+}
\ No newline at end of file
@@ -0,0 +1,185 @@
+#pragma once
+#include "exceptions.h"
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// 32-bit generational handle: the low bits index a slot, the high bits hold the slot's
+// generation at creation time. A released slot bumps its generation so stale handles
+// are detected instead of silently aliasing a newer object. 0 is never a valid handle.
+template<typename Tag>
+struct Handle
+{
+    static constexpr uint32_t IndexBits = 20u;
+    static constexpr uint32_t IndexMask = (1u << IndexBits) - 1u;
+    static constexpr uint32_t GenerationMask = (1u << (32u - IndexBits)) - 1u;
+
+    uint32_t Value = 0u;
+
+    static Handle Make(uint32_t Index, uint32_t Generation) noexcept
+    {
+        return Handle{(Generation << IndexBits) | Index};
+    }
+    uint32_t GetIndex() const noexcept
+    {
+        return Value & IndexMask;
+    }
+    uint32_t GetGeneration() const noexcept
+    {
+        return Value >> IndexBits;
+    }
+    bool IsValid() const noexcept
+    {
+        return Value != 0u;
+    }
+    bool operator==(const Handle&) const = default;
+};
+
+class StaleHandleException : public MyException
+{
+public:
+    StaleHandleException(int Line, const char* File, uint32_t Index, uint32_t Generation) noexcept;
+    const char* what() const noexcept override;
+    const char* GetType() const noexcept override;
+private:
+    uint32_t Index;
+    uint32_t Generation;
+};
+
+#define STALE_HANDLE_EXCEPT(h) StaleHandleException(__LINE__, __FILE__, (h).GetIndex(), (h).GetGeneration())
+
+// Objects live densely packed in one array, handles go through a sparse slot table.
+// Removing swaps the last object into the hole, so pointers from Get() are only
+// valid until the next Remove().
+template<typename T, typename HandleT = Handle<T>>
+class HandlePool
+{
+public:
+    using HandleType = HandleT;
+public:
+    HandleType Insert(T Value)
+    {
+        uint32_t Index;
+        if (!FreeSlots.empty())
+        {
+            Index = FreeSlots.back();
+            FreeSlots.pop_back();
+        }
+        else
+        {
+            if (Slots.size() > HandleType::IndexMask)
+            {
+                throw std::length_error("HandlePool is out of slots");
+            }
+            Index = static_cast<uint32_t>(Slots.size());
+            Slots.push_back({1u, 0u});
+        }
+
+        Slots[Index].DenseIndex = static_cast<uint32_t>(Dense.size());
+        Dense.push_back(std::move(Value));
+        DenseToSlot.push_back(Index);
+        return HandleType::Make(Index, Slots[Index].Generation);
+    }
+
+    // Null for handles that were never valid or whose object was removed
+    T* Get(HandleType h) noexcept
+    {
+        return IsAlive(h) ? &Dense[Slots[h.GetIndex()].DenseIndex] : nullptr;
+    }
+    const T* Get(HandleType h) const noexcept
+    {
+        return IsAlive(h) ? &Dense[Slots[h.GetIndex()].DenseIndex] : nullptr;
+    }
+    // Throws on use after free
+    T& At(HandleType h)
+    {
+        if (!IsAlive(h))
+        {
+            throw STALE_HANDLE_EXCEPT(h);
+        }
+        return Dense[Slots[h.GetIndex()].DenseIndex];
+    }
+    bool IsAlive(HandleType h) const noexcept
+    {
+        const uint32_t Index = h.GetIndex();
+        return h.IsValid() && Index < Slots.size() && Slots[Index].Generation == h.GetGeneration();
+    }
+
+    // Invalidates the handle and hands the object back, so that the caller decides
+    // when it is actually destroyed
+    T Remove(HandleType h)
+    {
+        if (!IsAlive(h))
+        {
+            throw STALE_HANDLE_EXCEPT(h);
+        }
+
+        Slot& s = Slots[h.GetIndex()];
+        const uint32_t Hole = s.DenseIndex;
+        T Removed = std::move(Dense[Hole]);
+        if (Hole + 1u != Dense.size())
+        {
+            Dense[Hole] = std::move(Dense.back());
+            DenseToSlot[Hole] = DenseToSlot.back();
+            Slots[DenseToSlot[Hole]].DenseIndex = Hole;
+        }
+        Dense.pop_back();
+        DenseToSlot.pop_back();
+
+        // Generation 0 is skipped so that a handle value is never 0
+        s.Generation = (s.Generation + 1u) & HandleType::GenerationMask;
+        if (s.Generation == 0u)
+        {
+            s.Generation = 1u;
+        }
+        FreeSlots.push_back(h.GetIndex());
+        return Removed;
+    }
+
+    template<typename Predicate>
+    HandleType FindIf(Predicate&& Pred) const
+    {
+        for (size_t i = 0; i < Dense.size(); i++)
+        {
+            if (Pred(Dense[i]))
+            {
+                const uint32_t Index = DenseToSlot[i];
+                return HandleType::Make(Index, Slots[Index].Generation);
+            }
+        }
+        return {};
+    }
+
+    size_t GetSize() const noexcept
+    {
+        return Dense.size();
+    }
+    // Dense iteration, in no particular order
+    T* begin() noexcept
+    {
+        return Dense.data();
+    }
+    T* end() noexcept
+    {
+        return Dense.data() + Dense.size();
+    }
+private:
+    struct Slot
+    {
+        uint32_t Generation;
+        uint32_t DenseIndex;
+    };
+private:
+    std::vector<T> Dense;
+    std::vector<uint32_t> DenseToSlot;
+    std::vector<Slot> Slots;
+    std::vector<uint32_t> FreeSlots;
+};
+
+// Handles for GPU resources owned by Graphics
+using BufferHandle = Handle<struct BufferTag>;
+using VertexShaderHandle = Handle<struct VertexShaderTag>;
+using PixelShaderHandle = Handle<struct PixelShaderTag>;
+using InputLayoutHandle = Handle<struct InputLayoutTag>;
+using ShaderViewHandle = Handle<struct ShaderViewTag>;
\ No newline at end of file
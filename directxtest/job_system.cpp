@@ -0,0 +1,127 @@
+#include "job_system.h"
+#include <algorithm>
+#include <utility>
+
+JobSystem::JobSystem(unsigned int WorkerCount)
+{
+    if (WorkerCount == HardwareWorkers)
+    {
+        const unsigned int Hardware = std::thread::hardware_concurrency();
+        WorkerCount = Hardware > 1u ? Hardware - 1u : 0u;
+    }
+
+    Workers.reserve(WorkerCount);
+    for (unsigned int i = 0; i < WorkerCount; i++)
+    {
+        Workers.emplace_back(&JobSystem::WorkerLoop, this, i + 1u);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> Lock(WakeMutex);
+        Quit = true;
+    }
+    WakeCondition.notify_all();
+    for (auto& w : Workers)
+    {
+        w.join();
+    }
+}
+
+unsigned int JobSystem::GetThreadCount() const noexcept
+{
+    return static_cast<unsigned int>(Workers.size()) + 1u;
+}
+
+void JobSystem::Run(size_t Count, size_t Grain, void* Context, Invoker Invoke)
+{
+    Grain = std::max<size_t>(Grain, 1u);
+    if (Count == 0u)
+    {
+        return;
+    }
+
+    // Busy or not worth waking anyone, run inline
+    std::unique_lock<std::mutex> RunLock(RunMutex, std::try_to_lock);
+    if (!RunLock.owns_lock() || Workers.empty() || Count <= Grain)
+    {
+        for (size_t Begin = 0; Begin < Count; Begin += Grain)
+        {
+            Invoke(Context, Begin, std::min(Begin + Grain, Count), 0u);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> Lock(WakeMutex);
+        LoopContext = Context;
+        LoopInvoke = Invoke;
+        LoopCount = Count;
+        LoopGrain = Grain;
+        NextChunk.store(0u, std::memory_order_relaxed);
+        LoopFailed.store(false, std::memory_order_relaxed);
+        LoopError = nullptr;
+        ActiveWorkers = static_cast<unsigned int>(Workers.size());
+        Generation++;
+    }
+    WakeCondition.notify_all();
+
+    ExecuteChunks(0u);
+
+    std::unique_lock<std::mutex> Lock(WakeMutex);
+    DoneCondition.wait(Lock, [this] { return ActiveWorkers == 0u; });
+    if (LoopError)
+    {
+        std::rethrow_exception(std::exchange(LoopError, nullptr));
+    }
+}
+
+void JobSystem::WorkerLoop(unsigned int ThreadIndex)
+{
+    unsigned long long Seen = 0u;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> Lock(WakeMutex);
+            WakeCondition.wait(Lock, [&] { return Quit || Generation != Seen; });
+            if (Quit)
+            {
+                return;
+            }
+            Seen = Generation;
+        }
+
+        ExecuteChunks(ThreadIndex);
+
+        std::lock_guard<std::mutex> Lock(WakeMutex);
+        if (--ActiveWorkers == 0u)
+        {
+            DoneCondition.notify_one();
+        }
+    }
+}
+
+void JobSystem::ExecuteChunks(unsigned int ThreadIndex) noexcept
+{
+    const size_t Chunks = (LoopCount + LoopGrain - 1u) / LoopGrain;
+    try
+    {
+        for (size_t c = NextChunk.fetch_add(1u, std::memory_order_relaxed); c < Chunks;
+             c = NextChunk.fetch_add(1u, std::memory_order_relaxed))
+        {
+            const size_t Begin = c * LoopGrain;
+            LoopInvoke(LoopContext, Begin, std::min(Begin + LoopGrain, LoopCount), ThreadIndex);
+        }
+    }
+    catch (...)
+    {
+        // Run reads the error after every thread has reported done under WakeMutex
+        if (!LoopFailed.exchange(true, std::memory_order_relaxed))
+        {
+            LoopError = std::current_exception();
+        }
+        NextChunk.store(Chunks, std::memory_order_relaxed);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed pool of worker threads for data-parallel loops. The calling thread takes part in
+// the work, so thread index 0 is always the caller and workers are 1..GetThreadCount()-1.
+class JobSystem
+{
+public:
+    // One worker per hardware thread besides the caller
+    static constexpr unsigned int HardwareWorkers = 0xFFFFFFFFu;
+public:
+    // 0 workers runs every loop on the caller
+    explicit JobSystem(unsigned int WorkerCount = HardwareWorkers);
+    ~JobSystem();
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    unsigned int GetThreadCount() const noexcept;
+
+    // Calls Body(Begin, End, ThreadIndex) for chunks of at most Grain items covering [0, Count)
+    // and returns when all chunks are done. Chunk k always starts at k * Grain.
+    // A loop started while another one is running (e.g. from inside a Body) runs serially.
+    // When a Body throws, chunks that have not started yet are skipped and the first
+    // exception is rethrown here once every thread has left the loop.
+    template<typename Func>
+    void ParallelFor(size_t Count, size_t Grain, Func&& Body)
+    {
+        Run(Count, Grain, &Body, [](void* Context, size_t Begin, size_t End, unsigned int Thread)
+        {
+            (*static_cast<std::remove_reference_t<Func>*>(Context))(Begin, End, Thread);
+        });
+    }
+private:
+    using Invoker = void(*)(void* Context, size_t Begin, size_t End, unsigned int Thread);
+    void Run(size_t Count, size_t Grain, void* Context, Invoker Invoke);
+    void WorkerLoop(unsigned int ThreadIndex);
+    void ExecuteChunks(unsigned int ThreadIndex) noexcept;
+private:
+    std::vector<std::thread> Workers;
+    std::mutex RunMutex;
+
+    // Current loop, published under WakeMutex
+    std::mutex WakeMutex;
+    std::condition_variable WakeCondition;
+    std::condition_variable DoneCondition;
+    unsigned long long Generation = 0u;
+    unsigned int ActiveWorkers = 0u;
+    bool Quit = false;
+    void* LoopContext = nullptr;
+    Invoker LoopInvoke = nullptr;
+    size_t LoopCount = 0u;
+    size_t LoopGrain = 1u;
+    std::atomic<size_t> NextChunk{0u};
+    // First exception of the current loop, written by whichever thread sets LoopFailed
+    std::atomic<bool> LoopFailed{false};
+    std::exception_ptr LoopError;
+};
\ No newline at end of file
@@ -6,6 +6,7 @@
 class Keyboard
 {
     friend class Window;
+    friend class MicroBenchmark;
 public:
     class Event
     {
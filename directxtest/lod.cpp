@@ -0,0 +1,245 @@
+#include "lod.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+namespace
+{
+    // Nearer bounding spheres count as touching the eye
+    constexpr float MinDistance = 1e-4f;
+    // 1 / log2(BudgetStep)
+    constexpr float InverseLog2Step = 3.10628372f;
+    static_assert(LodSelector::MaxLevels <= 8u && LodSelector::BudgetSteps < 256u, "Level steps are packed as bytes of a uint64_t");
+}
+
+LodSelector::LodSelector(const Settings& Config)
+{
+    SetSettings(Config);
+}
+
+void LodSelector::SetSettings(const Settings& NewConfig)
+{
+    if (!(NewConfig.PixelError > 0.0f) || !(NewConfig.Hysteresis >= 0.0f && NewConfig.Hysteresis < 1.0f))
+    {
+        throw std::invalid_argument("LOD pixel error must be positive and hysteresis in [0, 1)");
+    }
+    Config = NewConfig;
+    CoarsenFactor = 1.0f / (1.0f - Config.Hysteresis);
+    Thresholds[0] = Config.PixelError;
+    for (uint32_t k = 1; k < BudgetSteps; k++)
+    {
+        Thresholds[k] = Thresholds[k - 1u] * BudgetStep;
+    }
+}
+
+uint32_t LodSelector::AddMesh(const LodLevel* NewLevels, uint32_t LevelCount)
+{
+    if (LevelCount == 0u || LevelCount > MaxLevels)
+    {
+        throw std::invalid_argument("A mesh needs between 1 and MaxLevels levels of detail");
+    }
+    MeshLods Mesh = {};
+    Mesh.LevelCount = LevelCount;
+    for (uint32_t l = 0; l < LevelCount; l++)
+    {
+        if (NewLevels[l].IndexCount % 3u != 0u || (l > 0u && NewLevels[l].Error < NewLevels[l - 1u].Error))
+        {
+            throw std::invalid_argument("Levels of detail need whole triangles and errors that do not decrease");
+        }
+        Mesh.Levels[l] = NewLevels[l];
+        Mesh.Triangles[l] = NewLevels[l].IndexCount / 3u;
+    }
+    Meshes.push_back(Mesh);
+    return static_cast<uint32_t>(Meshes.size() - 1u);
+}
+
+const LodLevel& LodSelector::GetLevel(uint32_t Mesh, uint32_t Level) const noexcept
+{
+    return Meshes[Mesh].Levels[Level];
+}
+
+float LodSelector::GetPixelScale(const Mat4& Projection, uint32_t ViewportHeight) noexcept
+{
+    // The projection maps y / z = 1 to M[1][1] in clip space, half the viewport in pixels
+    return Projection.M[1][1] * 0.5f * static_cast<float>(ViewportHeight);
+}
+
+size_t LodSelector::CullAndSelect(JobSystem& Jobs, const Frustum& View, const Vec3& Eye, float PixelScale, const SphereStreams& Spheres, const uint32_t* MeshOf, size_t Count, uint32_t* Visible)
+{
+    Levels.resize(Count, 0u);
+    LevelSteps.resize(Count);
+    Triangles = 0u;
+    PixelError = Config.PixelError;
+    if (Count == 0u)
+    {
+        return 0u;
+    }
+
+    // Slice k of the objects is culled into Visible from k * Grain, like FrustumCuller
+    const size_t SliceCount = (Count + Grain - 1u) / Grain;
+    SliceCounts.assign(SliceCount, 0u);
+    SliceHistograms.assign(SliceCount, {});
+    SliceTriangles.assign(SliceCount, 0u);
+    const auto CullSlice = [&](size_t Begin, size_t End)
+    {
+        const SphereStreams Slice = {Spheres.X + Begin, Spheres.Y + Begin, Spheres.Z + Begin, Spheres.Radius + Begin};
+        const size_t n = ::CullSpheres(View, Slice, End - Begin, Visible + Begin, static_cast<uint32_t>(Begin));
+        MeasureSlice(Eye, PixelScale, Spheres, MeshOf, Visible + Begin, n, SliceHistograms[Begin / Grain]);
+        SliceCounts[Begin / Grain] = n;
+    };
+    if (SliceCount == 1u)
+    {
+        CullSlice(0u, Count);
+    }
+    else
+    {
+        Jobs.ParallelFor(Count, Grain, [&](size_t Begin, size_t End, unsigned int)
+        {
+            CullSlice(Begin, End);
+        });
+    }
+
+    // Lowest threshold whose triangles fit the budget, or the last one
+    uint32_t Step = 0u;
+    if (Config.TriangleBudget > 0u)
+    {
+        int64_t Total = 0;
+        for (Step = 0u; Step < BudgetSteps; Step++)
+        {
+            for (const Histogram& Counts : SliceHistograms)
+            {
+                Total += Counts.Triangles[Step];
+            }
+            if (Total <= static_cast<int64_t>(Config.TriangleBudget))
+            {
+                break;
+            }
+        }
+        Step = std::min(Step, BudgetSteps - 1u);
+        PixelError = Thresholds[Step];
+    }
+
+    const auto SelectAt = [&](size_t k)
+    {
+        SliceTriangles[k] = SelectSlice(MeshOf, Visible + k * Grain, SliceCounts[k], Step);
+    };
+    if (SliceCount == 1u)
+    {
+        SelectAt(0u);
+    }
+    else
+    {
+        Jobs.ParallelFor(SliceCount, 1u, [&](size_t Begin, size_t End, unsigned int)
+        {
+            for (size_t k = Begin; k < End; k++)
+            {
+                SelectAt(k);
+            }
+        });
+    }
+
+    // Close the gaps between the slices
+    size_t n = SliceCounts[0];
+    Triangles = SliceTriangles[0];
+    for (size_t k = 1; k < SliceCount; k++)
+    {
+        std::memmove(Visible + n, Visible + k * Grain, SliceCounts[k] * sizeof(uint32_t));
+        n += SliceCounts[k];
+        Triangles += SliceTriangles[k];
+    }
+    return n;
+}
+
+const uint8_t* LodSelector::GetLevels() const noexcept
+{
+    return Levels.data();
+}
+
+float LodSelector::GetPixelError() const noexcept
+{
+    return PixelError;
+}
+
+uint64_t LodSelector::GetTriangleCount() const noexcept
+{
+    return Triangles;
+}
+
+uint32_t LodSelector::GetStep(float Pixels) const noexcept
+{
+    if (Pixels <= Thresholds[0])
+    {
+        return 0u;
+    }
+    if (!(Pixels <= Thresholds[BudgetSteps - 1u]))
+    {
+        return BudgetSteps;
+    }
+    // Estimate from a quick log2, within one step, then settle on the table so both
+    // passes and the histogram agree exactly
+    const float Ratio = Pixels / Thresholds[0];
+    const uint32_t Bits = std::bit_cast<uint32_t>(Ratio);
+    const float Mantissa = std::bit_cast<float>((Bits & 0x007FFFFFu) | 0x3F800000u);
+    const float Log2 = static_cast<float>(static_cast<int32_t>(Bits >> 23u) - 127) + (-0.34484843f * Mantissa + 2.02466578f) * Mantissa - 0.67487759f;
+    uint32_t Step = std::min(static_cast<uint32_t>(std::max(Log2 * InverseLog2Step, 0.0f)), BudgetSteps - 1u);
+    while (Step > 0u && Thresholds[Step - 1u] >= Pixels)
+    {
+        Step--;
+    }
+    while (Thresholds[Step] < Pixels)
+    {
+        Step++;
+    }
+    return Step;
+}
+
+void LodSelector::MeasureSlice(const Vec3& Eye, float PixelScale, const SphereStreams& Spheres, const uint32_t* MeshOf, const uint32_t* SliceVisible, size_t VisibleCount, Histogram& Counts) noexcept
+{
+    for (size_t j = 0; j < VisibleCount; j++)
+    {
+        const uint32_t i = SliceVisible[j];
+        const Vec3 ToCenter = {Spheres.X[i] - Eye.X, Spheres.Y[i] - Eye.Y, Spheres.Z[i] - Eye.Z};
+        const float ErrorScale = PixelScale * Spheres.Radius[i] / std::max(Length(ToCenter) - Spheres.Radius[i], MinDistance);
+
+        // The object shows its full detail triangles at the first threshold, and each
+        // level it reaches at a higher one replaces the previous level's triangles
+        const MeshLods& Lods = Meshes[MeshOf[i]];
+        Counts.Triangles[0] += Lods.Triangles[0];
+        uint64_t Packed = 0u;
+        uint32_t Step = 0u;
+        for (uint32_t l = 1; l < Lods.LevelCount; l++)
+        {
+            const float Pixels = Lods.Levels[l].Error * ErrorScale * (l > Levels[i] ? CoarsenFactor : 1.0f);
+            Step = std::max(GetStep(Pixels), Step);
+            if (Step == BudgetSteps)
+            {
+                // No threshold reaches this level or the coarser ones
+                Packed |= ~uint64_t(0u) << (8u * l);
+                break;
+            }
+            Packed |= static_cast<uint64_t>(Step) << (8u * l);
+            Counts.Triangles[Step] += static_cast<int64_t>(Lods.Triangles[l]) - static_cast<int64_t>(Lods.Triangles[l - 1u]);
+        }
+        LevelSteps[i] = Packed;
+    }
+}
+
+uint64_t LodSelector::SelectSlice(const uint32_t* MeshOf, const uint32_t* SliceVisible, size_t VisibleCount, uint32_t Step) noexcept
+{
+    uint64_t Total = 0u;
+    for (size_t j = 0; j < VisibleCount; j++)
+    {
+        const uint32_t i = SliceVisible[j];
+        const MeshLods& Lods = Meshes[MeshOf[i]];
+        uint32_t Level = 0u;
+        while (Level + 1u < Lods.LevelCount && ((LevelSteps[i] >> (8u * (Level + 1u))) & 0xFFu) <= Step)
+        {
+            Level++;
+        }
+        Levels[i] = static_cast<uint8_t>(Level);
+        Total += Lods.Triangles[Level];
+    }
+    return Total;
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+#pragma once
+#include "simd_math.h"
+#include "culling.h"
+#include "job_system.h"
+#include <cstdint>
+#include <vector>
+
+// One level of detail of a mesh, a range of its index buffer
+struct LodLevel
+{
+    uint32_t FirstIndex;
+    uint32_t IndexCount;
+    // Largest distance between this level's surface and the full detail one, over the
+    // radius of the mesh's bounding sphere. Objects scale it by their sphere's radius.
+    // 0 for the full detail level.
+    float Error;
+};
+
+// Picks a level of detail per object from the size of its geometric error on screen.
+// An object takes the coarsest level whose error projects to at most the pixel threshold
+// at the nearest point of its bounding sphere. Going coarser additionally needs the error
+// to fit with Hysteresis to spare, so objects near a threshold do not pop back and forth.
+//
+// With a triangle budget the threshold rises in BudgetStep steps until the selected
+// levels fit. Every visible object counts its triangles at each candidate threshold into
+// a histogram while it is culled, so finding the threshold costs no extra pass over the
+// objects. Selection runs in the same jobs as frustum culling, in slices of Grain objects.
+class LodSelector
+{
+public:
+    static constexpr uint32_t MaxLevels = 8u;
+    static constexpr size_t Grain = FrustumCuller::Grain;
+    // Candidate thresholds, each BudgetStep times the previous. The last one is about
+    // 1000 times the base threshold.
+    static constexpr uint32_t BudgetSteps = 32u;
+    static constexpr float BudgetStep = 1.25f;
+    struct Settings
+    {
+        // Largest error on screen in pixels
+        float PixelError = 1.0f;
+        // Fraction of the threshold a coarser level's error must stay below
+        float Hysteresis = 0.2f;
+        // Triangles over all visible objects, 0 for no limit
+        uint64_t TriangleBudget = 0u;
+    };
+public:
+    explicit LodSelector(const Settings& Config);
+    void SetSettings(const Settings& NewConfig);
+
+    // Levels go from full detail to coarsest, their errors must not decrease
+    uint32_t AddMesh(const LodLevel* Levels, uint32_t LevelCount);
+    const LodLevel& GetLevel(uint32_t Mesh, uint32_t Level) const noexcept;
+
+    // Pixels per world unit at distance 1 for a perspective projection
+    static float GetPixelScale(const Mat4& Projection, uint32_t ViewportHeight) noexcept;
+
+    // Culls the bounding spheres against View and selects levels for the visible objects,
+    // object i shows mesh MeshOf[i]. Visible receives the visible objects in ascending
+    // order and needs room for Count entries. The levels of objects that were not visible
+    // keep their last value. Returns the number of visible objects.
+    size_t CullAndSelect(JobSystem& Jobs, const Frustum& View, const Vec3& Eye, float PixelScale, const SphereStreams& Spheres, const uint32_t* MeshOf, size_t Count, uint32_t* Visible);
+
+    // Level of every object, index with the object
+    const uint8_t* GetLevels() const noexcept;
+    // Threshold of the last selection, above Settings::PixelError when the budget forced it up
+    float GetPixelError() const noexcept;
+    // Triangles of the visible objects' selected levels. Above the budget only when even
+    // the last threshold does not fit it.
+    uint64_t GetTriangleCount() const noexcept;
+private:
+    struct MeshLods
+    {
+        LodLevel Levels[MaxLevels];
+        uint32_t Triangles[MaxLevels];
+        uint32_t LevelCount;
+    };
+    // Triangles at each candidate threshold, as changes from the previous one
+    struct Histogram
+    {
+        int64_t Triangles[BudgetSteps];
+    };
+private:
+    // First candidate threshold an error projected to Pixels fits under, BudgetSteps if none
+    uint32_t GetStep(float Pixels) const noexcept;
+    // Level steps of every visible object of the slice, and the slice's histogram
+    void MeasureSlice(const Vec3& Eye, float PixelScale, const SphereStreams& Spheres, const uint32_t* MeshOf, const uint32_t* SliceVisible, size_t VisibleCount, Histogram& Counts) noexcept;
+    // Levels at the candidate threshold Step, returns their triangles
+    uint64_t SelectSlice(const uint32_t* MeshOf, const uint32_t* SliceVisible, size_t VisibleCount, uint32_t Step) noexcept;
+private:
+    Settings Config;
+    // Applied to the errors of levels coarser than the current one
+    float CoarsenFactor = 1.0f;
+    std::vector<MeshLods> Meshes;
+    std::vector<uint8_t> Levels;
+    // Candidate threshold Thresholds[k] is PixelError * BudgetStep^k
+    float Thresholds[BudgetSteps] = {};
+    // Byte l holds the first candidate threshold level l fits under, never decreasing
+    // with l. Valid for the visible objects of the last selection.
+    std::vector<uint64_t> LevelSteps;
+    std::vector<size_t> SliceCounts;
+    std::vector<Histogram> SliceHistograms;
+    std::vector<uint64_t> SliceTriangles;
+    float PixelError = 0.0f;
+    uint64_t Triangles = 0u;
+};
\ No newline at end of file
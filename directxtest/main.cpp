@@ -1,22 +1,243 @@
 #include "app.h"
+#include "microbenchmark.h"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+namespace
+{
+    // Malformed command lines, reported together with the usage text
+    class UsageError : public std::invalid_argument
+    {
+    public:
+        using std::invalid_argument::invalid_argument;
+    };
+
+    constexpr int Failure = 2;
+
+    constexpr const char* Usage =
+        "usage: directxtest [options]\n"
+        "  -pipeline <depth>   simulate up to depth-1 frames ahead of submission\n"
+        "  -capture <file>     record every Graphics call\n"
+        "  -replay <file>      play a capture as fast as possible, -paced for the recorded cadence\n"
+        "  -bench              headless benchmark, configured with -scene <name> -frames <n> -warmup <n>\n"
+        "                      -width <w> -height <h> -backend hw|warp|null -seed <n> -out <file>\n"
+        "  -microbench         time the micro-benchmark cases and the Direct3D error paths,\n"
+        "                      -frames and -warmup count batches of -batch <n> calls";
+
+    // Scripted benchmark runs must not block on a message box
+    void ReportError(bool Interactive, const char* Text, const char* Caption)
+    {
+        if (Interactive)
+        {
+            MessageBoxA(nullptr, Text, Caption, MB_OK | MB_ICONEXCLAMATION);
+        }
+        else
+        {
+            std::cerr << Caption << std::endl << Text << std::endl;
+        }
+    }
+
+    Graphics::Backend ParseBackend(const std::wstring& Name)
+    {
+        if (Name == L"hw")
+        {
+            return Graphics::Backend::Hardware;
+        }
+        if (Name == L"warp")
+        {
+            return Graphics::Backend::Warp;
+        }
+        if (Name == L"null")
+        {
+            return Graphics::Backend::Null;
+        }
+        throw UsageError("Unknown backend, expected hw, warp or null");
+    }
+
+    int RunMicroBenchmarks(const AppConfig& Config)
+    {
+        BenchmarkReport::Settings Settings;
+        Settings.Backend = "none";
+        Settings.Seed = Config.Seed;
+        Settings.WarmupFrames = Config.WarmupFrames;
+        BenchmarkReport Report(Settings);
+
+        MicroBenchmark::Settings BenchSettings;
+        BenchSettings.Samples = Config.Frames;
+        BenchSettings.WarmupSamples = Config.WarmupFrames;
+        BenchSettings.BatchSize = Config.BatchSize;
+        MicroBenchmark Bench(BenchSettings);
+        Bench.Run(Report);
+        Bench.RunErrorPaths(Report);
+
+        std::ofstream Out(Config.OutputPath);
+        if (!Out)
+        {
+            throw std::runtime_error("Cannot create benchmark output file");
+        }
+        Report.WriteJson(Out);
+        return 0;
+    }
+
+    // Options are ASCII, anything else only shows up in error messages
+    std::string Narrow(const std::wstring& Text)
+    {
+        std::string Result;
+        for (const wchar_t c : Text)
+        {
+            Result += c < 0x80 ? static_cast<char>(c) : '?';
+        }
+        return Result;
+    }
+
+    std::wstring ReadValue(std::wistringstream& Args, const std::wstring& Option)
+    {
+        std::wstring Value;
+        if (!(Args >> std::quoted(Value)))
+        {
+            throw UsageError("Missing value for " + Narrow(Option));
+        }
+        return Value;
+    }
+
+    // Whole non-negative numbers only, "12x" or "-1" are usage errors
+    unsigned int ReadCount(std::wistringstream& Args, const std::wstring& Option)
+    {
+        const std::wstring Value = ReadValue(Args, Option);
+        size_t End = 0u;
+        unsigned long long Count = 0u;
+        try
+        {
+            Count = Value[0] == L'-' ? 0u : std::stoull(Value, &End);
+        }
+        catch (const std::exception&)
+        {
+            End = 0u;
+        }
+        if (End == 0u || End != Value.size() || Count > 0xFFFFFFFFull)
+        {
+            throw UsageError("Expected a number after " + Narrow(Option) + ", got '" + Narrow(Value) + "'");
+        }
+        return static_cast<unsigned int>(Count);
+    }
+
+    // Render target sizes, which must not be empty
+    unsigned int ReadSize(std::wistringstream& Args, const std::wstring& Option)
+    {
+        const unsigned int Size = ReadCount(Args, Option);
+        if (Size == 0u)
+        {
+            throw UsageError("Expected a size above 0 after " + Narrow(Option));
+        }
+        return Size;
+    }
+}
 
 int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR CmdLine, int nCmdShow)
 {
+    AppConfig Config;
+    const auto Interactive = [&Config]() { return !Config.Benchmark && !Config.MicroBenchmark; };
     try
     {
-        return App{}.Run();
+        // Options are listed in Usage, microbench runs the portable -microbench cases alone
+        std::wistringstream Args(CmdLine);
+        for (std::wstring Arg; Args >> Arg; )
+        {
+            if (Arg == L"-pipeline")
+            {
+                Config.PipelineDepth = ReadCount(Args, Arg);
+            }
+            else if (Arg == L"-capture")
+            {
+                Config.CapturePath = ReadValue(Args, Arg);
+            }
+            else if (Arg == L"-replay")
+            {
+                Config.ReplayPath = ReadValue(Args, Arg);
+            }
+            else if (Arg == L"-paced")
+            {
+                Config.ReplayPacing = CaptureReplayer::Pacing::Recorded;
+            }
+            else if (Arg == L"-bench")
+            {
+                Config.Benchmark = true;
+            }
+            else if (Arg == L"-microbench")
+            {
+                Config.MicroBenchmark = true;
+            }
+            else if (Arg == L"-batch")
+            {
+                Config.BatchSize = ReadCount(Args, Arg);
+            }
+            else if (Arg == L"-scene")
+            {
+                Config.Scene = ReadValue(Args, Arg);
+                if (!IsSceneName(Config.Scene))
+                {
+                    throw UsageError("Unknown scene '" + Narrow(Config.Scene) + "', expected one of " + Narrow(GetSceneNames()));
+                }
+            }
+            else if (Arg == L"-frames")
+            {
+                Config.Frames = ReadCount(Args, Arg);
+            }
+            else if (Arg == L"-warmup")
+            {
+                Config.WarmupFrames = ReadCount(Args, Arg);
+            }
+            else if (Arg == L"-width")
+            {
+                Config.Width = ReadSize(Args, Arg);
+            }
+            else if (Arg == L"-height")
+            {
+                Config.Height = ReadSize(Args, Arg);
+            }
+            else if (Arg == L"-backend")
+            {
+                Config.Backend = ParseBackend(ReadValue(Args, Arg));
+            }
+            else if (Arg == L"-seed")
+            {
+                Config.Seed = ReadCount(Args, Arg);
+            }
+            else if (Arg == L"-out")
+            {
+                Config.OutputPath = ReadValue(Args, Arg);
+            }
+            else
+            {
+                throw UsageError("Unknown option " + Narrow(Arg));
+            }
+        }
+
+        if (Config.MicroBenchmark)
+        {
+            return RunMicroBenchmarks(Config);
+        }
+        return App{Config}.Run();
+    }
+    catch (const UsageError& e)
+    {
+        ReportError(Interactive(), (std::string(e.what()) + "\n\n" + Usage).c_str(), "Invalid Command Line");
+        return Failure;
     }
     catch (const MyException& e)
     {
-        MessageBoxA(nullptr, e.what(), e.GetType(), MB_OK | MB_ICONEXCLAMATION);
+        ReportError(Interactive(), e.what(), e.GetType());
     }
     catch (const std::exception& e)
     {
-        MessageBoxA(nullptr, e.what(), "Standard Exception", MB_OK | MB_ICONEXCLAMATION);
+        ReportError(Interactive(), e.what(), "Standard Exception");
     }
     catch (...)
     {
-        MessageBoxA(nullptr, "No details available", "Unknown Exception", MB_OK | MB_ICONEXCLAMATION);
+        ReportError(Interactive(), "No details available", "Unknown Exception");
     }
 
     return -1;
@@ -0,0 +1,182 @@
+#include "mesh_format.h"
+#include "alloc_tracker.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <type_traits>
+
+namespace
+{
+    constexpr uint32_t MeshMagic = 0x534D5844u;    // "DXMS"
+    constexpr uint32_t MeshVersion = 1u;
+
+    struct MeshHeader
+    {
+        uint32_t Magic;
+        uint32_t Version;
+        uint32_t VertexCount;
+        uint32_t IndexCount;
+        uint32_t LevelCount;
+        Vec3 Center;
+        float Radius;
+    };
+
+    void Validate(const MeshData& Mesh)
+    {
+        if (Mesh.Levels.empty() || Mesh.Levels.size() > LodSelector::MaxLevels)
+        {
+            throw MESH_EXCEPT("A mesh needs between 1 and LodSelector::MaxLevels levels of detail");
+        }
+        for (size_t l = 0; l < Mesh.Levels.size(); l++)
+        {
+            const LodLevel& Level = Mesh.Levels[l];
+            if (Level.IndexCount % 3u != 0u || Level.FirstIndex > Mesh.Indices.size() || Level.IndexCount > Mesh.Indices.size() - Level.FirstIndex)
+            {
+                throw MESH_EXCEPT("Level of detail " + std::to_string(l) + " is not a range of whole triangles");
+            }
+            if (l > 0u && Level.Error < Mesh.Levels[l - 1u].Error)
+            {
+                throw MESH_EXCEPT("Level of detail errors must not decrease");
+            }
+        }
+        const size_t VertexCount = Mesh.Positions.size();
+        if (std::any_of(Mesh.Indices.begin(), Mesh.Indices.end(), [VertexCount](uint32_t i) { return i >= VertexCount; }))
+        {
+            throw MESH_EXCEPT("Index past the last position");
+        }
+    }
+
+    template<typename T>
+    void WriteArray(std::ofstream& Stream, const std::vector<T>& Values)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Only raw values can be stored");
+        Stream.write(reinterpret_cast<const char*>(Values.data()), static_cast<std::streamsize>(Values.size() * sizeof(T)));
+    }
+
+    template<typename T>
+    void ReadArray(std::ifstream& Stream, std::vector<T>& Values, size_t Count)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Only raw values can be stored");
+        Values.resize(Count);
+        if (!Stream.read(reinterpret_cast<char*>(Values.data()), static_cast<std::streamsize>(Count * sizeof(T))))
+        {
+            throw MESH_EXCEPT("Truncated mesh file");
+        }
+    }
+}
+
+MeshException::MeshException(int Line, const char* File, std::string Reason) noexcept
+    : MyException(Line, File), Reason(std::move(Reason)) {}
+
+const char* MeshException::what() const noexcept
+{
+    AllocScope Scope(AllocTag::Exception);
+    std::ostringstream oss;
+    oss << GetType() << std::endl
+        << "[Reason] " << Reason << std::endl
+        << GetOriginString();
+    whatBuffer = oss.str();
+    return whatBuffer.c_str();
+}
+
+const char* MeshException::GetType() const noexcept
+{
+    return "Mesh Exception";
+}
+
+void WriteMesh(const std::filesystem::path& Path, const MeshData& Mesh)
+{
+    Validate(Mesh);
+    std::ofstream Stream(Path, std::ios::binary | std::ios::trunc);
+    if (!Stream)
+    {
+        throw MESH_EXCEPT("Cannot create mesh file " + Path.string());
+    }
+
+    const MeshHeader Header = {MeshMagic, MeshVersion, static_cast<uint32_t>(Mesh.Positions.size()), static_cast<uint32_t>(Mesh.Indices.size()),
+        static_cast<uint32_t>(Mesh.Levels.size()), Mesh.Center, Mesh.Radius};
+    Stream.write(reinterpret_cast<const char*>(&Header), sizeof(Header));
+    WriteArray(Stream, Mesh.Positions);
+    WriteArray(Stream, Mesh.Indices);
+    WriteArray(Stream, Mesh.Levels);
+    if (!Stream)
+    {
+        throw MESH_EXCEPT("Failed to write mesh file " + Path.string());
+    }
+}
+
+MeshData ReadMesh(const std::filesystem::path& Path)
+{
+    std::ifstream Stream(Path, std::ios::binary);
+    if (!Stream)
+    {
+        throw MESH_EXCEPT("Cannot open mesh file " + Path.string());
+    }
+
+    MeshHeader Header;
+    if (!Stream.read(reinterpret_cast<char*>(&Header), sizeof(Header)) || Header.Magic != MeshMagic)
+    {
+        throw MESH_EXCEPT("Not a mesh file");
+    }
+    if (Header.Version != MeshVersion)
+    {
+        throw MESH_EXCEPT("Unsupported mesh version");
+    }
+    if (Header.LevelCount == 0u || Header.LevelCount > LodSelector::MaxLevels)
+    {
+        throw MESH_EXCEPT("A mesh needs between 1 and LodSelector::MaxLevels levels of detail");
+    }
+
+    // Sizes come from the file, check them against its length before allocating
+    const uint64_t Expected = sizeof(MeshHeader) + static_cast<uint64_t>(Header.VertexCount) * sizeof(Vec3)
+        + static_cast<uint64_t>(Header.IndexCount) * sizeof(uint32_t) + static_cast<uint64_t>(Header.LevelCount) * sizeof(LodLevel);
+    if (std::filesystem::file_size(Path) < Expected)
+    {
+        throw MESH_EXCEPT("Truncated mesh file");
+    }
+
+    MeshData Mesh;
+    ReadArray(Stream, Mesh.Positions, Header.VertexCount);
+    ReadArray(Stream, Mesh.Indices, Header.IndexCount);
+    ReadArray(Stream, Mesh.Levels, Header.LevelCount);
+    Mesh.Center = Header.Center;
+    Mesh.Radius = Header.Radius;
+    Validate(Mesh);
+    return Mesh;
+}
+
+void ComputeBounds(MeshData& Mesh) noexcept
+{
+    // The full detail level when there is one, every index otherwise
+    const uint32_t* Begin = Mesh.Indices.data();
+    const uint32_t* End = Begin + Mesh.Indices.size();
+    if (!Mesh.Levels.empty())
+    {
+        Begin += Mesh.Levels[0].FirstIndex;
+        End = Begin + Mesh.Levels[0].IndexCount;
+    }
+    if (Begin == End)
+    {
+        Mesh.Center = {};
+        Mesh.Radius = 0.0f;
+        return;
+    }
+
+    Vec3 Low = Mesh.Positions[*Begin];
+    Vec3 High = Low;
+    for (const uint32_t* i = Begin; i != End; i++)
+    {
+        const Vec3& p = Mesh.Positions[*i];
+        Low = {std::min(Low.X, p.X), std::min(Low.Y, p.Y), std::min(Low.Z, p.Z)};
+        High = {std::max(High.X, p.X), std::max(High.Y, p.Y), std::max(High.Z, p.Z)};
+    }
+    Mesh.Center = (Low + High) * 0.5f;
+    float Squared = 0.0f;
+    for (const uint32_t* i = Begin; i != End; i++)
+    {
+        const Vec3 d = Mesh.Positions[*i] - Mesh.Center;
+        Squared = std::max(Squared, Dot(d, d));
+    }
+    Mesh.Radius = std::sqrt(Squared);
+}
\ No newline at end of file
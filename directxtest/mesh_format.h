@@ -0,0 +1,44 @@
+#pragma once
+#include "exceptions.h"
+#include "simd_math.h"
+#include "lod.h"
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Triangle mesh with its chain of levels of detail, as stored in .mesh files. All levels
+// share one index buffer and one position buffer; indices are absolute, so a level draws
+// with DrawIndexed(IndexCount, FirstIndex) and no base vertex. Levels may use positions
+// of their own, a simplified level moves the vertices it keeps.
+//
+// File layout, little endian: magic "DXMS", version, vertex count, index count, level
+// count, bounding sphere (center, radius), then the positions, the indices and the levels.
+struct MeshData
+{
+    std::vector<Vec3> Positions;
+    std::vector<uint32_t> Indices;
+    // Full detail first, ready for LodSelector::AddMesh
+    std::vector<LodLevel> Levels;
+    // Bounds of the full detail level, LodLevel::Error is relative to Radius
+    Vec3 Center = {};
+    float Radius = 0.0f;
+};
+
+class MeshException : public MyException
+{
+public:
+    MeshException(int Line, const char* File, std::string Reason) noexcept;
+    const char* what() const noexcept override;
+    const char* GetType() const noexcept override;
+private:
+    std::string Reason;
+};
+
+#define MESH_EXCEPT(Reason) MeshException(__LINE__, __FILE__, (Reason))
+
+// Both check that the levels fit LodSelector::AddMesh and index valid positions
+void WriteMesh(const std::filesystem::path& Path, const MeshData& Mesh);
+MeshData ReadMesh(const std::filesystem::path& Path);
+// Sphere around the box of the full detail level, or of every index without levels
+void ComputeBounds(MeshData& Mesh) noexcept;
\ No newline at end of file
@@ -0,0 +1,14 @@
+cbuffer ViewConstants : register(b1)
+{
+    row_major float4x4 ViewProjection;
+};
+
+cbuffer DrawConstants : register(b2)
+{
+    row_major float4x4 World;
+};
+
+float4 main(float3 pos : Position) : SV_Position
+{
+    return mul(mul(float4(pos, 1.0f), World), ViewProjection);
+}
\ No newline at end of file
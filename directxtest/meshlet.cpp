@@ -0,0 +1,410 @@
+#include "meshlet.h"
+#include "simd_lanes.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+    // Cutoff of meshlets that cannot be back-facing as a whole, no sine reaches it
+    constexpr float NoCone = 2.0f;
+    constexpr uint32_t NoTriangle = std::numeric_limits<uint32_t>::max();
+
+    // Of the upper 3x3, negative when the matrix mirrors and turns front faces back
+    float Determinant3(const Mat4& M) noexcept
+    {
+        return M.M[0][0] * (M.M[1][1] * M.M[2][2] - M.M[1][2] * M.M[2][1])
+            - M.M[0][1] * (M.M[1][0] * M.M[2][2] - M.M[1][2] * M.M[2][0])
+            + M.M[0][2] * (M.M[1][0] * M.M[2][1] - M.M[1][1] * M.M[2][0]);
+    }
+
+    template<typename L>
+    L PlaneDistance(const Vec4& Plane, L x, L y, L z) noexcept
+    {
+        return x * L::Set(Plane.X) + y * L::Set(Plane.Y) + z * L::Set(Plane.Z) + L::Set(Plane.W);
+    }
+
+    // Sphere around the box of the meshlet's vertices and the cone around its triangle
+    // normals, Normals holds one per triangle of the meshlet
+    void AddBounds(MeshletMesh& Mesh, const Vec3* Positions, const Vec3* Normals, uint32_t FirstIndex, uint32_t EndIndex)
+    {
+        Vec3 Low = Positions[Mesh.Indices[FirstIndex]];
+        Vec3 High = Low;
+        Vec3 NormalSum = {};
+        for (uint32_t i = FirstIndex; i < EndIndex; i++)
+        {
+            Low = Min(Low, Positions[Mesh.Indices[i]]);
+            High = Max(High, Positions[Mesh.Indices[i]]);
+        }
+        const Vec3 Center = (Low + High) * 0.5f;
+        float Squared = 0.0f;
+        for (uint32_t i = FirstIndex; i < EndIndex; i++)
+        {
+            const Vec3 d = Positions[Mesh.Indices[i]] - Center;
+            Squared = std::max(Squared, Dot(d, d));
+        }
+        for (uint32_t i = FirstIndex; i < EndIndex; i += 3u)
+        {
+            NormalSum = NormalSum + Normals[(i - FirstIndex) / 3u];
+        }
+        Mesh.X.push_back(Center.X);
+        Mesh.Y.push_back(Center.Y);
+        Mesh.Z.push_back(Center.Z);
+        Mesh.Radius.push_back(std::sqrt(Squared));
+
+        // Degenerate triangles have no normal and are never drawn, they do not widen the cone
+        const float SumLength = Length(NormalSum);
+        const Vec3 Axis = SumLength > 1e-6f ? NormalSum * (1.0f / SumLength) : Vec3{0.0f, 0.0f, 1.0f};
+        float MinCosine = 1.0f;
+        for (uint32_t i = FirstIndex; i < EndIndex; i += 3u)
+        {
+            const Vec3& n = Normals[(i - FirstIndex) / 3u];
+            if (Dot(n, n) > 0.0f)
+            {
+                MinCosine = std::min(MinCosine, Dot(n, Axis));
+            }
+        }
+        Mesh.AxisX.push_back(Axis.X);
+        Mesh.AxisY.push_back(Axis.Y);
+        Mesh.AxisZ.push_back(Axis.Z);
+        Mesh.Cutoff.push_back(SumLength > 1e-6f && MinCosine > 0.0f ? std::sqrt(std::max(1.0f - MinCosine * MinCosine, 0.0f)) : NoCone);
+    }
+}
+
+size_t MeshletMesh::GetMeshletCount() const noexcept
+{
+    return FirstIndex.empty() ? 0u : FirstIndex.size() - 1u;
+}
+
+SphereStreams MeshletMesh::GetSpheres() const noexcept
+{
+    return {X.data(), Y.data(), Z.data(), Radius.data()};
+}
+
+MeshletMesh BuildMeshlets(const Vec3* Positions, size_t VertexCount, const uint32_t* Indices, size_t IndexCount)
+{
+    if (IndexCount % 3u != 0u || IndexCount > std::numeric_limits<uint32_t>::max())
+    {
+        throw std::invalid_argument("Meshlets need a list of whole triangles");
+    }
+    if (std::any_of(Indices, Indices + IndexCount, [VertexCount](uint32_t i) { return i >= VertexCount; }))
+    {
+        throw std::invalid_argument("Meshlet index past the last position");
+    }
+    const size_t TriangleCount = IndexCount / 3u;
+
+    // Unit normal of every triangle, zero for degenerate ones
+    std::vector<Vec3> Normals(TriangleCount);
+    for (size_t t = 0; t < TriangleCount; t++)
+    {
+        const Vec3& p0 = Positions[Indices[3u * t]];
+        const Vec3 n = Cross(Positions[Indices[3u * t + 1u]] - p0, Positions[Indices[3u * t + 2u]] - p0);
+        const float NormalLength = Length(n);
+        Normals[t] = NormalLength > 0.0f ? n * (1.0f / NormalLength) : Vec3{};
+    }
+
+    // Triangles around every vertex, vertex v has [AdjacencyStart[v], AdjacencyStart[v + 1])
+    std::vector<uint32_t> AdjacencyStart(VertexCount + 1u, 0u);
+    for (size_t i = 0; i < IndexCount; i++)
+    {
+        AdjacencyStart[Indices[i] + 1u]++;
+    }
+    for (size_t v = 0; v < VertexCount; v++)
+    {
+        AdjacencyStart[v + 1u] += AdjacencyStart[v];
+    }
+    std::vector<uint32_t> Adjacent(IndexCount);
+    std::vector<uint32_t> Fill(AdjacencyStart.begin(), AdjacencyStart.end() - 1);
+    for (size_t i = 0; i < IndexCount; i++)
+    {
+        Adjacent[Fill[Indices[i]]++] = static_cast<uint32_t>(i / 3u);
+    }
+
+    MeshletMesh Mesh;
+    Mesh.Indices.reserve(IndexCount);
+    Mesh.FirstIndex.push_back(0u);
+    std::vector<uint8_t> Emitted(TriangleCount, 0u);
+    // Meshlet that last took a vertex, or last listed a triangle as a candidate
+    std::vector<uint32_t> VertexStamp(VertexCount, NoTriangle);
+    std::vector<uint32_t> CandidateStamp(TriangleCount, NoTriangle);
+    std::vector<uint32_t> Candidates;
+    std::vector<Vec3> MeshletNormals;
+    size_t Remaining = TriangleCount;
+    size_t Scan = 0u;
+    for (uint32_t Meshlet = 0; Remaining > 0u; Meshlet++)
+    {
+        // A leftover neighbour of the last meshlet keeps the next one close by
+        uint32_t Seed = NoTriangle;
+        for (const uint32_t t : Candidates)
+        {
+            if (!Emitted[t])
+            {
+                Seed = t;
+                break;
+            }
+        }
+        if (Seed == NoTriangle)
+        {
+            while (Emitted[Scan])
+            {
+                Scan++;
+            }
+            Seed = static_cast<uint32_t>(Scan);
+        }
+        Candidates.clear();
+
+        uint32_t MeshletVertices = 0u;
+        uint32_t MeshletTriangles = 0u;
+        Vec3 NormalSum = {};
+        MeshletNormals.clear();
+        const auto Add = [&](uint32_t t)
+        {
+            Emitted[t] = 1u;
+            Remaining--;
+            MeshletTriangles++;
+            NormalSum = NormalSum + Normals[t];
+            MeshletNormals.push_back(Normals[t]);
+            for (size_t k = 0; k < 3u; k++)
+            {
+                const uint32_t v = Indices[3u * t + k];
+                Mesh.Indices.push_back(v);
+                if (VertexStamp[v] == Meshlet)
+                {
+                    continue;
+                }
+                VertexStamp[v] = Meshlet;
+                MeshletVertices++;
+                for (uint32_t a = AdjacencyStart[v]; a < AdjacencyStart[v + 1u]; a++)
+                {
+                    const uint32_t Neighbour = Adjacent[a];
+                    if (!Emitted[Neighbour] && CandidateStamp[Neighbour] != Meshlet)
+                    {
+                        CandidateStamp[Neighbour] = Meshlet;
+                        Candidates.push_back(Neighbour);
+                    }
+                }
+            }
+        };
+
+        Add(Seed);
+        while (MeshletTriangles < MeshletMesh::MaxTriangles)
+        {
+            // Fewest new vertices first, then the normal closest to the meshlet's. Taken
+            // candidates are dropped from the list on the way.
+            uint32_t Best = NoTriangle;
+            uint32_t BestNew = 4u;
+            float BestAlignment = 0.0f;
+            size_t Kept = 0u;
+            for (const uint32_t t : Candidates)
+            {
+                if (Emitted[t])
+                {
+                    continue;
+                }
+                Candidates[Kept++] = t;
+                uint32_t New = 0u;
+                for (size_t k = 0; k < 3u; k++)
+                {
+                    New += VertexStamp[Indices[3u * t + k]] != Meshlet ? 1u : 0u;
+                }
+                const float Alignment = Dot(Normals[t], NormalSum);
+                if (MeshletVertices + New <= MeshletMesh::MaxVertices && (New < BestNew || (New == BestNew && Alignment > BestAlignment)))
+                {
+                    Best = t;
+                    BestNew = New;
+                    BestAlignment = Alignment;
+                }
+            }
+            Candidates.resize(Kept);
+            if (Best == NoTriangle)
+            {
+                break;
+            }
+            Add(Best);
+        }
+
+        const uint32_t EndIndex = static_cast<uint32_t>(Mesh.Indices.size());
+        AddBounds(Mesh, Positions, MeshletNormals.data(), Mesh.FirstIndex.back(), EndIndex);
+        Mesh.FirstIndex.push_back(EndIndex);
+    }
+    return Mesh;
+}
+
+size_t MeshletCuller::Cull(const MeshletMesh& Mesh, const Mat4* Worlds, size_t Count, const Mat4& ViewProjection, const Vec3& Eye, OcclusionBuffer* Occlusion, JobSystem* Jobs)
+{
+    const size_t MeshletCount = Mesh.GetMeshletCount();
+    const size_t SlicesPerInstance = (MeshletCount + Grain - 1u) / Grain;
+    const size_t SliceCount = Count * SlicesPerInstance;
+    Ranges.resize(Count * MeshletCount);
+    SliceRanges.assign(SliceCount, 0u);
+    SliceTotals.assign(SliceCount, {});
+    Totals = {};
+
+    // Slice k covers meshlets [Begin, End) of one placement, its ranges go where its
+    // meshlets would in a buffer of every placement's meshlets
+    const auto SliceBegin = [&](size_t k)
+    {
+        return (k % SlicesPerInstance) * Grain;
+    };
+    const auto SliceOut = [&](size_t k)
+    {
+        return Ranges.data() + (k / SlicesPerInstance) * MeshletCount + SliceBegin(k);
+    };
+    const auto CullAt = [&](size_t k)
+    {
+        const size_t Instance = k / SlicesPerInstance;
+        const size_t Begin = SliceBegin(k);
+        SliceRanges[k] = CullSlice(Mesh, static_cast<uint32_t>(Instance), Worlds[Instance], ViewProjection, Eye, Occlusion,
+            Begin, std::min(Begin + Grain, MeshletCount), SliceOut(k), SliceTotals[k]);
+    };
+    if (Jobs == nullptr || SliceCount <= 1u)
+    {
+        for (size_t k = 0; k < SliceCount; k++)
+        {
+            CullAt(k);
+        }
+    }
+    else
+    {
+        Jobs->ParallelFor(SliceCount, 1u, [&](size_t Begin, size_t End, unsigned int)
+        {
+            for (size_t k = Begin; k < End; k++)
+            {
+                CullAt(k);
+            }
+        });
+    }
+
+    // Close the gaps between the slices, a range that runs on into the next slice
+    // absorbs that slice's first range
+    size_t n = 0u;
+    for (size_t k = 0; k < SliceCount; k++)
+    {
+        const DrawRange* Slice = SliceOut(k);
+        size_t First = 0u;
+        if (n > 0u && SliceRanges[k] > 0u)
+        {
+            DrawRange& Last = Ranges[n - 1u];
+            if (Last.Instance == Slice[0].Instance && Last.FirstIndex + Last.IndexCount == Slice[0].FirstIndex)
+            {
+                Last.IndexCount += Slice[0].IndexCount;
+                First = 1u;
+            }
+        }
+        std::memmove(Ranges.data() + n, Slice + First, (SliceRanges[k] - First) * sizeof(DrawRange));
+        n += SliceRanges[k] - First;
+
+        const Counts& c = SliceTotals[k];
+        Totals.Meshlets += c.Meshlets;
+        Totals.InFrustum += c.InFrustum;
+        Totals.FrontFacing += c.FrontFacing;
+        Totals.Unoccluded += c.Unoccluded;
+        Totals.Triangles += c.Triangles;
+    }
+    return n;
+}
+
+const MeshletCuller::DrawRange* MeshletCuller::GetRanges() const noexcept
+{
+    return Ranges.data();
+}
+
+const MeshletCuller::Counts& MeshletCuller::GetCounts() const noexcept
+{
+    return Totals;
+}
+
+size_t MeshletCuller::CullSlice(const MeshletMesh& Mesh, uint32_t Instance, const Mat4& World, const Mat4& ViewProjection, const Vec3& Eye, OcclusionBuffer* Occlusion, size_t Begin, size_t End, DrawRange* Out, Counts& SliceCounts) const noexcept
+{
+    // The spheres and cones stay in object space, the frustum and the eye go there instead.
+    // Planes are normalized after the transform so distances compare with object radii.
+    const Frustum View = Frustum::FromMatrix(Multiply(World, ViewProjection));
+    const Vec3 ObjectEye = TransformPoint(Eye, Inverse(World));
+    const float Facing = Determinant3(World) < 0.0f ? -1.0f : 1.0f;
+
+    // Kept meshlets relative to Begin
+    uint32_t Kept[Grain];
+    size_t n = 0u;
+    uint64_t InFrustum = 0u;
+    ForEachLane(End - Begin, MathPath::Native, [&](auto Tag, size_t i)
+    {
+        using L = decltype(Tag);
+        const size_t m = Begin + i;
+        const L x = L::Load(Mesh.X.data() + m);
+        const L y = L::Load(Mesh.Y.data() + m);
+        const L z = L::Load(Mesh.Z.data() + m);
+        const L r = L::Load(Mesh.Radius.data() + m);
+        L Nearest = PlaneDistance(View.Planes[0], x, y, z);
+        for (size_t p = 1; p < Frustum::SideCount; p++)
+        {
+            Nearest = Min(Nearest, PlaneDistance(View.Planes[p], x, y, z));
+        }
+        const uint32_t Inside = MaskGreaterEqual(Nearest + r, L::Set(0.0f));
+
+        // Every triangle faces away when, with v from the eye to the center and a the axis,
+        // v . a >= Cutoff |v| + r. Squared so no lane needs a square root.
+        const L vx = x - L::Set(ObjectEye.X);
+        const L vy = y - L::Set(ObjectEye.Y);
+        const L vz = z - L::Set(ObjectEye.Z);
+        const L Along = (vx * L::Load(Mesh.AxisX.data() + m) + vy * L::Load(Mesh.AxisY.data() + m) + vz * L::Load(Mesh.AxisZ.data() + m)) * L::Set(Facing) - r;
+        const L Cutoff = L::Load(Mesh.Cutoff.data() + m);
+        const uint32_t Back = MaskGreaterEqual(Along, L::Set(0.0f)) & MaskGreaterEqual(Along * Along, Cutoff * Cutoff * (vx * vx + vy * vy + vz * vz));
+
+        InFrustum += static_cast<uint64_t>(std::popcount(Inside));
+        for (uint32_t Mask = Inside & ~Back; Mask != 0u; Mask &= Mask - 1u)
+        {
+            Kept[n++] = static_cast<uint32_t>(i) + static_cast<uint32_t>(std::countr_zero(Mask));
+        }
+    });
+    const size_t FrontFacing = n;
+
+    if (Occlusion != nullptr && n > 0u)
+    {
+        // World boxes around the spheres, axis j reaches r times the length of column j.
+        // Only the kept meshlets' entries are filled.
+        float Boxes[6][Grain];
+        const auto ColumnLength = [&](size_t j)
+        {
+            return std::sqrt(World.M[0][j] * World.M[0][j] + World.M[1][j] * World.M[1][j] + World.M[2][j] * World.M[2][j]);
+        };
+        const Vec3 Scale = {ColumnLength(0u), ColumnLength(1u), ColumnLength(2u)};
+        for (size_t j = 0; j < n; j++)
+        {
+            const uint32_t Local = Kept[j];
+            const size_t m = Begin + Local;
+            const Vec3 Center = TransformPoint({Mesh.X[m], Mesh.Y[m], Mesh.Z[m]}, World);
+            Boxes[0][Local] = Center.X;
+            Boxes[1][Local] = Center.Y;
+            Boxes[2][Local] = Center.Z;
+            Boxes[3][Local] = Mesh.Radius[m] * Scale.X;
+            Boxes[4][Local] = Mesh.Radius[m] * Scale.Y;
+            Boxes[5][Local] = Mesh.Radius[m] * Scale.Z;
+        }
+        const BoxStreams Bounds = {Boxes[0], Boxes[1], Boxes[2], Boxes[3], Boxes[4], Boxes[5]};
+        n = Occlusion->CullBoxes(Bounds, Kept, n, Kept);
+    }
+
+    // Neighbouring meshlets share a range
+    size_t Written = 0u;
+    uint64_t Triangles = 0u;
+    for (size_t j = 0; j < n; j++)
+    {
+        const size_t m = Begin + Kept[j];
+        const uint32_t FirstIndex = Mesh.FirstIndex[m];
+        const uint32_t IndexCount = Mesh.FirstIndex[m + 1u] - FirstIndex;
+        Triangles += IndexCount / 3u;
+        if (Written > 0u && Out[Written - 1u].FirstIndex + Out[Written - 1u].IndexCount == FirstIndex)
+        {
+            Out[Written - 1u].IndexCount += IndexCount;
+        }
+        else
+        {
+            Out[Written++] = {Instance, FirstIndex, IndexCount};
+        }
+    }
+    SliceCounts = {End - Begin, InFrustum, FrontFacing, n, Triangles};
+    return Written;
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+#include "simd_math.h"
+#include "culling.h"
+#include "occlusion.h"
+#include "job_system.h"
+#include <cstdint>
+#include <vector>
+
+// A triangle list regrouped into meshlets, clusters of at most MaxVertices vertices and
+// MaxTriangles neighbouring triangles. Every meshlet is a contiguous range of Indices, so
+// one static index buffer serves any subset of them. Per meshlet there is a bounding
+// sphere and a normal cone in object space, as component arrays like SphereStreams.
+struct MeshletMesh
+{
+    static constexpr uint32_t MaxVertices = 64u;
+    static constexpr uint32_t MaxTriangles = 124u;
+
+    // The mesh's triangles in meshlet order, meshlet m owns [FirstIndex[m], FirstIndex[m + 1])
+    std::vector<uint32_t> Indices;
+    std::vector<uint32_t> FirstIndex;
+    // Bounding spheres
+    std::vector<float> X;
+    std::vector<float> Y;
+    std::vector<float> Z;
+    std::vector<float> Radius;
+    // Normal cones, Cutoff is the sine of the largest angle between the unit Axis and a
+    // triangle normal. 2 when the normals spread 90 degrees or more and the meshlet can
+    // never be back-facing as a whole.
+    std::vector<float> AxisX;
+    std::vector<float> AxisY;
+    std::vector<float> AxisZ;
+    std::vector<float> Cutoff;
+
+    size_t GetMeshletCount() const noexcept;
+    SphereStreams GetSpheres() const noexcept;
+};
+
+// Splits a triangle list into meshlets. Each meshlet grows from a seed triangle over
+// shared vertices, taking the neighbour that adds the fewest new vertices and then the one
+// closest to its average normal, so meshlets stay compact and their cones narrow. The next
+// seed is a leftover neighbour of the last meshlet. Triangle winding is kept. Throws
+// std::invalid_argument when the indices are not whole triangles or run past the positions.
+MeshletMesh BuildMeshlets(const Vec3* Positions, size_t VertexCount, const uint32_t* Indices, size_t IndexCount);
+
+// Culls the meshlets of placed copies of a mesh and merges what is left into draw ranges.
+// A meshlet is dropped when its sphere lies outside the frustum, when its normal cone
+// shows every triangle facing away from the eye, or when its box is hidden in an
+// occlusion buffer. The first two run in object space as one SIMD pass, the box test
+// only sees their survivors. Kept meshlets that follow each other in Indices become one
+// range, so the ranges can be drawn from the static index buffer without copying indices.
+//
+// Work is split into slices of Grain meshlets of one placement. Every slice writes its
+// ranges into its own part of a buffer and the parts are packed together afterwards,
+// joining ranges that continue across a slice border.
+class MeshletCuller
+{
+public:
+    // Meshlets per job
+    static constexpr size_t Grain = 512u;
+    struct DrawRange
+    {
+        // Index into the placements
+        uint32_t Instance;
+        uint32_t FirstIndex;
+        uint32_t IndexCount;
+    };
+    // Meshlets left after each stage and triangles in the ranges
+    struct Counts
+    {
+        uint64_t Meshlets;
+        uint64_t InFrustum;
+        uint64_t FrontFacing;
+        uint64_t Unoccluded;
+        uint64_t Triangles;
+    };
+public:
+    // Culls every meshlet of Mesh for each of the Count world matrices, which must be
+    // invertible. Eye is in world space. Occlusion is optional and must have been
+    // rasterized for ViewProjection; it is only read. Jobs is optional too. Returns the
+    // number of ranges, ordered by placement and then by index.
+    size_t Cull(const MeshletMesh& Mesh, const Mat4* Worlds, size_t Count, const Mat4& ViewProjection, const Vec3& Eye, OcclusionBuffer* Occlusion = nullptr, JobSystem* Jobs = nullptr);
+
+    const DrawRange* GetRanges() const noexcept;
+    const Counts& GetCounts() const noexcept;
+private:
+    // Culls one slice of one placement into Ranges at Out, returns the ranges written
+    size_t CullSlice(const MeshletMesh& Mesh, uint32_t Instance, const Mat4& World, const Mat4& ViewProjection, const Vec3& Eye, OcclusionBuffer* Occlusion, size_t Begin, size_t End, DrawRange* Out, Counts& SliceCounts) const noexcept;
+private:
+    std::vector<DrawRange> Ranges;
+    std::vector<size_t> SliceRanges;
+    std::vector<Counts> SliceTotals;
+    Counts Totals = {};
+};
\ No newline at end of file
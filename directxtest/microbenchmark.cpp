@@ -0,0 +1,910 @@
+#include "microbenchmark.h"
+#include "command_list.h"
+#include "keyboard.h"
+#include "mouse.h"
+#include "timer.h"
+#include "tsc_clock.h"
+#include "simd_math.h"
+#include "transform_hierarchy.h"
+#include "entity_store.h"
+#include "frame_arena.h"
+#include "handle_pool.h"
+#include "pipeline_state.h"
+#include "culling.h"
+#include "occlusion.h"
+#include "lod.h"
+#include "meshlet.h"
+#include "bvh.h"
+#include "picking.h"
+#include "job_system.h"
+#include "scene_random.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include "win_include.h"
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace
+{
+    // Elements per call of the batch math cases, about one scene chunk
+    constexpr size_t MathElements = 256u;
+
+    // Kernels the math and culling cases compare, the 4-wide ones only where the target has SSE
+    constexpr MathPath MathPaths[] =
+    {
+        MathPath::Native,
+#if defined(SIMD_MATH_SSE)
+        MathPath::Sse,
+#endif
+        MathPath::Scalar
+    };
+
+    std::string PathSuffix(MathPath Path)
+    {
+        switch (Path)
+        {
+            case MathPath::Native: return ".native";
+            case MathPath::Sse: return ".sse";
+            default: return ".scalar";
+        }
+    }
+
+    // Eight children per node, added breadth first
+    void BuildHierarchy(TransformHierarchy& Hierarchy, size_t Count)
+    {
+        Hierarchy.Reserve(Count);
+        for (size_t i = 0; i < Count; i++)
+        {
+            TransformHierarchy::Local Transform;
+            Transform.Position = {static_cast<float>(i % 8u), 0.0f, 1.0f};
+            Transform.Rotation = Quat::FromAxisAngle({0.0f, 0.0f, 1.0f}, static_cast<float>(i) * 0.01f);
+            Hierarchy.Add(i == 0u ? TransformHierarchy::NoParent : static_cast<TransformHierarchy::Node>((i - 1u) / 8u), Transform);
+        }
+        Hierarchy.Update();
+    }
+
+    struct BenchPosition
+    {
+        float X;
+        float Y;
+        float Z;
+    };
+    struct BenchVelocity
+    {
+        float X;
+        float Y;
+        float Z;
+    };
+    struct BenchTag
+    {
+        uint32_t Value;
+    };
+
+    // Position += Velocity * dt, the smallest useful system
+    void Integrate(size_t Count, BenchPosition* Positions, const BenchVelocity* Velocities) noexcept
+    {
+        for (size_t i = 0; i < Count; i++)
+        {
+            Positions[i].X += Velocities[i].X * (1.0f / 60.0f);
+            Positions[i].Y += Velocities[i].Y * (1.0f / 60.0f);
+            Positions[i].Z += Velocities[i].Z * (1.0f / 60.0f);
+        }
+    }
+
+    // Entities per call of the structural change cases
+    constexpr size_t StructuralEntities = 10000u;
+
+    // Allocations per call of the arena cases, 16 to 1024 bytes aligned to 4 to 64
+    constexpr size_t ArenaAllocations = 256u;
+    constexpr size_t ArenaCapacity = 1u << 20u;
+    // Elements pushed into the arena vector, one at a time
+    constexpr size_t ArenaVectorElements = 4096u;
+
+    // Live objects of the handle cases, resolved in a random order of HandleLookups
+    constexpr size_t HandleObjects = 100000u;
+    constexpr size_t HandleLookups = 4096u;
+    using BenchHandle = Handle<struct BenchTag>;
+
+    // Distinct descriptors in the cache of the pipeline cases, about what a scene uses
+    constexpr uint32_t PipelineDescs = 256u;
+
+    PipelineStateDesc MakeBenchDesc(uint32_t i)
+    {
+        PipelineStateDesc Desc;
+        Desc.VertexShader = VertexShaderHandle::Make(i % 16u + 1u, 1u);
+        Desc.PixelShader = PixelShaderHandle::Make(i / 16u + 1u, 1u);
+        Desc.InputLayout = InputLayoutHandle::Make(i % 16u + 1u, 1u);
+        Desc.Blend = static_cast<BlendMode>(i % static_cast<uint32_t>(BlendMode::Count));
+        return Desc;
+    }
+
+    // Draws recorded per call of the command cases, in lists of DrawsPerList like a scene's chunks
+    constexpr size_t RecordedDraws = 100000u;
+    constexpr size_t DrawsPerList = 1024u;
+
+    // Objects per call of the culling cases
+    constexpr size_t CullObjects = 1000000u;
+
+    // Depth buffer and occluders of the occlusion cases
+    constexpr uint32_t OcclusionWidth = 320u;
+    constexpr uint32_t OcclusionHeight = 184u;
+    constexpr size_t OcclusionWalls = 32u;
+
+    // Torus of the meshlet cases, TorusSegments around the ring and TorusSides around the
+    // tube, placed MeshletObjects times
+    constexpr uint32_t TorusSegments = 512u;
+    constexpr uint32_t TorusSides = 128u;
+    constexpr size_t MeshletObjects = 64u;
+
+    // Height field of the picking cases, 2 * 512^2 triangles placed PickObjects times
+    constexpr uint32_t PickGridSize = 512u;
+    constexpr size_t PickObjects = 8u;
+}
+
+MicroBenchmark::MicroBenchmark(Settings Config) : Config(std::move(Config))
+{
+    std::istringstream List(this->Config.Filter);
+    for (std::string Prefix; std::getline(List, Prefix, ','); )
+    {
+        if (!Prefix.empty())
+        {
+            Prefixes.push_back(Prefix);
+        }
+    }
+}
+
+bool MicroBenchmark::IsSelected(std::string_view Name) const noexcept
+{
+    if (Prefixes.empty())
+    {
+        return true;
+    }
+    for (const std::string& Prefix : Prefixes)
+    {
+        if (Name.starts_with(Prefix))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MicroBenchmark::IsGroupSelected(std::string_view Group) const noexcept
+{
+    if (Prefixes.empty())
+    {
+        return true;
+    }
+    for (const std::string& Prefix : Prefixes)
+    {
+        if (Group.starts_with(Prefix) || std::string_view(Prefix).starts_with(Group))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void MicroBenchmark::PinCurrentThread(unsigned int Core) noexcept
+{
+#ifdef _WIN32
+    SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1u) << (Core % (sizeof(DWORD_PTR) * 8u)));
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
+#else
+    cpu_set_t Cores;
+    CPU_ZERO(&Cores);
+    CPU_SET(Core % CPU_SETSIZE, &Cores);
+    pthread_setaffinity_np(pthread_self(), sizeof(Cores), &Cores);
+#endif
+}
+
+void MicroBenchmark::Run(BenchmarkReport& Report)
+{
+    // Started before the measuring thread is pinned, on Linux new threads inherit their creator's affinity
+    JobSystem Jobs;
+    // 1, 2, 4... threads up to the hardware's for the scaling cases
+    std::vector<std::unique_ptr<JobSystem>> Scaling;
+    if (IsGroupSelected("commands."))
+    {
+        const unsigned int Hardware = std::max(std::thread::hardware_concurrency(), 1u);
+        for (unsigned int Threads = 1u; Threads <= Hardware; Threads *= 2u)
+        {
+            Scaling.push_back(std::make_unique<JobSystem>(Threads - 1u));
+        }
+    }
+    RunPinned([&]()
+    {
+        if (IsGroupSelected("keyboard.") || IsGroupSelected("mouse."))
+        {
+            RunInput(Report);
+        }
+        if (IsGroupSelected("timer."))
+        {
+            RunTimer(Report);
+        }
+        // what() formats into the exception's buffer on every call
+        const MyException Plain(__LINE__, __FILE__);
+        Measure(Report, "exception.what", [&](size_t)
+        {
+            Sink = Sink + std::strlen(Plain.what());
+        });
+        if (IsGroupSelected("math."))
+        {
+            RunMath(Report);
+        }
+        if (IsGroupSelected("hierarchy."))
+        {
+            RunHierarchy(Report, Jobs);
+        }
+        if (IsGroupSelected("entities."))
+        {
+            RunEntities(Report, Jobs);
+        }
+        if (IsGroupSelected("arena."))
+        {
+            RunArena(Report);
+        }
+        if (IsGroupSelected("handles."))
+        {
+            RunHandles(Report);
+        }
+        if (IsGroupSelected("pipeline."))
+        {
+            RunPipeline(Report);
+        }
+        if (IsGroupSelected("commands."))
+        {
+            RunCommands(Report, Scaling);
+        }
+        if (IsGroupSelected("culling.") || IsGroupSelected("lod.") || IsGroupSelected("occlusion.") || IsGroupSelected("meshlet."))
+        {
+            RunCulling(Report, Jobs);
+        }
+        if (IsGroupSelected("bvh."))
+        {
+            RunBvh(Report, Jobs);
+        }
+        if (IsGroupSelected("picking."))
+        {
+            RunPicking(Report, Jobs);
+        }
+    });
+}
+
+void MicroBenchmark::RunInput(BenchmarkReport& Report)
+{
+    // Every press is read straight back, the common case of a drained queue
+    Keyboard Keys;
+    Measure(Report, "keyboard.press_read", [&](size_t i)
+    {
+        Keys.OnKeyPressed(static_cast<unsigned char>(i));
+        Sink = Sink + Keys.ReadKey().GetCode();
+    });
+    // Nobody reads, every press trims the full queue
+    Keys.Flush();
+    Measure(Report, "keyboard.press_overflow", [&](size_t i)
+    {
+        Keys.OnKeyPressed(static_cast<unsigned char>(i));
+    });
+    Sink = Sink + Keys.KeyIsPressed(0u);
+
+    Mouse Pointer;
+    Measure(Report, "mouse.move_read", [&](size_t i)
+    {
+        Pointer.OnMouseMove(static_cast<int>(i & 1023u), static_cast<int>((i >> 10u) & 1023u));
+        Sink = Sink + Pointer.Read().GetPosX();
+    });
+    Pointer.Flush();
+    Measure(Report, "mouse.move_overflow", [&](size_t i)
+    {
+        Pointer.OnMouseMove(static_cast<int>(i & 1023u), static_cast<int>((i >> 10u) & 1023u));
+    });
+    Sink = Sink + Pointer.GetPosY();
+}
+
+void MicroBenchmark::RunTimer(BenchmarkReport& Report)
+{
+    Measure(Report, "timer.clock_now", [&](size_t)
+    {
+        Sink = Sink + static_cast<size_t>(TscClock::Now());
+    });
+    Timer Clock;
+    Measure(Report, "timer.mark", [&](size_t)
+    {
+        Sink = Sink + static_cast<size_t>(Clock.Mark() > 1.0f);
+    });
+    Measure(Report, "timer.peek", [&](size_t)
+    {
+        Sink = Sink + static_cast<size_t>(Clock.Peek() > 1.0);
+    });
+}
+
+void MicroBenchmark::RunMath(BenchmarkReport& Report)
+{
+    // Batch math, each kernel on the native SIMD path and on the scalar reference path
+    std::vector<float> X(MathElements), Y(MathElements), Z(MathElements), Angles(MathElements), Scales(MathElements, 0.5f);
+    std::vector<float> Rotation[4] = {std::vector<float>(MathElements, 0.0f), std::vector<float>(MathElements, 0.0f), std::vector<float>(MathElements, 0.0f), std::vector<float>(MathElements, 1.0f)};
+    std::vector<Mat4> Matrices(MathElements), Products(MathElements);
+    for (size_t i = 0; i < MathElements; i++)
+    {
+        X[i] = static_cast<float>(i) * 0.01f;
+        Y[i] = 1.0f - static_cast<float>(i) * 0.01f;
+        Z[i] = 0.5f;
+        Angles[i] = static_cast<float>(i) * 0.1f;
+    }
+    const Mat4 View = Mat4::LookAt({0.0f, 1.0f, -5.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f});
+    const TransformStreams Transforms = {X.data(), Y.data(), Z.data(), Rotation[0].data(), Rotation[1].data(), Rotation[2].data(), Rotation[3].data(), Scales.data(), Scales.data(), Scales.data()};
+    for (const MathPath Path : MathPaths)
+    {
+        const std::string Suffix = PathSuffix(Path);
+        std::vector<float> OutX(MathElements), OutY(MathElements), OutZ(MathElements);
+        Measure(Report, "math.transform_points" + Suffix, [&](size_t)
+        {
+            TransformPoints(View, {X.data(), Y.data(), Z.data()}, {OutX.data(), OutY.data(), OutZ.data()}, MathElements, Path);
+            Sink = Sink + static_cast<size_t>(OutX[0] > 0.0f);
+        });
+        Measure(Report, "math.compose_transforms" + Suffix, [&](size_t)
+        {
+            ComposeTransforms(Transforms, Matrices.data(), MathElements, Path);
+            Sink = Sink + static_cast<size_t>(Matrices[0].M[0][0] > 0.0f);
+        });
+        Measure(Report, "math.compose_transforms_2d" + Suffix, [&](size_t)
+        {
+            ComposeTransforms2D(X.data(), Y.data(), Scales.data(), Angles.data(), Matrices.data(), MathElements, Path);
+            Sink = Sink + static_cast<size_t>(Matrices[0].M[0][0] > 0.0f);
+        });
+        Measure(Report, "math.multiply_matrices" + Suffix, [&](size_t)
+        {
+            MultiplyMatrices(Matrices.data(), View, Products.data(), MathElements, Path);
+            Sink = Sink + static_cast<size_t>(Products[0].M[0][0] > 0.0f);
+        });
+        Measure(Report, "math.sincos" + Suffix, [&](size_t)
+        {
+            SinCos(Angles.data(), OutX.data(), OutY.data(), MathElements, Path);
+            Sink = Sink + static_cast<size_t>(OutX[0] > 0.0f);
+        });
+    }
+}
+
+void MicroBenchmark::RunHierarchy(BenchmarkReport& Report, JobSystem& Jobs)
+{
+    // Transform hierarchy, one Update per call. Moving the root dirties every node, moving
+    // scattered leaves shows the cost of the linear pass when almost nothing changed.
+    for (const size_t Nodes : {size_t(100000u), size_t(1000000u)})
+    {
+        const std::string Suffix = Nodes == 100000u ? ".100k" : ".1m";
+        TransformHierarchy Hierarchy;
+        BuildHierarchy(Hierarchy, Nodes);
+        const TransformHierarchy::Node Root = 0u;
+        const TransformHierarchy::Local RootTransform = Hierarchy.GetLocal(Root);
+        Measure(Report, "hierarchy.update_all" + Suffix, [&](size_t)
+        {
+            Hierarchy.SetLocal(Root, RootTransform);
+            Hierarchy.Update();
+            Sink = Sink + Hierarchy.GetChangedCount();
+        }, 1u);
+        Measure(Report, "hierarchy.update_all_jobs" + Suffix, [&](size_t)
+        {
+            Hierarchy.SetLocal(Root, RootTransform);
+            Hierarchy.Update(&Jobs);
+            Sink = Sink + Hierarchy.GetChangedCount();
+        }, 1u);
+        Measure(Report, "hierarchy.update_dirty" + Suffix, [&](size_t i)
+        {
+            // Leaves are the last seven eighths of a breadth-first tree
+            for (size_t k = 0; k < Nodes / 1000u; k++)
+            {
+                const size_t Leaf = Nodes - 1u - (i * 7919u + k * 104729u) % (Nodes * 7u / 8u);
+                const TransformHierarchy::Node Moved = static_cast<TransformHierarchy::Node>(Leaf);
+                Hierarchy.SetLocal(Moved, Hierarchy.GetLocal(Moved));
+            }
+            Hierarchy.Update();
+            Sink = Sink + Hierarchy.GetChangedCount();
+        }, 1u);
+    }
+}
+
+void MicroBenchmark::RunEntities(BenchmarkReport& Report, JobSystem& Jobs)
+{
+    // Entity store, a whole system pass per call and structural changes in batches of 10k
+    for (const size_t Count : {size_t(100000u), size_t(1000000u)})
+    {
+        const std::string Suffix = Count == 100000u ? ".100k" : ".1m";
+        EntityStore Entities;
+        for (size_t i = 0; i < Count; i++)
+        {
+            Entities.Create(BenchPosition{static_cast<float>(i), 0.0f, 0.0f}, BenchVelocity{1.0f, 0.5f, 0.0f});
+        }
+        Measure(Report, "entities.iterate" + Suffix, [&](size_t)
+        {
+            Entities.ForEachChunk<BenchPosition, const BenchVelocity>([](size_t n, const Entity*, BenchPosition* p, const BenchVelocity* v)
+            {
+                Integrate(n, p, v);
+            });
+        }, 1u);
+        Measure(Report, "entities.iterate_jobs" + Suffix, [&](size_t)
+        {
+            Entities.ParallelForEachChunk<BenchPosition, const BenchVelocity>(Jobs, [](size_t n, const Entity*, BenchPosition* p, const BenchVelocity* v, unsigned int)
+            {
+                Integrate(n, p, v);
+            });
+        }, 1u);
+    }
+
+    EntityStore Entities;
+    std::vector<Entity> Created(StructuralEntities);
+    Measure(Report, "entities.create_destroy", [&](size_t)
+    {
+        for (Entity& e : Created)
+        {
+            e = Entities.Create(BenchPosition{0.0f, 0.0f, 0.0f}, BenchVelocity{1.0f, 0.0f, 0.0f});
+        }
+        for (const Entity e : Created)
+        {
+            Entities.Destroy(e);
+        }
+    }, 1u);
+    for (Entity& e : Created)
+    {
+        e = Entities.Create(BenchPosition{0.0f, 0.0f, 0.0f}, BenchVelocity{1.0f, 0.0f, 0.0f});
+    }
+    // Every entity moves to the tagged archetype and back through a command buffer
+    CommandBuffer Commands;
+    Measure(Report, "entities.add_remove", [&](size_t i)
+    {
+        for (const Entity e : Created)
+        {
+            Commands.Add(e, BenchTag{static_cast<uint32_t>(i)});
+        }
+        Entities.Apply(Commands);
+        for (const Entity e : Created)
+        {
+            Commands.Remove<BenchTag>(e);
+        }
+        Entities.Apply(Commands);
+    }, 1u);
+    Sink = Sink + Entities.GetEntityCount();
+}
+
+void MicroBenchmark::RunArena(BenchmarkReport& Report)
+{
+    // Every call is one frame: all blocks are made, then freed at once by Reset or one by one on the heap
+    SceneRandom Random(5u);
+    std::vector<size_t> Sizes(ArenaAllocations);
+    std::vector<size_t> Alignments(ArenaAllocations);
+    size_t Payload = 0u;
+    for (size_t i = 0; i < ArenaAllocations; i++)
+    {
+        Sizes[i] = 16u + Random.Next() % 1009u;
+        Alignments[i] = size_t{4u} << (Random.Next() % 5u);
+        Payload += Sizes[i];
+    }
+
+    FrameArena Arena(ArenaCapacity);
+    if (BenchmarkRun* Result = Measure(Report, "arena.allocate", [&](size_t)
+    {
+        for (size_t i = 0; i < ArenaAllocations; i++)
+        {
+            Sink = Sink + reinterpret_cast<uintptr_t>(Arena.Allocate(Sizes[i], Alignments[i]));
+        }
+        Arena.Reset();
+    }, 100u))
+    {
+        Result->AddPeak("payload_bytes", static_cast<double>(Payload));
+        Result->AddPeak("used_bytes", static_cast<double>(Arena.GetHighWaterMark()));
+    }
+
+    std::vector<void*> Blocks(ArenaAllocations);
+    Measure(Report, "arena.heap", [&](size_t)
+    {
+        for (size_t i = 0; i < ArenaAllocations; i++)
+        {
+            Blocks[i] = ::operator new(Sizes[i], std::align_val_t{Alignments[i]});
+        }
+        for (size_t i = 0; i < ArenaAllocations; i++)
+        {
+            ::operator delete(Blocks[i], std::align_val_t{Alignments[i]});
+        }
+    }, 100u);
+
+    // Storage the vector outgrows stays behind until Reset
+    FrameArena VectorArena(ArenaCapacity);
+    if (BenchmarkRun* Result = Measure(Report, "arena.vector", [&](size_t)
+    {
+        std::vector<uint32_t, ArenaAllocator<uint32_t>> Values{ArenaAllocator<uint32_t>(VectorArena)};
+        for (size_t i = 0; i < ArenaVectorElements; i++)
+        {
+            Values.push_back(static_cast<uint32_t>(i));
+        }
+        Sink = Sink + Values.back();
+        VectorArena.Reset();
+    }, 100u))
+    {
+        Result->AddPeak("payload_bytes", static_cast<double>(ArenaVectorElements * sizeof(uint32_t)));
+        Result->AddPeak("used_bytes", static_cast<double>(VectorArena.GetHighWaterMark()));
+    }
+}
+
+void MicroBenchmark::RunHandles(BenchmarkReport& Report)
+{
+    // Graphics resolves a handle for every bound resource. The same random order through
+    // plain pointers is the cost without the slot table and generation check.
+    HandlePool<size_t, BenchHandle> Pool;
+    std::vector<BenchHandle> Handles;
+    Handles.reserve(HandleObjects);
+    for (size_t i = 0; i < HandleObjects; i++)
+    {
+        Handles.push_back(Pool.Insert(i));
+    }
+    std::vector<size_t> Objects(HandleObjects);
+    std::vector<size_t*> Pointers(HandleObjects);
+    for (size_t i = 0; i < HandleObjects; i++)
+    {
+        Objects[i] = i;
+        Pointers[i] = &Objects[i];
+    }
+    SceneRandom Random(3u);
+    std::vector<uint32_t> Order(HandleLookups);
+    for (uint32_t& Index : Order)
+    {
+        Index = static_cast<uint32_t>(Random.Next() % HandleObjects);
+    }
+
+    Measure(Report, "handles.get", [&](size_t i)
+    {
+        Sink = Sink + *Pool.Get(Handles[Order[i % HandleLookups]]);
+    });
+    Measure(Report, "handles.pointer", [&](size_t i)
+    {
+        Sink = Sink + *Pointers[Order[i % HandleLookups]];
+    });
+    // A stale handle is caught by the generation check alone
+    const BenchHandle Stale = Handles[0];
+    Handles[0] = Pool.Insert(Pool.Remove(Stale));
+    Measure(Report, "handles.get_stale", [&](size_t)
+    {
+        Sink = Sink + (Pool.Get(Stale) == nullptr);
+    });
+    // The pool stays at HandleObjects, every call frees a random slot and refills it
+    Measure(Report, "handles.remove_insert", [&](size_t i)
+    {
+        BenchHandle& h = Handles[Order[i % HandleLookups]];
+        h = Pool.Insert(Pool.Remove(h));
+    });
+    Sink = Sink + Pool.GetSize();
+}
+
+void MicroBenchmark::RunPipeline(BenchmarkReport& Report)
+{
+    // What CreatePipelineState costs before any Direct3D call: hashing the descriptor and
+    // finding it among the existing PSOs, or learning that it is new
+    PipelineStateCache Cache;
+    std::vector<PipelineStateDesc> Descs;
+    for (uint32_t i = 0; i < PipelineDescs; i++)
+    {
+        Descs.push_back(MakeBenchDesc(i));
+        Cache.Insert(Descs.back(), HashPipelineState(Descs.back()), i);
+    }
+    std::vector<PipelineStateDesc> Missing(Descs);
+    for (PipelineStateDesc& Desc : Missing)
+    {
+        Desc.Sampler = SamplerMode::Point;
+    }
+
+    Measure(Report, "pipeline.hash", [&](size_t i)
+    {
+        Sink = Sink + HashPipelineState(Descs[i % PipelineDescs]);
+    });
+    Measure(Report, "pipeline.find_hit", [&](size_t i)
+    {
+        const PipelineStateDesc& Desc = Descs[i % PipelineDescs];
+        Sink = Sink + Cache.Find(Desc, HashPipelineState(Desc));
+    });
+    Measure(Report, "pipeline.find_miss", [&](size_t i)
+    {
+        const PipelineStateDesc& Desc = Missing[i % PipelineDescs];
+        Sink = Sink + Cache.Find(Desc, HashPipelineState(Desc));
+    });
+}
+
+void MicroBenchmark::RunCommands(BenchmarkReport& Report, const std::vector<std::unique_ptr<JobSystem>>& Scaling)
+{
+    // Every draw sets a PSO, a vertex buffer and 64 bytes of constants, as the scenes do.
+    // Lists are recycled, so after warmup recording no longer allocates.
+    std::vector<CommandList> Lists((RecordedDraws + DrawsPerList - 1u) / DrawsPerList);
+    std::vector<Mat4> Constants(RecordedDraws);
+    for (size_t i = 0; i < RecordedDraws; i++)
+    {
+        Constants[i] = Mat4::Translation(static_cast<float>(i), 0.0f, 0.0f);
+    }
+    for (const std::unique_ptr<JobSystem>& Jobs : Scaling)
+    {
+        Measure(Report, "commands.record." + std::to_string(Jobs->GetThreadCount()) + "t", [&](size_t)
+        {
+            Jobs->ParallelFor(RecordedDraws, DrawsPerList, [&](size_t Begin, size_t End, unsigned int)
+            {
+                CommandList& List = Lists[Begin / DrawsPerList];
+                List.Reset();
+                for (size_t i = Begin; i < End; i++)
+                {
+                    List.SetPipelineState(static_cast<uint32_t>(i % 8u));
+                    List.SetVertexBuffer(BufferHandle::Make(static_cast<uint32_t>(i % 64u) + 1u, 1u), 32u);
+                    List.SetDrawConstants(&Constants[i], sizeof(Mat4));
+                    List.Draw(36u);
+                }
+            });
+            Sink = Sink + Lists.back().GetDrawCount();
+        }, 1u);
+    }
+}
+
+void MicroBenchmark::RunCulling(BenchmarkReport& Report, JobSystem& Jobs)
+{
+    // Frustum culling of a cube of objects seen from outside, about a tenth is kept
+    std::vector<float> CenterX(CullObjects), CenterY(CullObjects), CenterZ(CullObjects), Extents(CullObjects);
+    std::vector<uint32_t> Visible(CullObjects);
+    SceneRandom Random(1u);
+    for (size_t i = 0; i < CullObjects; i++)
+    {
+        CenterX[i] = Random.NextFloat(-100.0f, 100.0f);
+        CenterY[i] = Random.NextFloat(-100.0f, 100.0f);
+        CenterZ[i] = Random.NextFloat(-100.0f, 100.0f);
+        Extents[i] = Random.NextFloat(0.1f, 2.0f);
+    }
+    const Frustum Camera = Frustum::FromMatrix(Multiply(Mat4::LookAt({0.0f, 0.0f, -150.0f}, {20.0f, 10.0f, 0.0f}, {0.0f, 1.0f, 0.0f}), Mat4::Perspective(0.3f, 16.0f / 9.0f, 0.1f, 400.0f)));
+    const SphereStreams Spheres = {CenterX.data(), CenterY.data(), CenterZ.data(), Extents.data()};
+    const BoxStreams Boxes = {CenterX.data(), CenterY.data(), CenterZ.data(), Extents.data(), Extents.data(), Extents.data()};
+    for (const MathPath Path : MathPaths)
+    {
+        const std::string Suffix = PathSuffix(Path);
+        Measure(Report, "culling.spheres" + Suffix, [&](size_t)
+        {
+            Sink = Sink + CullSpheres(Camera, Spheres, CullObjects, Visible.data(), 0u, Path);
+        }, 1u);
+        Measure(Report, "culling.boxes" + Suffix, [&](size_t)
+        {
+            Sink = Sink + CullBoxes(Camera, Boxes, CullObjects, Visible.data(), 0u, Path);
+        }, 1u);
+    }
+    FrustumCuller Culler;
+    Measure(Report, "culling.spheres_jobs", [&](size_t)
+    {
+        Sink = Sink + Culler.CullSpheres(Jobs, Camera, Spheres, CullObjects, Visible.data());
+    }, 1u);
+
+    if (IsGroupSelected("lod."))
+    {
+        // The same spheres with a level of detail picked for every kept one, five levels that
+        // quarter the triangles each, without a budget and with one that forces coarser levels
+        LodLevel BenchLevels[5];
+        for (uint32_t l = 0; l < 5u; l++)
+        {
+            BenchLevels[l] = {0u, (4096u >> (2u * l)) * 3u, l == 0u ? 0.0f : 0.01f * static_cast<float>(1u << l)};
+        }
+        LodSelector Lods({1.0f, 0.2f, 0u});
+        const std::vector<uint32_t> LodMeshes(CullObjects, Lods.AddMesh(BenchLevels, 5u));
+        const float PixelScale = LodSelector::GetPixelScale(Mat4::Perspective(0.3f, 16.0f / 9.0f, 0.1f, 400.0f), 1080u);
+        Measure(Report, "lod.cull_select", [&](size_t)
+        {
+            Sink = Sink + Lods.CullAndSelect(Jobs, Camera, {0.0f, 0.0f, -150.0f}, PixelScale, Spheres, LodMeshes.data(), CullObjects, Visible.data());
+        }, 1u);
+        Lods.SetSettings({1.0f, 0.2f, 1000000u});
+        Measure(Report, "lod.cull_select_budget", [&](size_t)
+        {
+            Sink = Sink + Lods.CullAndSelect(Jobs, Camera, {0.0f, 0.0f, -150.0f}, PixelScale, Spheres, LodMeshes.data(), CullObjects, Visible.data());
+        }, 1u);
+    }
+
+    // Occlusion of the boxes the frustum kept, by walls a fifth of the way to the cube
+    const Mat4 ViewProjection = Multiply(Mat4::LookAt({0.0f, 0.0f, -150.0f}, {20.0f, 10.0f, 0.0f}, {0.0f, 1.0f, 0.0f}), Mat4::Perspective(0.3f, 16.0f / 9.0f, 0.1f, 400.0f));
+    const Vec3 WallCorners[] = {{-1.0f, -1.0f, 0.0f}, {1.0f, -1.0f, 0.0f}, {1.0f, 1.0f, 0.0f}, {-1.0f, 1.0f, 0.0f}};
+    const uint32_t WallIndices[] = {0u, 2u, 1u, 0u, 3u, 2u};
+    std::vector<Mat4> Walls(OcclusionWalls);
+    for (Mat4& Wall : Walls)
+    {
+        const Mat4 Size = Mat4::Scaling(Random.NextFloat(1.0f, 3.0f), Random.NextFloat(1.0f, 3.0f), 1.0f);
+        Wall = Multiply(Size, Mat4::Translation(Random.NextFloat(-4.0f, 12.0f), Random.NextFloat(-2.0f, 6.0f), Random.NextFloat(-125.0f, -115.0f)));
+    }
+    if (!IsGroupSelected("occlusion.") && !IsGroupSelected("meshlet."))
+    {
+        return;
+    }
+    const std::vector<uint32_t> Candidates(Visible.begin(), Visible.begin() + CullBoxes(Camera, Boxes, CullObjects, Visible.data()));
+    OcclusionBuffer Occlusion(OcclusionWidth, OcclusionHeight);
+    const auto RasterizeWalls = [&](JobSystem* Workers)
+    {
+        Occlusion.Begin(ViewProjection);
+        for (const Mat4& Wall : Walls)
+        {
+            Occlusion.AddOccluder(WallCorners, WallIndices, std::size(WallIndices), Wall);
+        }
+        Occlusion.Rasterize(Workers);
+    };
+    Measure(Report, "occlusion.rasterize", [&](size_t)
+    {
+        RasterizeWalls(nullptr);
+        Sink = Sink + Occlusion.GetTriangleCount();
+    }, 1u);
+    Measure(Report, "occlusion.rasterize_jobs", [&](size_t)
+    {
+        RasterizeWalls(&Jobs);
+        Sink = Sink + Occlusion.GetTriangleCount();
+    }, 1u);
+    Measure(Report, "occlusion.cull_boxes", [&](size_t)
+    {
+        Sink = Sink + Occlusion.CullBoxes(Boxes, Candidates.data(), Candidates.size(), Visible.data());
+    }, 1u);
+    Measure(Report, "occlusion.cull_boxes_jobs", [&](size_t)
+    {
+        Sink = Sink + Occlusion.CullBoxes(Boxes, Candidates.data(), Candidates.size(), Visible.data(), &Jobs);
+    }, 1u);
+
+    // Meshlets of tori spread over the view behind the walls, some turned edge on. The
+    // tests without the depth buffer drop what is outside or facing away, the last case
+    // also tests what is left against the walls rasterized above.
+    if (!IsGroupSelected("meshlet."))
+    {
+        return;
+    }
+    RasterizeWalls(&Jobs);
+    std::vector<Vec3> TorusPositions;
+    std::vector<uint32_t> TorusIndices;
+    for (uint32_t a = 0; a < TorusSegments; a++)
+    {
+        for (uint32_t b = 0; b < TorusSides; b++)
+        {
+            const float Around = 6.2831853f * static_cast<float>(a) / static_cast<float>(TorusSegments);
+            const float Tube = 6.2831853f * static_cast<float>(b) / static_cast<float>(TorusSides);
+            const float Ring = 1.0f + 0.4f * Cos(Tube);
+            TorusPositions.push_back({Ring * Cos(Around), 0.4f * Sin(Tube), Ring * Sin(Around)});
+        }
+    }
+    for (uint32_t a = 0; a < TorusSegments; a++)
+    {
+        for (uint32_t b = 0; b < TorusSides; b++)
+        {
+            // Wound so the faces on the outside of the tube are front faces
+            const uint32_t Next = (a + 1u) % TorusSegments;
+            const uint32_t Side = (b + 1u) % TorusSides;
+            const uint32_t Quad[] = {a * TorusSides + b, a * TorusSides + Side, Next * TorusSides + b,
+                Next * TorusSides + b, a * TorusSides + Side, Next * TorusSides + Side};
+            TorusIndices.insert(TorusIndices.end(), std::begin(Quad), std::end(Quad));
+        }
+    }
+    const MeshletMesh Torus = BuildMeshlets(TorusPositions.data(), TorusPositions.size(), TorusIndices.data(), TorusIndices.size());
+    std::vector<Mat4> TorusPlacements(MeshletObjects);
+    for (size_t i = 0; i < MeshletObjects; i++)
+    {
+        const Vec3 Axis = Normalize(Vec3{Random.NextFloat(-1.0f, 1.0f), 1.0f, Random.NextFloat(-1.0f, 1.0f)});
+        const Vec3 Position = {static_cast<float>(i % 8u) * 4.0f - 5.0f, static_cast<float>(i / 8u) * 2.5f - 4.0f, Random.NextFloat(-90.0f, -70.0f)};
+        TorusPlacements[i] = Mat4::Compose(Position, Quat::FromAxisAngle(Axis, Random.NextFloat(0.0f, 3.0f)), {1.5f, 1.5f, 1.5f});
+    }
+    MeshletCuller Meshlets;
+    Measure(Report, "meshlet.cull", [&](size_t)
+    {
+        Sink = Sink + Meshlets.Cull(Torus, TorusPlacements.data(), MeshletObjects, ViewProjection, {0.0f, 0.0f, -150.0f});
+    }, 1u);
+    Measure(Report, "meshlet.cull_jobs", [&](size_t)
+    {
+        Sink = Sink + Meshlets.Cull(Torus, TorusPlacements.data(), MeshletObjects, ViewProjection, {0.0f, 0.0f, -150.0f}, nullptr, &Jobs);
+    }, 1u);
+    Measure(Report, "meshlet.cull_occlusion_jobs", [&](size_t)
+    {
+        Sink = Sink + Meshlets.Cull(Torus, TorusPlacements.data(), MeshletObjects, ViewProjection, {0.0f, 0.0f, -150.0f}, &Occlusion, &Jobs);
+    }, 1u);
+}
+
+void MicroBenchmark::RunBvh(BenchmarkReport& Report, JobSystem& Jobs)
+{
+    // Bounding volume hierarchy over boxes at the same density whatever the count, so a
+    // query finds a few objects and its cost shows the depth of the tree. Refits move
+    // every hundredth object a little, or refit all of them.
+    SceneRandom Random(2u);
+    for (const size_t Count : {size_t(10000u), size_t(100000u), size_t(1000000u)})
+    {
+        const std::string Suffix = Count == 10000u ? ".10k" : Count == 100000u ? ".100k" : ".1m";
+        const float WorldSize = 4.0f * std::cbrt(static_cast<float>(Count));
+        std::vector<Bvh::Box> Objects(Count);
+        for (Bvh::Box& Object : Objects)
+        {
+            const Vec3 Center = {Random.NextFloat(0.0f, WorldSize), Random.NextFloat(0.0f, WorldSize), Random.NextFloat(0.0f, WorldSize)};
+            const float HalfSize = Random.NextFloat(0.1f, 1.1f);
+            Object = {{Center.X - HalfSize, Center.Y - HalfSize, Center.Z - HalfSize}, {Center.X + HalfSize, Center.Y + HalfSize, Center.Z + HalfSize}};
+        }
+        std::vector<uint32_t> Moved;
+        for (size_t i = 0; i < Count; i += 100u)
+        {
+            Moved.push_back(static_cast<uint32_t>(i));
+        }
+        Bvh Tree;
+        if (Count == 10000u)
+        {
+            Measure(Report, "bvh.build" + Suffix, [&](size_t)
+            {
+                Tree.Build(Objects.data(), Count);
+                Sink = Sink + Tree.GetNodeCount();
+            }, 1u);
+            Measure(Report, "bvh.build_jobs" + Suffix, [&](size_t)
+            {
+                Tree.Build(Objects.data(), Count, &Jobs);
+                Sink = Sink + Tree.GetNodeCount();
+            }, 1u);
+        }
+        Tree.Build(Objects.data(), Count, &Jobs);
+        std::vector<uint32_t> Found(Count);
+        Measure(Report, "bvh.query_box" + Suffix, [&](size_t i)
+        {
+            const Bvh::Box& Around = Objects[(i * 7919u) % Count];
+            const Bvh::Box Region = {{Around.Min.X - 1.0f, Around.Min.Y - 1.0f, Around.Min.Z - 1.0f}, {Around.Max.X + 1.0f, Around.Max.Y + 1.0f, Around.Max.Z + 1.0f}};
+            Sink = Sink + Tree.QueryBox(Region, Found.data());
+        });
+        Measure(Report, "bvh.refit_moved" + Suffix, [&](size_t i)
+        {
+            const float Step = (i & 1u) ? -0.01f : 0.01f;
+            for (const uint32_t Object : Moved)
+            {
+                Objects[Object].Min.X += Step;
+                Objects[Object].Max.X += Step;
+            }
+            Tree.Refit(Objects.data(), Moved.data(), Moved.size());
+        }, 1u);
+        if (Count != 1000000u)
+        {
+            Measure(Report, "bvh.refit_all" + Suffix, [&](size_t)
+            {
+                Tree.Refit(Objects.data(), &Jobs);
+            }, 1u);
+        }
+    }
+}
+
+void MicroBenchmark::RunPicking(BenchmarkReport& Report, JobSystem& Jobs)
+{
+    // Picking under a cursor that sweeps a 1280 x 720 view of eight height fields, 4M
+    // triangles in all, about a quarter of the rays hit
+    Mouse Pointer;
+    std::vector<Vec3> GridPositions;
+    std::vector<uint32_t> GridIndices;
+    for (uint32_t y = 0; y <= PickGridSize; y++)
+    {
+        for (uint32_t x = 0; x <= PickGridSize; x++)
+        {
+            const float Height = Sin(static_cast<float>(x) * 0.11f) * Cos(static_cast<float>(y) * 0.07f) * 1.5f;
+            GridPositions.push_back({static_cast<float>(x) / static_cast<float>(PickGridSize) * 16.0f - 8.0f, Height, static_cast<float>(y) / static_cast<float>(PickGridSize) * 16.0f - 8.0f});
+        }
+    }
+    for (uint32_t y = 0; y < PickGridSize; y++)
+    {
+        for (uint32_t x = 0; x < PickGridSize; x++)
+        {
+            const uint32_t Corner = y * (PickGridSize + 1u) + x;
+            const uint32_t Quad[] = {Corner, Corner + PickGridSize + 1u, Corner + 1u, Corner + 1u, Corner + PickGridSize + 1u, Corner + PickGridSize + 2u};
+            GridIndices.insert(GridIndices.end(), std::begin(Quad), std::end(Quad));
+        }
+    }
+    Picker Picking;
+    const uint32_t Grid = Picking.AddMesh(GridPositions.data(), GridIndices.data(), GridIndices.size() / 3u, &Jobs);
+    const std::vector<uint32_t> PickMeshes(PickObjects, Grid);
+    std::vector<Mat4> PickPlacements;
+    for (size_t i = 0; i < PickObjects; i++)
+    {
+        PickPlacements.push_back(Mat4::Translation(static_cast<float>(i % 4u) * 17.0f - 25.0f, static_cast<float>(i / 4u) * 3.0f, static_cast<float>(i / 4u) * 17.0f));
+    }
+    Picking.SetObjects(PickMeshes.data(), PickPlacements.data(), PickObjects, &Jobs);
+    const Mat4 PickCamera = Multiply(Mat4::LookAt({0.0f, 12.0f, -30.0f}, {0.0f, 0.0f, 10.0f}, {0.0f, 1.0f, 0.0f}), Mat4::Perspective(1.0f, 16.0f / 9.0f, 0.5f, 500.0f));
+    Measure(Report, "picking.mouse_pick", [&](size_t i)
+    {
+        Pointer.OnMouseMove(static_cast<int>((i * 37u) % 1280u), static_cast<int>((i * 53u) % 720u));
+        Sink = Sink + static_cast<size_t>(Picking.Pick(Picker::MouseRay(Pointer, 1280u, 720u, PickCamera)).State);
+    });
+}
\ No newline at end of file
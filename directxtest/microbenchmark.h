@@ -0,0 +1,160 @@
+#pragma once
+#include "benchmark.h"
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+class JobSystem;
+
+// CPU cost of the small paths that run for every input message, frame or error: the
+// keyboard and mouse queues, the frame timer, exception formatting and batch math.
+// Every case is a BenchmarkRun whose frames are batches of calls, so the report has the
+// usual layout and benchcompare reads it unchanged. Divide a frame time by BatchSize for one call.
+// The math.* cases process 256 elements per call with the native kernels, the 4-wide SSE
+// kernels and the scalar reference kernels. Native is AVX2 in the microbench build.
+// The hierarchy.* cases time one Update of a 100k or 1M node TransformHierarchy per
+// frame, with everything dirty or 0.1% of the leaves.
+// The entities.* cases iterate 100k or 1M entities per frame, or move and create 10k.
+// The arena.* cases make a frame's worth of mixed size allocations in a FrameArena and
+// on the heap, and grow a vector in the arena. Their peaks show the bytes padding and
+// abandoned vector storage cost on top of the payload.
+// The handles.* cases resolve, reject and recycle handles of a 100k object HandlePool.
+// The pipeline.* cases hash PSO descriptors and look them up among 256 cached ones.
+// The commands.* cases record 100k draws into command lists on 1, 2, 4... threads.
+// The culling.* cases test 1M bounding volumes against a frustum that keeps about 10%,
+// on the same three paths as math.*. The native AVX2 path packs kept lanes with one permute.
+// The lod.* cases cull the same spheres and pick a level of detail for the kept ones.
+// The occlusion.* cases rasterize 32 walls into a 320 x 184 depth buffer and test the
+// boxes that frustum kept against it.
+// The meshlet.* cases cull the meshlets of 64 tori of 131k triangles behind those walls,
+// by frustum and normal cone, and in the last case by the walls' depth buffer as well.
+// The bvh.* cases query, refit and build bounding volume hierarchies of 10k to 1M boxes.
+// The picking.* case moves the cursor and picks the triangle under it among 4M.
+//
+// Everything above only needs the portable modules and also builds as the microbench
+// console tool. The Direct3D error paths are Windows only and run from directxtest.
+class MicroBenchmark
+{
+public:
+    struct Settings
+    {
+        unsigned int Samples = 1000u;
+        unsigned int WarmupSamples = 100u;
+        unsigned int BatchSize = 1000u;
+        // The measuring thread stays on this core so migrations do not show up as outliers
+        unsigned int Core = 0u;
+        // Comma separated name prefixes of the cases to run, e.g. "math.,bvh.query", empty runs all
+        std::string Filter;
+        // Gets one line per case with the median and p99 time of a single call
+        std::ostream* Log = nullptr;
+    };
+public:
+    explicit MicroBenchmark(Settings Config);
+    void Run(BenchmarkReport& Report);
+#ifdef _WIN32
+    // exception.hr_what and dxerr.error_string, defined with Graphics in microbenchmark_win32.cpp
+    void RunErrorPaths(BenchmarkReport& Report);
+#endif
+    bool IsSelected(std::string_view Name) const noexcept;
+private:
+    // False when no selected case can start with Group, so its setup can be skipped
+    bool IsGroupSelected(std::string_view Group) const noexcept;
+    // Runs Cases on a thread of its own pinned to Settings::Core. The caller keeps its
+    // affinity, and threads it started before (job workers) are not confined to that core.
+    template<typename F>
+    void RunPinned(F&& Cases);
+    static void PinCurrentThread(unsigned int Core) noexcept;
+    // Calls per sample defaults to Settings::BatchSize. Returns the run, null when the
+    // case is not selected.
+    template<typename F>
+    BenchmarkRun* Measure(BenchmarkReport& Report, const std::string& Name, F&& Call, unsigned int Calls = 0u);
+    void RunInput(BenchmarkReport& Report);
+    void RunTimer(BenchmarkReport& Report);
+    void RunMath(BenchmarkReport& Report);
+    void RunHierarchy(BenchmarkReport& Report, JobSystem& Jobs);
+    void RunEntities(BenchmarkReport& Report, JobSystem& Jobs);
+    void RunArena(BenchmarkReport& Report);
+    void RunHandles(BenchmarkReport& Report);
+    void RunPipeline(BenchmarkReport& Report);
+    // One case per job system, the thread count is the name's suffix
+    void RunCommands(BenchmarkReport& Report, const std::vector<std::unique_ptr<JobSystem>>& Scaling);
+    // The culling, lod, occlusion and meshlet cases share one cloud of objects
+    void RunCulling(BenchmarkReport& Report, JobSystem& Jobs);
+    void RunBvh(BenchmarkReport& Report, JobSystem& Jobs);
+    void RunPicking(BenchmarkReport& Report, JobSystem& Jobs);
+private:
+    Settings Config;
+    std::vector<std::string> Prefixes;
+    // Results are folded in here so the optimizer cannot drop the calls
+    volatile size_t Sink = 0u;
+};
+
+template<typename F>
+void MicroBenchmark::RunPinned(F&& Cases)
+{
+    std::exception_ptr Error;
+    std::thread Measuring([&]()
+    {
+        PinCurrentThread(Config.Core);
+        try
+        {
+            Cases();
+        }
+        catch (...)
+        {
+            Error = std::current_exception();
+        }
+    });
+    Measuring.join();
+    if (Error)
+    {
+        std::rethrow_exception(Error);
+    }
+}
+
+template<typename F>
+BenchmarkRun* MicroBenchmark::Measure(BenchmarkReport& Report, const std::string& Name, F&& Call, unsigned int Calls)
+{
+    using namespace std::chrono;
+
+    if (!IsSelected(Name))
+    {
+        return nullptr;
+    }
+    const unsigned int Batch = Calls != 0u ? Calls : Config.BatchSize;
+    BenchmarkRun& Result = Report.AddRun(Name);
+    size_t Iteration = 0u;
+    for (unsigned int s = 0; s < Config.WarmupSamples + Config.Samples; s++)
+    {
+        // Allocations are attributed to the sample that made them
+        AllocTracker::EndFrame();
+
+        const auto Start = steady_clock::now();
+        for (unsigned int i = 0; i < Batch; i++)
+        {
+            Call(Iteration++);
+        }
+        const duration<float> Elapsed = steady_clock::now() - Start;
+
+        const AllocTracker::FrameStats Allocations = AllocTracker::EndFrame();
+        if (s >= Config.WarmupSamples)
+        {
+            Result.AddFrame(Elapsed.count(), Allocations);
+            Result.AddCounter("calls", Batch);
+        }
+    }
+
+    if (Config.Log)
+    {
+        const std::vector<double> Samples(Result.GetFrameTimes().begin(), Result.GetFrameTimes().end());
+        const BenchmarkRun::Distribution Times = BenchmarkRun::Summarize(Samples);
+        const double Nanoseconds = 1e9 / static_cast<double>(Batch);
+        *Config.Log << Name << ": " << Times.P50 * Nanoseconds << " ns p50, " << Times.P99 * Nanoseconds << " ns p99" << std::endl;
+    }
+    return &Result;
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#include "microbenchmark.h"
+#include "graphics.h"
+#include "dxerr.h"
+#include <cstring>
+#include <iterator>
+
+namespace
+{
+    // A mix of frequent codes and one the lookup does not know, which walks the whole table
+    constexpr HRESULT ErrorCodes[] =
+    {
+        E_FAIL,
+        E_INVALIDARG,
+        E_OUTOFMEMORY,
+        DXGI_ERROR_DEVICE_REMOVED,
+        DXGI_ERROR_DEVICE_HUNG,
+        DXGI_ERROR_INVALID_CALL,
+        D3D11_ERROR_FILE_NOT_FOUND,
+        static_cast<HRESULT>(0x8BADF00Du)
+    };
+}
+
+void MicroBenchmark::RunErrorPaths(BenchmarkReport& Report)
+{
+    RunPinned([&]()
+    {
+        const Graphics::HrException Hr(__LINE__, __FILE__, DXGI_ERROR_DEVICE_HUNG);
+        Measure(Report, "exception.hr_what", [&](size_t)
+        {
+            Sink = Sink + std::strlen(Hr.what());
+        });
+
+        Measure(Report, "dxerr.error_string", [&](size_t i)
+        {
+            Sink = Sink + std::strlen(DXGetErrorStringA(ErrorCodes[i % std::size(ErrorCodes)]));
+        });
+    });
+}
\ No newline at end of file
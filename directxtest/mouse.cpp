@@ -1,5 +1,10 @@
 #include "mouse.h"
+#ifdef _WIN32
 #include "win_include.h"
+#else
+// One notch of a standard wheel, as in the Win32 headers
+#define WHEEL_DELTA 120
+#endif
 
 std::pair<int,int> Mouse::GetPos() const noexcept
 {
@@ -0,0 +1,380 @@
+#include "occlusion.h"
+#include "simd_lanes.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    // Vertices this close to the camera plane are treated as crossing it
+    constexpr float MinW = 1e-5f;
+
+    // x + 0.5 for every lane, pixel centers of a row of lanes
+    constexpr float PixelCenters[8] = {0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f};
+
+    // Normalized device bounds of boxes given as center and half extent, one box per lane.
+    // MinW is the smallest w of the eight corners, the bounds are meaningless below 0.
+    template<typename L>
+    struct ProjectedBoxes
+    {
+        L MinX;
+        L MaxX;
+        L MinY;
+        L MaxY;
+        L MinZ;
+        L MinW;
+    };
+
+    template<typename L>
+    ProjectedBoxes<L> ProjectBoxes(const Mat4& M, L cx, L cy, L cz, L ex, L ey, L ez) noexcept
+    {
+        // Clip space center and half axes, each corner is the center plus or minus each axis
+        L Center[4];
+        L AxisX[4];
+        L AxisY[4];
+        L AxisZ[4];
+        for (size_t c = 0; c < 4u; c++)
+        {
+            Center[c] = cx * L::Set(M.M[0][c]) + cy * L::Set(M.M[1][c]) + cz * L::Set(M.M[2][c]) + L::Set(M.M[3][c]);
+            AxisX[c] = ex * L::Set(M.M[0][c]);
+            AxisY[c] = ey * L::Set(M.M[1][c]);
+            AxisZ[c] = ez * L::Set(M.M[2][c]);
+        }
+
+        ProjectedBoxes<L> Result;
+        for (uint32_t Corner = 0; Corner < 8u; Corner++)
+        {
+            L Clip[4];
+            for (size_t c = 0; c < 4u; c++)
+            {
+                Clip[c] = Center[c];
+                Clip[c] = (Corner & 1u) ? Clip[c] + AxisX[c] : Clip[c] - AxisX[c];
+                Clip[c] = (Corner & 2u) ? Clip[c] + AxisY[c] : Clip[c] - AxisY[c];
+                Clip[c] = (Corner & 4u) ? Clip[c] + AxisZ[c] : Clip[c] - AxisZ[c];
+            }
+            const L InvW = L::Set(1.0f) / Clip[3];
+            const L x = Clip[0] * InvW;
+            const L y = Clip[1] * InvW;
+            const L z = Clip[2] * InvW;
+            if (Corner == 0u)
+            {
+                Result = {x, x, y, y, z, Clip[3]};
+                continue;
+            }
+            Result.MinX = Min(Result.MinX, x);
+            Result.MaxX = Max(Result.MaxX, x);
+            Result.MinY = Min(Result.MinY, y);
+            Result.MaxY = Max(Result.MaxY, y);
+            Result.MinZ = Min(Result.MinZ, z);
+            Result.MinW = Min(Result.MinW, Clip[3]);
+        }
+        return Result;
+    }
+
+    int32_t ToPixel(float Value, uint32_t Size, bool RoundUp) noexcept
+    {
+        const float Clamped = std::clamp(Value, 0.0f, static_cast<float>(Size));
+        return static_cast<int32_t>(RoundUp ? std::ceil(Clamped) : std::floor(Clamped));
+    }
+}
+
+OcclusionBuffer::OcclusionBuffer(uint32_t Width, uint32_t Height)
+    : Width(Width), Height(Height), TilesX(Width / TileSize), TilesY(Height / TileSize), ViewProjection(Mat4::Identity())
+{
+    if (Width == 0u || Height == 0u || Width % TileSize != 0u || Height % TileSize != 0u)
+    {
+        throw std::invalid_argument("Occlusion buffer size must be a multiple of the tile size");
+    }
+    Depth.assign(static_cast<size_t>(Width) * Height, 1.0f);
+    TileMax.assign(static_cast<size_t>(TilesX) * TilesY, 1.0f);
+}
+
+void OcclusionBuffer::Begin(const Mat4& ViewProjection) noexcept
+{
+    this->ViewProjection = ViewProjection;
+    std::fill(Depth.begin(), Depth.end(), 1.0f);
+    std::fill(TileMax.begin(), TileMax.end(), 1.0f);
+    Occluders.clear();
+    Triangles.clear();
+}
+
+void OcclusionBuffer::AddOccluder(const Vec3* Positions, const uint32_t* Indices, size_t IndexCount, const Mat4& World)
+{
+    Occluders.push_back({Positions, Indices, IndexCount, Multiply(World, ViewProjection)});
+}
+
+void OcclusionBuffer::Rasterize(JobSystem* Jobs)
+{
+    Setup();
+    if (Jobs != nullptr)
+    {
+        Jobs->ParallelFor(TilesY, BandTiles, [&](size_t Begin, size_t End, unsigned int)
+        {
+            RasterizeBand(Begin, End);
+        });
+    }
+    else
+    {
+        RasterizeBand(0u, TilesY);
+    }
+}
+
+bool OcclusionBuffer::IsOccluded(const Vec3& Min, const Vec3& Max) const noexcept
+{
+    using L = ScalarLanes;
+    const Vec3 Center = (Min + Max) * 0.5f;
+    const Vec3 Extent = (Max - Min) * 0.5f;
+    const ProjectedBoxes<L> Box = ProjectBoxes(ViewProjection,
+        L::Set(Center.X), L::Set(Center.Y), L::Set(Center.Z), L::Set(Extent.X), L::Set(Extent.Y), L::Set(Extent.Z));
+    return Box.MinW.v > MinW && IsRectOccluded(Box.MinX.v, Box.MaxX.v, Box.MinY.v, Box.MaxY.v, Box.MinZ.v);
+}
+
+size_t OcclusionBuffer::CullBoxes(const BoxStreams& Boxes, const uint32_t* Candidates, size_t Count, uint32_t* Visible, JobSystem* Jobs)
+{
+    if (Jobs == nullptr || Count <= Grain)
+    {
+        return CullSlice(Boxes, Candidates, 0u, Count, Visible);
+    }
+
+    SliceCounts.assign((Count + Grain - 1u) / Grain, 0u);
+    Jobs->ParallelFor(Count, Grain, [&](size_t Begin, size_t End, unsigned int)
+    {
+        SliceCounts[Begin / Grain] = CullSlice(Boxes, Candidates, Begin, End, Visible);
+    });
+
+    // Slice k was written at k * Grain, close the gaps between them
+    size_t n = SliceCounts[0];
+    for (size_t k = 1; k < SliceCounts.size(); k++)
+    {
+        std::memmove(Visible + n, Visible + k * Grain, SliceCounts[k] * sizeof(uint32_t));
+        n += SliceCounts[k];
+    }
+    return n;
+}
+
+uint32_t OcclusionBuffer::GetWidth() const noexcept
+{
+    return Width;
+}
+
+uint32_t OcclusionBuffer::GetHeight() const noexcept
+{
+    return Height;
+}
+
+const float* OcclusionBuffer::GetDepth() const noexcept
+{
+    return Depth.data();
+}
+
+size_t OcclusionBuffer::GetTriangleCount() const noexcept
+{
+    return Triangles.size();
+}
+
+void OcclusionBuffer::Setup()
+{
+    Triangles.clear();
+    for (const Occluder& o : Occluders)
+    {
+        for (size_t i = 0; i + 2u < o.IndexCount; i += 3u)
+        {
+            const auto ToClip = [&](uint32_t Index)
+            {
+                const Vec3& p = o.Positions[Index];
+                return Transform(Vec4{p.X, p.Y, p.Z, 1.0f}, o.Transform);
+            };
+            SetupTriangle(ToClip(o.Indices[i]), ToClip(o.Indices[i + 1u]), ToClip(o.Indices[i + 2u]));
+        }
+    }
+}
+
+void OcclusionBuffer::SetupTriangle(const Vec4& v0, const Vec4& v1, const Vec4& v2)
+{
+    if (v0.W <= MinW || v1.W <= MinW || v2.W <= MinW)
+    {
+        return;
+    }
+    const auto ToScreen = [&](const Vec4& v)
+    {
+        const float InvW = 1.0f / v.W;
+        return Vec3{(v.X * InvW * 0.5f + 0.5f) * Width, (0.5f - v.Y * InvW * 0.5f) * Height, v.Z * InvW};
+    };
+    const Vec3 p0 = ToScreen(v0);
+    Vec3 p1 = ToScreen(v1);
+    Vec3 p2 = ToScreen(v2);
+
+    // Occluders hide from both sides, so flip clockwise triangles instead of culling them
+    float Area = (p1.X - p0.X) * (p2.Y - p0.Y) - (p1.Y - p0.Y) * (p2.X - p0.X);
+    if (Area < 0.0f)
+    {
+        std::swap(p1, p2);
+        Area = -Area;
+    }
+    if (!(Area > 1e-6f))
+    {
+        return;
+    }
+
+    Triangle t;
+    t.MinX = ToPixel(std::min({p0.X, p1.X, p2.X}), Width, false);
+    t.MaxX = ToPixel(std::max({p0.X, p1.X, p2.X}), Width, true);
+    t.MinY = ToPixel(std::min({p0.Y, p1.Y, p2.Y}), Height, false);
+    t.MaxY = ToPixel(std::max({p0.Y, p1.Y, p2.Y}), Height, true);
+    if (t.MinX >= t.MaxX || t.MinY >= t.MaxY || std::min({p0.Z, p1.Z, p2.Z}) > 1.0f)
+    {
+        return;
+    }
+
+    // Edge i is opposite vertex i: cross(b - a, p - a), positive inside. Moving the edge
+    // inward by half a pixel leaves only pixels the triangle covers entirely.
+    const auto Edge = [&](size_t i, const Vec3& a, const Vec3& b)
+    {
+        const float dx = b.X - a.X;
+        const float dy = b.Y - a.Y;
+        t.A[i] = -dy;
+        t.B[i] = dx;
+        t.C[i] = dy * a.X - dx * a.Y - 0.5f * (std::fabs(dx) + std::fabs(dy));
+    };
+    Edge(0u, p1, p2);
+    Edge(1u, p2, p0);
+    Edge(2u, p0, p1);
+
+    // Depth is linear in screen space after the divide. Moving the plane by half a pixel
+    // along each gradient gives the farthest depth anywhere in the pixel.
+    const float InvArea = 1.0f / Area;
+    t.DzDx = ((p1.Z - p0.Z) * (p2.Y - p0.Y) - (p2.Z - p0.Z) * (p1.Y - p0.Y)) * InvArea;
+    t.DzDy = ((p2.Z - p0.Z) * (p1.X - p0.X) - (p1.Z - p0.Z) * (p2.X - p0.X)) * InvArea;
+    t.Z0 = p0.Z - t.DzDx * p0.X - t.DzDy * p0.Y + 0.5f * (std::fabs(t.DzDx) + std::fabs(t.DzDy));
+    t.MaxZ = std::max({p0.Z, p1.Z, p2.Z});
+    Triangles.push_back(t);
+}
+
+void OcclusionBuffer::RasterizeBand(size_t FirstTileRow, size_t EndTileRow) noexcept
+{
+    const int32_t BandBegin = static_cast<int32_t>(FirstTileRow * TileSize);
+    const int32_t BandEnd = static_cast<int32_t>(EndTileRow * TileSize);
+    for (const Triangle& t : Triangles)
+    {
+        const int32_t RowBegin = std::max(t.MinY, BandBegin);
+        const int32_t RowEnd = std::min(t.MaxY, BandEnd);
+        for (int32_t y = RowBegin; y < RowEnd; y++)
+        {
+            // Edge and depth values at x = 0 of this row
+            const float py = static_cast<float>(y) + 0.5f;
+            const float Row0 = t.B[0] * py + t.C[0];
+            const float Row1 = t.B[1] * py + t.C[1];
+            const float Row2 = t.B[2] * py + t.C[2];
+            const float RowZ = t.DzDy * py + t.Z0;
+            float* const Line = Depth.data() + static_cast<size_t>(y) * Width + t.MinX;
+            ForEachLane(static_cast<size_t>(t.MaxX - t.MinX), MathPath::Native, [&](auto Tag, size_t i)
+            {
+                using L = decltype(Tag);
+                const L px = L::Load(PixelCenters) + L::Set(static_cast<float>(t.MinX + static_cast<int32_t>(i)));
+                const L e0 = px * L::Set(t.A[0]) + L::Set(Row0);
+                const L e1 = px * L::Set(t.A[1]) + L::Set(Row1);
+                const L e2 = px * L::Set(t.A[2]) + L::Set(Row2);
+                const L z = Min(px * L::Set(t.DzDx) + L::Set(RowZ), L::Set(t.MaxZ));
+                const L Old = L::Load(Line + i);
+                SelectGreater(Min(Min(e0, e1), e2), L::Set(0.0f), Min(Old, z), Old).Store(Line + i);
+            });
+        }
+    }
+
+    // Farthest depth of every tile in the band
+    for (size_t ty = FirstTileRow; ty < EndTileRow; ty++)
+    {
+        for (size_t tx = 0; tx < TilesX; tx++)
+        {
+            float Farthest = 0.0f;
+            for (size_t y = ty * TileSize; y < (ty + 1u) * TileSize; y++)
+            {
+                const float* Row = Depth.data() + y * Width + tx * TileSize;
+                Farthest = std::max(Farthest, *std::max_element(Row, Row + TileSize));
+            }
+            TileMax[ty * TilesX + tx] = Farthest;
+        }
+    }
+}
+
+size_t OcclusionBuffer::CullSlice(const BoxStreams& Boxes, const uint32_t* Candidates, size_t Begin, size_t End, uint32_t* Visible) const noexcept
+{
+    size_t n = Begin;
+    ForEachLane(End - Begin, MathPath::Native, [&](auto Tag, size_t i)
+    {
+        using L = decltype(Tag);
+        // Gather the group's boxes, every index is read before Visible is written
+        alignas(32) uint32_t Index[L::Width];
+        alignas(32) float Values[6][L::Width];
+        for (size_t j = 0; j < L::Width; j++)
+        {
+            const uint32_t Object = Index[j] = Candidates[Begin + i + j];
+            Values[0][j] = Boxes.CenterX[Object];
+            Values[1][j] = Boxes.CenterY[Object];
+            Values[2][j] = Boxes.CenterZ[Object];
+            Values[3][j] = Boxes.ExtentX[Object];
+            Values[4][j] = Boxes.ExtentY[Object];
+            Values[5][j] = Boxes.ExtentZ[Object];
+        }
+        const ProjectedBoxes<L> Box = ProjectBoxes(ViewProjection,
+            L::Load(Values[0]), L::Load(Values[1]), L::Load(Values[2]), L::Load(Values[3]), L::Load(Values[4]), L::Load(Values[5]));
+
+        alignas(32) float Bounds[6][L::Width];
+        Box.MinX.Store(Bounds[0]);
+        Box.MaxX.Store(Bounds[1]);
+        Box.MinY.Store(Bounds[2]);
+        Box.MaxY.Store(Bounds[3]);
+        Box.MinZ.Store(Bounds[4]);
+        Box.MinW.Store(Bounds[5]);
+        for (size_t j = 0; j < L::Width; j++)
+        {
+            const bool Occluded = Bounds[5][j] > MinW && IsRectOccluded(Bounds[0][j], Bounds[1][j], Bounds[2][j], Bounds[3][j], Bounds[4][j]);
+            Visible[n] = Index[j];
+            n += Occluded ? 0u : 1u;
+        }
+    });
+    return n - Begin;
+}
+
+bool OcclusionBuffer::IsRectOccluded(float MinX, float MaxX, float MinY, float MaxY, float MinZ) const noexcept
+{
+    // Every pixel the rectangle touches, y flips from device to screen
+    const int32_t x0 = ToPixel((MinX * 0.5f + 0.5f) * Width, Width, false);
+    const int32_t x1 = ToPixel((MaxX * 0.5f + 0.5f) * Width, Width, true);
+    const int32_t y0 = ToPixel((0.5f - MaxY * 0.5f) * Height, Height, false);
+    const int32_t y1 = ToPixel((0.5f - MinY * 0.5f) * Height, Height, true);
+    if (x0 >= x1 || y0 >= y1)
+    {
+        // Off screen, that is for the frustum test to decide
+        return false;
+    }
+
+    for (int32_t ty = y0 / static_cast<int32_t>(TileSize); ty <= (y1 - 1) / static_cast<int32_t>(TileSize); ty++)
+    {
+        for (int32_t tx = x0 / static_cast<int32_t>(TileSize); tx <= (x1 - 1) / static_cast<int32_t>(TileSize); tx++)
+        {
+            if (TileMax[static_cast<size_t>(ty) * TilesX + tx] < MinZ)
+            {
+                continue;
+            }
+            // The tile has something farther, look at the covered pixels themselves
+            const int32_t px0 = std::max(x0, tx * static_cast<int32_t>(TileSize));
+            const int32_t px1 = std::min(x1, (tx + 1) * static_cast<int32_t>(TileSize));
+            const int32_t py0 = std::max(y0, ty * static_cast<int32_t>(TileSize));
+            const int32_t py1 = std::min(y1, (ty + 1) * static_cast<int32_t>(TileSize));
+            for (int32_t y = py0; y < py1; y++)
+            {
+                const float* Row = Depth.data() + static_cast<size_t>(y) * Width;
+                for (int32_t x = px0; x < px1; x++)
+                {
+                    if (Row[x] >= MinZ)
+                    {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+#pragma once
+#include "simd_math.h"
+#include "culling.h"
+#include "job_system.h"
+#include <cstdint>
+#include <vector>
+
+// Low resolution software depth buffer for occlusion culling. Selected occluder meshes
+// are rasterized on the CPU keeping the nearest depth per pixel, and every TileSize x
+// TileSize tile keeps the farthest depth of its pixels. A box is occluded when its
+// nearest point lies behind everything rasterized over the pixels it covers; most boxes
+// are decided by the tiles alone. Depth follows D3D, 0 is near and 1 is far.
+//
+// Everything errs on the side of visible: pixels count as covered only when a single
+// triangle covers all of them, occluder depth is taken at the far corner of each pixel, and
+// triangles or boxes that cross the camera plane never occlude or get occluded.
+class OcclusionBuffer
+{
+public:
+    static constexpr uint32_t TileSize = 8u;
+    // Tile rows per rasterization job
+    static constexpr size_t BandTiles = 4u;
+    // Boxes per job in CullBoxes
+    static constexpr size_t Grain = 4096u;
+public:
+    // Width and Height must be non-zero multiples of TileSize
+    OcclusionBuffer(uint32_t Width, uint32_t Height);
+
+    // Clears the buffer and the occluder list for a new camera
+    void Begin(const Mat4& ViewProjection) noexcept;
+    // Triangle list in object space. The arrays are read by Rasterize and must stay valid until then.
+    void AddOccluder(const Vec3* Positions, const uint32_t* Indices, size_t IndexCount, const Mat4& World);
+    // Rasterizes every occluder added since Begin, in horizontal bands over the job
+    // system, or serially when Jobs is null
+    void Rasterize(JobSystem* Jobs = nullptr);
+
+    bool IsOccluded(const Vec3& Min, const Vec3& Max) const noexcept;
+    // Keeps the candidates whose box is not occluded, in order. Visible may be Candidates.
+    // Without Jobs it only reads the buffer, so several threads may call it at once.
+    size_t CullBoxes(const BoxStreams& Boxes, const uint32_t* Candidates, size_t Count, uint32_t* Visible, JobSystem* Jobs = nullptr);
+
+    uint32_t GetWidth() const noexcept;
+    uint32_t GetHeight() const noexcept;
+    // Row-major, Width x Height
+    const float* GetDepth() const noexcept;
+    // Triangles that reached the rasterizer in the last Rasterize
+    size_t GetTriangleCount() const noexcept;
+private:
+    struct Occluder
+    {
+        const Vec3* Positions;
+        const uint32_t* Indices;
+        size_t IndexCount;
+        Mat4 Transform;
+    };
+    // Screen space triangle, edge functions A x + B y + C are positive inside
+    struct Triangle
+    {
+        float A[3];
+        float B[3];
+        float C[3];
+        // Depth plane Z0 + DzDx x + DzDy y, already moved to the far corner of a pixel
+        float Z0;
+        float DzDx;
+        float DzDy;
+        float MaxZ;
+        // Pixel bounds, the maxima exclusive
+        int32_t MinX;
+        int32_t MaxX;
+        int32_t MinY;
+        int32_t MaxY;
+    };
+private:
+    void Setup();
+    void SetupTriangle(const Vec4& v0, const Vec4& v1, const Vec4& v2);
+    void RasterizeBand(size_t FirstTileRow, size_t EndTileRow) noexcept;
+    // Visible candidates of [Begin, End) packed at Visible + Begin
+    size_t CullSlice(const BoxStreams& Boxes, const uint32_t* Candidates, size_t Begin, size_t End, uint32_t* Visible) const noexcept;
+    // Normalized device rectangle and nearest depth of a projected box
+    bool IsRectOccluded(float MinX, float MaxX, float MinY, float MaxY, float MinZ) const noexcept;
+private:
+    uint32_t Width;
+    uint32_t Height;
+    uint32_t TilesX;
+    uint32_t TilesY;
+    Mat4 ViewProjection;
+    std::vector<float> Depth;
+    std::vector<float> TileMax;
+    std::vector<Occluder> Occluders;
+    std::vector<Triangle> Triangles;
+    std::vector<size_t> SliceCounts;
+};
\ No newline at end of file
@@ -0,0 +1,287 @@
+#include "picking.h"
+#include "simd_lanes.h"
+#include "tsc_clock.h"
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+namespace
+{
+    constexpr float Infinity = std::numeric_limits<float>::infinity();
+    // Smaller determinants mean the ray runs along the triangle's plane
+    constexpr float MinDeterminant = 1e-30f;
+
+#if defined(SIMD_MATH_AVX2) || defined(SIMD_MATH_SSE)
+    using TriangleLanes = SseLanes;
+#else
+    using TriangleLanes = ScalarLanes;
+#endif
+
+    // The triangles of one leaf as component arrays, unused entries stay degenerate
+    struct TrianglePack
+    {
+        float OriginX[Bvh::LeafSize];
+        float OriginY[Bvh::LeafSize];
+        float OriginZ[Bvh::LeafSize];
+        float Edge1X[Bvh::LeafSize];
+        float Edge1Y[Bvh::LeafSize];
+        float Edge1Z[Bvh::LeafSize];
+        float Edge2X[Bvh::LeafSize];
+        float Edge2Y[Bvh::LeafSize];
+        float Edge2Z[Bvh::LeafSize];
+    };
+
+    // Moller-Trumbore on every triangle of the pack at once, both sides count. Returns the
+    // pack entry of the nearest hit closer than Nearest and moves Nearest to it, or
+    // LeafSize when there is none.
+    template<typename L>
+    uint32_t IntersectPack(const TrianglePack& p, const Vec3& Origin, const Vec3& Direction, float& Nearest) noexcept
+    {
+        const L Dx = L::Set(Direction.X);
+        const L Dy = L::Set(Direction.Y);
+        const L Dz = L::Set(Direction.Z);
+        const L Zero = L::Set(0.0f);
+        const L One = L::Set(1.0f);
+        uint32_t Closest = Bvh::LeafSize;
+        for (size_t i = 0; i < Bvh::LeafSize; i += L::Width)
+        {
+            const L E1x = L::Load(p.Edge1X + i);
+            const L E1y = L::Load(p.Edge1Y + i);
+            const L E1z = L::Load(p.Edge1Z + i);
+            const L E2x = L::Load(p.Edge2X + i);
+            const L E2y = L::Load(p.Edge2Y + i);
+            const L E2z = L::Load(p.Edge2Z + i);
+
+            // P = D x E2, the determinant is E1 . P
+            const L Px = Dy * E2z - Dz * E2y;
+            const L Py = Dz * E2x - Dx * E2z;
+            const L Pz = Dx * E2y - Dy * E2x;
+            const L Determinant = E1x * Px + E1y * Py + E1z * Pz;
+            const L MinimumDet = L::Set(MinDeterminant);
+            const L Inverse = One / SelectGreater(Abs(Determinant), MinimumDet, Determinant, One);
+
+            // Barycentrics of the point where the ray meets the plane
+            const L Tx = L::Set(Origin.X) - L::Load(p.OriginX + i);
+            const L Ty = L::Set(Origin.Y) - L::Load(p.OriginY + i);
+            const L Tz = L::Set(Origin.Z) - L::Load(p.OriginZ + i);
+            const L U = (Tx * Px + Ty * Py + Tz * Pz) * Inverse;
+            const L Qx = Ty * E1z - Tz * E1y;
+            const L Qy = Tz * E1x - Tx * E1z;
+            const L Qz = Tx * E1y - Ty * E1x;
+            const L V = (Dx * Qx + Dy * Qy + Dz * Qz) * Inverse;
+            const L t = (E2x * Qx + E2y * Qy + E2z * Qz) * Inverse;
+
+            uint32_t Mask = MaskGreaterEqual(Abs(Determinant), MinimumDet);
+            Mask &= MaskGreaterEqual(U, Zero) & MaskGreaterEqual(V, Zero) & MaskGreaterEqual(One, U + V);
+            Mask &= MaskGreaterEqual(t, Zero) & MaskGreaterEqual(L::Set(Nearest), t);
+            if (Mask == 0u)
+            {
+                continue;
+            }
+            float Distances[L::Width];
+            t.Store(Distances);
+            for (; Mask != 0u; Mask &= Mask - 1u)
+            {
+                const uint32_t Lane = static_cast<uint32_t>(std::countr_zero(Mask));
+                if (Distances[Lane] < Nearest)
+                {
+                    Nearest = Distances[Lane];
+                    Closest = static_cast<uint32_t>(i) + Lane;
+                }
+            }
+        }
+        return Closest;
+    }
+}
+
+Ray Picker::ScreenRay(float X, float Y, uint32_t Width, uint32_t Height, const Mat4& ViewProjection) noexcept
+{
+    const float NdcX = X / static_cast<float>(Width) * 2.0f - 1.0f;
+    const float NdcY = 1.0f - Y / static_cast<float>(Height) * 2.0f;
+    const Mat4 ToWorld = Inverse(ViewProjection);
+    const Vec4 Near = Transform({NdcX, NdcY, 0.0f, 1.0f}, ToWorld);
+    const Vec4 Far = Transform({NdcX, NdcY, 1.0f, 1.0f}, ToWorld);
+    const Vec3 NearPoint = {Near.X / Near.W, Near.Y / Near.W, Near.Z / Near.W};
+    const Vec3 FarPoint = {Far.X / Far.W, Far.Y / Far.W, Far.Z / Far.W};
+    return {NearPoint, Normalize(FarPoint - NearPoint)};
+}
+
+Ray Picker::MouseRay(const Mouse& Pointer, uint32_t Width, uint32_t Height, const Mat4& ViewProjection) noexcept
+{
+    const auto [X, Y] = Pointer.GetPos();
+    return ScreenRay(static_cast<float>(X) + 0.5f, static_cast<float>(Y) + 0.5f, Width, Height, ViewProjection);
+}
+
+uint32_t Picker::AddMesh(const Vec3* Positions, const uint32_t* Indices, size_t TriangleCount, JobSystem* Jobs)
+{
+    Mesh Added;
+    Added.Triangles.resize(TriangleCount);
+    std::vector<Bvh::Box> Bounds(TriangleCount);
+    Added.Bounds = {{Infinity, Infinity, Infinity}, {-Infinity, -Infinity, -Infinity}};
+    for (size_t i = 0; i < TriangleCount; i++)
+    {
+        const Vec3& a = Positions[Indices[3u * i]];
+        const Vec3& b = Positions[Indices[3u * i + 1u]];
+        const Vec3& c = Positions[Indices[3u * i + 2u]];
+        Added.Triangles[i] = {a, b - a, c - a};
+        Bounds[i] = {Min(Min(a, b), c), Max(Max(a, b), c)};
+        Added.Bounds = {Min(Added.Bounds.Min, Bounds[i].Min), Max(Added.Bounds.Max, Bounds[i].Max)};
+    }
+    Added.Tree.Build(Bounds.data(), TriangleCount, Jobs);
+    Meshes.push_back(std::move(Added));
+    State = Progress::Idle;
+    return static_cast<uint32_t>(Meshes.size() - 1u);
+}
+
+void Picker::SetObjects(const uint32_t* MeshOf, const Mat4* World, size_t Count, JobSystem* Jobs)
+{
+    if (std::any_of(MeshOf, MeshOf + Count, [&](uint32_t m) { return m >= Meshes.size(); }))
+    {
+        throw std::invalid_argument("Unknown mesh");
+    }
+    Objects.resize(Count);
+    ObjectBounds.resize(Count);
+    for (size_t i = 0; i < Count; i++)
+    {
+        PlaceObject(static_cast<uint32_t>(i), MeshOf[i], World[i]);
+    }
+    ObjectTree.Build(ObjectBounds.data(), Count, Jobs);
+    State = Progress::Idle;
+}
+
+void Picker::MoveObjects(const uint32_t* Moved, const Mat4* World, size_t Count)
+{
+    for (size_t i = 0; i < Count; i++)
+    {
+        PlaceObject(Moved[i], Objects[Moved[i]].MeshIndex, World[i]);
+    }
+    ObjectTree.Refit(ObjectBounds.data(), Moved, Count);
+    State = Progress::Idle;
+}
+
+Picker::Result Picker::Pick(const Ray& r, double Budget) noexcept
+{
+    const bool SameRay = State != Progress::Idle &&
+        r.Origin.X == Current.Origin.X && r.Origin.Y == Current.Origin.Y && r.Origin.Z == Current.Origin.Z &&
+        r.Direction.X == Current.Direction.X && r.Direction.Y == Current.Direction.Y && r.Direction.Z == Current.Direction.Z;
+    if (!SameRay)
+    {
+        State = Progress::Walking;
+        Current = r;
+        ObjectTree.BeginRay(ObjectWalk, r.Origin, r.Direction, Infinity);
+        LeafCount = 0u;
+        NextInLeaf = 0u;
+        InObject = false;
+        Found = false;
+    }
+
+    const double BudgetTicks = Budget * TscClock::GetFrequency();
+    const uint64_t Start = TscClock::Now();
+    const uint64_t Deadline = BudgetTicks < 1e18 ? Start + static_cast<uint64_t>(std::max(BudgetTicks, 0.0)) : ~uint64_t(0u);
+    uint32_t Leaves = 0u;
+    while (State == Progress::Walking)
+    {
+        if (InObject)
+        {
+            uint32_t Candidates[Bvh::LeafSize];
+            const size_t Count = Meshes[Objects[CurrentObject].MeshIndex].Tree.NextLeaf(TriangleWalk, Candidates);
+            InObject = Count > 0u;
+            if (InObject)
+            {
+                TestLeaf(Candidates, Count);
+            }
+        }
+        else if (NextInLeaf < LeafCount)
+        {
+            EnterObject(Leaf[NextInLeaf++]);
+            continue;
+        }
+        else
+        {
+            LeafCount = ObjectTree.NextLeaf(ObjectWalk, Leaf);
+            NextInLeaf = 0u;
+            State = LeafCount > 0u ? Progress::Walking : Progress::Done;
+        }
+        if (State == Progress::Walking && ++Leaves % LeavesPerCheck == 0u && TscClock::Now() >= Deadline)
+        {
+            return {Status::Pending, {}};
+        }
+    }
+    return {Found ? Status::Hit : Status::Miss, Nearest};
+}
+
+size_t Picker::GetObjectCount() const noexcept
+{
+    return Objects.size();
+}
+
+size_t Picker::GetTriangleCount() const noexcept
+{
+    size_t Count = 0u;
+    for (const Object& o : Objects)
+    {
+        Count += Meshes[o.MeshIndex].Triangles.size();
+    }
+    return Count;
+}
+
+void Picker::PlaceObject(uint32_t o, uint32_t MeshIndex, const Mat4& World) noexcept
+{
+    Objects[o] = {MeshIndex, Inverse(World)};
+    const Bvh::Box& Local = Meshes[MeshIndex].Bounds;
+    if (Meshes[MeshIndex].Triangles.empty())
+    {
+        // Nothing to hit, a point keeps the tree's boxes finite
+        const Vec3 Position = TransformPoint({0.0f, 0.0f, 0.0f}, World);
+        ObjectBounds[o] = {Position, Position};
+        return;
+    }
+    Bvh::Box Bounds = {{Infinity, Infinity, Infinity}, {-Infinity, -Infinity, -Infinity}};
+    for (uint32_t Corner = 0; Corner < 8u; Corner++)
+    {
+        const Vec3 p = {(Corner & 1u) ? Local.Max.X : Local.Min.X, (Corner & 2u) ? Local.Max.Y : Local.Min.Y, (Corner & 4u) ? Local.Max.Z : Local.Min.Z};
+        const Vec3 Placed = TransformPoint(p, World);
+        Bounds = {Min(Bounds.Min, Placed), Max(Bounds.Max, Placed)};
+    }
+    ObjectBounds[o] = Bounds;
+}
+
+void Picker::EnterObject(uint32_t o) noexcept
+{
+    // The direction is not normalized in object space, so distances stay in world units
+    const Object& Entered = Objects[o];
+    CurrentObject = o;
+    LocalOrigin = TransformPoint(Current.Origin, Entered.ToObject);
+    LocalDirection = TransformDirection(Current.Direction, Entered.ToObject);
+    Meshes[Entered.MeshIndex].Tree.BeginRay(TriangleWalk, LocalOrigin, LocalDirection, ObjectWalk.MaxDistance);
+    InObject = true;
+}
+
+void Picker::TestLeaf(const uint32_t* Candidates, size_t Count) noexcept
+{
+    const std::vector<Triangle>& Triangles = Meshes[Objects[CurrentObject].MeshIndex].Triangles;
+    TrianglePack Pack = {};
+    for (size_t i = 0; i < Count; i++)
+    {
+        const Triangle& t = Triangles[Candidates[i]];
+        Pack.OriginX[i] = t.Origin.X;
+        Pack.OriginY[i] = t.Origin.Y;
+        Pack.OriginZ[i] = t.Origin.Z;
+        Pack.Edge1X[i] = t.Edge1.X;
+        Pack.Edge1Y[i] = t.Edge1.Y;
+        Pack.Edge1Z[i] = t.Edge1.Z;
+        Pack.Edge2X[i] = t.Edge2.X;
+        Pack.Edge2Y[i] = t.Edge2.Y;
+        Pack.Edge2Z[i] = t.Edge2.Z;
+    }
+    float Distance = TriangleWalk.MaxDistance;
+    const uint32_t Closest = IntersectPack<TriangleLanes>(Pack, LocalOrigin, LocalDirection, Distance);
+    if (Closest < Count)
+    {
+        Found = true;
+        Nearest = {CurrentObject, Candidates[Closest], Distance};
+        // Both walks now skip everything behind the hit
+        TriangleWalk.MaxDistance = Distance;
+        ObjectWalk.MaxDistance = Distance;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+#pragma once
+#include "simd_math.h"
+#include "bvh.h"
+#include "mouse.h"
+#include "job_system.h"
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// World space ray, Direction is unit length so distances along it are world units
+struct Ray
+{
+    Vec3 Origin;
+    Vec3 Direction;
+};
+
+// Finds the nearest triangle under a ray in a scene of triangle mesh instances. Every mesh
+// has a BVH over its triangles and the objects placing the meshes have one over their
+// world boxes. A pick walks the object tree nearest box first, walks the mesh of every
+// object it reaches with the ray moved into object space, and tests the four triangles of
+// a leaf together. Each hit shortens the ray, which prunes the rest of both walks.
+//
+// Picks stop when their time budget runs out and report Pending, and the next pick of the
+// same ray carries on where the last one stopped. A finished pick is kept until the ray or
+// the scene changes, so picking the same ray every frame only costs the comparison.
+class Picker
+{
+public:
+    struct Hit
+    {
+        uint32_t Object;
+        // Triangle of the object's mesh
+        uint32_t Triangle;
+        float Distance;
+    };
+    enum class Status
+    {
+        Hit,
+        Miss,
+        // Out of time, pick the same ray again to continue
+        Pending
+    };
+    struct Result
+    {
+        Status State;
+        // Valid when State is Hit
+        Hit Nearest;
+    };
+public:
+    // Ray from the near plane through a point in pixels, from the top left corner
+    static Ray ScreenRay(float X, float Y, uint32_t Width, uint32_t Height, const Mat4& ViewProjection) noexcept;
+    // Ray through the center of the pixel under the cursor
+    static Ray MouseRay(const Mouse& Pointer, uint32_t Width, uint32_t Height, const Mat4& ViewProjection) noexcept;
+
+    // Triangle list in object space. The picker keeps its own copy of the triangles,
+    // returns the mesh index SetObjects refers to.
+    uint32_t AddMesh(const Vec3* Positions, const uint32_t* Indices, size_t TriangleCount, JobSystem* Jobs = nullptr);
+    // Object i shows mesh MeshOf[i] placed by World[i]. Rebuilds the object tree.
+    void SetObjects(const uint32_t* MeshOf, const Mat4* World, size_t Count, JobSystem* Jobs = nullptr);
+    // Places object Moved[i] by World[i] and refits the object tree
+    void MoveObjects(const uint32_t* Moved, const Mat4* World, size_t Count);
+
+    // Budget is in seconds. It is checked every few leaves, so a pick always makes progress.
+    Result Pick(const Ray& r, double Budget = std::numeric_limits<double>::infinity()) noexcept;
+
+    size_t GetObjectCount() const noexcept;
+    // Triangles over all objects
+    size_t GetTriangleCount() const noexcept;
+private:
+    // Leaves between clock reads
+    static constexpr uint32_t LeavesPerCheck = 16u;
+    // First vertex and the two edges from it, what the intersection test reads
+    struct Triangle
+    {
+        Vec3 Origin;
+        Vec3 Edge1;
+        Vec3 Edge2;
+    };
+    struct Mesh
+    {
+        std::vector<Triangle> Triangles;
+        Bvh Tree;
+        Bvh::Box Bounds;
+    };
+    struct Object
+    {
+        uint32_t MeshIndex;
+        Mat4 ToObject;
+    };
+    enum class Progress
+    {
+        Idle,
+        Walking,
+        Done
+    };
+private:
+    void PlaceObject(uint32_t o, uint32_t MeshIndex, const Mat4& World) noexcept;
+    // Starts the walk of the next object in the current object leaf
+    void EnterObject(uint32_t o) noexcept;
+    // Tests the triangles of one mesh leaf against the ray in object space
+    void TestLeaf(const uint32_t* Candidates, size_t Count) noexcept;
+private:
+    std::vector<Mesh> Meshes;
+    std::vector<Object> Objects;
+    std::vector<Bvh::Box> ObjectBounds;
+    Bvh ObjectTree;
+
+    // Pick in progress or done
+    Progress State = Progress::Idle;
+    Ray Current = {};
+    Bvh::RayWalk ObjectWalk;
+    Bvh::RayWalk TriangleWalk;
+    uint32_t Leaf[Bvh::LeafSize] = {};
+    size_t LeafCount = 0u;
+    size_t NextInLeaf = 0u;
+    // Object whose mesh is being walked, and the ray in its space
+    bool InObject = false;
+    uint32_t CurrentObject = 0u;
+    Vec3 LocalOrigin = {};
+    Vec3 LocalDirection = {};
+    bool Found = false;
+    Hit Nearest = {};
+};
\ No newline at end of file
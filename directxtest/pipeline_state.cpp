@@ -0,0 +1,124 @@
+#include "pipeline_state.h"
+
+uint64_t HashPipelineState(const PipelineStateDesc& Desc) noexcept
+{
+    // FNV-1a over the fields, the struct itself has padding
+    uint64_t Hash = 14695981039346656037ull;
+    auto Mix = [&Hash](uint32_t Value)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            Hash ^= (Value >> (i * 8)) & 0xFFu;
+            Hash *= 1099511628211ull;
+        }
+    };
+
+    Mix(Desc.VertexShader.Value);
+    Mix(Desc.PixelShader.Value);
+    Mix(Desc.InputLayout.Value);
+    Mix(static_cast<uint32_t>(Desc.PrimitiveTopology) |
+        static_cast<uint32_t>(Desc.Blend) << 8 |
+        static_cast<uint32_t>(Desc.Cull) << 16 |
+        static_cast<uint32_t>(Desc.Fill) << 24);
+    Mix(static_cast<uint32_t>(Desc.Depth) |
+        static_cast<uint32_t>(Desc.Sampler) << 8);
+    return Hash;
+}
+
+PipelineStateCache::PipelineStateCache(size_t InitialCapacity)
+{
+    size_t Capacity = 8u;
+    while (Capacity < InitialCapacity)
+    {
+        Capacity *= 2u;
+    }
+    Slots.resize(Capacity);
+}
+
+uint32_t PipelineStateCache::Find(const PipelineStateDesc& Desc, uint64_t Hash) const noexcept
+{
+    const size_t Mask = Slots.size() - 1u;
+    for (size_t i = Hash & Mask; ; i = (i + 1u) & Mask)
+    {
+        const Slot& s = Slots[i];
+        if (s.Index == InvalidIndex)
+        {
+            return InvalidIndex;
+        }
+        if (s.Hash == Hash && s.Desc == Desc)
+        {
+            return s.Index;
+        }
+    }
+}
+
+void PipelineStateCache::Insert(const PipelineStateDesc& Desc, uint64_t Hash, uint32_t Index)
+{
+    // Keep the load factor under 3/4 so probe sequences stay short
+    if ((Size + 1u) * 4u > Slots.size() * 3u)
+    {
+        Grow();
+    }
+
+    const size_t Mask = Slots.size() - 1u;
+    size_t i = Hash & Mask;
+    while (Slots[i].Index != InvalidIndex)
+    {
+        i = (i + 1u) & Mask;
+    }
+    Slots[i] = {Hash, Index, Desc};
+    Size++;
+}
+
+uint32_t PipelineStateCache::Remove(const PipelineStateDesc& Desc, uint64_t Hash) noexcept
+{
+    const size_t Mask = Slots.size() - 1u;
+    size_t Hole = Hash & Mask;
+    for (; Slots[Hole].Index != InvalidIndex; Hole = (Hole + 1u) & Mask)
+    {
+        if (Slots[Hole].Hash == Hash && Slots[Hole].Desc == Desc)
+        {
+            break;
+        }
+    }
+    const uint32_t Removed = Slots[Hole].Index;
+    if (Removed == InvalidIndex)
+    {
+        return InvalidIndex;
+    }
+
+    // No tombstones: later entries of the probe run move back into the hole unless that
+    // would put them in front of their home slot
+    Slots[Hole] = {};
+    for (size_t i = (Hole + 1u) & Mask; Slots[i].Index != InvalidIndex; i = (i + 1u) & Mask)
+    {
+        const size_t Home = Slots[i].Hash & Mask;
+        if (((i - Home) & Mask) >= ((i - Hole) & Mask))
+        {
+            Slots[Hole] = Slots[i];
+            Slots[i] = {};
+            Hole = i;
+        }
+    }
+    Size--;
+    return Removed;
+}
+
+size_t PipelineStateCache::GetSize() const noexcept
+{
+    return Size;
+}
+
+void PipelineStateCache::Grow()
+{
+    std::vector<Slot> Old(Slots.size() * 2u);
+    Old.swap(Slots);
+    Size = 0u;
+    for (const Slot& s : Old)
+    {
+        if (s.Index != InvalidIndex)
+        {
+            Insert(s.Desc, s.Hash, s.Index);
+        }
+    }
+}
\ No newline at end of file
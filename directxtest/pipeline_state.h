@@ -0,0 +1,99 @@
+#pragma once
+#include "handle_pool.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class Topology : unsigned char
+{
+    TriangleList,
+    TriangleStrip,
+    LineList,
+    PointList,
+    Count
+};
+
+enum class BlendMode : unsigned char
+{
+    Opaque,
+    Alpha,
+    Additive,
+    Count
+};
+
+enum class CullMode : unsigned char
+{
+    None,
+    Back,
+    Front,
+    Count
+};
+
+enum class FillMode : unsigned char
+{
+    Solid,
+    Wireframe,
+    Count
+};
+
+enum class DepthMode : unsigned char
+{
+    Off,
+    Test,
+    TestWrite,
+    Count
+};
+
+enum class SamplerMode : unsigned char
+{
+    Point,
+    Linear,
+    Anisotropic,
+    Count
+};
+
+// Immutable description of everything bound for a draw apart from buffers and constants.
+// Shaders and layouts are referenced by handle, a null handle means none.
+struct PipelineStateDesc
+{
+    VertexShaderHandle VertexShader;
+    PixelShaderHandle PixelShader;
+    InputLayoutHandle InputLayout;
+    Topology PrimitiveTopology = Topology::TriangleList;
+    BlendMode Blend = BlendMode::Opaque;
+    CullMode Cull = CullMode::Back;
+    FillMode Fill = FillMode::Solid;
+    DepthMode Depth = DepthMode::Off;
+    SamplerMode Sampler = SamplerMode::Linear;
+
+    bool operator==(const PipelineStateDesc&) const = default;
+};
+
+uint64_t HashPipelineState(const PipelineStateDesc& Desc) noexcept;
+
+// Open-addressing (linear probing) map from a descriptor to the index of the state
+// created for it, so equal descriptors always resolve to the same state object
+class PipelineStateCache
+{
+public:
+    static constexpr uint32_t InvalidIndex = 0xFFFFFFFFu;
+public:
+    explicit PipelineStateCache(size_t InitialCapacity = 64u);
+
+    uint32_t Find(const PipelineStateDesc& Desc, uint64_t Hash) const noexcept;
+    void Insert(const PipelineStateDesc& Desc, uint64_t Hash, uint32_t Index);
+    // Returns the removed index, InvalidIndex when Desc was not in the cache
+    uint32_t Remove(const PipelineStateDesc& Desc, uint64_t Hash) noexcept;
+    size_t GetSize() const noexcept;
+private:
+    struct Slot
+    {
+        uint64_t Hash = 0u;
+        uint32_t Index = InvalidIndex;
+        PipelineStateDesc Desc;
+    };
+    void Grow();
+private:
+    std::vector<Slot> Slots;
+    size_t Size = 0u;
+};
\ No newline at end of file
@@ -1,4 +1,10 @@
+cbuffer FrameConstants : register(b0)
+{
+    float4 Tint;
+    float Time;
+};
+
 float4 main() : SV_Target
 {
-    return float4(1.0f, 1.0f, 1.0f, 1.0f);
+    return Tint;
 }
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include "ring_allocator.h"
+
+RingAllocator::RingAllocator(size_t Capacity, unsigned int FramesInFlight)
+    : Capacity(Capacity), Fences(FramesInFlight + 1u) {}
+
+std::optional<RingAllocator::Allocation> RingAllocator::Allocate(size_t Size, size_t Alignment) noexcept
+{
+    if (Size == 0u || Size > Capacity)
+    {
+        return {};
+    }
+
+    // The first write to a fresh buffer has to rename it as well
+    if (FirstUse)
+    {
+        FirstUse = false;
+        Head = Size;
+        return Allocation{0u, MapMode::Discard};
+    }
+
+    // Alignment may be a vertex stride, so it is not necessarily a power of two
+    const size_t Offset = (Head + Alignment - 1u) / Alignment * Alignment;
+    if (Head >= Tail)
+    {
+        // In-flight data is [Tail, Head), free space is the end of the ring and [0, Tail)
+        if (Offset + Size <= Capacity)
+        {
+            Head = Offset + Size;
+            return Allocation{Offset, MapMode::NoOverwrite};
+        }
+        // Head == Tail would read as an empty ring, so the wrap has to stay short of Tail
+        if (Size < Tail)
+        {
+            Head = Size;
+            return Allocation{0u, MapMode::NoOverwrite};
+        }
+    }
+    else if (Offset + Size < Tail)
+    {
+        // Wrapped, free space is [Head, Tail)
+        Head = Offset + Size;
+        return Allocation{Offset, MapMode::NoOverwrite};
+    }
+
+    Discard();
+    Head = Size;
+    return Allocation{0u, MapMode::Discard};
+}
+
+void RingAllocator::EndFrame() noexcept
+{
+    Fences[(FirstFence + FenceCount) % Fences.size()] = Head;
+    FenceCount++;
+
+    // Oldest frame is complete, everything up to its fence can be reused
+    if (FenceCount == Fences.size())
+    {
+        Tail = Fences[FirstFence];
+        FirstFence = (FirstFence + 1u) % Fences.size();
+        FenceCount--;
+    }
+}
+
+size_t RingAllocator::GetCapacity() const noexcept
+{
+    return Capacity;
+}
+
+size_t RingAllocator::GetInFlightBytes() const noexcept
+{
+    return Head >= Tail ? Head - Tail : Capacity - Tail + Head;
+}
+
+unsigned int RingAllocator::GetDiscardCount() const noexcept
+{
+    return Discards;
+}
+
+void RingAllocator::Discard() noexcept
+{
+    // The old buffer contents are renamed away, so no frame is in flight in the new one
+    Discards++;
+    Head = 0u;
+    Tail = 0u;
+    FirstFence = 0u;
+    FenceCount = 0u;
+}
\ No newline at end of file
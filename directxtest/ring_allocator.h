@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+// Bookkeeping for a dynamic GPU buffer that is used as a ring. Every frame appends
+// to the ring and EndFrame() places a fence at the write position. A frame's region
+// only becomes writable again once FramesInFlight newer frames have ended, so data
+// the GPU may still read is never overwritten without renaming the buffer.
+// Holds no API objects, the caller maps the buffer with the returned MapMode.
+class RingAllocator
+{
+public:
+    enum class MapMode
+    {
+        NoOverwrite,    // Region is not in flight, append without synchronization
+        Discard         // Ring is full of in-flight data, buffer must be renamed
+    };
+    struct Allocation
+    {
+        size_t Offset;
+        MapMode Mode;
+    };
+public:
+    RingAllocator(size_t Capacity, unsigned int FramesInFlight);
+
+    // Returns nothing if Size can never fit into the ring
+    std::optional<Allocation> Allocate(size_t Size, size_t Alignment = 16u) noexcept;
+    void EndFrame() noexcept;
+
+    size_t GetCapacity() const noexcept;
+    size_t GetInFlightBytes() const noexcept;
+    unsigned int GetDiscardCount() const noexcept;
+private:
+    void Discard() noexcept;
+private:
+    size_t Capacity;
+    bool FirstUse = true;
+    size_t Head = 0u;
+    size_t Tail = 0u;
+    // Fences of the frames in flight (ring of write positions, oldest first)
+    std::vector<size_t> Fences;
+    size_t FirstFence = 0u;
+    size_t FenceCount = 0u;
+    unsigned int Discards = 0u;
+};
\ No newline at end of file
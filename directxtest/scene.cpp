@@ -0,0 +1,116 @@
+#include "scene.h"
+#include "benchmark_scenes.h"
+#include <iterator>
+#include <type_traits>
+
+PipelineStateDesc Scene::LoadDefaultPipeline(Graphics& GFX)
+{
+    const D3D11_INPUT_ELEMENT_DESC InputElementDesc[] =
+    {
+        {"Position", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0}
+    };
+
+    PipelineStateDesc Desc;
+    Desc.VertexShader = GFX.LoadVertexShader(L"vertex_shader.cso");
+    Desc.PixelShader = GFX.LoadPixelShader(L"pixel_shader.cso");
+    Desc.InputLayout = GFX.CreateInputLayout(InputElementDesc, (UINT)std::size(InputElementDesc), Desc.VertexShader);
+    Desc.PrimitiveTopology = Topology::TriangleList;
+    return Desc;
+}
+
+PipelineStateDesc Scene::LoadMeshPipeline(Graphics& GFX)
+{
+    const D3D11_INPUT_ELEMENT_DESC InputElementDesc[] =
+    {
+        {"Position", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0}
+    };
+
+    PipelineStateDesc Desc;
+    Desc.VertexShader = GFX.LoadVertexShader(L"mesh_vertex_shader.cso");
+    Desc.PixelShader = GFX.LoadPixelShader(L"pixel_shader.cso");
+    Desc.InputLayout = GFX.CreateInputLayout(InputElementDesc, (UINT)std::size(InputElementDesc), Desc.VertexShader);
+    Desc.PrimitiveTopology = Topology::TriangleList;
+    Desc.Depth = DepthMode::TestWrite;
+    return Desc;
+}
+
+BufferHandle Scene::CreateStaticBuffer(Graphics& GFX, UINT BindFlags, const void* Data, size_t Size)
+{
+    D3D11_BUFFER_DESC Desc = {};
+    Desc.ByteWidth = static_cast<UINT>(Size);
+    Desc.Usage = D3D11_USAGE_IMMUTABLE;
+    Desc.BindFlags = BindFlags;
+    Desc.CPUAccessFlags = 0u;
+    Desc.MiscFlags = 0u;
+    Desc.StructureByteStride = 0u;
+    return GFX.CreateBuffer(Desc, Data);
+}
+
+namespace
+{
+    template <typename T>
+    std::unique_ptr<Scene> Make(uint32_t Seed)
+    {
+        if constexpr (std::is_constructible_v<T, uint32_t>)
+        {
+            return std::make_unique<T>(Seed);
+        }
+        else
+        {
+            return std::make_unique<T>();
+        }
+    }
+
+    struct SceneEntry
+    {
+        const wchar_t* Name;
+        std::unique_ptr<Scene> (*Create)(uint32_t Seed);
+    };
+
+    constexpr SceneEntry Scenes[] =
+    {
+        {L"triangle", &Make<TriangleScene>},
+        {L"tiny_draws", &Make<TinyDrawsScene>},
+        {L"huge_meshes", &Make<HugeMeshScene>},
+        {L"overdraw", &Make<OverdrawScene>},
+        {L"state_changes", &Make<StateChangeScene>},
+        {L"streaming", &Make<StreamingScene>},
+        {L"culling", &Make<CullingScene>},
+        {L"occlusion", &Make<OcclusionScene>},
+        {L"lod", &Make<LodScene>},
+        {L"meshlets", &Make<MeshletScene>}
+    };
+
+    const SceneEntry* FindScene(const std::wstring& Name) noexcept
+    {
+        for (const SceneEntry& Entry : Scenes)
+        {
+            if (Name == Entry.Name)
+            {
+                return &Entry;
+            }
+        }
+        return nullptr;
+    }
+}
+
+bool IsSceneName(const std::wstring& Name) noexcept
+{
+    return FindScene(Name) != nullptr;
+}
+
+std::wstring GetSceneNames()
+{
+    std::wstring Names;
+    for (const SceneEntry& Entry : Scenes)
+    {
+        Names += (Names.empty() ? L"" : L", ") + std::wstring(Entry.Name);
+    }
+    return Names;
+}
+
+std::unique_ptr<Scene> CreateScene(const std::wstring& Name, uint32_t Seed)
+{
+    const SceneEntry* Entry = FindScene(Name);
+    return Entry != nullptr ? Entry->Create(Seed) : nullptr;
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+#include "graphics.h"
+#include "frame_pipeline.h"
+#include "job_system.h"
+#include "scene_random.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Content driven by App. Scenes are procedural and deterministic: the same seed and
+// time always record the same commands, so benchmark runs are comparable.
+class Scene
+{
+public:
+    virtual ~Scene() = default;
+    virtual const char* GetName() const noexcept = 0;
+    // Creates GPU resources, called once on the render thread before the first frame
+    virtual void Load(Graphics& GFX) = 0;
+    // Records one frame into Packet.Draws or Packet.Chunks and fills Packet.Statistics.
+    // Runs on the simulation thread, so it must not touch the device.
+    virtual void Simulate(FramePacket& Packet, float Time, JobSystem& Jobs) = 0;
+protected:
+    // Default shaders with a float2 position layout, the base of every scene's PSOs
+    static PipelineStateDesc LoadDefaultPipeline(Graphics& GFX);
+    // float3 positions transformed by a World draw constant and the ViewProjection in
+    // FramePacket::ViewConstants, depth tested and written. Clockwise triangles face front.
+    static PipelineStateDesc LoadMeshPipeline(Graphics& GFX);
+    static BufferHandle CreateStaticBuffer(Graphics& GFX, UINT BindFlags, const void* Data, size_t Size);
+};
+
+// Null for unknown names
+std::unique_ptr<Scene> CreateScene(const std::wstring& Name, uint32_t Seed);
+bool IsSceneName(const std::wstring& Name) noexcept;
+// Every name CreateScene knows, comma separated
+std::wstring GetSceneNames();
\ No newline at end of file
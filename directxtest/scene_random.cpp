@@ -0,0 +1,18 @@
+#include "scene_random.h"
+
+SceneRandom::SceneRandom(uint64_t Seed) noexcept : State(Seed) {}
+
+uint64_t SceneRandom::Next() noexcept
+{
+    uint64_t z = (State += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30u)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27u)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31u);
+}
+
+float SceneRandom::NextFloat(float Min, float Max) noexcept
+{
+    // 24 random mantissa bits give every representable step in [0, 1)
+    const float Unit = static_cast<float>(Next() >> 40u) * (1.0f / 16777216.0f);
+    return Min + (Max - Min) * Unit;
+}
\ No newline at end of file
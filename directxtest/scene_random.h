@@ -0,0 +1,14 @@
+#pragma once
+#include <cstdint>
+
+// splitmix64, fully specified so scenes come out the same with every standard library
+class SceneRandom
+{
+public:
+    explicit SceneRandom(uint64_t Seed) noexcept;
+    uint64_t Next() noexcept;
+    // Uniform in [Min, Max)
+    float NextFloat(float Min = 0.0f, float Max = 1.0f) noexcept;
+private:
+    uint64_t State;
+};
\ No newline at end of file
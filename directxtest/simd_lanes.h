@@ -0,0 +1,118 @@
+#pragma once
+#include "simd_math.h"
+#include <cmath>
+#include <cstdint>
+
+#if defined(SIMD_MATH_AVX2) || defined(SIMD_MATH_SSE)
+#include <immintrin.h>
+#endif
+
+// Batch kernels are written once against these lane types: plain floats for the
+// reference path and remainders, and 4 or 8 wide registers for the native one.
+// Include from .cpp files only, it pulls in the intrinsics headers.
+struct ScalarLanes
+{
+    static constexpr size_t Width = 1u;
+    float v;
+
+    static ScalarLanes Load(const float* p) noexcept { return {*p}; }
+    static ScalarLanes Set(float s) noexcept { return {s}; }
+    void Store(float* p) const noexcept { *p = v; }
+    friend ScalarLanes operator+(ScalarLanes a, ScalarLanes b) noexcept { return {a.v + b.v}; }
+    friend ScalarLanes operator-(ScalarLanes a, ScalarLanes b) noexcept { return {a.v - b.v}; }
+    friend ScalarLanes operator*(ScalarLanes a, ScalarLanes b) noexcept { return {a.v * b.v}; }
+    friend ScalarLanes operator/(ScalarLanes a, ScalarLanes b) noexcept { return {a.v / b.v}; }
+    friend ScalarLanes Round(ScalarLanes a) noexcept { return {std::nearbyint(a.v)}; }
+    // a > b ? x : y
+    friend ScalarLanes SelectGreater(ScalarLanes a, ScalarLanes b, ScalarLanes x, ScalarLanes y) noexcept { return a.v > b.v ? x : y; }
+    friend ScalarLanes Min(ScalarLanes a, ScalarLanes b) noexcept { return {a.v < b.v ? a.v : b.v}; }
+    friend ScalarLanes Max(ScalarLanes a, ScalarLanes b) noexcept { return {a.v > b.v ? a.v : b.v}; }
+    friend ScalarLanes Abs(ScalarLanes a) noexcept { return {std::fabs(a.v)}; }
+    // Bit j set where lane j of a >= b
+    friend uint32_t MaskGreaterEqual(ScalarLanes a, ScalarLanes b) noexcept { return a.v >= b.v ? 1u : 0u; }
+};
+
+#if defined(SIMD_MATH_SSE)
+struct SseLanes
+{
+    static constexpr size_t Width = 4u;
+    __m128 v;
+
+    static SseLanes Load(const float* p) noexcept { return {_mm_loadu_ps(p)}; }
+    static SseLanes Set(float s) noexcept { return {_mm_set1_ps(s)}; }
+    void Store(float* p) const noexcept { _mm_storeu_ps(p, v); }
+    friend SseLanes operator+(SseLanes a, SseLanes b) noexcept { return {_mm_add_ps(a.v, b.v)}; }
+    friend SseLanes operator-(SseLanes a, SseLanes b) noexcept { return {_mm_sub_ps(a.v, b.v)}; }
+    friend SseLanes operator*(SseLanes a, SseLanes b) noexcept { return {_mm_mul_ps(a.v, b.v)}; }
+    friend SseLanes operator/(SseLanes a, SseLanes b) noexcept { return {_mm_div_ps(a.v, b.v)}; }
+    // SSE2 has no round instruction, the conversion rounds to nearest even like nearbyint
+    friend SseLanes Round(SseLanes a) noexcept { return {_mm_cvtepi32_ps(_mm_cvtps_epi32(a.v))}; }
+    friend SseLanes SelectGreater(SseLanes a, SseLanes b, SseLanes x, SseLanes y) noexcept
+    {
+        const __m128 Mask = _mm_cmpgt_ps(a.v, b.v);
+        return {_mm_or_ps(_mm_and_ps(Mask, x.v), _mm_andnot_ps(Mask, y.v))};
+    }
+    friend SseLanes Min(SseLanes a, SseLanes b) noexcept { return {_mm_min_ps(a.v, b.v)}; }
+    friend SseLanes Max(SseLanes a, SseLanes b) noexcept { return {_mm_max_ps(a.v, b.v)}; }
+    friend SseLanes Abs(SseLanes a) noexcept { return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)}; }
+    friend uint32_t MaskGreaterEqual(SseLanes a, SseLanes b) noexcept { return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmpge_ps(a.v, b.v))); }
+};
+#endif
+
+#if defined(SIMD_MATH_AVX2)
+struct AvxLanes
+{
+    static constexpr size_t Width = 8u;
+    __m256 v;
+
+    static AvxLanes Load(const float* p) noexcept { return {_mm256_loadu_ps(p)}; }
+    static AvxLanes Set(float s) noexcept { return {_mm256_set1_ps(s)}; }
+    void Store(float* p) const noexcept { _mm256_storeu_ps(p, v); }
+    friend AvxLanes operator+(AvxLanes a, AvxLanes b) noexcept { return {_mm256_add_ps(a.v, b.v)}; }
+    friend AvxLanes operator-(AvxLanes a, AvxLanes b) noexcept { return {_mm256_sub_ps(a.v, b.v)}; }
+    friend AvxLanes operator*(AvxLanes a, AvxLanes b) noexcept { return {_mm256_mul_ps(a.v, b.v)}; }
+    friend AvxLanes operator/(AvxLanes a, AvxLanes b) noexcept { return {_mm256_div_ps(a.v, b.v)}; }
+    friend AvxLanes Round(AvxLanes a) noexcept { return {_mm256_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)}; }
+    friend AvxLanes SelectGreater(AvxLanes a, AvxLanes b, AvxLanes x, AvxLanes y) noexcept
+    {
+        return {_mm256_blendv_ps(y.v, x.v, _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ))};
+    }
+    friend AvxLanes Min(AvxLanes a, AvxLanes b) noexcept { return {_mm256_min_ps(a.v, b.v)}; }
+    friend AvxLanes Max(AvxLanes a, AvxLanes b) noexcept { return {_mm256_max_ps(a.v, b.v)}; }
+    friend AvxLanes Abs(AvxLanes a) noexcept { return {_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v)}; }
+    friend uint32_t MaskGreaterEqual(AvxLanes a, AvxLanes b) noexcept { return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ))); }
+};
+using NativeLanes = AvxLanes;
+#elif defined(SIMD_MATH_SSE)
+using NativeLanes = SseLanes;
+#else
+using NativeLanes = ScalarLanes;
+#endif
+
+// Calls Body(Lanes{}, i) for every group of lanes starting at i, full groups of the
+// path's width first and the remainder one element at a time
+template<typename F>
+void ForEachLane(size_t Count, MathPath Path, F&& Body) noexcept
+{
+    size_t i = 0u;
+    if (Path == MathPath::Native)
+    {
+        for (; i + NativeLanes::Width <= Count; i += NativeLanes::Width)
+        {
+            Body(NativeLanes{}, i);
+        }
+    }
+#if defined(SIMD_MATH_SSE)
+    else if (Path == MathPath::Sse)
+    {
+        for (; i + SseLanes::Width <= Count; i += SseLanes::Width)
+        {
+            Body(SseLanes{}, i);
+        }
+    }
+#endif
+    for (; i < Count; i++)
+    {
+        Body(ScalarLanes{}, i);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,613 @@
+#include "simd_math.h"
+#include "simd_lanes.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    template<typename L>
+    void SinCosLanes(L Angle, L& Sin, L& Cos) noexcept
+    {
+        // Reduce to [-pi, pi] with 2 pi split in two, the high part has few enough bits
+        // that k * TwoPiHigh is exact
+        constexpr float TwoPiHigh = 6.28125f;
+        constexpr float TwoPiLow = 1.9353071795864769253e-3f;
+        const L k = Round(Angle * L::Set(1.0f / (2.0f * Pi)));
+        L x = Angle - k * L::Set(TwoPiHigh) - k * L::Set(TwoPiLow);
+
+        // Fold into [-pi/2, pi/2]: sin(pi - x) = sin(x) and cos(pi - x) = -cos(x)
+        const L HalfPi = L::Set(0.5f * Pi);
+        const L Upper = L::Set(Pi) - x;
+        const L Lower = L::Set(-Pi) - x;
+        const L One = L::Set(1.0f);
+        const L MinusOne = L::Set(-1.0f);
+        const L CosSign = SelectGreater(x, HalfPi, MinusOne, SelectGreater(L::Set(0.0f) - HalfPi, x, MinusOne, One));
+        x = SelectGreater(x, HalfPi, Upper, SelectGreater(L::Set(0.0f) - HalfPi, x, Lower, x));
+
+        // Taylor series, the first dropped terms are below float precision on [-pi/2, pi/2]
+        const L x2 = x * x;
+        L s = L::Set(-2.5052108e-8f);
+        s = s * x2 + L::Set(2.7557319e-6f);
+        s = s * x2 + L::Set(-1.9841270e-4f);
+        s = s * x2 + L::Set(8.3333333e-3f);
+        s = s * x2 + L::Set(-1.6666667e-1f);
+        Sin = (s * x2 + One) * x;
+
+        L c = L::Set(2.0876757e-9f);
+        c = c * x2 + L::Set(-2.7557319e-7f);
+        c = c * x2 + L::Set(2.4801587e-5f);
+        c = c * x2 + L::Set(-1.3888889e-3f);
+        c = c * x2 + L::Set(4.1666667e-2f);
+        c = c * x2 + L::Set(-0.5f);
+        Cos = (c * x2 + One) * CosSign;
+    }
+
+    // Writes lane j of the 16 component registers to Out[j]
+    void StoreMatrices(const ScalarLanes (&Components)[16], Mat4* Out) noexcept
+    {
+        for (size_t c = 0; c < 16u; c++)
+        {
+            Out->M[c / 4u][c % 4u] = Components[c].v;
+        }
+    }
+
+#if defined(SIMD_MATH_SSE)
+    // Each row is a 4x4 transpose of its four component registers
+    void StoreMatrices(const SseLanes (&Components)[16], Mat4* Out) noexcept
+    {
+        for (size_t r = 0; r < 4u; r++)
+        {
+            __m128 c0 = Components[4u * r].v;
+            __m128 c1 = Components[4u * r + 1u].v;
+            __m128 c2 = Components[4u * r + 2u].v;
+            __m128 c3 = Components[4u * r + 3u].v;
+            _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+            _mm_store_ps(Out[0].M[r], c0);
+            _mm_store_ps(Out[1].M[r], c1);
+            _mm_store_ps(Out[2].M[r], c2);
+            _mm_store_ps(Out[3].M[r], c3);
+        }
+    }
+#endif
+
+#if defined(SIMD_MATH_AVX2)
+    // _MM_TRANSPOSE4_PS within both 128 bit halves
+    void Transpose4(__m256& a, __m256& b, __m256& c, __m256& d) noexcept
+    {
+        const __m256 ab01 = _mm256_unpacklo_ps(a, b);
+        const __m256 cd01 = _mm256_unpacklo_ps(c, d);
+        const __m256 ab23 = _mm256_unpackhi_ps(a, b);
+        const __m256 cd23 = _mm256_unpackhi_ps(c, d);
+        a = _mm256_shuffle_ps(ab01, cd01, _MM_SHUFFLE(1, 0, 1, 0));
+        b = _mm256_shuffle_ps(ab01, cd01, _MM_SHUFFLE(3, 2, 3, 2));
+        c = _mm256_shuffle_ps(ab23, cd23, _MM_SHUFFLE(1, 0, 1, 0));
+        d = _mm256_shuffle_ps(ab23, cd23, _MM_SHUFFLE(3, 2, 3, 2));
+    }
+
+    // Two rows at a time: after the in-half transposes register k holds that row of
+    // matrices k and k + 4, and the halves are recombined into each matrix's row pair
+    void StoreMatrices(const AvxLanes (&Components)[16], Mat4* Out) noexcept
+    {
+        for (size_t r = 0; r < 4u; r += 2u)
+        {
+            __m256 Upper[4] = {Components[4u * r].v, Components[4u * r + 1u].v, Components[4u * r + 2u].v, Components[4u * r + 3u].v};
+            __m256 Lower[4] = {Components[4u * r + 4u].v, Components[4u * r + 5u].v, Components[4u * r + 6u].v, Components[4u * r + 7u].v};
+            Transpose4(Upper[0], Upper[1], Upper[2], Upper[3]);
+            Transpose4(Lower[0], Lower[1], Lower[2], Lower[3]);
+            for (size_t k = 0; k < 4u; k++)
+            {
+                // Mat4 is only 16 byte aligned
+                _mm256_storeu_ps(Out[k].M[r], _mm256_permute2f128_ps(Upper[k], Lower[k], 0x20));
+                _mm256_storeu_ps(Out[k + 4u].M[r], _mm256_permute2f128_ps(Upper[k], Lower[k], 0x31));
+            }
+        }
+    }
+#endif
+
+    // Out = A * B with every row of Out a combination of the rows of B. Both inputs are
+    // fully read before Out is written, so Out may alias them.
+    void MultiplyScalar(const Mat4& A, const Mat4& B, Mat4& Out) noexcept
+    {
+        Mat4 Result;
+        for (size_t r = 0; r < 4u; r++)
+        {
+            for (size_t c = 0; c < 4u; c++)
+            {
+                Result.M[r][c] = A.M[r][0] * B.M[0][c] + A.M[r][1] * B.M[1][c] + A.M[r][2] * B.M[2][c] + A.M[r][3] * B.M[3][c];
+            }
+        }
+        Out = Result;
+    }
+
+#if defined(SIMD_MATH_SSE)
+    void MultiplySse(const Mat4& A, const Mat4& B, Mat4& Out) noexcept
+    {
+        const __m128 B0 = _mm_load_ps(B.M[0]);
+        const __m128 B1 = _mm_load_ps(B.M[1]);
+        const __m128 B2 = _mm_load_ps(B.M[2]);
+        const __m128 B3 = _mm_load_ps(B.M[3]);
+        const __m128 A0 = _mm_load_ps(A.M[0]);
+        const __m128 A1 = _mm_load_ps(A.M[1]);
+        const __m128 A2 = _mm_load_ps(A.M[2]);
+        const __m128 A3 = _mm_load_ps(A.M[3]);
+        const auto Row = [&](__m128 a)
+        {
+            __m128 r = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 0, 0)), B0);
+            r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1)), B1));
+            r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 2, 2)), B2));
+            return _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)), B3));
+        };
+        _mm_store_ps(Out.M[0], Row(A0));
+        _mm_store_ps(Out.M[1], Row(A1));
+        _mm_store_ps(Out.M[2], Row(A2));
+        _mm_store_ps(Out.M[3], Row(A3));
+    }
+#endif
+
+#if defined(SIMD_MATH_AVX2)
+    // Two rows per register, B's rows broadcast into both halves
+    void MultiplyAvx(const Mat4& A, const Mat4& B, Mat4& Out) noexcept
+    {
+        const __m256 B0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(B.M[0]));
+        const __m256 B1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(B.M[1]));
+        const __m256 B2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(B.M[2]));
+        const __m256 B3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(B.M[3]));
+        // Mat4 is only 16 byte aligned
+        const __m256 A01 = _mm256_loadu_ps(A.M[0]);
+        const __m256 A23 = _mm256_loadu_ps(A.M[2]);
+        const auto Rows = [&](__m256 a)
+        {
+            __m256 r = _mm256_mul_ps(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 0, 0)), B0);
+            r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1)), B1));
+            r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 2, 2)), B2));
+            return _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)), B3));
+        };
+        const __m256 Out01 = Rows(A01);
+        const __m256 Out23 = Rows(A23);
+        _mm256_storeu_ps(Out.M[0], Out01);
+        _mm256_storeu_ps(Out.M[2], Out23);
+    }
+#endif
+
+    void MultiplyNative(const Mat4& A, const Mat4& B, Mat4& Out) noexcept
+    {
+#if defined(SIMD_MATH_AVX2)
+        MultiplyAvx(A, B, Out);
+#elif defined(SIMD_MATH_SSE)
+        MultiplySse(A, B, Out);
+#else
+        MultiplyScalar(A, B, Out);
+#endif
+    }
+
+    // Calls Body(Multiply, i) for every i below Count with the product kernel of Path,
+    // one loop per kernel so the calls inline
+    template<typename F>
+    void ForEachProduct(size_t Count, MathPath Path, F&& Body) noexcept
+    {
+        const auto Run = [&](auto Multiply)
+        {
+            for (size_t i = 0; i < Count; i++)
+            {
+                Body(Multiply, i);
+            }
+        };
+        switch (Path)
+        {
+            case MathPath::Native:
+                Run([](const Mat4& A, const Mat4& B, Mat4& Out) noexcept { MultiplyNative(A, B, Out); });
+                break;
+#if defined(SIMD_MATH_SSE)
+            case MathPath::Sse:
+                Run([](const Mat4& A, const Mat4& B, Mat4& Out) noexcept { MultiplySse(A, B, Out); });
+                break;
+#endif
+            default:
+                Run([](const Mat4& A, const Mat4& B, Mat4& Out) noexcept { MultiplyScalar(A, B, Out); });
+                break;
+        }
+    }
+}
+
+// Vectors
+
+float Length(const Vec3& v) noexcept
+{
+    return std::sqrt(Dot(v, v));
+}
+
+Vec3 Normalize(const Vec3& v) noexcept
+{
+    const float SquaredLength = Dot(v, v);
+    return SquaredLength > 0.0f ? v * (1.0f / std::sqrt(SquaredLength)) : v;
+}
+
+Vec3 Min(const Vec3& a, const Vec3& b) noexcept
+{
+    return {std::min(a.X, b.X), std::min(a.Y, b.Y), std::min(a.Z, b.Z)};
+}
+
+Vec3 Max(const Vec3& a, const Vec3& b) noexcept
+{
+    return {std::max(a.X, b.X), std::max(a.Y, b.Y), std::max(a.Z, b.Z)};
+}
+
+// Quaternions
+
+Quat Quat::Identity() noexcept
+{
+    return {0.0f, 0.0f, 0.0f, 1.0f};
+}
+
+Quat Quat::FromAxisAngle(const Vec3& Axis, float Angle) noexcept
+{
+    float s, c;
+    SinCos(0.5f * Angle, s, c);
+    return {Axis.X * s, Axis.Y * s, Axis.Z * s, c};
+}
+
+Quat Multiply(const Quat& A, const Quat& B) noexcept
+{
+    // Hamilton product B * A, which rotates by A first
+    return
+    {
+        B.W * A.X + B.X * A.W + B.Y * A.Z - B.Z * A.Y,
+        B.W * A.Y - B.X * A.Z + B.Y * A.W + B.Z * A.X,
+        B.W * A.Z + B.X * A.Y - B.Y * A.X + B.Z * A.W,
+        B.W * A.W - B.X * A.X - B.Y * A.Y - B.Z * A.Z
+    };
+}
+
+Quat Normalize(const Quat& q) noexcept
+{
+    const float SquaredLength = q.X * q.X + q.Y * q.Y + q.Z * q.Z + q.W * q.W;
+    if (SquaredLength <= 0.0f)
+    {
+        return Quat::Identity();
+    }
+    const float s = 1.0f / std::sqrt(SquaredLength);
+    return {q.X * s, q.Y * s, q.Z * s, q.W * s};
+}
+
+Vec3 Rotate(const Vec3& v, const Quat& q) noexcept
+{
+    const Vec3 u = {q.X, q.Y, q.Z};
+    const Vec3 t = Cross(u, v) * 2.0f;
+    return v + t * q.W + Cross(u, t);
+}
+
+Quat Slerp(const Quat& A, const Quat& B, float t) noexcept
+{
+    float CosAngle = A.X * B.X + A.Y * B.Y + A.Z * B.Z + A.W * B.W;
+    // Take the short way around
+    const float Sign = CosAngle < 0.0f ? -1.0f : 1.0f;
+    CosAngle *= Sign;
+
+    float WeightA = 1.0f - t;
+    float WeightB = t;
+    // Nearly parallel rotations interpolate linearly, the sine below would vanish
+    if (CosAngle < 0.9995f)
+    {
+        const float Angle = std::acos(CosAngle);
+        const float InvSin = 1.0f / std::sin(Angle);
+        WeightA = std::sin((1.0f - t) * Angle) * InvSin;
+        WeightB = std::sin(t * Angle) * InvSin;
+    }
+    WeightB *= Sign;
+    return Normalize(Quat{A.X * WeightA + B.X * WeightB, A.Y * WeightA + B.Y * WeightB, A.Z * WeightA + B.Z * WeightB, A.W * WeightA + B.W * WeightB});
+}
+
+// Matrices
+
+Mat4 Mat4::Identity() noexcept
+{
+    return Scaling(1.0f, 1.0f, 1.0f);
+}
+
+Mat4 Mat4::Translation(float X, float Y, float Z) noexcept
+{
+    Mat4 Result = Identity();
+    Result.M[3][0] = X;
+    Result.M[3][1] = Y;
+    Result.M[3][2] = Z;
+    return Result;
+}
+
+Mat4 Mat4::Scaling(float X, float Y, float Z) noexcept
+{
+    return
+    {{
+        {X,    0.0f, 0.0f, 0.0f},
+        {0.0f, Y,    0.0f, 0.0f},
+        {0.0f, 0.0f, Z,    0.0f},
+        {0.0f, 0.0f, 0.0f, 1.0f}
+    }};
+}
+
+Mat4 Mat4::RotationZ(float Angle) noexcept
+{
+    return Transform2D(0.0f, 0.0f, 1.0f, Angle);
+}
+
+Mat4 Mat4::Rotation(const Quat& Rotation) noexcept
+{
+    return Compose({0.0f, 0.0f, 0.0f}, Rotation, {1.0f, 1.0f, 1.0f});
+}
+
+Mat4 Mat4::Compose(const Vec3& Position, const Quat& Rotation, const Vec3& Scale) noexcept
+{
+    const float x = Rotation.X, y = Rotation.Y, z = Rotation.Z, w = Rotation.W;
+    return
+    {{
+        {(1.0f - 2.0f * (y * y + z * z)) * Scale.X, 2.0f * (x * y + w * z) * Scale.X,          2.0f * (x * z - w * y) * Scale.X,          0.0f},
+        {2.0f * (x * y - w * z) * Scale.Y,          (1.0f - 2.0f * (x * x + z * z)) * Scale.Y, 2.0f * (y * z + w * x) * Scale.Y,          0.0f},
+        {2.0f * (x * z + w * y) * Scale.Z,          2.0f * (y * z - w * x) * Scale.Z,          (1.0f - 2.0f * (x * x + y * y)) * Scale.Z, 0.0f},
+        {Position.X,                                Position.Y,                                Position.Z,                                1.0f}
+    }};
+}
+
+Mat4 Mat4::Transform2D(float X, float Y, float Scale, float Angle) noexcept
+{
+    float s, c;
+    SinCos(Angle, s, c);
+    s *= Scale;
+    c *= Scale;
+    return
+    {{
+        { c,    s,    0.0f, 0.0f},
+        {-s,    c,    0.0f, 0.0f},
+        { 0.0f, 0.0f, 1.0f, 0.0f},
+        { X,    Y,    0.0f, 1.0f}
+    }};
+}
+
+Mat4 Mat4::Orthographic(float Width, float Height, float NearZ, float FarZ) noexcept
+{
+    const float Range = 1.0f / (FarZ - NearZ);
+    return
+    {{
+        {2.0f / Width, 0.0f,          0.0f,           0.0f},
+        {0.0f,         2.0f / Height, 0.0f,           0.0f},
+        {0.0f,         0.0f,          Range,          0.0f},
+        {0.0f,         0.0f,          -NearZ * Range, 1.0f}
+    }};
+}
+
+Mat4 Mat4::Perspective(float FovY, float Aspect, float NearZ, float FarZ) noexcept
+{
+    // Left-handed with depth in [0, 1], like the rest of Direct3D
+    const float YScale = 1.0f / std::tan(0.5f * FovY);
+    const float Range = FarZ / (FarZ - NearZ);
+    return
+    {{
+        {YScale / Aspect, 0.0f,   0.0f,           0.0f},
+        {0.0f,            YScale, 0.0f,           0.0f},
+        {0.0f,            0.0f,   Range,          1.0f},
+        {0.0f,            0.0f,   -NearZ * Range, 0.0f}
+    }};
+}
+
+Mat4 Mat4::LookAt(const Vec3& Eye, const Vec3& Target, const Vec3& Up) noexcept
+{
+    const Vec3 z = Normalize(Target - Eye);
+    const Vec3 x = Normalize(Cross(Up, z));
+    const Vec3 y = Cross(z, x);
+    return
+    {{
+        {x.X,           y.X,           z.X,           0.0f},
+        {x.Y,           y.Y,           z.Y,           0.0f},
+        {x.Z,           y.Z,           z.Z,           0.0f},
+        {-Dot(x, Eye),  -Dot(y, Eye),  -Dot(z, Eye),  1.0f}
+    }};
+}
+
+Mat4 Multiply(const Mat4& A, const Mat4& B) noexcept
+{
+    Mat4 Result;
+    MultiplyNative(A, B, Result);
+    return Result;
+}
+
+Vec4 Transform(const Vec4& v, const Mat4& M) noexcept
+{
+#if defined(SIMD_MATH_SSE)
+    __m128 r = _mm_mul_ps(_mm_set1_ps(v.X), _mm_load_ps(M.M[0]));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(v.Y), _mm_load_ps(M.M[1])));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(v.Z), _mm_load_ps(M.M[2])));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(v.W), _mm_load_ps(M.M[3])));
+    Vec4 Result;
+    _mm_store_ps(&Result.X, r);
+    return Result;
+#else
+    return
+    {
+        v.X * M.M[0][0] + v.Y * M.M[1][0] + v.Z * M.M[2][0] + v.W * M.M[3][0],
+        v.X * M.M[0][1] + v.Y * M.M[1][1] + v.Z * M.M[2][1] + v.W * M.M[3][1],
+        v.X * M.M[0][2] + v.Y * M.M[1][2] + v.Z * M.M[2][2] + v.W * M.M[3][2],
+        v.X * M.M[0][3] + v.Y * M.M[1][3] + v.Z * M.M[2][3] + v.W * M.M[3][3]
+    };
+#endif
+}
+
+Vec3 TransformPoint(const Vec3& p, const Mat4& M) noexcept
+{
+    const Vec4 r = Transform(Vec4{p.X, p.Y, p.Z, 1.0f}, M);
+    return {r.X, r.Y, r.Z};
+}
+
+Vec3 TransformDirection(const Vec3& d, const Mat4& M) noexcept
+{
+    const Vec4 r = Transform(Vec4{d.X, d.Y, d.Z, 0.0f}, M);
+    return {r.X, r.Y, r.Z};
+}
+
+Mat4 Transpose(const Mat4& M) noexcept
+{
+    Mat4 Result;
+    for (size_t r = 0; r < 4u; r++)
+    {
+        for (size_t c = 0; c < 4u; c++)
+        {
+            Result.M[r][c] = M.M[c][r];
+        }
+    }
+    return Result;
+}
+
+Mat4 Inverse(const Mat4& M) noexcept
+{
+    // Cofactor expansion through the 2x2 minors of the top and bottom row pairs
+    const float (&m)[4][4] = M.M;
+    const float s0 = m[0][0] * m[1][1] - m[1][0] * m[0][1];
+    const float s1 = m[0][0] * m[1][2] - m[1][0] * m[0][2];
+    const float s2 = m[0][0] * m[1][3] - m[1][0] * m[0][3];
+    const float s3 = m[0][1] * m[1][2] - m[1][1] * m[0][2];
+    const float s4 = m[0][1] * m[1][3] - m[1][1] * m[0][3];
+    const float s5 = m[0][2] * m[1][3] - m[1][2] * m[0][3];
+    const float c5 = m[2][2] * m[3][3] - m[3][2] * m[2][3];
+    const float c4 = m[2][1] * m[3][3] - m[3][1] * m[2][3];
+    const float c3 = m[2][1] * m[3][2] - m[3][1] * m[2][2];
+    const float c2 = m[2][0] * m[3][3] - m[3][0] * m[2][3];
+    const float c1 = m[2][0] * m[3][2] - m[3][0] * m[2][2];
+    const float c0 = m[2][0] * m[3][1] - m[3][0] * m[2][1];
+
+    const float Determinant = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    if (Determinant == 0.0f || !std::isfinite(Determinant))
+    {
+        return Mat4::Identity();
+    }
+    const float d = 1.0f / Determinant;
+    return
+    {{
+        {( m[1][1] * c5 - m[1][2] * c4 + m[1][3] * c3) * d, (-m[0][1] * c5 + m[0][2] * c4 - m[0][3] * c3) * d, ( m[3][1] * s5 - m[3][2] * s4 + m[3][3] * s3) * d, (-m[2][1] * s5 + m[2][2] * s4 - m[2][3] * s3) * d},
+        {(-m[1][0] * c5 + m[1][2] * c2 - m[1][3] * c1) * d, ( m[0][0] * c5 - m[0][2] * c2 + m[0][3] * c1) * d, (-m[3][0] * s5 + m[3][2] * s2 - m[3][3] * s1) * d, ( m[2][0] * s5 - m[2][2] * s2 + m[2][3] * s1) * d},
+        {( m[1][0] * c4 - m[1][1] * c2 + m[1][3] * c0) * d, (-m[0][0] * c4 + m[0][1] * c2 - m[0][3] * c0) * d, ( m[3][0] * s4 - m[3][1] * s2 + m[3][3] * s0) * d, (-m[2][0] * s4 + m[2][1] * s2 - m[2][3] * s0) * d},
+        {(-m[1][0] * c3 + m[1][1] * c1 - m[1][2] * c0) * d, ( m[0][0] * c3 - m[0][1] * c1 + m[0][2] * c0) * d, (-m[3][0] * s3 + m[3][1] * s1 - m[3][2] * s0) * d, ( m[2][0] * s3 - m[2][1] * s1 + m[2][2] * s0) * d}
+    }};
+}
+
+// Trigonometry
+
+float Sin(float Angle) noexcept
+{
+    float s, c;
+    SinCos(Angle, s, c);
+    return s;
+}
+
+float Cos(float Angle) noexcept
+{
+    float s, c;
+    SinCos(Angle, s, c);
+    return c;
+}
+
+void SinCos(float Angle, float& Sin, float& Cos) noexcept
+{
+    ScalarLanes s, c;
+    SinCosLanes(ScalarLanes{Angle}, s, c);
+    Sin = s.v;
+    Cos = c.v;
+}
+
+// Batches
+
+void SinCos(const float* Angles, float* Sines, float* Cosines, size_t Count, MathPath Path) noexcept
+{
+    ForEachLane(Count, Path, [&](auto Tag, size_t i)
+    {
+        using L = decltype(Tag);
+        L s, c;
+        SinCosLanes(L::Load(Angles + i), s, c);
+        s.Store(Sines + i);
+        c.Store(Cosines + i);
+    });
+}
+
+void TransformPoints(const Mat4& M, ConstPointStreams In, PointStreams Out, size_t Count, MathPath Path) noexcept
+{
+    ForEachLane(Count, Path, [&](auto Tag, size_t i)
+    {
+        using L = decltype(Tag);
+        const L x = L::Load(In.X + i);
+        const L y = L::Load(In.Y + i);
+        const L z = L::Load(In.Z + i);
+        const auto Column = [&](size_t c)
+        {
+            return x * L::Set(M.M[0][c]) + y * L::Set(M.M[1][c]) + z * L::Set(M.M[2][c]) + L::Set(M.M[3][c]);
+        };
+        const L OutX = Column(0u);
+        const L OutY = Column(1u);
+        const L OutZ = Column(2u);
+        OutX.Store(Out.X + i);
+        OutY.Store(Out.Y + i);
+        OutZ.Store(Out.Z + i);
+    });
+}
+
+void MultiplyMatrices(const Mat4* A, const Mat4* B, Mat4* Out, size_t Count, MathPath Path) noexcept
+{
+    ForEachProduct(Count, Path, [&](auto Multiply, size_t i)
+    {
+        Multiply(A[i], B[i], Out[i]);
+    });
+}
+
+void MultiplyMatrices(const Mat4* Local, const Mat4& Parent, Mat4* Out, size_t Count, MathPath Path) noexcept
+{
+    // Copied so a write to Out cannot change it halfway through
+    const Mat4 P = Parent;
+    ForEachProduct(Count, Path, [&](auto Multiply, size_t i)
+    {
+        Multiply(Local[i], P, Out[i]);
+    });
+}
+
+void ComposeTransforms(const TransformStreams& In, Mat4* Out, size_t Count, MathPath Path) noexcept
+{
+    ForEachLane(Count, Path, [&](auto Tag, size_t i)
+    {
+        using L = decltype(Tag);
+        const L x = L::Load(In.RotationX + i);
+        const L y = L::Load(In.RotationY + i);
+        const L z = L::Load(In.RotationZ + i);
+        const L w = L::Load(In.RotationW + i);
+        const L sx = L::Load(In.ScaleX + i);
+        const L sy = L::Load(In.ScaleY + i);
+        const L sz = L::Load(In.ScaleZ + i);
+        const L One = L::Set(1.0f);
+        const L Two = L::Set(2.0f);
+        const L Zero = L::Set(0.0f);
+        const L Components[16] =
+        {
+            (One - Two * (y * y + z * z)) * sx, Two * (x * y + w * z) * sx,         Two * (x * z - w * y) * sx,         Zero,
+            Two * (x * y - w * z) * sy,         (One - Two * (x * x + z * z)) * sy, Two * (y * z + w * x) * sy,         Zero,
+            Two * (x * z + w * y) * sz,         Two * (y * z - w * x) * sz,         (One - Two * (x * x + y * y)) * sz, Zero,
+            L::Load(In.PositionX + i),          L::Load(In.PositionY + i),          L::Load(In.PositionZ + i),          One
+        };
+        StoreMatrices(Components, Out + i);
+    });
+}
+
+void ComposeTransforms2D(const float* X, const float* Y, const float* Scale, const float* Angle, Mat4* Out, size_t Count, MathPath Path) noexcept
+{
+    ForEachLane(Count, Path, [&](auto Tag, size_t i)
+    {
+        using L = decltype(Tag);
+        L s, c;
+        SinCosLanes(L::Load(Angle + i), s, c);
+        const L Scaling = L::Load(Scale + i);
+        s = s * Scaling;
+        c = c * Scaling;
+        const L Zero = L::Set(0.0f);
+        const L One = L::Set(1.0f);
+        const L Components[16] =
+        {
+            c,                 s,                 Zero, Zero,
+            Zero - s,          c,                 Zero, Zero,
+            Zero,              Zero,              One,  Zero,
+            L::Load(X + i),    L::Load(Y + i),    Zero, One
+        };
+        StoreMatrices(Components, Out + i);
+    });
+}
\ No newline at end of file
@@ -0,0 +1,162 @@
+#pragma once
+#include <cstddef>
+
+// Vector, matrix and quaternion types plus batch kernels over structure-of-arrays data.
+// Matrices are row-major and transform row vectors (p * M), the layout DrawConstants
+// expects, so Multiply(A, B) applies A first. Single values use SSE where it pays off;
+// the batch routines are where the throughput is, with AVX2 kernels when the build
+// targets it (/arch:AVX2 defines __AVX2__), SSE2 otherwise and scalar code on other CPUs.
+#if defined(__AVX2__)
+#define SIMD_MATH_AVX2
+#endif
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_MATH_SSE
+#endif
+
+constexpr float Pi = 3.14159265358979323846f;
+
+struct Vec2
+{
+    float X;
+    float Y;
+};
+
+struct Vec3
+{
+    float X;
+    float Y;
+    float Z;
+};
+
+struct alignas(16) Vec4
+{
+    float X;
+    float Y;
+    float Z;
+    float W;
+};
+
+struct alignas(16) Quat
+{
+    float X;
+    float Y;
+    float Z;
+    float W;
+
+    static Quat Identity() noexcept;
+    // Axis must be normalized
+    static Quat FromAxisAngle(const Vec3& Axis, float Angle) noexcept;
+};
+
+struct alignas(16) Mat4
+{
+    float M[4][4];
+
+    static Mat4 Identity() noexcept;
+    static Mat4 Translation(float X, float Y, float Z) noexcept;
+    static Mat4 Scaling(float X, float Y, float Z) noexcept;
+    static Mat4 RotationZ(float Angle) noexcept;
+    static Mat4 Rotation(const Quat& Rotation) noexcept;
+    // Scale, then rotate, then translate
+    static Mat4 Compose(const Vec3& Position, const Quat& Rotation, const Vec3& Scale) noexcept;
+    // Uniform scale and rotation around Z followed by a translation in the XY plane
+    static Mat4 Transform2D(float X, float Y, float Scale, float Angle) noexcept;
+    static Mat4 Orthographic(float Width, float Height, float NearZ, float FarZ) noexcept;
+    static Mat4 Perspective(float FovY, float Aspect, float NearZ, float FarZ) noexcept;
+    static Mat4 LookAt(const Vec3& Eye, const Vec3& Target, const Vec3& Up) noexcept;
+};
+
+inline Vec3 operator+(const Vec3& a, const Vec3& b) noexcept { return {a.X + b.X, a.Y + b.Y, a.Z + b.Z}; }
+inline Vec3 operator-(const Vec3& a, const Vec3& b) noexcept { return {a.X - b.X, a.Y - b.Y, a.Z - b.Z}; }
+inline Vec3 operator*(const Vec3& a, float s) noexcept { return {a.X * s, a.Y * s, a.Z * s}; }
+inline Vec3 operator*(const Vec3& a, const Vec3& b) noexcept { return {a.X * b.X, a.Y * b.Y, a.Z * b.Z}; }
+inline Vec3 operator-(const Vec3& a) noexcept { return {-a.X, -a.Y, -a.Z}; }
+inline Vec4 operator+(const Vec4& a, const Vec4& b) noexcept { return {a.X + b.X, a.Y + b.Y, a.Z + b.Z, a.W + b.W}; }
+inline Vec4 operator-(const Vec4& a, const Vec4& b) noexcept { return {a.X - b.X, a.Y - b.Y, a.Z - b.Z, a.W - b.W}; }
+inline Vec4 operator*(const Vec4& a, float s) noexcept { return {a.X * s, a.Y * s, a.Z * s, a.W * s}; }
+
+inline float Dot(const Vec3& a, const Vec3& b) noexcept { return a.X * b.X + a.Y * b.Y + a.Z * b.Z; }
+inline float Dot(const Vec4& a, const Vec4& b) noexcept { return a.X * b.X + a.Y * b.Y + a.Z * b.Z + a.W * b.W; }
+inline Vec3 Cross(const Vec3& a, const Vec3& b) noexcept
+{
+    return {a.Y * b.Z - a.Z * b.Y, a.Z * b.X - a.X * b.Z, a.X * b.Y - a.Y * b.X};
+}
+float Length(const Vec3& v) noexcept;
+// Zero vectors stay zero
+Vec3 Normalize(const Vec3& v) noexcept;
+Vec3 Min(const Vec3& a, const Vec3& b) noexcept;
+Vec3 Max(const Vec3& a, const Vec3& b) noexcept;
+
+// A then B
+Quat Multiply(const Quat& A, const Quat& B) noexcept;
+Quat Normalize(const Quat& q) noexcept;
+Vec3 Rotate(const Vec3& v, const Quat& q) noexcept;
+Quat Slerp(const Quat& A, const Quat& B, float t) noexcept;
+
+// A then B
+Mat4 Multiply(const Mat4& A, const Mat4& B) noexcept;
+Vec4 Transform(const Vec4& v, const Mat4& M) noexcept;
+// w = 1, no perspective divide
+Vec3 TransformPoint(const Vec3& p, const Mat4& M) noexcept;
+// w = 0
+Vec3 TransformDirection(const Vec3& d, const Mat4& M) noexcept;
+Mat4 Transpose(const Mat4& M) noexcept;
+// General inverse, singular matrices return the identity
+Mat4 Inverse(const Mat4& M) noexcept;
+
+// Polynomial sine and cosine, accurate to a few float ulps for |Angle| below 1e4. The
+// batch SinCos evaluates the same polynomial.
+float Sin(float Angle) noexcept;
+float Cos(float Angle) noexcept;
+void SinCos(float Angle, float& Sin, float& Cos) noexcept;
+
+// Batch routines. Arrays hold Count elements each and need no particular alignment.
+// MathPath::Scalar forces the reference kernels, for measuring what the SIMD ones gain.
+// MathPath::Sse forces the 4-wide kernels even in AVX2 builds, it is the scalar path on
+// targets without SSE.
+enum class MathPath
+{
+    Native,
+    Sse,
+    Scalar
+};
+
+// Component arrays of Count positions
+struct PointStreams
+{
+    float* X;
+    float* Y;
+    float* Z;
+};
+struct ConstPointStreams
+{
+    const float* X;
+    const float* Y;
+    const float* Z;
+};
+// Component arrays of Count position, rotation and scale triples
+struct TransformStreams
+{
+    const float* PositionX;
+    const float* PositionY;
+    const float* PositionZ;
+    const float* RotationX;
+    const float* RotationY;
+    const float* RotationZ;
+    const float* RotationW;
+    const float* ScaleX;
+    const float* ScaleY;
+    const float* ScaleZ;
+};
+
+void SinCos(const float* Angles, float* Sines, float* Cosines, size_t Count, MathPath Path = MathPath::Native) noexcept;
+// Out may alias In
+void TransformPoints(const Mat4& M, ConstPointStreams In, PointStreams Out, size_t Count, MathPath Path = MathPath::Native) noexcept;
+// Out[i] = Multiply(A[i], B[i]), Out may alias either input
+void MultiplyMatrices(const Mat4* A, const Mat4* B, Mat4* Out, size_t Count, MathPath Path = MathPath::Native) noexcept;
+// Out[i] = Multiply(Local[i], Parent), the common case of many children under one parent
+void MultiplyMatrices(const Mat4* Local, const Mat4& Parent, Mat4* Out, size_t Count, MathPath Path = MathPath::Native) noexcept;
+// Out[i] = Mat4::Compose of element i
+void ComposeTransforms(const TransformStreams& In, Mat4* Out, size_t Count, MathPath Path = MathPath::Native) noexcept;
+// Out[i] = Mat4::Transform2D of element i
+void ComposeTransforms2D(const float* X, const float* Y, const float* Scale, const float* Angle, Mat4* Out, size_t Count, MathPath Path = MathPath::Native) noexcept;
\ No newline at end of file
@@ -1,21 +1,19 @@
 #include "timer.h"
+#include "tsc_clock.h"
 
-using namespace std::chrono;
-
-Timer::Timer()
+Timer::Timer() noexcept
 {
-    Last = steady_clock::now();
+    Last = TscClock::Now();
 }
 
-float Timer::Mark()
+float Timer::Mark() noexcept
 {
-    const auto Old = Last;
-    Last = steady_clock::now();
-    const duration<float> FrameTime = Last - Old;
-    return FrameTime.count();
+    const uint64_t Old = Last;
+    Last = TscClock::Now();
+    return static_cast<float>(TscClock::ToSeconds(Last - Old));
 }
 
-float Timer::Peek() const
+double Timer::Peek() const noexcept
 {
-    return duration<float>(steady_clock::now() - Last).count();
+    return TscClock::ToSeconds(TscClock::Now() - Last);
 }
\ No newline at end of file
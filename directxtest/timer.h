@@ -1,12 +1,15 @@
 #pragma once
-#include <chrono>
+#include <cstdint>
 
+// Ticks are kept as integers and only the elapsed time is converted, so frame times from
+// Mark do not lose precision in long sessions. Peek measures since the last Mark, which
+// for a clock that is never marked grows with the session, so it stays double.
 class Timer
 {
 public:
-    Timer();
-    float Mark();
-    float Peek() const;
+    Timer() noexcept;
+    float Mark() noexcept;
+    double Peek() const noexcept;
 private:
-    std::chrono::steady_clock::time_point Last;
+    uint64_t Last;
 };
\ No newline at end of file
@@ -0,0 +1,274 @@
+#include "transform_hierarchy.h"
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+namespace
+{
+    // Moves element i to NewIndex[i]
+    template<typename T>
+    void Permute(std::vector<T>& Values, const std::vector<uint32_t>& NewIndex)
+    {
+        std::vector<T> Sorted(Values.size());
+        for (size_t i = 0; i < Values.size(); i++)
+        {
+            Sorted[NewIndex[i]] = Values[i];
+        }
+        Values.swap(Sorted);
+    }
+}
+
+void TransformHierarchy::Reserve(size_t Count)
+{
+    for (std::vector<float>* Stream : {&PositionX, &PositionY, &PositionZ, &RotationX, &RotationY, &RotationZ, &RotationW, &ScaleX, &ScaleY, &ScaleZ})
+    {
+        Stream->reserve(Count);
+    }
+    World.reserve(Count);
+    Parent.reserve(Count);
+    Depth.reserve(Count);
+    Dirty.reserve(Count);
+    Changed.reserve(Count);
+    IndexOfNode.reserve(Count);
+    NodeAtIndex.reserve(Count);
+}
+
+TransformHierarchy::Node TransformHierarchy::Add(Node ParentNode, const Local& Transform)
+{
+    if (ParentNode != NoParent && ParentNode >= IndexOfNode.size())
+    {
+        throw std::invalid_argument("Transform parent does not exist");
+    }
+
+    const uint32_t Index = static_cast<uint32_t>(Parent.size());
+    const Node Created = static_cast<Node>(IndexOfNode.size());
+    const uint32_t ParentIndex = ParentNode != NoParent ? IndexOfNode[ParentNode] : NoParent;
+    const uint32_t NodeDepth = ParentIndex != NoParent ? Depth[ParentIndex] + 1u : 0u;
+
+    // Appending keeps depth order unless the node belongs to an earlier level
+    if (LevelStart.empty())
+    {
+        LevelStart = {0u, 1u};
+    }
+    else if (Sorted && NodeDepth == Depth.back())
+    {
+        LevelStart.back()++;
+    }
+    else if (Sorted && NodeDepth == Depth.back() + 1u)
+    {
+        LevelStart.push_back(LevelStart.back() + 1u);
+    }
+    else
+    {
+        Sorted = false;
+    }
+
+    IndexOfNode.push_back(Index);
+    NodeAtIndex.push_back(Created);
+    Parent.push_back(ParentIndex);
+    Depth.push_back(NodeDepth);
+    PositionX.push_back(0.0f);
+    PositionY.push_back(0.0f);
+    PositionZ.push_back(0.0f);
+    RotationX.push_back(0.0f);
+    RotationY.push_back(0.0f);
+    RotationZ.push_back(0.0f);
+    RotationW.push_back(1.0f);
+    ScaleX.push_back(1.0f);
+    ScaleY.push_back(1.0f);
+    ScaleZ.push_back(1.0f);
+    World.push_back(Mat4::Identity());
+    Dirty.push_back(1u);
+    Changed.push_back(0u);
+    SetLocal(Created, Transform);
+    return Created;
+}
+
+void TransformHierarchy::Clear() noexcept
+{
+    for (std::vector<float>* Stream : {&PositionX, &PositionY, &PositionZ, &RotationX, &RotationY, &RotationZ, &RotationW, &ScaleX, &ScaleY, &ScaleZ})
+    {
+        Stream->clear();
+    }
+    World.clear();
+    Parent.clear();
+    Depth.clear();
+    Dirty.clear();
+    Changed.clear();
+    IndexOfNode.clear();
+    NodeAtIndex.clear();
+    LevelStart.clear();
+    Sorted = true;
+    ChangedCount = 0u;
+}
+
+void TransformHierarchy::SetLocal(Node n, const Local& Transform) noexcept
+{
+    const uint32_t i = IndexOfNode[n];
+    PositionX[i] = Transform.Position.X;
+    PositionY[i] = Transform.Position.Y;
+    PositionZ[i] = Transform.Position.Z;
+    RotationX[i] = Transform.Rotation.X;
+    RotationY[i] = Transform.Rotation.Y;
+    RotationZ[i] = Transform.Rotation.Z;
+    RotationW[i] = Transform.Rotation.W;
+    ScaleX[i] = Transform.Scale.X;
+    ScaleY[i] = Transform.Scale.Y;
+    ScaleZ[i] = Transform.Scale.Z;
+    Dirty[i] = 1u;
+}
+
+TransformHierarchy::Local TransformHierarchy::GetLocal(Node n) const noexcept
+{
+    const uint32_t i = IndexOfNode[n];
+    Local Result;
+    Result.Position = {PositionX[i], PositionY[i], PositionZ[i]};
+    Result.Rotation = {RotationX[i], RotationY[i], RotationZ[i], RotationW[i]};
+    Result.Scale = {ScaleX[i], ScaleY[i], ScaleZ[i]};
+    return Result;
+}
+
+TransformHierarchy::Node TransformHierarchy::GetParent(Node n) const noexcept
+{
+    const uint32_t p = Parent[IndexOfNode[n]];
+    return p != NoParent ? NodeAtIndex[p] : NoParent;
+}
+
+const Mat4& TransformHierarchy::GetWorld(Node n) const noexcept
+{
+    return World[IndexOfNode[n]];
+}
+
+bool TransformHierarchy::WasChanged(Node n) const noexcept
+{
+    return Changed[IndexOfNode[n]] != 0u;
+}
+
+void TransformHierarchy::Update(JobSystem* Jobs)
+{
+    if (!Sorted)
+    {
+        Sort();
+    }
+
+    std::atomic<size_t> Count{0u};
+    for (size_t Level = 0; Level + 1u < LevelStart.size(); Level++)
+    {
+        const size_t Begin = LevelStart[Level];
+        const size_t End = LevelStart[Level + 1u];
+        if (Jobs != nullptr && End - Begin > Grain)
+        {
+            Jobs->ParallelFor(End - Begin, Grain, [&](size_t First, size_t Last, unsigned int)
+            {
+                Count.fetch_add(UpdateRange(Begin + First, Begin + Last), std::memory_order_relaxed);
+            });
+        }
+        else
+        {
+            Count.fetch_add(UpdateRange(Begin, End), std::memory_order_relaxed);
+        }
+    }
+    ChangedCount = Count.load(std::memory_order_relaxed);
+}
+
+size_t TransformHierarchy::UpdateRange(size_t Begin, size_t End) noexcept
+{
+    // Parents sit in an earlier level, so their flags are final
+    for (size_t i = Begin; i < End; i++)
+    {
+        const uint32_t p = Parent[i];
+        Changed[i] = Dirty[i] | (p != NoParent ? Changed[p] : uint8_t(0u));
+        Dirty[i] = 0u;
+    }
+
+    // Runs of changed nodes go through the batch kernels together
+    constexpr size_t BatchSize = 64u;
+    Mat4 LocalMatrices[BatchSize];
+    size_t Count = 0u;
+    for (size_t i = Begin; i < End; )
+    {
+        if (Changed[i] == 0u)
+        {
+            i++;
+            continue;
+        }
+        size_t RunEnd = i + 1u;
+        while (RunEnd < End && RunEnd - i < BatchSize && Changed[RunEnd] != 0u)
+        {
+            RunEnd++;
+        }
+
+        const TransformStreams Streams =
+        {
+            &PositionX[i], &PositionY[i], &PositionZ[i],
+            &RotationX[i], &RotationY[i], &RotationZ[i], &RotationW[i],
+            &ScaleX[i], &ScaleY[i], &ScaleZ[i]
+        };
+        ComposeTransforms(Streams, LocalMatrices, RunEnd - i);
+        for (size_t k = i; k < RunEnd; k++)
+        {
+            const uint32_t p = Parent[k];
+            World[k] = p != NoParent ? Multiply(LocalMatrices[k - i], World[p]) : LocalMatrices[k - i];
+        }
+        Count += RunEnd - i;
+        i = RunEnd;
+    }
+    return Count;
+}
+
+void TransformHierarchy::Sort()
+{
+    // Counting sort by depth, stable so siblings keep the order they were added in
+    const uint32_t Levels = *std::max_element(Depth.begin(), Depth.end()) + 1u;
+    LevelStart.assign(Levels + 1u, 0u);
+    for (const uint32_t d : Depth)
+    {
+        LevelStart[d + 1u]++;
+    }
+    for (size_t Level = 1; Level <= Levels; Level++)
+    {
+        LevelStart[Level] += LevelStart[Level - 1u];
+    }
+
+    std::vector<size_t> Cursor(LevelStart.begin(), LevelStart.end() - 1);
+    std::vector<uint32_t> NewIndex(Depth.size());
+    for (size_t i = 0; i < Depth.size(); i++)
+    {
+        NewIndex[i] = static_cast<uint32_t>(Cursor[Depth[i]]++);
+    }
+
+    for (std::vector<float>* Stream : {&PositionX, &PositionY, &PositionZ, &RotationX, &RotationY, &RotationZ, &RotationW, &ScaleX, &ScaleY, &ScaleZ})
+    {
+        Permute(*Stream, NewIndex);
+    }
+    Permute(World, NewIndex);
+    Permute(Depth, NewIndex);
+    Permute(Dirty, NewIndex);
+    Permute(Changed, NewIndex);
+    Permute(NodeAtIndex, NewIndex);
+    for (uint32_t& p : Parent)
+    {
+        p = p != NoParent ? NewIndex[p] : NoParent;
+    }
+    Permute(Parent, NewIndex);
+    for (size_t i = 0; i < NodeAtIndex.size(); i++)
+    {
+        IndexOfNode[NodeAtIndex[i]] = static_cast<uint32_t>(i);
+    }
+    Sorted = true;
+}
+
+size_t TransformHierarchy::GetNodeCount() const noexcept
+{
+    return Parent.size();
+}
+
+size_t TransformHierarchy::GetDepthCount() const noexcept
+{
+    return LevelStart.empty() ? 0u : LevelStart.size() - 1u;
+}
+
+size_t TransformHierarchy::GetChangedCount() const noexcept
+{
+    return ChangedCount;
+}
\ No newline at end of file
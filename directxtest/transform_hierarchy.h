@@ -0,0 +1,80 @@
+#pragma once
+#include "simd_math.h"
+#include "job_system.h"
+#include <cstdint>
+#include <vector>
+
+// Transform hierarchy stored as flat arrays sorted by depth, so every parent comes before
+// its children and Update is one linear pass with no pointer chasing. Local transforms
+// are position, rotation and scale in structure-of-arrays form for the batch kernels.
+// Setting a local transform marks the node dirty; Update recomputes world matrices for
+// dirty nodes and everything below them only. Each depth level is independent, so large
+// levels are split across the job system.
+//
+// Nodes are addressed by the id Add returned, which stays valid for the hierarchy's
+// lifetime. World matrices and change flags are valid after Update.
+class TransformHierarchy
+{
+public:
+    using Node = uint32_t;
+    static constexpr Node NoParent = ~0u;
+    struct Local
+    {
+        Vec3 Position = {0.0f, 0.0f, 0.0f};
+        Quat Rotation = Quat::Identity();
+        Vec3 Scale = {1.0f, 1.0f, 1.0f};
+    };
+    // Nodes per job, and levels smaller than this run on the calling thread
+    static constexpr size_t Grain = 4096u;
+public:
+    void Reserve(size_t Count);
+    // Parent must already exist, or be NoParent for a root
+    Node Add(Node Parent, const Local& Transform);
+    void Clear() noexcept;
+
+    void SetLocal(Node n, const Local& Transform) noexcept;
+    Local GetLocal(Node n) const noexcept;
+    Node GetParent(Node n) const noexcept;
+    const Mat4& GetWorld(Node n) const noexcept;
+    // True if the world matrix changed in the last Update
+    bool WasChanged(Node n) const noexcept;
+
+    // Serial when Jobs is null
+    void Update(JobSystem* Jobs = nullptr);
+
+    size_t GetNodeCount() const noexcept;
+    size_t GetDepthCount() const noexcept;
+    // Nodes whose world matrix the last Update recomputed
+    size_t GetChangedCount() const noexcept;
+private:
+    // Restores depth order after nodes were added deeper than the current last level
+    void Sort();
+    // Returns how many world matrices were recomputed
+    size_t UpdateRange(size_t Begin, size_t End) noexcept;
+private:
+    // Indexed by position in depth order
+    std::vector<float> PositionX;
+    std::vector<float> PositionY;
+    std::vector<float> PositionZ;
+    std::vector<float> RotationX;
+    std::vector<float> RotationY;
+    std::vector<float> RotationZ;
+    std::vector<float> RotationW;
+    std::vector<float> ScaleX;
+    std::vector<float> ScaleY;
+    std::vector<float> ScaleZ;
+    std::vector<Mat4> World;
+    std::vector<uint32_t> Parent;
+    std::vector<uint32_t> Depth;
+    // Set by SetLocal, cleared by Update
+    std::vector<uint8_t> Dirty;
+    // Dirty here or above, written by Update
+    std::vector<uint8_t> Changed;
+    // Position in depth order of every node id and the other way round
+    std::vector<uint32_t> IndexOfNode;
+    std::vector<Node> NodeAtIndex;
+    // First index of every depth, plus the end
+    std::vector<size_t> LevelStart;
+    bool Sorted = true;
+    size_t ChangedCount = 0u;
+};
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include "tsc_clock.h"
+#include <chrono>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define TSC_AVAILABLE
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace
+{
+    // Long enough that the steady_clock resolution is a negligible part of the measurement
+    constexpr std::chrono::milliseconds CalibrationTime(20);
+
+    bool HasInvariantTsc() noexcept
+    {
+#if !defined(TSC_AVAILABLE)
+        return false;
+#elif defined(_MSC_VER)
+        int Registers[4] = {};
+        __cpuid(Registers, 0x80000000);
+        if (static_cast<unsigned int>(Registers[0]) < 0x80000007u)
+        {
+            return false;
+        }
+        __cpuid(Registers, 0x80000007);
+        return (Registers[3] & (1 << 8)) != 0;
+#else
+        unsigned int a = 0u, b = 0u, c = 0u, d = 0u;
+        if (__get_cpuid_max(0x80000000u, nullptr) < 0x80000007u || !__get_cpuid(0x80000007u, &a, &b, &c, &d))
+        {
+            return false;
+        }
+        return (d & (1u << 8u)) != 0u;
+#endif
+    }
+
+    uint64_t ReadTsc() noexcept
+    {
+#ifdef TSC_AVAILABLE
+        return __rdtsc();
+#else
+        return 0u;
+#endif
+    }
+
+    uint64_t ReadSteadyClock() noexcept
+    {
+        return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    }
+}
+
+TscClock::Calibration TscClock::Calibrate() noexcept
+{
+    using namespace std::chrono;
+
+    Calibration Result;
+    if (!HasInvariantTsc())
+    {
+        Result.TicksPerSecond = static_cast<double>(steady_clock::period::den) / static_cast<double>(steady_clock::period::num);
+        Result.SecondsPerTick = 1.0 / Result.TicksPerSecond;
+        return Result;
+    }
+
+    // Spin rather than sleep, both clocks are read back to back at each end
+    const auto Start = steady_clock::now();
+    const uint64_t StartTicks = ReadTsc();
+    auto End = Start;
+    while (End - Start < CalibrationTime)
+    {
+        End = steady_clock::now();
+    }
+    const uint64_t EndTicks = ReadTsc();
+
+    Result.UseTsc = true;
+    Result.TicksPerSecond = static_cast<double>(EndTicks - StartTicks) / duration<double>(End - Start).count();
+    Result.SecondsPerTick = 1.0 / Result.TicksPerSecond;
+    return Result;
+}
+
+const TscClock::Calibration& TscClock::Get() noexcept
+{
+    static const Calibration Instance = Calibrate();
+    return Instance;
+}
+
+uint64_t TscClock::Now() noexcept
+{
+    return Get().UseTsc ? ReadTsc() : ReadSteadyClock();
+}
+
+double TscClock::GetFrequency() noexcept
+{
+    return Get().TicksPerSecond;
+}
+
+double TscClock::ToSeconds(uint64_t Ticks) noexcept
+{
+    return static_cast<double>(Ticks) * Get().SecondsPerTick;
+}
+
+bool TscClock::IsUsingTsc() noexcept
+{
+    return Get().UseTsc;
+}
\ No newline at end of file
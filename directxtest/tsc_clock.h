@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+
+// Monotonic clock that costs a few nanoseconds per read. Uses the invariant TSC when
+// the CPU has one, calibrated against steady_clock on first use, and steady_clock
+// otherwise. Ticks are 64-bit integers that stay exact for centuries, only differences
+// should be converted to seconds.
+class TscClock
+{
+public:
+    static uint64_t Now() noexcept;
+    static double GetFrequency() noexcept;
+    static double ToSeconds(uint64_t Ticks) noexcept;
+    static bool IsUsingTsc() noexcept;
+private:
+    struct Calibration
+    {
+        bool UseTsc = false;
+        double TicksPerSecond = 0.0;
+        double SecondsPerTick = 0.0;
+    };
+    static Calibration Calibrate() noexcept;
+    static const Calibration& Get() noexcept;
+};
\ No newline at end of file
@@ -1,4 +1,15 @@
+cbuffer FrameConstants : register(b0)
+{
+    float4 Tint;
+    float Time;
+};
+
+cbuffer DrawConstants : register(b2)
+{
+    row_major float4x4 Transform;
+};
+
 float4 main(float2 pos : Position) : SV_Position
 {
-    return float4( pos.x, pos.y, 0.0f, 1.0f);
+    return mul(float4(pos.x, pos.y, 0.0f, 1.0f), Transform);
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "win_class.h"
 #include <sstream>
 #include "resource.h"
+#include "alloc_tracker.h"
 
 Window::WindowClass Window::WindowClass::WinClass;
 
@@ -38,7 +39,7 @@ HINSTANCE Window::WindowClass::GetInstance() noexcept
     return WinClass.hInstance;
 }
 
-Window::Window(int Width, int Height, const wchar_t* Name) : Width(Width), Height(Height)
+Window::Window(int Width, int Height, const wchar_t* Name, const std::filesystem::path& CapturePath) : Width(Width), Height(Height)
 {
     RECT WindowRect;
     WindowRect.left = 100;
@@ -64,7 +65,7 @@ Window::Window(int Width, int Height, const wchar_t* Name) : Width(Width), Heigh
     ShowWindow(WindowHandle, SW_SHOWDEFAULT);
 
     // Create Graphics object
-    GFX = std::make_unique<Graphics>(WindowHandle);
+    GFX = std::make_unique<Graphics>(WindowHandle, CapturePath);
 }
 
 Window::~Window()
@@ -136,6 +137,7 @@ void Window::SetTitle(const std::string& Title)
 // NOTE: MAIN WINDOW MESSAGE HANDLER
 LRESULT Window::HandleMessage(HWND WindowHandle, UINT Message, WPARAM wParam, LPARAM lParam) noexcept
 {
+    AllocScope Scope(AllocTag::Window);
     switch (Message)
     {
         case WM_CLOSE:
@@ -238,6 +240,7 @@ Window::HrException::HrException(int Line, const char* File, HRESULT Result) noe
 
 const char* Window::HrException::what() const noexcept
 {
+    AllocScope Scope(AllocTag::Exception);
     std::ostringstream oss;
     oss << GetType() << std::endl
         << "[Error Code] 0x" << std::hex << std::uppercase << GetErrorCode()
@@ -4,6 +4,7 @@
 #include "keyboard.h"
 #include "mouse.h"
 #include "graphics.h"
+#include <filesystem>
 #include <optional>
 #include <memory>
 
@@ -50,7 +51,7 @@ private:
         HINSTANCE hInstance;
     };
 public:
-    Window(int Width, int Height, const wchar_t* Name);
+    Window(int Width, int Height, const wchar_t* Name, const std::filesystem::path& CapturePath = {});
     ~Window();
     Window(const Window&) = delete;
     Window& operator=(const Window&) = delete;
@@ -0,0 +1,246 @@
+#include "mesh_simplifier.h"
+#include "obj_reader.h"
+#include "job_system.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Exit codes, so a build script can tell failed assets from a broken invocation
+namespace
+{
+    constexpr int Simplified = 0;
+    constexpr int AssetsFailed = 1;
+    constexpr int Failure = 2;
+
+    struct Asset
+    {
+        std::filesystem::path Input;
+        std::filesystem::path Output;
+        uintmax_t Size = 0u;
+        // Filled in by the job that simplifies the asset
+        MeshData Result;
+        size_t Triangles = 0u;
+        double Seconds = 0.0;
+        std::string Error;
+    };
+
+    bool IsMeshInput(const std::filesystem::path& Path)
+    {
+        return Path.extension() == ".obj" || Path.extension() == ".mesh";
+    }
+
+    // "a,b,c"
+    std::vector<uint32_t> ParseTargets(const std::string& Arg)
+    {
+        std::vector<uint32_t> Targets;
+        std::istringstream List(Arg);
+        std::string Item;
+        while (std::getline(List, Item, ','))
+        {
+            Targets.push_back(static_cast<uint32_t>(std::stoul(Item)));
+        }
+        return Targets;
+    }
+
+    void Simplify(const MeshSimplifier& Simplifier, Asset& Job) noexcept
+    {
+        const auto Start = std::chrono::steady_clock::now();
+        try
+        {
+            const MeshData Input = Job.Input.extension() == ".obj" ? ReadObj(Job.Input) : ReadMesh(Job.Input);
+            Job.Result = Simplifier.Simplify(Input);
+            Job.Triangles = Job.Result.Levels[0].IndexCount / 3u;
+            WriteMesh(Job.Output, Job.Result);
+        }
+        catch (const MyException& e)
+        {
+            Job.Error = e.what();
+        }
+        catch (const std::exception& e)
+        {
+            Job.Error = e.what();
+        }
+        catch (...)
+        {
+            Job.Error = "Unknown Exception";
+        }
+        Job.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+    }
+
+    void WriteReport(std::ostream& Out, const std::vector<Asset>& Assets, double Seconds, unsigned int Threads)
+    {
+        size_t Triangles = 0u;
+        size_t Failed = 0u;
+        for (const Asset& a : Assets)
+        {
+            Out << std::endl << a.Input.string() << std::fixed << std::setprecision(3) << "  " << a.Seconds << " s" << std::endl;
+            if (!a.Error.empty())
+            {
+                Out << "  failed: " << a.Error << std::endl;
+                Failed++;
+                continue;
+            }
+            Triangles += a.Triangles;
+            Out << "  " << std::setw(5) << "level" << std::setw(12) << "triangles" << std::setw(12) << "vertices"
+                << std::setw(14) << "error" << std::setw(10) << "error %" << std::endl;
+            for (size_t l = 0; l < a.Result.Levels.size(); l++)
+            {
+                // Every level has a contiguous range of positions of its own
+                const LodLevel& Level = a.Result.Levels[l];
+                const uint32_t* Indices = a.Result.Indices.data() + Level.FirstIndex;
+                const auto Range = std::minmax_element(Indices, Indices + Level.IndexCount);
+                const size_t Vertices = Level.IndexCount > 0u ? *Range.second - *Range.first + 1u : 0u;
+                Out << "  " << std::setw(5) << l << std::setw(12) << Level.IndexCount / 3u << std::setw(12) << Vertices
+                    << std::setw(14) << std::setprecision(6) << Level.Error * a.Result.Radius
+                    << std::setw(10) << std::setprecision(3) << 100.0f * Level.Error << std::endl;
+            }
+        }
+
+        Out << std::endl << "Simplified " << Assets.size() - Failed << " of " << Assets.size() << " assets, "
+            << Triangles << " triangles in " << std::setprecision(3) << Seconds << " s on " << Threads << " threads, "
+            << std::setprecision(2) << (Seconds > 0.0 ? Triangles / Seconds * 1e-6 : 0.0) << " M triangles/s" << std::endl;
+    }
+
+    void PrintUsage()
+    {
+        std::cerr << "usage: meshsimplify [options] <input>..." << std::endl
+            << "  <input> are .obj or .mesh files, or directories searched for them" << std::endl
+            << "  -out <dir>          where the .mesh files go (next to each input)" << std::endl
+            << "  -levels <n>         levels of detail including the full one (5)" << std::endl
+            << "  -ratio <r>          triangles of a level over the previous one (0.5)" << std::endl
+            << "  -min <n>            fewest triangles of a level (64)" << std::endl
+            << "  -targets <a,b,...>  triangle counts of the simplified levels, replaces the three above" << std::endl
+            << "  -threads <n>        threads to simplify on, 0 for every hardware thread (0)" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        MeshSimplifier::Settings Config;
+        std::filesystem::path OutDirectory;
+        unsigned int Threads = 0u;
+        std::vector<std::filesystem::path> Inputs;
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string Arg = argv[i];
+            if (Arg == "-out" && i + 1 < argc)
+            {
+                OutDirectory = argv[++i];
+            }
+            else if (Arg == "-levels" && i + 1 < argc)
+            {
+                Config.LevelCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+            }
+            else if (Arg == "-ratio" && i + 1 < argc)
+            {
+                Config.Ratio = std::stof(argv[++i]);
+            }
+            else if (Arg == "-min" && i + 1 < argc)
+            {
+                Config.MinTriangles = static_cast<uint32_t>(std::stoul(argv[++i]));
+            }
+            else if (Arg == "-targets" && i + 1 < argc)
+            {
+                Config.Targets = ParseTargets(argv[++i]);
+            }
+            else if (Arg == "-threads" && i + 1 < argc)
+            {
+                Threads = static_cast<unsigned int>(std::stoul(argv[++i]));
+            }
+            else if (!Arg.empty() && Arg[0] != '-')
+            {
+                Inputs.emplace_back(Arg);
+            }
+            else
+            {
+                PrintUsage();
+                return Failure;
+            }
+        }
+        if (Inputs.empty())
+        {
+            PrintUsage();
+            return Failure;
+        }
+        const MeshSimplifier Simplifier(Config);
+
+        std::vector<Asset> Assets;
+        const auto AddAsset = [&](const std::filesystem::path& Input)
+        {
+            Asset Job;
+            Job.Input = Input;
+            Job.Output = (OutDirectory.empty() ? Input.parent_path() : OutDirectory) / Input.filename();
+            Job.Output.replace_extension(".mesh");
+            if (Job.Output == Job.Input)
+            {
+                Job.Output.replace_extension(".lod.mesh");
+            }
+            Job.Size = std::filesystem::file_size(Input);
+            Assets.push_back(std::move(Job));
+        };
+        for (const std::filesystem::path& Input : Inputs)
+        {
+            if (!std::filesystem::is_directory(Input))
+            {
+                AddAsset(Input);
+                continue;
+            }
+            for (const auto& Entry : std::filesystem::recursive_directory_iterator(Input))
+            {
+                if (Entry.is_regular_file() && IsMeshInput(Entry.path()))
+                {
+                    AddAsset(Entry.path());
+                }
+            }
+        }
+        if (!OutDirectory.empty())
+        {
+            std::filesystem::create_directories(OutDirectory);
+        }
+
+        // One asset per job, largest first so a big one does not start last and run alone
+        std::vector<Asset*> Order;
+        for (Asset& a : Assets)
+        {
+            Order.push_back(&a);
+        }
+        std::stable_sort(Order.begin(), Order.end(), [](const Asset* a, const Asset* b) { return a->Size > b->Size; });
+
+        JobSystem Jobs(Threads == 0u ? JobSystem::HardwareWorkers : Threads - 1u);
+        const auto Start = std::chrono::steady_clock::now();
+        Jobs.ParallelFor(Order.size(), 1u, [&](size_t Begin, size_t End, unsigned int)
+        {
+            for (size_t i = Begin; i < End; i++)
+            {
+                Simplify(Simplifier, *Order[i]);
+            }
+        });
+        const double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+
+        WriteReport(std::cout, Assets, Seconds, Jobs.GetThreadCount());
+        const bool AnyFailed = std::any_of(Assets.begin(), Assets.end(), [](const Asset& a) { return !a.Error.empty(); });
+        return AnyFailed ? AssetsFailed : Simplified;
+    }
+    catch (const MyException& e)
+    {
+        std::cerr << e.GetType() << std::endl << e.what() << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Standard Exception" << std::endl << e.what() << std::endl;
+    }
+    catch (...)
+    {
+        std::cerr << "Unknown Exception" << std::endl << "No details available" << std::endl;
+    }
+
+    return Failure;
+}
\ No newline at end of file
@@ -0,0 +1,644 @@
+#include "mesh_simplifier.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+namespace
+{
+    // Weight of the planes across open borders, relative to the area weight of a
+    // triangle's plane
+    constexpr double BorderWeight = 10.0;
+    // Smallest cosine between a triangle's normal before and after a collapse
+    constexpr double MinNormalCosine = 0.2;
+    constexpr uint32_t Unused = ~0u;
+
+    struct Point
+    {
+        double X;
+        double Y;
+        double Z;
+    };
+
+    Point operator+(const Point& a, const Point& b) noexcept { return {a.X + b.X, a.Y + b.Y, a.Z + b.Z}; }
+    Point operator-(const Point& a, const Point& b) noexcept { return {a.X - b.X, a.Y - b.Y, a.Z - b.Z}; }
+    Point operator*(const Point& a, double s) noexcept { return {a.X * s, a.Y * s, a.Z * s}; }
+    double Dot(const Point& a, const Point& b) noexcept { return a.X * b.X + a.Y * b.Y + a.Z * b.Z; }
+    Point Cross(const Point& a, const Point& b) noexcept
+    {
+        return {a.Y * b.Z - a.Z * b.Y, a.Z * b.X - a.X * b.Z, a.X * b.Y - a.Y * b.X};
+    }
+
+    // Sum of weighted squared distances to planes, p A p + 2 b.p + c with A symmetric
+    struct Quadric
+    {
+        double XX = 0.0;
+        double XY = 0.0;
+        double XZ = 0.0;
+        double YY = 0.0;
+        double YZ = 0.0;
+        double ZZ = 0.0;
+        double X = 0.0;
+        double Y = 0.0;
+        double Z = 0.0;
+        double C = 0.0;
+        // Triangle area the planes stand for
+        double Area = 0.0;
+
+        // Plane Dot(Normal, p) + Distance = 0, Normal is unit length
+        void AddPlane(const Point& Normal, double Distance, double Weight) noexcept
+        {
+            XX += Weight * Normal.X * Normal.X;
+            XY += Weight * Normal.X * Normal.Y;
+            XZ += Weight * Normal.X * Normal.Z;
+            YY += Weight * Normal.Y * Normal.Y;
+            YZ += Weight * Normal.Y * Normal.Z;
+            ZZ += Weight * Normal.Z * Normal.Z;
+            X += Weight * Distance * Normal.X;
+            Y += Weight * Distance * Normal.Y;
+            Z += Weight * Distance * Normal.Z;
+            C += Weight * Distance * Distance;
+        }
+        void Add(const Quadric& q) noexcept
+        {
+            XX += q.XX;
+            XY += q.XY;
+            XZ += q.XZ;
+            YY += q.YY;
+            YZ += q.YZ;
+            ZZ += q.ZZ;
+            X += q.X;
+            Y += q.Y;
+            Z += q.Z;
+            C += q.C;
+            Area += q.Area;
+        }
+        double Evaluate(const Point& p) const noexcept
+        {
+            const double Ax = XX * p.X + XY * p.Y + XZ * p.Z;
+            const double Ay = XY * p.X + YY * p.Y + YZ * p.Z;
+            const double Az = XZ * p.X + YZ * p.Y + ZZ * p.Z;
+            return p.X * Ax + p.Y * Ay + p.Z * Az + 2.0 * (X * p.X + Y * p.Y + Z * p.Z) + C;
+        }
+        // Solves A p = -b, false when A is too close to singular, e.g. for a flat
+        // neighbourhood where the whole plane has the same error
+        bool Minimize(Point& Out) const noexcept
+        {
+            const double Co0 = YY * ZZ - YZ * YZ;
+            const double Co1 = XZ * YZ - XY * ZZ;
+            const double Co2 = XY * YZ - XZ * YY;
+            const double Det = XX * Co0 + XY * Co1 + XZ * Co2;
+            const double Trace = XX + YY + ZZ;
+            if (!(std::abs(Det) > 1e-9 * Trace * Trace * Trace))
+            {
+                return false;
+            }
+            // The inverse of a symmetric matrix is symmetric, only six cofactors are needed
+            const double Co4 = XX * ZZ - XZ * XZ;
+            const double Co5 = XY * XZ - XX * YZ;
+            const double Co8 = XX * YY - XY * XY;
+            const double Scale = -1.0 / Det;
+            Out.X = (Co0 * X + Co1 * Y + Co2 * Z) * Scale;
+            Out.Y = (Co1 * X + Co4 * Y + Co5 * Z) * Scale;
+            Out.Z = (Co2 * X + Co5 * Y + Co8 * Z) * Scale;
+            return true;
+        }
+    };
+
+    // Edge to collapse, queued with the versions of its ends at the time
+    struct Candidate
+    {
+        uint32_t Keep;
+        uint32_t Remove;
+        uint32_t KeepVersion;
+        uint32_t RemoveVersion;
+    };
+
+    // Candidates by cost. The bit pattern of a non-negative float orders like its value,
+    // so its top bits pick a bucket and a bitmap over the buckets finds the cheapest one.
+    // Candidates within a bucket are less than 1% apart in cost and come out in any order.
+    // Push and Pop touch a few cache lines where a binary heap of millions of edges
+    // misses the cache on every level.
+    class CostQueue
+    {
+    public:
+        CostQueue() : Buckets(BucketCount) {}
+
+        bool IsEmpty() const noexcept
+        {
+            return Summary == 0u;
+        }
+        void Push(double Cost, const Candidate& c)
+        {
+            const float Clamped = std::min(static_cast<float>(std::max(Cost, 0.0)), std::numeric_limits<float>::max());
+            const uint32_t b = std::bit_cast<uint32_t>(Clamped) >> (32u - BucketBits);
+            Buckets[b].push_back(c);
+            Occupied[b / 64u] |= 1ull << (b % 64u);
+            Summary |= 1ull << (b / 64u / 64u);
+            Groups[b / 64u / 64u] |= 1ull << (b / 64u % 64u);
+        }
+        // The queue must not be empty
+        Candidate Pop() noexcept
+        {
+            const uint32_t g = static_cast<uint32_t>(std::countr_zero(Summary));
+            const uint32_t w = g * 64u + static_cast<uint32_t>(std::countr_zero(Groups[g]));
+            const uint32_t b = w * 64u + static_cast<uint32_t>(std::countr_zero(Occupied[w]));
+            std::vector<Candidate>& Bucket = Buckets[b];
+            const Candidate c = Bucket.back();
+            Bucket.pop_back();
+            if (Bucket.empty())
+            {
+                Occupied[w] &= ~(1ull << (b % 64u));
+                if (Occupied[w] == 0u)
+                {
+                    Groups[g] &= ~(1ull << (w % 64u));
+                    if (Groups[g] == 0u)
+                    {
+                        Summary &= ~(1ull << g);
+                    }
+                }
+            }
+            return c;
+        }
+    private:
+        // Sign bit, which is always clear, 8 exponent and 8 mantissa bits
+        static constexpr uint32_t BucketBits = 17u;
+        static constexpr uint32_t BucketCount = 1u << (BucketBits - 1u);
+        std::vector<std::vector<Candidate>> Buckets;
+        // One bit per bucket, per word of those and per word of those
+        uint64_t Occupied[BucketCount / 64u] = {};
+        uint64_t Groups[BucketCount / 64u / 64u] = {};
+        uint64_t Summary = 0u;
+    };
+
+    // Edge collapse state of one mesh. Candidates are queued with the versions of their
+    // ends and dropped when either end changed since; they only keep the cost, the rest
+    // of the collapse is worked out again for the few that get popped.
+    class Collapser
+    {
+    public:
+        Collapser(const std::vector<Vec3>& Positions, const uint32_t* Indices, size_t TriangleCount)
+        {
+            Weld(Positions);
+            Triangles.reserve(TriangleCount);
+            for (size_t t = 0; t < TriangleCount; t++)
+            {
+                const std::array<uint32_t, 3> Corners = {Remap[Indices[3u * t]], Remap[Indices[3u * t + 1u]], Remap[Indices[3u * t + 2u]]};
+                if (Corners[0] != Corners[1] && Corners[1] != Corners[2] && Corners[2] != Corners[0])
+                {
+                    Triangles.push_back(Corners);
+                }
+            }
+            Alive = Triangles.size();
+            Dead.assign(Triangles.size(), 0u);
+            Quadrics.resize(Points.size());
+            Versions.assign(Points.size(), 0u);
+            VertexTriangles.resize(Points.size());
+            for (uint32_t t = 0; t < Triangles.size(); t++)
+            {
+                for (uint32_t v : Triangles[t])
+                {
+                    VertexTriangles[v].push_back(t);
+                }
+            }
+            AddTrianglePlanes();
+            QueueEdges();
+        }
+
+        size_t GetTriangleCount() const noexcept
+        {
+            return Alive;
+        }
+        // Largest error of the collapses so far, in world units
+        double GetError() const noexcept
+        {
+            return MaxError;
+        }
+
+        // Collapses edges until at most Target triangles are left or no edge can go
+        void Reduce(size_t Target)
+        {
+            bool Progress = true;
+            while (Alive > Target)
+            {
+                if (Queue.IsEmpty())
+                {
+                    // Skipped edges may have become collapsible as their neighbourhood
+                    // changed, go over all of them once more
+                    if (!Progress)
+                    {
+                        break;
+                    }
+                    Progress = false;
+                    for (uint32_t v = 0; v < Points.size(); v++)
+                    {
+                        PushEdges(v, true);
+                    }
+                    continue;
+                }
+                const Candidate c = Queue.Pop();
+                if (Versions[c.Keep] != c.KeepVersion || Versions[c.Remove] != c.RemoveVersion)
+                {
+                    continue;
+                }
+                const Plan Best = Evaluate(c.Keep, c.Remove);
+                if (!CanCollapse(c.Keep, c.Remove, Best.Target))
+                {
+                    continue;
+                }
+                Collapse(c.Keep, c.Remove, Best);
+                Progress = true;
+            }
+        }
+
+        // Appends the remaining triangles and the positions they use as a new level
+        void Emit(MeshData& Output) const
+        {
+            std::vector<uint32_t> NewIndex(Points.size(), Unused);
+            const size_t FirstIndex = Output.Indices.size();
+            for (size_t t = 0; t < Triangles.size(); t++)
+            {
+                if (Dead[t] != 0u)
+                {
+                    continue;
+                }
+                for (uint32_t v : Triangles[t])
+                {
+                    if (NewIndex[v] == Unused)
+                    {
+                        NewIndex[v] = static_cast<uint32_t>(Output.Positions.size());
+                        const Point& p = Points[v];
+                        Output.Positions.push_back({static_cast<float>(p.X), static_cast<float>(p.Y), static_cast<float>(p.Z)});
+                    }
+                    Output.Indices.push_back(NewIndex[v]);
+                }
+            }
+            Output.Levels.push_back({static_cast<uint32_t>(FirstIndex), static_cast<uint32_t>(Output.Indices.size() - FirstIndex), 0.0f});
+        }
+    private:
+        struct Plan
+        {
+            double Cost;
+            // Distance estimate, see MeshSimplifier
+            double Error;
+            Point Target;
+        };
+    private:
+        // Points with the same position become one vertex
+        void Weld(const std::vector<Vec3>& Positions)
+        {
+            std::vector<uint32_t> Order(Positions.size());
+            std::iota(Order.begin(), Order.end(), 0u);
+            const auto Less = [&Positions](uint32_t a, uint32_t b)
+            {
+                const Vec3& p = Positions[a];
+                const Vec3& q = Positions[b];
+                return p.X != q.X ? p.X < q.X : p.Y != q.Y ? p.Y < q.Y : p.Z < q.Z;
+            };
+            std::sort(Order.begin(), Order.end(), Less);
+
+            Remap.resize(Positions.size());
+            for (size_t i = 0; i < Order.size(); i++)
+            {
+                const Vec3& p = Positions[Order[i]];
+                if (i == 0u || Less(Order[i - 1u], Order[i]))
+                {
+                    Points.push_back({p.X, p.Y, p.Z});
+                }
+                Remap[Order[i]] = static_cast<uint32_t>(Points.size() - 1u);
+            }
+        }
+
+        void AddTrianglePlanes() noexcept
+        {
+            for (const std::array<uint32_t, 3>& t : Triangles)
+            {
+                const Point& p0 = Points[t[0]];
+                const Point Normal = Cross(Points[t[1]] - p0, Points[t[2]] - p0);
+                const double Length = std::sqrt(Dot(Normal, Normal));
+                if (Length == 0.0)
+                {
+                    continue;
+                }
+                const Point Unit = Normal * (1.0 / Length);
+                Quadric Plane;
+                Plane.AddPlane(Unit, -Dot(Unit, p0), 0.5 * Length);
+                Plane.Area = 0.5 * Length;
+                for (uint32_t v : t)
+                {
+                    Quadrics[v].Add(Plane);
+                }
+            }
+        }
+
+        // Edges with one triangle get a plane through them, perpendicular to the triangle.
+        // Then every edge is queued, once the border planes are in the costs.
+        void QueueEdges()
+        {
+            struct Edge
+            {
+                uint32_t Low;
+                uint32_t High;
+                uint32_t Triangle;
+                uint32_t Corner;
+            };
+            std::vector<Edge> Edges;
+            Edges.reserve(3u * Triangles.size());
+            for (uint32_t t = 0; t < Triangles.size(); t++)
+            {
+                for (uint32_t c = 0; c < 3u; c++)
+                {
+                    const uint32_t a = Triangles[t][c];
+                    const uint32_t b = Triangles[t][(c + 1u) % 3u];
+                    Edges.push_back({std::min(a, b), std::max(a, b), t, c});
+                }
+            }
+            std::sort(Edges.begin(), Edges.end(), [](const Edge& a, const Edge& b)
+            {
+                return a.Low != b.Low ? a.Low < b.Low : a.High < b.High;
+            });
+
+            for (size_t i = 0; i < Edges.size(); )
+            {
+                size_t j = i + 1u;
+                while (j < Edges.size() && Edges[j].Low == Edges[i].Low && Edges[j].High == Edges[i].High)
+                {
+                    j++;
+                }
+                if (j == i + 1u)
+                {
+                    const std::array<uint32_t, 3>& t = Triangles[Edges[i].Triangle];
+                    const Point& a = Points[t[Edges[i].Corner]];
+                    const Point& b = Points[t[(Edges[i].Corner + 1u) % 3u]];
+                    const Point Along = b - a;
+                    const Point Normal = Cross(Points[t[1]] - Points[t[0]], Points[t[2]] - Points[t[0]]);
+                    const Point Across = Cross(Along, Normal);
+                    const double Length = std::sqrt(Dot(Across, Across));
+                    if (Length > 0.0)
+                    {
+                        const Point Unit = Across * (1.0 / Length);
+                        Quadric Plane;
+                        Plane.AddPlane(Unit, -Dot(Unit, a), BorderWeight * Dot(Along, Along));
+                        Quadrics[Edges[i].Low].Add(Plane);
+                        Quadrics[Edges[i].High].Add(Plane);
+                    }
+                }
+                i = j;
+            }
+
+            for (size_t i = 0; i < Edges.size(); i++)
+            {
+                if (i == 0u || Edges[i].Low != Edges[i - 1u].Low || Edges[i].High != Edges[i - 1u].High)
+                {
+                    PushEdge(Edges[i].Low, Edges[i].High);
+                }
+            }
+        }
+
+        // Sorted vertices sharing a live triangle with v
+        void GetNeighbors(uint32_t v, std::vector<uint32_t>& Out) const
+        {
+            Out.clear();
+            for (uint32_t t : VertexTriangles[v])
+            {
+                if (Dead[t] != 0u)
+                {
+                    continue;
+                }
+                for (uint32_t w : Triangles[t])
+                {
+                    if (w != v)
+                    {
+                        Out.push_back(w);
+                    }
+                }
+            }
+            std::sort(Out.begin(), Out.end());
+            Out.erase(std::unique(Out.begin(), Out.end()), Out.end());
+        }
+
+        // Queues the edges from v, only those to higher vertices when Once is set so
+        // a pass over all vertices queues every edge one time
+        void PushEdges(uint32_t v, bool Once)
+        {
+            GetNeighbors(v, Ring);
+            for (uint32_t w : Ring)
+            {
+                if (!Once || w > v)
+                {
+                    PushEdge(v, w);
+                }
+            }
+        }
+
+        void PushEdge(uint32_t a, uint32_t b)
+        {
+            // Keeping the end with more triangles moves fewer of them
+            const bool KeepA = VertexTriangles[a].size() >= VertexTriangles[b].size();
+            const uint32_t Keep = KeepA ? a : b;
+            const uint32_t Remove = KeepA ? b : a;
+            Queue.Push(Evaluate(Keep, Remove).Cost, {Keep, Remove, Versions[Keep], Versions[Remove]});
+        }
+
+        Plan Evaluate(uint32_t a, uint32_t b) const noexcept
+        {
+            Quadric Merged = Quadrics[a];
+            Merged.Add(Quadrics[b]);
+            const Point& Pa = Points[a];
+            const Point& Pb = Points[b];
+
+            // The optimum may lie far off for nearly flat neighbourhoods, stay within an
+            // edge length of the midpoint and fall back to the ends and the midpoint
+            const Point Middle = (Pa + Pb) * 0.5;
+            Point Best = Middle;
+            double BestCost = Merged.Evaluate(Middle);
+            Point Optimum;
+            if (Merged.Minimize(Optimum) && Dot(Optimum - Middle, Optimum - Middle) <= Dot(Pb - Pa, Pb - Pa))
+            {
+                const double Cost = Merged.Evaluate(Optimum);
+                if (Cost < BestCost)
+                {
+                    Best = Optimum;
+                    BestCost = Cost;
+                }
+            }
+            for (const Point& End : {Pa, Pb})
+            {
+                const double Cost = Merged.Evaluate(End);
+                if (Cost < BestCost)
+                {
+                    Best = End;
+                    BestCost = Cost;
+                }
+            }
+
+            BestCost = std::max(BestCost, 0.0);
+            return {BestCost, Merged.Area > 0.0 ? std::sqrt(BestCost / Merged.Area) : 0.0, Best};
+        }
+
+        bool CanCollapse(uint32_t Keep, uint32_t Remove, const Point& Target)
+        {
+            // Link condition: the ends may only share the neighbours opposite the edge,
+            // otherwise the collapse pinches the surface
+            GetNeighbors(Keep, Ring);
+            GetNeighbors(Remove, OtherRing);
+            Shared.clear();
+            std::set_intersection(Ring.begin(), Ring.end(), OtherRing.begin(), OtherRing.end(), std::back_inserter(Shared));
+            size_t EdgeTriangles = 0u;
+            for (uint32_t t : VertexTriangles[Remove])
+            {
+                if (Dead[t] == 0u && std::find(Triangles[t].begin(), Triangles[t].end(), Keep) != Triangles[t].end())
+                {
+                    EdgeTriangles++;
+                }
+            }
+            if (EdgeTriangles == 0u || Shared.size() != EdgeTriangles)
+            {
+                return false;
+            }
+
+            // Triangles that stay must not turn over or collapse to a line
+            for (uint32_t Moved : {Keep, Remove})
+            {
+                for (uint32_t t : VertexTriangles[Moved])
+                {
+                    const std::array<uint32_t, 3>& Corners = Triangles[t];
+                    if (Dead[t] != 0u || std::find(Corners.begin(), Corners.end(), Moved == Keep ? Remove : Keep) != Corners.end())
+                    {
+                        continue;
+                    }
+                    std::array<Point, 3> After = {Points[Corners[0]], Points[Corners[1]], Points[Corners[2]]};
+                    const Point Before = Cross(After[1] - After[0], After[2] - After[0]);
+                    for (uint32_t k = 0; k < 3u; k++)
+                    {
+                        if (Corners[k] == Moved)
+                        {
+                            After[k] = Target;
+                        }
+                    }
+                    const Point Normal = Cross(After[1] - After[0], After[2] - After[0]);
+                    const double Lengths = std::sqrt(Dot(Before, Before) * Dot(Normal, Normal));
+                    if (Lengths > 0.0 && Dot(Before, Normal) < MinNormalCosine * Lengths)
+                    {
+                        return false;
+                    }
+                    if (Lengths == 0.0 && Dot(Before, Before) > 0.0)
+                    {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        void Collapse(uint32_t Keep, uint32_t Remove, const Plan& Best)
+        {
+            std::vector<uint32_t>& KeepTriangles = VertexTriangles[Keep];
+            for (uint32_t t : VertexTriangles[Remove])
+            {
+                if (Dead[t] != 0u)
+                {
+                    continue;
+                }
+                std::array<uint32_t, 3>& Corners = Triangles[t];
+                if (std::find(Corners.begin(), Corners.end(), Keep) != Corners.end())
+                {
+                    Dead[t] = 1u;
+                    Alive--;
+                    continue;
+                }
+                std::replace(Corners.begin(), Corners.end(), Remove, Keep);
+                KeepTriangles.push_back(t);
+            }
+            VertexTriangles[Remove].clear();
+            VertexTriangles[Remove].shrink_to_fit();
+            KeepTriangles.erase(std::remove_if(KeepTriangles.begin(), KeepTriangles.end(), [this](uint32_t t) { return Dead[t] != 0u; }), KeepTriangles.end());
+
+            Quadrics[Keep].Add(Quadrics[Remove]);
+            Points[Keep] = Best.Target;
+            Versions[Keep]++;
+            Versions[Remove]++;
+            MaxError = std::max(MaxError, Best.Error);
+            PushEdges(Keep, false);
+        }
+    private:
+        std::vector<Point> Points;
+        // Welded vertex of every input position
+        std::vector<uint32_t> Remap;
+        std::vector<Quadric> Quadrics;
+        std::vector<uint32_t> Versions;
+        std::vector<std::array<uint32_t, 3>> Triangles;
+        std::vector<uint8_t> Dead;
+        // Triangles around each vertex, may hold dead ones
+        std::vector<std::vector<uint32_t>> VertexTriangles;
+        CostQueue Queue;
+        size_t Alive = 0u;
+        double MaxError = 0.0;
+        // Scratch lists of GetNeighbors callers
+        std::vector<uint32_t> Ring;
+        std::vector<uint32_t> OtherRing;
+        std::vector<uint32_t> Shared;
+    };
+}
+
+MeshSimplifier::MeshSimplifier(Settings Config)
+    : Config(std::move(Config))
+{
+    if (this->Config.Targets.empty())
+    {
+        if (this->Config.LevelCount == 0u || this->Config.LevelCount > LodSelector::MaxLevels || !(this->Config.Ratio > 0.0f && this->Config.Ratio < 1.0f))
+        {
+            throw std::invalid_argument("Simplification needs 1 to LodSelector::MaxLevels levels and a ratio between 0 and 1");
+        }
+    }
+    else if (this->Config.Targets.size() >= LodSelector::MaxLevels
+        || std::adjacent_find(this->Config.Targets.begin(), this->Config.Targets.end(), std::less_equal<uint32_t>()) != this->Config.Targets.end())
+    {
+        throw std::invalid_argument("Triangle targets must decrease and leave room for the full detail level");
+    }
+}
+
+MeshData MeshSimplifier::Simplify(const MeshData& Input) const
+{
+    const LodLevel Full = Input.Levels.empty() ? LodLevel{0u, static_cast<uint32_t>(Input.Indices.size()), 0.0f} : Input.Levels[0];
+    Collapser Mesh(Input.Positions, Input.Indices.data() + Full.FirstIndex, Full.IndexCount / 3u);
+    MeshData Output;
+    Mesh.Emit(Output);
+    ComputeBounds(Output);
+
+    std::vector<size_t> Targets(Config.Targets.begin(), Config.Targets.end());
+    if (Targets.empty())
+    {
+        double Target = static_cast<double>(Mesh.GetTriangleCount());
+        for (uint32_t l = 1; l < Config.LevelCount; l++)
+        {
+            Target *= Config.Ratio;
+            if (Target < Config.MinTriangles)
+            {
+                break;
+            }
+            Targets.push_back(static_cast<size_t>(Target));
+        }
+    }
+
+    for (size_t Target : Targets)
+    {
+        if (Target >= Mesh.GetTriangleCount())
+        {
+            continue;
+        }
+        Mesh.Reduce(Target);
+        if (Mesh.GetTriangleCount() >= Output.Levels.back().IndexCount / 3u)
+        {
+            break;
+        }
+        Mesh.Emit(Output);
+        Output.Levels.back().Error = Output.Radius > 0.0f ? static_cast<float>(Mesh.GetError() / Output.Radius) : 0.0f;
+    }
+    return Output;
+}
\ No newline at end of file
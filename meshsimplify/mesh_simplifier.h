@@ -0,0 +1,41 @@
+#pragma once
+#include "mesh_format.h"
+#include <cstdint>
+#include <vector>
+
+// Builds a chain of levels of detail by quadric error metric edge collapse (Garland and
+// Heckbert). Every vertex carries the sum of the squared distances to the planes of its
+// triangles, weighted by their area; collapsing an edge merges the sums of its ends and
+// moves the kept vertex to where the merged sum is smallest. Edges go cheapest first.
+// Open borders get extra planes across them so outlines do not shrink, and collapses
+// that would fold a triangle over or make the surface non-manifold are skipped.
+//
+// The levels are snapshots of one collapse sequence, each with its own copy of the
+// positions it uses. Their Error is the largest collapse error so far, the square root of
+// the merged sum over the merged area, relative to the mesh's radius: an estimate of the
+// distance to the full detail surface, not a measured bound.
+class MeshSimplifier
+{
+public:
+    struct Settings
+    {
+        // Levels including the full detail one, at most LodSelector::MaxLevels
+        uint32_t LevelCount = 5u;
+        // Triangles of each level over the previous one's target
+        float Ratio = 0.5f;
+        // Levels stop before going under this many triangles
+        uint32_t MinTriangles = 64u;
+        // Triangle counts of the simplified levels, decreasing. Replaces LevelCount, Ratio
+        // and MinTriangles when not empty.
+        std::vector<uint32_t> Targets;
+    };
+public:
+    explicit MeshSimplifier(Settings Config);
+
+    // Simplifies the first level of Input, the others are dropped. The full detail level
+    // is welded by position and loses degenerate triangles. The chain ends early when a
+    // level cannot get below the previous one. Thread-safe.
+    MeshData Simplify(const MeshData& Input) const;
+private:
+    Settings Config;
+};
\ No newline at end of file
@@ -0,0 +1,157 @@
+#include "obj_reader.h"
+#include <charconv>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Cursor over the file contents, one line at a time
+    class ObjParser
+    {
+    public:
+        ObjParser(const char* Begin, const char* End) noexcept : Cursor(Begin), End(End) {}
+
+        bool NextLine() noexcept
+        {
+            // Skip the rest of the current line
+            while (Cursor != End && *Cursor != '\n')
+            {
+                Cursor++;
+            }
+            if (Cursor == End)
+            {
+                return false;
+            }
+            Cursor++;
+            Line++;
+            return true;
+        }
+        void SkipSpaces() noexcept
+        {
+            while (Cursor != End && (*Cursor == ' ' || *Cursor == '\t'))
+            {
+                Cursor++;
+            }
+        }
+        bool AtLineEnd() noexcept
+        {
+            SkipSpaces();
+            return Cursor == End || *Cursor == '\n' || *Cursor == '\r' || *Cursor == '#';
+        }
+        // True when the line starts with Keyword followed by a space
+        bool Starts(const char* Keyword) noexcept
+        {
+            const char* c = Cursor;
+            for (; *Keyword != '\0'; Keyword++, c++)
+            {
+                if (c == End || *c != *Keyword)
+                {
+                    return false;
+                }
+            }
+            if (c == End || (*c != ' ' && *c != '\t'))
+            {
+                return false;
+            }
+            Cursor = c;
+            return true;
+        }
+        float ReadFloat()
+        {
+            SkipSpaces();
+            // from_chars takes no plus sign
+            if (Cursor != End && *Cursor == '+')
+            {
+                Cursor++;
+            }
+            float Value = 0.0f;
+            const std::from_chars_result Result = std::from_chars(Cursor, End, Value);
+            if (Result.ec != std::errc())
+            {
+                Fail("Expected a number");
+            }
+            Cursor = Result.ptr;
+            return Value;
+        }
+        // Position index of a face vertex, the texture and normal indices after it are skipped
+        int64_t ReadIndex()
+        {
+            SkipSpaces();
+            int64_t Value = 0;
+            const std::from_chars_result Result = std::from_chars(Cursor, End, Value);
+            if (Result.ec != std::errc() || Value == 0)
+            {
+                Fail("Expected a vertex index");
+            }
+            Cursor = Result.ptr;
+            while (Cursor != End && *Cursor != ' ' && *Cursor != '\t' && *Cursor != '\n' && *Cursor != '\r')
+            {
+                Cursor++;
+            }
+            return Value;
+        }
+        [[noreturn]] void Fail(const std::string& Reason) const
+        {
+            throw MESH_EXCEPT(Reason + " on line " + std::to_string(Line));
+        }
+    private:
+        const char* Cursor;
+        const char* End;
+        size_t Line = 1u;
+    };
+}
+
+MeshData ReadObj(const std::filesystem::path& Path)
+{
+    std::ifstream Stream(Path, std::ios::binary | std::ios::ate);
+    if (!Stream)
+    {
+        throw MESH_EXCEPT("Cannot open " + Path.string());
+    }
+    std::string Text(static_cast<size_t>(Stream.tellg()), '\0');
+    Stream.seekg(0);
+    Stream.read(Text.data(), static_cast<std::streamsize>(Text.size()));
+
+    MeshData Mesh;
+    std::vector<uint32_t> Polygon;
+    ObjParser Parser(Text.data(), Text.data() + Text.size());
+    do
+    {
+        Parser.SkipSpaces();
+        if (Parser.Starts("v"))
+        {
+            const float X = Parser.ReadFloat();
+            const float Y = Parser.ReadFloat();
+            const float Z = Parser.ReadFloat();
+            Mesh.Positions.push_back({X, Y, Z});
+        }
+        else if (Parser.Starts("f"))
+        {
+            // Negative indices count back from the last position read so far
+            Polygon.clear();
+            while (!Parser.AtLineEnd())
+            {
+                const int64_t Index = Parser.ReadIndex();
+                const int64_t Position = Index > 0 ? Index - 1 : static_cast<int64_t>(Mesh.Positions.size()) + Index;
+                if (Position < 0 || Position >= static_cast<int64_t>(Mesh.Positions.size()))
+                {
+                    Parser.Fail("Vertex index out of range");
+                }
+                Polygon.push_back(static_cast<uint32_t>(Position));
+            }
+            if (Polygon.size() < 3u)
+            {
+                Parser.Fail("Face with fewer than three vertices");
+            }
+            for (size_t i = 2; i < Polygon.size(); i++)
+            {
+                Mesh.Indices.insert(Mesh.Indices.end(), {Polygon[0], Polygon[i - 1u], Polygon[i]});
+            }
+        }
+    } while (Parser.NextLine());
+
+    Mesh.Levels.push_back({0u, static_cast<uint32_t>(Mesh.Indices.size()), 0.0f});
+    ComputeBounds(Mesh);
+    return Mesh;
+}
\ No newline at end of file
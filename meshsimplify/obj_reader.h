@@ -0,0 +1,8 @@
+#pragma once
+#include "mesh_format.h"
+#include <filesystem>
+
+// Positions and faces of a Wavefront OBJ file as a single full detail level. Polygons
+// are split into triangle fans; texture coordinates, normals, groups and materials are
+// ignored. Throws MeshException on malformed positions or faces.
+MeshData ReadObj(const std::filesystem::path& Path);
\ No newline at end of file
@@ -0,0 +1,118 @@
+#include "microbenchmark.h"
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+// Portable build of the micro-benchmarks, the same cases as directxtest -microbench
+// without the Direct3D error paths
+namespace
+{
+    constexpr int Success = 0;
+    constexpr int Failure = 2;
+
+    // Whole non-negative numbers only, "12x" or "-1" are usage errors
+    unsigned int ParseCount(const std::string& Arg)
+    {
+        size_t End = 0u;
+        const unsigned long Value = Arg.empty() || Arg[0] == '-' ? 0ul : std::stoul(Arg, &End);
+        if (End == 0u || End != Arg.size() || Value > 0xFFFFFFFFul)
+        {
+            throw std::invalid_argument("Expected a number, got '" + Arg + "'");
+        }
+        return static_cast<unsigned int>(Value);
+    }
+
+    void PrintUsage()
+    {
+        std::cerr << "usage: microbench [options]" << std::endl
+            << "  -samples <n>       measured samples per case (1000)" << std::endl
+            << "  -warmup <n>        samples run before measuring (100)" << std::endl
+            << "  -batch <n>         calls per sample of the small cases (1000)" << std::endl
+            << "  -core <n>          core the measuring thread is pinned to (0)" << std::endl
+            << "  -filter <prefixes> comma separated case name prefixes, e.g. math.,bvh.query" << std::endl
+            << "  -out <file>        benchmark report (microbenchmark.json)" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        MicroBenchmark::Settings Config;
+        Config.Log = &std::cout;
+        std::string OutputPath = "microbenchmark.json";
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string Arg = argv[i];
+            if (i + 1 >= argc)
+            {
+                PrintUsage();
+                return Failure;
+            }
+            const std::string Value = argv[++i];
+            if (Arg == "-samples")
+            {
+                Config.Samples = ParseCount(Value);
+            }
+            else if (Arg == "-warmup")
+            {
+                Config.WarmupSamples = ParseCount(Value);
+            }
+            else if (Arg == "-batch")
+            {
+                Config.BatchSize = ParseCount(Value);
+            }
+            else if (Arg == "-core")
+            {
+                Config.Core = ParseCount(Value);
+            }
+            else if (Arg == "-filter")
+            {
+                Config.Filter = Value;
+            }
+            else if (Arg == "-out")
+            {
+                OutputPath = Value;
+            }
+            else
+            {
+                PrintUsage();
+                return Failure;
+            }
+        }
+        if (Config.Samples == 0u || Config.BatchSize == 0u)
+        {
+            PrintUsage();
+            return Failure;
+        }
+
+        BenchmarkReport::Settings Settings;
+        Settings.Backend = "none";
+        Settings.WarmupFrames = Config.WarmupSamples;
+        BenchmarkReport Report(Settings);
+        MicroBenchmark(Config).Run(Report);
+
+        std::ofstream Out(OutputPath);
+        if (!Out)
+        {
+            throw std::runtime_error("Cannot create benchmark output file");
+        }
+        Report.WriteJson(Out);
+        return Success;
+    }
+    catch (const MyException& e)
+    {
+        std::cerr << e.GetType() << std::endl << e.what() << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Standard Exception" << std::endl << e.what() << std::endl;
+    }
+    catch (...)
+    {
+        std::cerr << "Unknown Exception" << std::endl << "No details available" << std::endl;
+    }
+
+    return Failure;
+}
\ No newline at end of file
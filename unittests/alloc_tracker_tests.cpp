@@ -0,0 +1,91 @@
+#include "test_harness.h"
+#include "alloc_tracker.h"
+#include <cstdint>
+#include <new>
+
+// The unittests target defines ALLOC_TRACKING. Blocks come from operator new directly,
+// new-expressions could be elided by the optimizer.
+namespace
+{
+    size_t Index(AllocTag Tag)
+    {
+        return static_cast<size_t>(Tag);
+    }
+}
+
+TEST(alloc_tracker, frees_count_for_the_allocating_tag)
+{
+    AllocTracker::EndFrame();
+    void* Block;
+    void* Aligned;
+    {
+        AllocScope Scope(AllocTag::Graphics);
+        Block = ::operator new(32u);
+        Aligned = ::operator new(64u, std::align_val_t{64u});
+    }
+    CHECK(reinterpret_cast<uintptr_t>(Aligned) % 64u == 0u);
+    {
+        AllocScope Scope(AllocTag::Window);
+        ::operator delete(Block);
+        ::operator delete(Aligned, std::align_val_t{64u});
+    }
+    const AllocTracker::FrameStats Frame = AllocTracker::EndFrame();
+    CHECK(Frame.Tags[Index(AllocTag::Graphics)].Count == 2u);
+    CHECK(Frame.Tags[Index(AllocTag::Graphics)].Bytes == 96u);
+    CHECK(Frame.Tags[Index(AllocTag::Graphics)].Frees == 2u);
+    CHECK(Frame.Tags[Index(AllocTag::Window)].Frees == 0u);
+}
+
+TEST(alloc_tracker, strict_frame_without_allocations_passes)
+{
+    AllocTracker::EndFrame();
+    AllocTracker::SetStrict(AllocTag::Frame);
+    {
+        AllocScope Scope(AllocTag::Frame);
+    }
+    AllocTracker::SetStrict(AllocTag::Frame, false);
+    AllocTracker::EndFrame();
+}
+
+TEST(alloc_tracker, strict_frame_fails_on_nested_allocation)
+{
+    // Graphics is not strict itself, the enclosing Frame scope decides
+    AllocTracker::EndFrame();
+    AllocTracker::SetStrict(AllocTag::Frame);
+    void* Block;
+    {
+        AllocScope Frame(AllocTag::Frame);
+        AllocScope Graphics(AllocTag::Graphics);
+        Block = ::operator new(16u);
+    }
+    ::operator delete(Block);
+    AllocTracker::SetStrict(AllocTag::Frame, false);
+
+    bool Thrown = false;
+    try
+    {
+        AllocTracker::EndFrame();
+    }
+    catch (const AllocTracker::Exception& e)
+    {
+        Thrown = true;
+        CHECK(e.GetTag() == AllocTag::Frame);
+    }
+    CHECK(Thrown);
+    // The violation is reported once
+    AllocTracker::EndFrame();
+}
+
+TEST(alloc_tracker, strictness_ends_with_the_scope)
+{
+    AllocTracker::EndFrame();
+    AllocTracker::SetStrict(AllocTag::Frame);
+    {
+        AllocScope Frame(AllocTag::Frame);
+    }
+    void* Block = ::operator new(16u);
+    ::operator delete(Block);
+    AllocTracker::SetStrict(AllocTag::Frame, false);
+    const AllocTracker::FrameStats Frame = AllocTracker::EndFrame();
+    CHECK(Frame.Tags[Index(AllocTag::Untagged)].Count >= 1u);
+}
\ No newline at end of file
@@ -0,0 +1,285 @@
+#include "test_harness.h"
+#include "bvh.h"
+#include "job_system.h"
+#include "scene_random.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+    Bvh::Box RandomBox(SceneRandom& Random, float Size)
+    {
+        const Vec3 c = {Random.NextFloat(0.0f, Size), Random.NextFloat(0.0f, Size), Random.NextFloat(0.0f, Size)};
+        const float e = Random.NextFloat(0.1f, 1.1f);
+        return {{c.X - e, c.Y - e, c.Z - e}, {c.X + e, c.Y + e, c.Z + e}};
+    }
+
+    // Same test as the tree's, object by object
+    bool IsInside(const Frustum& View, const Bvh::Box& b)
+    {
+        for (const Vec4& p : View.Planes)
+        {
+            const float x = p.X > 0.0f ? b.Max.X : b.Min.X;
+            const float y = p.Y > 0.0f ? b.Max.Y : b.Min.Y;
+            const float z = p.Z > 0.0f ? b.Max.Z : b.Min.Z;
+            if (p.X * x + p.Y * y + p.Z * z + p.W < 0.0f)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool Overlaps(const Bvh::Box& a, const Bvh::Box& b)
+    {
+        return a.Min.X <= b.Max.X && a.Max.X >= b.Min.X &&
+            a.Min.Y <= b.Max.Y && a.Max.Y >= b.Min.Y &&
+            a.Min.Z <= b.Max.Z && a.Max.Z >= b.Min.Z;
+    }
+
+    // Number of random frustum and box queries whose sorted result differs from testing every box
+    size_t CountWrongQueries(const Bvh& Tree, const std::vector<Bvh::Box>& Boxes, float Size, SceneRandom& Random)
+    {
+        size_t Wrong = 0u;
+        std::vector<uint32_t> Found(Boxes.size());
+        std::vector<uint32_t> Expected;
+        for (int q = 0; q < 20; q++)
+        {
+            const Vec3 Eye = {Random.NextFloat(0.0f, Size), Random.NextFloat(0.0f, Size), Random.NextFloat(0.0f, Size)};
+            const Vec3 Target = {Random.NextFloat(0.0f, Size), Random.NextFloat(0.0f, Size), Random.NextFloat(0.0f, Size)};
+            const Frustum View = Frustum::FromMatrix(Multiply(Mat4::LookAt(Eye, Target, {0.0f, 1.0f, 0.0f}), Mat4::Perspective(0.8f, 1.5f, 0.5f, Size * 0.7f)));
+            size_t n = Tree.CullFrustum(View, Found.data());
+            std::sort(Found.begin(), Found.begin() + n);
+            Expected.clear();
+            for (uint32_t i = 0; i < Boxes.size(); i++)
+            {
+                if (IsInside(View, Boxes[i]))
+                {
+                    Expected.push_back(i);
+                }
+            }
+            Wrong += n == Expected.size() && std::equal(Expected.begin(), Expected.end(), Found.begin()) ? 0u : 1u;
+
+            const Vec3 c = {Random.NextFloat(0.0f, Size), Random.NextFloat(0.0f, Size), Random.NextFloat(0.0f, Size)};
+            const float e = Random.NextFloat(0.0f, Size * 0.1f);
+            const Bvh::Box Region = {{c.X - e, c.Y - e, c.Z - e}, {c.X + e, c.Y + e, c.Z + e}};
+            n = Tree.QueryBox(Region, Found.data());
+            std::sort(Found.begin(), Found.begin() + n);
+            Expected.clear();
+            for (uint32_t i = 0; i < Boxes.size(); i++)
+            {
+                if (Overlaps(Region, Boxes[i]))
+                {
+                    Expected.push_back(i);
+                }
+            }
+            Wrong += n == Expected.size() && std::equal(Expected.begin(), Expected.end(), Found.begin()) ? 0u : 1u;
+        }
+        return Wrong;
+    }
+
+    // Entry and exit of the ray in double, or false if it clearly misses the box
+    bool ClearlyHits(const Vec3& Origin, const Vec3& Direction, float MaxDistance, const Bvh::Box& b)
+    {
+        const double o[3] = {Origin.X, Origin.Y, Origin.Z};
+        const double d[3] = {Direction.X, Direction.Y, Direction.Z};
+        const double Min[3] = {b.Min.X, b.Min.Y, b.Min.Z};
+        const double Max[3] = {b.Max.X, b.Max.Y, b.Max.Z};
+        double Enter = 0.0;
+        double Exit = MaxDistance;
+        for (int a = 0; a < 3; a++)
+        {
+            const double t1 = (Min[a] - o[a]) / d[a];
+            const double t2 = (Max[a] - o[a]) / d[a];
+            Enter = std::max(Enter, std::min(t1, t2));
+            Exit = std::min(Exit, std::max(t1, t2));
+        }
+        return Exit - Enter > 1e-3;
+    }
+}
+
+TEST(bvh, queries_match_brute_force_after_build)
+{
+    // Tiny trees, a single leaf node and enough objects to bin and build over jobs
+    const size_t Counts[] = {0u, 1u, 3u, 5u, 17u, 1000u, 3u * Bvh::Grain + 13u};
+    JobSystem Jobs(3u);
+    for (const size_t Count : Counts)
+    {
+        SceneRandom Random(Count + 1u);
+        const float Size = std::cbrt(static_cast<float>(Count)) * 4.0f + 1.0f;
+        std::vector<Bvh::Box> Boxes(Count);
+        for (Bvh::Box& b : Boxes)
+        {
+            b = RandomBox(Random, Size);
+        }
+        Bvh Serial;
+        Bvh Jobbed;
+        Serial.Build(Boxes.data(), Count);
+        Jobbed.Build(Boxes.data(), Count, &Jobs);
+        CHECK(Serial.GetObjectCount() == Count && Jobbed.GetObjectCount() == Count);
+        CHECK(CountWrongQueries(Serial, Boxes, Size, Random) == 0u);
+        CHECK(CountWrongQueries(Jobbed, Boxes, Size, Random) == 0u);
+    }
+
+    // Every object in one spot cannot be split by position
+    const std::vector<Bvh::Box> Same(5000u, {{1.0f, 1.0f, 1.0f}, {2.0f, 2.0f, 2.0f}});
+    Bvh Stacked;
+    Stacked.Build(Same.data(), Same.size(), &Jobs);
+    std::vector<uint32_t> Found(Same.size());
+    CHECK(Stacked.QueryBox({{0.0f, 0.0f, 0.0f}, {3.0f, 3.0f, 3.0f}}, Found.data()) == Same.size());
+    CHECK(Stacked.QueryBox({{2.5f, 0.0f, 0.0f}, {3.0f, 3.0f, 3.0f}}, Found.data()) == 0u);
+}
+
+TEST(bvh, refits_and_degraded_rebuilds_keep_queries_exact)
+{
+    constexpr size_t Count = 3u * Bvh::Grain + 13u;
+    SceneRandom Random(5u);
+    const float Size = std::cbrt(static_cast<float>(Count)) * 4.0f + 1.0f;
+    std::vector<Bvh::Box> Boxes(Count);
+    for (Bvh::Box& b : Boxes)
+    {
+        b = RandomBox(Random, Size);
+    }
+    JobSystem Jobs(3u);
+    Bvh Tree;
+    Tree.Build(Boxes.data(), Count, &Jobs);
+    const float BuiltCost = Tree.GetSahCost();
+
+    // A few objects moved, refitting only their paths
+    std::vector<uint32_t> Moved;
+    for (uint32_t i = 0; i < Count; i += 100u)
+    {
+        const float d = Random.NextFloat(0.0f, Size * 0.3f);
+        Boxes[i].Min.X += d;
+        Boxes[i].Max.X += d;
+        Moved.push_back(i);
+    }
+    Tree.Refit(Boxes.data(), Moved.data(), Moved.size());
+    CHECK(CountWrongQueries(Tree, Boxes, Size, Random) == 0u);
+
+    // A third scattered across the scene stretches most boxes of the tree
+    for (size_t i = 0; i < Count; i += 3u)
+    {
+        Boxes[i] = RandomBox(Random, Size);
+    }
+    Tree.Refit(Boxes.data(), &Jobs);
+    const float ScatteredCost = Tree.GetSahCost();
+    CHECK(ScatteredCost > BuiltCost);
+    CHECK(CountWrongQueries(Tree, Boxes, Size, Random) == 0u);
+    CHECK(Tree.RebuildDegraded(&Jobs) > 0u);
+    CHECK(Tree.GetSahCost() < ScatteredCost);
+    CHECK(Tree.GetObjectCount() == Count);
+    CHECK(CountWrongQueries(Tree, Boxes, Size, Random) == 0u);
+    // Nothing grew since, so there is nothing left to rebuild
+    CHECK(Tree.RebuildDegraded() == 0u);
+
+    // Repeatedly moving a corner of the scene rebuilds subtrees in place until the
+    // unreachable nodes force a full build
+    for (int Round = 0; Round < 6; Round++)
+    {
+        Moved.clear();
+        for (uint32_t i = 0; i < Count; i++)
+        {
+            if (Boxes[i].Min.X < Size * 0.3f && Boxes[i].Min.Y < Size * 0.3f)
+            {
+                const float d = Random.NextFloat(-Size, Size) * 0.2f;
+                Boxes[i].Min.Z += d;
+                Boxes[i].Max.Z += d;
+                Moved.push_back(i);
+            }
+        }
+        Tree.Refit(Boxes.data(), Moved.data(), Moved.size());
+        Tree.RebuildDegraded(Round % 2 == 0 ? &Jobs : nullptr);
+        CHECK(CountWrongQueries(Tree, Boxes, Size, Random) == 0u);
+    }
+    CHECK(Tree.GetObjectCount() == Count);
+}
+
+TEST(bvh, ray_walks_reach_every_hit_box_once)
+{
+    constexpr size_t Count = 20000u;
+    SceneRandom Random(9u);
+    const float Size = std::cbrt(static_cast<float>(Count)) * 4.0f + 1.0f;
+    std::vector<Bvh::Box> Boxes(Count);
+    for (Bvh::Box& b : Boxes)
+    {
+        b = RandomBox(Random, Size);
+    }
+    Bvh Tree;
+    Tree.Build(Boxes.data(), Count);
+
+    size_t Missing = 0u;
+    size_t Repeated = 0u;
+    size_t Hits = 0u;
+    std::vector<uint32_t> Seen(Count, 0u);
+    for (int r = 0; r < 200; r++)
+    {
+        const Vec3 Origin = {Random.NextFloat(-Size, 2.0f * Size), Random.NextFloat(-Size, 2.0f * Size), Random.NextFloat(-Size, 2.0f * Size)};
+        const Vec3 Target = {Random.NextFloat(0.0f, Size), Random.NextFloat(0.0f, Size), Random.NextFloat(0.0f, Size)};
+        const Vec3 Direction = Normalize(Target - Origin);
+        const float MaxDistance = Size * 2.0f;
+
+        // Two walks in step: one stops after every leaf and carries on from a copy of its state
+        std::fill(Seen.begin(), Seen.end(), 0u);
+        Bvh::RayWalk Walk;
+        Bvh::RayWalk Stopped;
+        Tree.BeginRay(Walk, Origin, Direction, MaxDistance);
+        Tree.BeginRay(Stopped, Origin, Direction, MaxDistance);
+        uint32_t Leaf[Bvh::LeafSize];
+        uint32_t Resumed[Bvh::LeafSize];
+        for (size_t n = Tree.NextLeaf(Walk, Leaf); n > 0u; n = Tree.NextLeaf(Walk, Leaf))
+        {
+            Bvh::RayWalk Copy = Stopped;
+            CHECK(Tree.NextLeaf(Copy, Resumed) == n && std::equal(Leaf, Leaf + n, Resumed));
+            Stopped = Copy;
+            for (size_t i = 0; i < n; i++)
+            {
+                Repeated += Seen[Leaf[i]]++ > 0u ? 1u : 0u;
+            }
+        }
+        CHECK(Tree.NextLeaf(Stopped, Resumed) == 0u);
+        for (uint32_t i = 0; i < Count; i++)
+        {
+            if (ClearlyHits(Origin, Direction, MaxDistance, Boxes[i]))
+            {
+                Hits++;
+                Missing += Seen[i] == 0u ? 1u : 0u;
+            }
+        }
+    }
+    CHECK(Missing == 0u);
+    CHECK(Repeated == 0u);
+    CHECK(Hits > 200u);
+
+    // Lowering MaxDistance during a walk keeps every box entered before it
+    size_t Pruned = 0u;
+    for (int r = 0; r < 50; r++)
+    {
+        const Vec3 Origin = {-1.0f, Random.NextFloat(0.0f, Size), Random.NextFloat(0.0f, Size)};
+        const Vec3 Direction = Normalize(Vec3{1.0f, Random.NextFloat(-0.2f, 0.2f), Random.NextFloat(-0.2f, 0.2f)});
+        const float Cut = Size * 0.25f;
+        std::fill(Seen.begin(), Seen.end(), 0u);
+        Bvh::RayWalk Walk;
+        Tree.BeginRay(Walk, Origin, Direction, Size * 2.0f);
+        uint32_t Leaf[Bvh::LeafSize];
+        size_t n = Tree.NextLeaf(Walk, Leaf);
+        Walk.MaxDistance = Cut;
+        for (; n > 0u; n = Tree.NextLeaf(Walk, Leaf))
+        {
+            for (size_t i = 0; i < n; i++)
+            {
+                Seen[Leaf[i]] = 1u;
+            }
+        }
+        for (uint32_t i = 0; i < Count; i++)
+        {
+            if (ClearlyHits(Origin, Direction, Cut, Boxes[i]))
+            {
+                Pruned += Seen[i] == 0u ? 1u : 0u;
+            }
+        }
+    }
+    CHECK(Pruned == 0u);
+}
\ No newline at end of file
@@ -0,0 +1,126 @@
+#include "test_harness.h"
+#include "capture.h"
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+namespace
+{
+    std::filesystem::path TempCapture()
+    {
+        return std::filesystem::temp_directory_path() / "unittests_capture.bin";
+    }
+
+    bool SameBytes(const CaptureReader::Blob& Blob, const std::vector<unsigned char>& Expected)
+    {
+        return Blob.Size == Expected.size() && std::memcmp(Blob.Data, Expected.data(), Expected.size()) == 0;
+    }
+}
+
+TEST(capture, repeated_payloads_are_stored_once)
+{
+    std::vector<unsigned char> First(1000u);
+    std::vector<unsigned char> Second(1000u);
+    for (size_t i = 0; i < First.size(); i++)
+    {
+        First[i] = static_cast<unsigned char>(i);
+        Second[i] = static_cast<unsigned char>(i * 7u);
+    }
+    // Same leading bytes but shorter, it must not be taken for First
+    const std::vector<unsigned char> Prefix(First.begin(), First.begin() + 500);
+    const std::vector<unsigned char>* const Sequence[] = {&First, &Second, &First, &Prefix, &Second};
+
+    const std::filesystem::path Path = TempCapture();
+    {
+        CaptureWriter Writer(Path);
+        for (const auto* Payload : Sequence)
+        {
+            Writer.Begin(CaptureOp::StreamIndices);
+            Writer.WriteBlob(Payload->data(), Payload->size());
+        }
+        Writer.Begin(CaptureOp::StreamIndices);
+        Writer.WriteBlob(nullptr, 0u);
+        Writer.EndFrame();
+        CHECK(Writer.GetDeduplicatedBytes() == 2000u);
+    }
+
+    CaptureReader Reader(Path);
+    CaptureOp Op;
+    for (const auto* Payload : Sequence)
+    {
+        REQUIRE(Reader.Next(Op));
+        CHECK(Op == CaptureOp::StreamIndices);
+        CHECK(SameBytes(Reader.ReadBlob(), *Payload));
+    }
+    REQUIRE(Reader.Next(Op));
+    CHECK(Reader.ReadBlob().Size == 0u);
+    REQUIRE(Reader.Next(Op));
+    CHECK(Op == CaptureOp::EndFrame);
+    Reader.Read<uint64_t>();
+    CHECK(!Reader.Next(Op));
+    std::filesystem::remove(Path);
+}
+
+TEST(capture, payloads_one_byte_apart_stay_distinct)
+{
+    // Every size around the 16 byte blocks of the hash, with each byte flipped in turn
+    std::vector<std::vector<unsigned char>> Payloads;
+    for (size_t Size = 1u; Size <= 48u; Size++)
+    {
+        const std::vector<unsigned char> Base(Size, 0u);
+        Payloads.push_back(Base);
+        for (size_t i = 0; i < Size; i++)
+        {
+            Payloads.push_back(Base);
+            Payloads.back()[i] = 1u;
+        }
+    }
+
+    const std::filesystem::path Path = TempCapture();
+    uint64_t Repeated = 0u;
+    {
+        CaptureWriter Writer(Path);
+        for (int Pass = 0; Pass < 2; Pass++)
+        {
+            for (const std::vector<unsigned char>& Payload : Payloads)
+            {
+                Writer.Begin(CaptureOp::SetFrameConstants);
+                Writer.WriteBlob(Payload.data(), Payload.size());
+                Repeated += Pass == 1 ? Payload.size() : 0u;
+            }
+        }
+        Writer.EndFrame();
+        CHECK(Writer.GetDeduplicatedBytes() == Repeated);
+    }
+
+    CaptureReader Reader(Path);
+    CaptureOp Op;
+    size_t Wrong = 0u;
+    for (int Pass = 0; Pass < 2; Pass++)
+    {
+        for (const std::vector<unsigned char>& Payload : Payloads)
+        {
+            REQUIRE(Reader.Next(Op));
+            Wrong += SameBytes(Reader.ReadBlob(), Payload) ? 0u : 1u;
+        }
+    }
+    CHECK(Wrong == 0u);
+    std::filesystem::remove(Path);
+}
+
+#ifndef _WIN32
+TEST(capture, failed_writes_throw_at_end_of_frame)
+{
+    // Every write to /dev/full fails once the stream flushes its buffer
+    if (!std::filesystem::exists("/dev/full"))
+    {
+        return;
+    }
+    CaptureWriter Writer("/dev/full");
+    const std::vector<unsigned char> Payload(1u << 20u, 1u);
+    Writer.Begin(CaptureOp::StreamVertices);
+    Writer.WriteBlob(Payload.data(), Payload.size());
+    CHECK_THROWS(Writer.EndFrame(), CaptureException);
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include "test_harness.h"
+#include "constant_buffer.h"
+#include <cstdint>
+#include <random>
+#include <vector>
+
+TEST(constant_buffer, blocks_round_up_to_256_bytes)
+{
+    CHECK(ConstantPacking::GetBlockSize(1u) == 256u);
+    CHECK(ConstantPacking::GetBlockSize(64u) == 256u);
+    CHECK(ConstantPacking::GetBlockSize(256u) == 256u);
+    CHECK(ConstantPacking::GetBlockSize(257u) == 512u);
+    CHECK(ConstantPacking::GetBlockSize(1000u) == 1024u);
+}
+
+TEST(constant_buffer, locations_meet_offsetting_rules)
+{
+    // VSSetConstantBuffers1 wants FirstConstant and NumConstants in multiples of 16
+    for (size_t Size : {16u, 80u, 256u, 272u, 4000u})
+    {
+        for (size_t ByteOffset : {0u, 256u, 65536u})
+        {
+            for (size_t Index = 0; Index < 8u; Index++)
+            {
+                const ConstantLocation Location = ConstantPacking::Locate(ByteOffset, Size, Index);
+                CHECK(Location.FirstConstant % 16u == 0u);
+                CHECK(Location.NumConstants % 16u == 0u);
+                CHECK(Location.NumConstants * ConstantPacking::ConstantSize >= Size);
+                CHECK(Location.FirstConstant * ConstantPacking::ConstantSize == ByteOffset + Index * ConstantPacking::GetBlockSize(Size));
+            }
+        }
+    }
+    const ConstantLocation Third = ConstantPacking::Locate(512u, 80u, 3u);
+    CHECK(Third.FirstConstant == 80u);
+    CHECK(Third.NumConstants == 16u);
+}
+
+TEST(constant_buffer, pack_places_every_block_on_its_boundary)
+{
+    std::mt19937 Random(29u);
+    for (size_t Size : {16u, 80u, 208u, 256u, 304u})
+    {
+        const size_t Count = 7u;
+        const size_t BlockSize = ConstantPacking::GetBlockSize(Size);
+        std::vector<uint8_t> Source(Size * Count);
+        for (uint8_t& Byte : Source)
+        {
+            Byte = static_cast<uint8_t>(Random());
+        }
+        // Padding must be left as it was
+        std::vector<uint8_t> Packed(BlockSize * Count, 0xCDu);
+        ConstantPacking::Pack(Packed.data(), Source.data(), Size, Count);
+        for (size_t Block = 0; Block < Count; Block++)
+        {
+            for (size_t i = 0; i < BlockSize; i++)
+            {
+                const uint8_t Expected = i < Size ? Source[Block * Size + i] : 0xCDu;
+                REQUIRE(Packed[Block * BlockSize + i] == Expected);
+            }
+        }
+    }
+}
+
+TEST(constant_buffer, shadow_tracks_whole_dirty_constants)
+{
+    ConstantShadow Shadow(72u);
+    CHECK(Shadow.GetSize() == 80u);
+    CHECK(!Shadow.IsDirty());
+
+    const float Value = 1.0f;
+    Shadow.Write(20u, &Value, sizeof(Value));
+    CHECK(Shadow.IsDirty());
+    CHECK(Shadow.GetDirtyBegin() == 16u);
+    CHECK(Shadow.GetDirtyEnd() == 32u);
+
+    // A later write only widens the range
+    Shadow.Write(60u, &Value, sizeof(Value));
+    CHECK(Shadow.GetDirtyBegin() == 16u);
+    CHECK(Shadow.GetDirtyEnd() == 64u);
+    CHECK(*reinterpret_cast<const float*>(static_cast<const uint8_t*>(Shadow.GetData()) + 60u) == 1.0f);
+
+    Shadow.ClearDirty();
+    CHECK(!Shadow.IsDirty());
+}
+
+TEST(constant_buffer, shadow_clips_writes_past_the_end)
+{
+    ConstantShadow Shadow(32u);
+    const uint8_t Data[16] = {};
+    Shadow.Write(24u, Data, sizeof(Data));
+    CHECK(Shadow.GetDirtyBegin() == 16u);
+    CHECK(Shadow.GetDirtyEnd() == 32u);
+    Shadow.ClearDirty();
+    Shadow.Write(40u, Data, sizeof(Data));
+    CHECK(!Shadow.IsDirty());
+}
\ No newline at end of file
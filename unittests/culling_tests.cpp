@@ -0,0 +1,192 @@
+#include "test_harness.h"
+#include "culling.h"
+#include "job_system.h"
+#include "scene_random.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+    enum class Expect : uint8_t
+    {
+        Kept,
+        Culled,
+        Either      // Within rounding of a plane, any path may decide either way
+    };
+
+    struct Cloud
+    {
+        std::vector<float> X;
+        std::vector<float> Y;
+        std::vector<float> Z;
+        std::vector<float> Size;
+
+        explicit Cloud(size_t Count)
+            : X(Count), Y(Count), Z(Count), Size(Count)
+        {
+            SceneRandom Random(Count + 1u);
+            for (size_t i = 0; i < Count; i++)
+            {
+                X[i] = Random.NextFloat(-50.0f, 50.0f);
+                Y[i] = Random.NextFloat(-50.0f, 50.0f);
+                Z[i] = Random.NextFloat(-50.0f, 50.0f);
+                Size[i] = Random.NextFloat(0.1f, 4.0f);
+            }
+        }
+        SphereStreams Spheres() const noexcept
+        {
+            return {X.data(), Y.data(), Z.data(), Size.data()};
+        }
+        BoxStreams Boxes() const noexcept
+        {
+            return {X.data(), Y.data(), Z.data(), Size.data(), Size.data(), Size.data()};
+        }
+    };
+
+    Frustum GetView()
+    {
+        return Frustum::FromMatrix(Multiply(Mat4::LookAt({0.0f, 0.0f, -60.0f}, {5.0f, 3.0f, 0.0f}, {0.0f, 1.0f, 0.0f}), Mat4::Perspective(1.0f, 16.0f / 9.0f, 0.5f, 200.0f)));
+    }
+
+    // Worst distance to each plane in double, Reach is how far the object extends towards it
+    template<typename R>
+    std::vector<Expect> Classify(const Frustum& View, const Cloud& Objects, R&& Reach)
+    {
+        std::vector<Expect> Expected(Objects.X.size(), Expect::Kept);
+        for (size_t i = 0; i < Expected.size(); i++)
+        {
+            for (const Vec4& p : View.Planes)
+            {
+                const double Distance = static_cast<double>(p.X) * Objects.X[i] + static_cast<double>(p.Y) * Objects.Y[i] + static_cast<double>(p.Z) * Objects.Z[i] + p.W + Reach(p, i);
+                if (Distance < -1e-3)
+                {
+                    Expected[i] = Expect::Culled;
+                    break;
+                }
+                if (Distance < 1e-3)
+                {
+                    Expected[i] = Expect::Either;
+                }
+            }
+        }
+        return Expected;
+    }
+
+    // Visible must be ascending, offset by FirstIndex and agree with every clear decision
+    bool Matches(const std::vector<Expect>& Expected, const uint32_t* Visible, size_t VisibleCount, uint32_t FirstIndex)
+    {
+        size_t Next = 0u;
+        for (size_t v = 0; v < VisibleCount; v++)
+        {
+            if (Visible[v] < FirstIndex + Next || Visible[v] - FirstIndex >= Expected.size())
+            {
+                return false;
+            }
+            const size_t i = Visible[v] - FirstIndex;
+            for (; Next < i; Next++)
+            {
+                if (Expected[Next] == Expect::Kept)
+                {
+                    return false;
+                }
+            }
+            if (Expected[i] == Expect::Culled)
+            {
+                return false;
+            }
+            Next = i + 1u;
+        }
+        for (; Next < Expected.size(); Next++)
+        {
+            if (Expected[Next] == Expect::Kept)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+TEST(culling, every_path_packs_the_brute_force_result)
+{
+    // Counts around the 4 and 8 lane widths and across several job slices
+    const size_t Counts[] = {0u, 1u, 3u, 4u, 5u, 7u, 8u, 9u, 15u, 17u, 1000u, 3u * FrustumCuller::Grain + 13u};
+    const MathPath Paths[] = {MathPath::Native, MathPath::Sse, MathPath::Scalar};
+    const Frustum View = GetView();
+    JobSystem Jobs(3u);
+    FrustumCuller Culler;
+    for (const size_t Count : Counts)
+    {
+        const Cloud Objects(Count);
+        const std::vector<Expect> SphereExpected = Classify(View, Objects, [&](const Vec4&, size_t i)
+        {
+            return static_cast<double>(Objects.Size[i]);
+        });
+        const std::vector<Expect> BoxExpected = Classify(View, Objects, [&](const Vec4& p, size_t i)
+        {
+            return (std::fabs(static_cast<double>(p.X)) + std::fabs(static_cast<double>(p.Y)) + std::fabs(static_cast<double>(p.Z))) * Objects.Size[i];
+        });
+
+        std::vector<uint32_t> Visible(Count + 1u);
+        std::vector<uint32_t> Reference(Count + 1u);
+        const size_t SphereCount = CullSpheres(View, Objects.Spheres(), Count, Reference.data());
+        CHECK(Matches(SphereExpected, Reference.data(), SphereCount, 0u));
+        for (const MathPath Path : Paths)
+        {
+            const size_t n = CullSpheres(View, Objects.Spheres(), Count, Visible.data(), 5u, Path);
+            CHECK(Matches(SphereExpected, Visible.data(), n, 5u));
+        }
+        // The job slices must pack into exactly the serial list
+        const size_t Jobbed = Culler.CullSpheres(Jobs, View, Objects.Spheres(), Count, Visible.data());
+        CHECK(Jobbed == SphereCount);
+        CHECK(std::equal(Visible.begin(), Visible.begin() + Jobbed, Reference.begin()));
+
+        const size_t BoxCount = CullBoxes(View, Objects.Boxes(), Count, Reference.data());
+        CHECK(Matches(BoxExpected, Reference.data(), BoxCount, 0u));
+        for (const MathPath Path : Paths)
+        {
+            const size_t n = CullBoxes(View, Objects.Boxes(), Count, Visible.data(), 5u, Path);
+            CHECK(Matches(BoxExpected, Visible.data(), n, 5u));
+        }
+        const size_t JobbedBoxes = Culler.CullBoxes(Jobs, View, Objects.Boxes(), Count, Visible.data());
+        CHECK(JobbedBoxes == BoxCount);
+        CHECK(std::equal(Visible.begin(), Visible.begin() + JobbedBoxes, Reference.begin()));
+    }
+}
+
+TEST(culling, lane_patterns_pack_in_order)
+{
+    // Every keep/cull pattern of 8 consecutive objects: object i is far behind the eye
+    // unless bit i of the pattern is set
+    const Frustum View = GetView();
+    constexpr size_t Count = 256u * 8u;
+    std::vector<float> X(Count, 0.0f);
+    std::vector<float> Y(Count, 0.0f);
+    std::vector<float> Z(Count);
+    std::vector<float> Radius(Count, 1.0f);
+    for (size_t i = 0; i < Count; i++)
+    {
+        const bool Keep = ((i / 8u) >> (i % 8u)) & 1u;
+        Z[i] = Keep ? 0.0f : -500.0f;
+    }
+    const SphereStreams Spheres = {X.data(), Y.data(), Z.data(), Radius.data()};
+    const MathPath Paths[] = {MathPath::Native, MathPath::Sse, MathPath::Scalar};
+    for (const MathPath Path : Paths)
+    {
+        std::vector<uint32_t> Visible(Count);
+        const size_t n = CullSpheres(View, Spheres, Count, Visible.data(), 0u, Path);
+        size_t v = 0u;
+        bool Same = true;
+        for (uint32_t i = 0; i < Count; i++)
+        {
+            if (Z[i] == 0.0f)
+            {
+                Same = Same && v < n && Visible[v] == i;
+                v++;
+            }
+        }
+        CHECK(Same && v == n);
+    }
+}
\ No newline at end of file
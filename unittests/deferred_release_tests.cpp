@@ -0,0 +1,125 @@
+#include "test_harness.h"
+#include "deferred_release.h"
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // Objects are indices smuggled through the pointer, the deleter logs them
+    std::vector<uintptr_t> Destroyed;
+
+    void Record(void* Object) noexcept
+    {
+        Destroyed.push_back(reinterpret_cast<uintptr_t>(Object));
+    }
+
+    void* MakeObject(uintptr_t Id) noexcept
+    {
+        return reinterpret_cast<void*>(Id);
+    }
+}
+
+TEST(deferred_release, waits_for_the_last_use_to_complete)
+{
+    Destroyed.clear();
+    DeferredReleaseQueue Queue;
+    Queue.Enqueue(MakeObject(1u), Record, 3u);
+    Queue.Enqueue(MakeObject(2u), Record, 5u);
+    CHECK(Queue.GetPendingCount() == 2u);
+
+    CHECK(Queue.Retire(2u) == 0u);
+    CHECK(Destroyed.empty());
+    CHECK(Queue.Retire(3u) == 1u);
+    CHECK(Destroyed == std::vector<uintptr_t>{1u});
+    CHECK(Queue.Retire(4u) == 0u);
+    CHECK(Queue.Retire(5u) == 1u);
+    CHECK(Destroyed == (std::vector<uintptr_t>{1u, 2u}));
+    CHECK(Queue.GetPendingCount() == 0u);
+}
+
+TEST(deferred_release, retires_in_enqueue_order)
+{
+    // Batches collected by different Retire calls still come out oldest first
+    Destroyed.clear();
+    DeferredReleaseQueue Queue;
+    Queue.Enqueue(MakeObject(1u), Record, 10u);
+    Queue.Enqueue(MakeObject(2u), Record, 1u);
+    Queue.Enqueue(MakeObject(3u), Record, 10u);
+    CHECK(Queue.Retire(1u) == 1u);
+    Queue.Enqueue(MakeObject(4u), Record, 2u);
+    Queue.Enqueue(MakeObject(5u), Record, 10u);
+    CHECK(Queue.Retire(1u) == 0u);
+    Queue.Enqueue(MakeObject(6u), Record, 3u);
+    CHECK(Queue.Retire(10u) == 5u);
+    CHECK(Destroyed == (std::vector<uintptr_t>{2u, 1u, 3u, 4u, 5u, 6u}));
+}
+
+TEST(deferred_release, shutdown_destroys_everything)
+{
+    Destroyed.clear();
+    {
+        DeferredReleaseQueue Queue;
+        Queue.Enqueue(MakeObject(1u), Record, UINT64_MAX - 1u);
+        Queue.Enqueue(MakeObject(2u), Record, 7u);
+        CHECK(Queue.RetireAll() == 2u);
+        Queue.Enqueue(MakeObject(3u), Record, 100u);
+    }
+    CHECK(Destroyed == (std::vector<uintptr_t>{1u, 2u, 3u}));
+}
+
+TEST(deferred_release, concurrent_producers_lose_nothing)
+{
+    // Producers enqueue for frames ahead of the consumer, which retires as it advances.
+    // Every object has to be destroyed exactly once and never before its frame.
+    constexpr uintptr_t Producers = 4u;
+    constexpr uintptr_t PerProducer = 20000u;
+    Destroyed.clear();
+    DeferredReleaseQueue Queue;
+    std::atomic<uint64_t> Completed{0u};
+    std::vector<std::thread> Threads;
+    for (uintptr_t p = 0; p < Producers; p++)
+    {
+        Threads.emplace_back([&Queue, &Completed, p]()
+        {
+            for (uintptr_t i = 0; i < PerProducer; i++)
+            {
+                // The id encodes the frame, so the consumer can check it
+                const uint64_t Frame = Completed.load() + 1u + i % 3u;
+                Queue.Enqueue(MakeObject((Frame << 20u) | (p * PerProducer + i)), Record, Frame);
+            }
+        });
+    }
+    bool Early = false;
+    while (Destroyed.size() < Producers * PerProducer)
+    {
+        const uint64_t Frame = Completed.load() + 1u;
+        const size_t Before = Destroyed.size();
+        Queue.Retire(Frame);
+        for (size_t i = Before; i < Destroyed.size(); i++)
+        {
+            Early = Early || (Destroyed[i] >> 20u) > Frame;
+        }
+        Completed.store(Frame);
+        if (Frame > 10000000u)
+        {
+            break;
+        }
+    }
+    for (std::thread& t : Threads)
+    {
+        t.join();
+    }
+    Queue.RetireAll();
+    CHECK(!Early);
+    REQUIRE(Destroyed.size() == Producers * PerProducer);
+    std::vector<bool> Seen(Producers * PerProducer, false);
+    for (const uintptr_t Id : Destroyed)
+    {
+        const uintptr_t Index = Id & ((uintptr_t(1u) << 20u) - 1u);
+        REQUIRE(!Seen[Index]);
+        Seen[Index] = true;
+    }
+    CHECK(Queue.GetPendingCount() == 0u);
+}
\ No newline at end of file
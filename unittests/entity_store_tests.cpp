@@ -0,0 +1,197 @@
+#include "test_harness.h"
+#include "entity_store.h"
+#include "job_system.h"
+#include "scene_random.h"
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    struct Position
+    {
+        float X, Y, Z;
+    };
+    struct Velocity
+    {
+        float X, Y, Z;
+    };
+    struct Health
+    {
+        int Value;
+    };
+    struct Tag
+    {
+        uint8_t Unused;
+    };
+    struct alignas(32) Wide
+    {
+        float V[16];
+    };
+
+    // What each live entity should hold, -1 where it lacks the component. Position.Z is
+    // -1 - Position.X, so every byte of a moved row is checked.
+    struct Expected
+    {
+        Entity Handle;
+        float PositionX;
+        bool HasVelocity;
+        int HealthValue;
+        bool HasTag;
+    };
+
+    // Entities in the store that disagree with the model, and the model entries the store lacks
+    size_t CountMismatches(EntityStore& Store, const std::unordered_map<uint32_t, Expected>& Model)
+    {
+        size_t Wrong = Store.GetEntityCount() == Model.size() ? 0u : 1u;
+        for (const auto& [Value, m] : Model)
+        {
+            const Position* p = Store.Get<Position>(m.Handle);
+            const Health* h = Store.Get<Health>(m.Handle);
+            const bool Same = Store.IsAlive(m.Handle) && p != nullptr && p->X == m.PositionX && p->Z == -1.0f - m.PositionX &&
+                (Store.Get<Velocity>(m.Handle) != nullptr) == m.HasVelocity &&
+                (Store.Get<Tag>(m.Handle) != nullptr) == m.HasTag &&
+                (h != nullptr ? h->Value : -1) == m.HealthValue;
+            Wrong += Same ? 0u : 1u;
+        }
+
+        // Every iteration visits each matching entity once
+        std::unordered_map<uint32_t, int> Visits;
+        Store.ForEach<const Position>([&](Entity e, const Position& p)
+        {
+            const auto Found = Model.find(e.Value);
+            Wrong += Found != Model.end() && Found->second.PositionX == p.X ? 0u : 1u;
+            Visits[e.Value]++;
+        });
+        for (const auto& [Value, Count] : Visits)
+        {
+            Wrong += Count == 1 ? 0u : 1u;
+        }
+        Wrong += Visits.size() == Model.size() ? 0u : 1u;
+
+        size_t Moving = 0u;
+        size_t Tagged = 0u;
+        size_t Healthy = 0u;
+        for (const auto& [Value, m] : Model)
+        {
+            Moving += m.HasVelocity ? 1u : 0u;
+            Tagged += m.HasTag ? 1u : 0u;
+            Healthy += m.HasTag && m.HealthValue >= 0 ? 1u : 0u;
+        }
+        Wrong += Store.Count<Velocity>() == Moving && Store.Count<Tag>() == Tagged && Store.Count<Health, const Tag>() == Healthy ? 0u : 1u;
+        return Wrong;
+    }
+}
+
+TEST(entity_store, random_changes_match_a_model)
+{
+    EntityStore Store;
+    std::unordered_map<uint32_t, Expected> Model;
+    std::vector<Entity> Alive;
+    SceneRandom Random(5u);
+    for (int Step = 0; Step < 100000; Step++)
+    {
+        const uint64_t Op = Alive.empty() ? 0u : Random.Next() % 7u;
+        if (Op == 0u || Op == 6u)
+        {
+            const Position p = {static_cast<float>(Step), 0.0f, -1.0f - static_cast<float>(Step)};
+            const uint64_t Kind = Random.Next() % 3u;
+            const Entity e = Kind == 0u ? Store.Create(p) : Kind == 1u ? Store.Create(p, Velocity{1.0f, 2.0f, 3.0f}) : Store.Create(Health{Step}, p);
+            Alive.push_back(e);
+            Model[e.Value] = {e, p.X, Kind == 1u, Kind == 2u ? Step : -1, false};
+            continue;
+        }
+        const size_t k = Random.Next() % Alive.size();
+        const Entity e = Alive[k];
+        Expected& m = Model[e.Value];
+        switch (Op)
+        {
+        case 1u:
+            Store.Destroy(e);
+            Model.erase(e.Value);
+            Alive[k] = Alive.back();
+            Alive.pop_back();
+            break;
+        case 2u:
+            Store.Add(e, Tag{});
+            m.HasTag = true;
+            break;
+        case 3u:
+            Store.Remove<Tag>(e);
+            m.HasTag = false;
+            break;
+        case 4u:
+            Store.Add(e, Health{Step});
+            m.HealthValue = Step;
+            break;
+        default:
+            Store.Remove<Velocity>(e);
+            m.HasVelocity = false;
+            break;
+        }
+        if (Step % 20000 == 0)
+        {
+            CHECK(CountMismatches(Store, Model) == 0u);
+        }
+    }
+    CHECK(CountMismatches(Store, Model) == 0u);
+
+    // Chunks spread over workers see every entity once
+    JobSystem Jobs(3u);
+    std::atomic<size_t> Visited = 0u;
+    Store.ParallelForEachChunk<Position>(Jobs, [&](size_t Count, const Entity*, Position* p, unsigned int)
+    {
+        for (size_t i = 0; i < Count; i++)
+        {
+            p[i].Y += 1.0f;
+        }
+        Visited += Count;
+    });
+    CHECK(Visited == Model.size());
+    size_t Moved = 0u;
+    Store.ForEach<const Position>([&](Entity, const Position& p)
+    {
+        Moved += p.Y == 1.0f ? 1u : 0u;
+    });
+    CHECK(Moved == Model.size());
+
+    // Destroying everything frees every chunk
+    for (const Entity e : Alive)
+    {
+        Store.Destroy(e);
+    }
+    CHECK(Store.GetEntityCount() == 0u);
+    CHECK(Store.GetChunkCount() == 0u);
+}
+
+TEST(entity_store, command_buffers_apply_in_order_and_skip_stale_entities)
+{
+    EntityStore Store;
+    const Entity First = Store.Create(Position{1.0f, 0.0f, 0.0f});
+    const Entity Second = Store.Create(Position{2.0f, 0.0f, 0.0f}, Velocity{});
+
+    CommandBuffer Commands;
+    Commands.Destroy(First);
+    Commands.Add(First, Tag{});
+    Commands.Create(Position{3.0f, 0.0f, 0.0f}, Wide{});
+    Commands.Remove<Position>(Second);
+    Store.Apply(Commands);
+    CHECK(Commands.IsEmpty());
+    CHECK(!Store.IsAlive(First));
+    CHECK(Store.Count<Tag>() == 0u);
+    CHECK(Store.Count<Wide>() == 1u);
+    CHECK(Store.Get<Position>(Second) == nullptr);
+    CHECK(Store.Get<Velocity>(Second) != nullptr);
+    Store.ForEachChunk<Wide>([&](size_t, const Entity*, Wide* Columns)
+    {
+        CHECK(reinterpret_cast<uintptr_t>(Columns) % alignof(Wide) == 0u);
+    });
+
+    // Structural changes are refused while iterating, and on stale entities
+    CHECK_THROWS(Store.ForEach<Velocity>([&](Entity e, Velocity&) { Store.Destroy(e); }), std::logic_error);
+    CHECK(Store.IsAlive(Second));
+    CHECK_THROWS(Store.Destroy(First), StaleHandleException);
+    CHECK(Store.Get<Position>(First) == nullptr);
+}
\ No newline at end of file
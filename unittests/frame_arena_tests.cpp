@@ -0,0 +1,77 @@
+#include "test_harness.h"
+#include "frame_arena.h"
+#include <cstdint>
+#include <new>
+#include <vector>
+
+TEST(frame_arena, aligns_and_packs_allocations)
+{
+    FrameArena Arena(1024u);
+    Arena.Allocate(3u, 1u);
+    std::byte* const Aligned = static_cast<std::byte*>(Arena.Allocate(16u, 16u));
+    CHECK(Aligned - Arena.GetData() == 16);
+    CHECK(reinterpret_cast<uintptr_t>(Aligned) % 16u == 0u);
+    Arena.Allocate(4u, 4u);
+    CHECK(Arena.GetUsed() == 36u);
+}
+
+TEST(frame_arena, throws_when_full)
+{
+    FrameArena Arena(64u);
+    CHECK(Arena.Allocate(64u, 1u) != nullptr);
+    CHECK_THROWS(Arena.Allocate(1u, 1u), FrameArena::Exception);
+    // A failed allocation leaves the arena as it was
+    CHECK(Arena.GetUsed() == 64u);
+    CHECK_THROWS(Arena.Allocate(SIZE_MAX, 1u), FrameArena::Exception);
+}
+
+TEST(frame_arena, rejects_array_sizes_that_overflow)
+{
+    FrameArena Arena(1024u);
+    CHECK_THROWS(Arena.NewArray<uint64_t>(SIZE_MAX / 4u), FrameArena::Exception);
+    CHECK(Arena.GetUsed() == 0u);
+    const uint32_t* const Values = Arena.NewArray<uint32_t>(8u);
+    for (size_t i = 0; i < 8u; i++)
+    {
+        CHECK(Values[i] == 0u);
+    }
+}
+
+TEST(frame_arena, reset_keeps_the_high_water_mark)
+{
+    FrameArena Arena(1024u);
+    Arena.Allocate(600u);
+    Arena.Reset();
+    CHECK(Arena.GetUsed() == 0u);
+    Arena.Allocate(100u);
+    CHECK(Arena.GetHighWaterMark() == 600u);
+}
+
+TEST(frame_arena, ring_keeps_earlier_frames)
+{
+    // Frame 0's data is still intact while frames 1 and 2 allocate
+    FrameArenaRing<3> Ring(256u);
+    uint32_t* const First = Ring.Current().New<uint32_t>(7u);
+    Ring.NextFrame();
+    *Ring.Current().New<uint32_t>() = 1u;
+    Ring.NextFrame();
+    *Ring.Current().New<uint32_t>() = 2u;
+    CHECK(*First == 7u);
+    Ring.NextFrame();
+    CHECK(Ring.Current().GetUsed() == 0u);
+    CHECK(Ring.GetHighWaterMark() == sizeof(uint32_t));
+}
+
+TEST(frame_arena, allocator_backs_containers)
+{
+    FrameArena Arena(1u << 16u);
+    std::vector<uint32_t, ArenaAllocator<uint32_t>> Values{ArenaAllocator<uint32_t>(Arena)};
+    for (uint32_t i = 0; i < 1000u; i++)
+    {
+        Values.push_back(i);
+    }
+    CHECK(Values[999] == 999u);
+    // Outgrown storage is not returned, so the arena holds more than the payload
+    CHECK(Arena.GetUsed() >= Values.size() * sizeof(uint32_t));
+    CHECK_THROWS(ArenaAllocator<uint64_t>(Arena).allocate(SIZE_MAX / 4u), std::bad_array_new_length);
+}
\ No newline at end of file
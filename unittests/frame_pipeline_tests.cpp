@@ -0,0 +1,155 @@
+#include "test_harness.h"
+#include "frame_pipeline.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+    // Runs Frames frames with a simulation thread against a render side that is slower,
+    // returns how far the simulation got ahead of the last finished render at most
+    uint64_t RunFrames(FramePipeline& Pipeline, uint64_t Frames, size_t& OutOfOrder)
+    {
+        std::atomic<uint64_t> Rendered = 0u;
+        std::atomic<uint64_t> MaxAhead = 0u;
+        std::thread Simulation([&]()
+        {
+            while (FramePacket* const Packet = Pipeline.BeginSimulate())
+            {
+                // Rendered is counted before EndRender, so this never undercounts the lead
+                const uint64_t Ahead = Packet->Index - Rendered;
+                MaxAhead = std::max<uint64_t>(MaxAhead, Ahead);
+                Packet->FrameConstants[0] = static_cast<float>(Packet->Index);
+                Pipeline.EndSimulate(*Packet);
+            }
+        });
+
+        OutOfOrder = 0u;
+        for (uint64_t i = 0; i < Frames; i++)
+        {
+            FramePacket* const Packet = Pipeline.BeginRender();
+            if (Packet == nullptr)
+            {
+                OutOfOrder++;
+                break;
+            }
+            OutOfOrder += Packet->Index == i && Packet->FrameConstants[0] == static_cast<float>(i) ? 0u : 1u;
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+            Rendered++;
+            Pipeline.EndRender(*Packet);
+        }
+        Pipeline.Stop();
+        Simulation.join();
+        return MaxAhead;
+    }
+}
+
+TEST(frame_pipeline, depth_one_runs_serially)
+{
+    FramePipeline Pipeline(1u);
+    CHECK(Pipeline.GetDepth() == 1u);
+    size_t OutOfOrder = 0u;
+    CHECK(RunFrames(Pipeline, 50u, OutOfOrder) == 0u);
+    CHECK(OutOfOrder == 0u);
+
+    // A depth of 0 is treated as 1
+    CHECK(FramePipeline(0u).GetDepth() == 1u);
+}
+
+TEST(frame_pipeline, simulation_runs_at_most_depth_minus_one_frames_ahead)
+{
+    for (unsigned int Depth : {2u, 3u, 5u})
+    {
+        FramePipeline Pipeline(Depth);
+        size_t OutOfOrder = 0u;
+        // The render side is slow enough that the simulation fills every packet
+        CHECK(RunFrames(Pipeline, 50u, OutOfOrder) == Depth - 1u);
+        CHECK(OutOfOrder == 0u);
+    }
+}
+
+TEST(frame_pipeline, fail_rethrows_on_both_sides)
+{
+    // A render thread already waiting for a packet wakes up with the error
+    FramePipeline Pipeline(2u);
+    std::atomic<bool> Caught = false;
+    std::thread Render([&]()
+    {
+        try
+        {
+            Pipeline.BeginRender();
+        }
+        catch (const std::runtime_error&)
+        {
+            Caught = true;
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    Pipeline.Fail(std::make_exception_ptr(std::runtime_error("simulation failed")));
+    Render.join();
+    CHECK(Caught);
+
+    CHECK_THROWS(Pipeline.BeginRender(), std::runtime_error);
+    CHECK_THROWS(Pipeline.BeginSimulate(), std::runtime_error);
+}
+
+TEST(frame_pipeline, stop_wakes_both_sides)
+{
+    // A simulation blocked on a full ring returns null
+    FramePipeline Full(2u);
+    for (int i = 0; i < 2; i++)
+    {
+        FramePacket* const Packet = Full.BeginSimulate();
+        REQUIRE(Packet != nullptr);
+        Full.EndSimulate(*Packet);
+    }
+    std::atomic<bool> SimulationWoke = false;
+    std::thread Simulation([&]()
+    {
+        SimulationWoke = Full.BeginSimulate() == nullptr;
+    });
+
+    // A render side waiting on an empty ring returns null without any error
+    FramePipeline Empty(2u);
+    std::atomic<bool> RenderWoke = false;
+    std::thread Render([&]()
+    {
+        RenderWoke = Empty.BeginRender() == nullptr;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    Full.Stop();
+    Empty.Stop();
+    Simulation.join();
+    Render.join();
+    CHECK(SimulationWoke);
+    CHECK(RenderWoke);
+    CHECK(Full.BeginSimulate() == nullptr);
+    CHECK(Full.BeginRender() == nullptr);
+}
+
+TEST(frame_pipeline, latency_covers_simulation_to_submission)
+{
+    FramePipeline Pipeline(1u);
+    for (int Milliseconds : {5, 15, 10})
+    {
+        FramePacket* const Simulated = Pipeline.BeginSimulate();
+        REQUIRE(Simulated != nullptr);
+        Pipeline.EndSimulate(*Simulated);
+        std::this_thread::sleep_for(std::chrono::milliseconds(Milliseconds));
+        FramePacket* const Packet = Pipeline.BeginRender();
+        REQUIRE(Packet == Simulated);
+        Pipeline.EndRender(*Packet);
+    }
+    const FramePipeline::LatencyStats Latency = Pipeline.GetLatency();
+    CHECK(Latency.Frames == 3u);
+    CHECK(Latency.Last >= 0.010f);
+    CHECK(Latency.Max >= 0.015f);
+    CHECK(Latency.Max >= Latency.Last);
+    // The mean of three frames of at least 5, 15 and 10 ms, and no more than the worst
+    CHECK(Latency.Average >= 0.010f);
+    CHECK(Latency.Average <= Latency.Max);
+}
\ No newline at end of file
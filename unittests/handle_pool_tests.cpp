@@ -0,0 +1,118 @@
+#include "test_harness.h"
+#include "handle_pool.h"
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    using TestHandle = Handle<struct TestTag>;
+    using TestPool = HandlePool<int, TestHandle>;
+}
+
+TEST(handle_pool, removed_handles_are_stale)
+{
+    TestPool Pool;
+    const TestHandle First = Pool.Insert(1);
+    const TestHandle Second = Pool.Insert(2);
+    CHECK(First.IsValid());
+    CHECK(*Pool.Get(First) == 1);
+
+    CHECK(Pool.Remove(First) == 1);
+    CHECK(!Pool.IsAlive(First));
+    CHECK(Pool.Get(First) == nullptr);
+    CHECK_THROWS(Pool.At(First), StaleHandleException);
+    CHECK_THROWS(Pool.Remove(First), StaleHandleException);
+    // The last object was swapped into the hole and keeps its handle
+    CHECK(Pool.At(Second) == 2);
+    CHECK(Pool.GetSize() == 1u);
+}
+
+TEST(handle_pool, reused_slots_do_not_alias_old_handles)
+{
+    TestPool Pool;
+    const TestHandle Old = Pool.Insert(1);
+    Pool.Remove(Old);
+    const TestHandle New = Pool.Insert(2);
+    CHECK(New.GetIndex() == Old.GetIndex());
+    CHECK(New.GetGeneration() != Old.GetGeneration());
+    CHECK(Pool.Get(Old) == nullptr);
+    CHECK(*Pool.Get(New) == 2);
+}
+
+TEST(handle_pool, null_and_foreign_handles_are_rejected)
+{
+    TestPool Pool;
+    Pool.Insert(1);
+    CHECK(!Pool.IsAlive(TestHandle{}));
+    CHECK(Pool.Get(TestHandle{}) == nullptr);
+    CHECK(!Pool.IsAlive(TestHandle::Make(5u, 1u)));
+    CHECK_THROWS(Pool.At(TestHandle::Make(5u, 1u)), StaleHandleException);
+}
+
+TEST(handle_pool, generations_wrap_without_producing_null)
+{
+    // Every generation of slot 0 is used up, so the counter wraps and has to skip 0
+    TestPool Pool;
+    TestHandle Previous = Pool.Insert(0);
+    // Generations run from 1 to GenerationMask, that many removes come back to the first
+    for (uint32_t i = 1u; i <= TestHandle::GenerationMask; i++)
+    {
+        Pool.Remove(Previous);
+        const TestHandle Next = Pool.Insert(static_cast<int>(i));
+        REQUIRE(Next.GetIndex() == 0u);
+        REQUIRE(Next.IsValid());
+        REQUIRE(Next.GetGeneration() != 0u);
+        REQUIRE(!Pool.IsAlive(Previous));
+        REQUIRE(Pool.At(Next) == static_cast<int>(i));
+        Previous = Next;
+    }
+    CHECK(Previous.GetGeneration() == 1u);
+}
+
+TEST(handle_pool, matches_a_map_under_random_use)
+{
+    TestPool Pool;
+    std::unordered_map<uint32_t, int> Expected;
+    std::vector<TestHandle> Live;
+    std::vector<TestHandle> Dead;
+    std::mt19937 Random(31u);
+    for (int Step = 0; Step < 20000; Step++)
+    {
+        if (Live.empty() || Random() % 3u != 0u)
+        {
+            const TestHandle h = Pool.Insert(Step);
+            REQUIRE(!Expected.contains(h.Value));
+            Expected[h.Value] = Step;
+            Live.push_back(h);
+        }
+        else
+        {
+            const size_t Pick = Random() % Live.size();
+            const TestHandle h = Live[Pick];
+            CHECK(Pool.Remove(h) == Expected[h.Value]);
+            Expected.erase(h.Value);
+            Live[Pick] = Live.back();
+            Live.pop_back();
+            Dead.push_back(h);
+        }
+    }
+    REQUIRE(Pool.GetSize() == Live.size());
+    for (const TestHandle h : Live)
+    {
+        REQUIRE(Pool.Get(h) != nullptr);
+        CHECK(*Pool.Get(h) == Expected[h.Value]);
+    }
+    // Dead handles stay dead unless the very same value was handed out again
+    for (const TestHandle h : Dead)
+    {
+        CHECK(Pool.IsAlive(h) == Expected.contains(h.Value));
+    }
+    size_t Count = 0u;
+    for (const int Value : Pool)
+    {
+        Count += Value >= 0 ? 1u : 0u;
+    }
+    CHECK(Count == Live.size());
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#include "test_harness.h"
+#include "job_system.h"
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+TEST(job_system, covers_every_item_once)
+{
+    JobSystem Jobs(3u);
+    for (size_t Count : {1u, 7u, 64u, 1000u, 4097u})
+    {
+        for (size_t Grain : {1u, 3u, 64u, 5000u})
+        {
+            std::vector<std::atomic<int>> Hits(Count);
+            std::atomic<bool> Aligned{true};
+            Jobs.ParallelFor(Count, Grain, [&](size_t Begin, size_t End, unsigned int Thread)
+            {
+                Aligned = Aligned && Begin % Grain == 0u && End - Begin <= Grain && Thread < Jobs.GetThreadCount();
+                for (size_t i = Begin; i < End; i++)
+                {
+                    Hits[i]++;
+                }
+            });
+            CHECK(Aligned);
+            for (const std::atomic<int>& h : Hits)
+            {
+                REQUIRE(h == 1);
+            }
+        }
+    }
+}
+
+TEST(job_system, nested_loops_run_serially)
+{
+    JobSystem Jobs(3u);
+    std::atomic<size_t> Total{0u};
+    Jobs.ParallelFor(16u, 1u, [&](size_t, size_t, unsigned int)
+    {
+        Jobs.ParallelFor(100u, 10u, [&](size_t Begin, size_t End, unsigned int)
+        {
+            Total += End - Begin;
+        });
+    });
+    CHECK(Total == 1600u);
+}
+
+TEST(job_system, rethrows_a_worker_exception_on_the_caller)
+{
+    JobSystem Jobs(3u);
+    for (int Round = 0; Round < 50; Round++)
+    {
+        // Every chunk throws, only one exception may come out and the rest are skipped
+        std::atomic<size_t> Started{0u};
+        bool Caught = false;
+        try
+        {
+            Jobs.ParallelFor(1000u, 1u, [&](size_t Begin, size_t, unsigned int)
+            {
+                Started++;
+                if (Begin % 2u == 1u || Round % 2 == 0)
+                {
+                    throw std::runtime_error("chunk failed");
+                }
+            });
+        }
+        catch (const std::runtime_error&)
+        {
+            Caught = true;
+        }
+        CHECK(Caught);
+        CHECK(Started < 1000u);
+    }
+
+    // The pool keeps working afterwards
+    std::atomic<size_t> Total{0u};
+    Jobs.ParallelFor(1000u, 10u, [&](size_t Begin, size_t End, unsigned int) { Total += End - Begin; });
+    CHECK(Total == 1000u);
+}
+
+TEST(job_system, serial_loops_throw_as_well)
+{
+    JobSystem Jobs(0u);
+    CHECK_THROWS(Jobs.ParallelFor(10u, 1u, [](size_t, size_t, unsigned int) { throw std::logic_error("serial"); }), std::logic_error);
+}
\ No newline at end of file
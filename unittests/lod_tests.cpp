@@ -0,0 +1,215 @@
+#include "test_harness.h"
+#include "lod.h"
+#include "job_system.h"
+#include "scene_random.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+    // Candidate thresholds the way the selector builds them
+    std::vector<float> GetThresholds(float PixelError)
+    {
+        std::vector<float> Thresholds(LodSelector::BudgetSteps);
+        Thresholds[0] = PixelError;
+        for (uint32_t k = 1; k < LodSelector::BudgetSteps; k++)
+        {
+            Thresholds[k] = Thresholds[k - 1u] * LodSelector::BudgetStep;
+        }
+        return Thresholds;
+    }
+
+    // Linear search for the first threshold Pixels fits under
+    uint32_t FindStep(const std::vector<float>& Thresholds, float Pixels)
+    {
+        uint32_t Step = 0u;
+        while (Step < Thresholds.size() && Thresholds[Step] < Pixels)
+        {
+            Step++;
+        }
+        return Step;
+    }
+
+    // One sphere of radius 1 at the origin seen from Distance past its surface on -z.
+    // With a pixel scale of 1 an error projects to exactly its own size at distance 1.
+    struct SingleObject
+    {
+        float X = 0.0f;
+        float Y = 0.0f;
+        float Z = 0.0f;
+        float Radius = 1.0f;
+        uint32_t Mesh = 0u;
+        uint32_t Visible = 0u;
+
+        uint32_t Select(LodSelector& Lods, JobSystem& Jobs, float Distance)
+        {
+            const Vec3 Eye = {0.0f, 0.0f, -(Radius + Distance)};
+            const Mat4 ViewProjection = Multiply(Mat4::LookAt(Eye, {0.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}), Mat4::Perspective(1.5f, 1.0f, 0.01f, 100.0f));
+            const SphereStreams Spheres = {&X, &Y, &Z, &Radius};
+            REQUIRE(Lods.CullAndSelect(Jobs, Frustum::FromMatrix(ViewProjection), Eye, 1.0f, Spheres, &Mesh, 1u, &Visible) == 1u);
+            return Lods.GetLevels()[0];
+        }
+    };
+}
+
+TEST(lod, step_lookup_lands_on_the_threshold_table)
+{
+    // Level 1 halves the triangles and a budget of one triangle forces it, so the
+    // threshold picked is the first one level 1's error fits under
+    JobSystem Jobs(1u);
+    const std::vector<float> Thresholds = GetThresholds(1.0f);
+    SingleObject Object;
+    for (uint32_t k = 0; k < LodSelector::BudgetSteps; k++)
+    {
+        // Exactly on a threshold, just above it and between two of them
+        const float Errors[] = {Thresholds[k], std::nextafter(Thresholds[k], 2.0f * Thresholds[k]), Thresholds[k] * 1.1f};
+        for (const float Error : Errors)
+        {
+            LodSelector Probe({1.0f, 0.0f, 1u});
+            const LodLevel Levels[] = {{0u, 6u, 0.0f}, {6u, 3u, Error}};
+            Probe.AddMesh(Levels, 2u);
+            const uint32_t Level = Object.Select(Probe, Jobs, 1.0f);
+            const uint32_t Expected = FindStep(Thresholds, Error);
+            if (Expected < LodSelector::BudgetSteps)
+            {
+                CHECK(Probe.GetPixelError() == Thresholds[Expected]);
+                CHECK(Level == 1u);
+                CHECK(Probe.GetTriangleCount() == 1u);
+            }
+            else
+            {
+                // Past the last threshold the budget cannot be met
+                CHECK(Probe.GetPixelError() == Thresholds[LodSelector::BudgetSteps - 1u]);
+                CHECK(Level == 0u);
+                CHECK(Probe.GetTriangleCount() == 2u);
+            }
+        }
+    }
+}
+
+TEST(lod, hysteresis_keeps_the_coarser_level)
+{
+    // Level 1 projects to 1 / Distance pixels. Coarsening needs 1.25 / Distance <= 1,
+    // staying coarse only 1 / Distance <= 1.
+    JobSystem Jobs(1u);
+    const LodLevel Levels[] = {{0u, 6u, 0.0f}, {6u, 3u, 1.0f}};
+    LodSelector Lods({1.0f, 0.2f, 0u});
+    Lods.AddMesh(Levels, 2u);
+    SingleObject Object;
+    CHECK(Object.Select(Lods, Jobs, 1.1f) == 0u);
+    CHECK(Object.Select(Lods, Jobs, 1.5f) == 1u);
+    CHECK(Object.Select(Lods, Jobs, 1.1f) == 1u);
+    CHECK(Object.Select(Lods, Jobs, 0.95f) == 0u);
+    CHECK(Object.Select(Lods, Jobs, 1.1f) == 0u);
+
+    LodSelector Plain({1.0f, 0.0f, 0u});
+    Plain.AddMesh(Levels, 2u);
+    CHECK(Object.Select(Plain, Jobs, 1.1f) == 1u);
+    CHECK(Object.Select(Plain, Jobs, 0.95f) == 0u);
+    CHECK(Object.Select(Plain, Jobs, 1.1f) == 1u);
+}
+
+TEST(lod, budget_matches_brute_force_selection)
+{
+    // Enough objects for several slices on several workers, three meshes whose levels
+    // quarter the triangles and double the error
+    constexpr size_t Count = 2u * LodSelector::Grain + 5000u;
+    const LodSelector::Settings Config = {1.0f, 0.2f, 0u};
+    LodSelector Lods(Config);
+    std::vector<std::vector<LodLevel>> Meshes;
+    for (uint32_t m = 0; m < 3u; m++)
+    {
+        std::vector<LodLevel> Levels;
+        uint32_t First = 0u;
+        for (uint32_t l = 0; l < 4u + m; l++)
+        {
+            const uint32_t Triangles = std::max((4096u >> (2u * m)) >> (2u * l), 1u);
+            Levels.push_back({First, Triangles * 3u, l == 0u ? 0.0f : 0.01f * static_cast<float>((1u << l) * (m + 1u))});
+            First += Triangles * 3u;
+        }
+        Lods.AddMesh(Levels.data(), static_cast<uint32_t>(Levels.size()));
+        Meshes.push_back(std::move(Levels));
+    }
+
+    SceneRandom Random(11u);
+    std::vector<float> X(Count);
+    std::vector<float> Y(Count);
+    std::vector<float> Z(Count);
+    std::vector<float> Radius(Count);
+    std::vector<uint32_t> MeshOf(Count);
+    for (size_t i = 0; i < Count; i++)
+    {
+        X[i] = Random.NextFloat(-100.0f, 100.0f);
+        Y[i] = Random.NextFloat(-10.0f, 10.0f);
+        Z[i] = Random.NextFloat(-10.0f, 400.0f);
+        Radius[i] = Random.NextFloat(0.5f, 1.5f);
+        MeshOf[i] = static_cast<uint32_t>(i % 3u);
+    }
+    const SphereStreams Spheres = {X.data(), Y.data(), Z.data(), Radius.data()};
+    const Mat4 Projection = Mat4::Perspective(1.0f, 16.0f / 9.0f, 0.5f, 1000.0f);
+    const Vec3 Eye = {0.0f, 2.0f, -20.0f};
+    const Frustum View = Frustum::FromMatrix(Multiply(Mat4::LookAt(Eye, {0.0f, 0.0f, 50.0f}, {0.0f, 1.0f, 0.0f}), Projection));
+    const float PixelScale = LodSelector::GetPixelScale(Projection, 1080u);
+    const std::vector<float> Thresholds = GetThresholds(Config.PixelError);
+    const float CoarsenFactor = 1.0f / (1.0f - Config.Hysteresis);
+
+    JobSystem Jobs(3u);
+    std::vector<uint32_t> Visible(Count);
+    std::vector<uint8_t> Previous(Count, 0u);
+    const uint64_t Budgets[] = {0u, 2000000u, 600000u, 40000u, 1000u, 600000u};
+    for (const uint64_t Budget : Budgets)
+    {
+        Lods.SetSettings({Config.PixelError, Config.Hysteresis, Budget});
+        const size_t VisibleCount = Lods.CullAndSelect(Jobs, View, Eye, PixelScale, Spheres, MeshOf.data(), Count, Visible.data());
+        REQUIRE(VisibleCount > 0u);
+
+        // Step at which each visible object reaches each level, from the levels it had
+        std::vector<std::vector<uint32_t>> Reached(VisibleCount);
+        std::vector<uint64_t> StepTriangles(LodSelector::BudgetSteps, 0u);
+        for (size_t j = 0; j < VisibleCount; j++)
+        {
+            const uint32_t i = Visible[j];
+            const std::vector<LodLevel>& Levels = Meshes[MeshOf[i]];
+            const Vec3 ToCenter = {X[i] - Eye.X, Y[i] - Eye.Y, Z[i] - Eye.Z};
+            const float ErrorScale = PixelScale * Radius[i] / std::max(Length(ToCenter) - Radius[i], 1e-4f);
+            Reached[j].push_back(0u);
+            for (uint32_t l = 1; l < Levels.size(); l++)
+            {
+                const float Pixels = Levels[l].Error * ErrorScale * (l > Previous[i] ? CoarsenFactor : 1.0f);
+                Reached[j].push_back(std::max(FindStep(Thresholds, Pixels), Reached[j].back()));
+            }
+            for (uint32_t k = 0; k < LodSelector::BudgetSteps; k++)
+            {
+                uint32_t Level = 0u;
+                while (Level + 1u < Levels.size() && Reached[j][Level + 1u] <= k)
+                {
+                    Level++;
+                }
+                StepTriangles[k] += Levels[Level].IndexCount / 3u;
+            }
+        }
+
+        uint32_t Step = 0u;
+        while (Budget > 0u && Step + 1u < LodSelector::BudgetSteps && StepTriangles[Step] > Budget)
+        {
+            Step++;
+        }
+        CHECK(Lods.GetPixelError() == Thresholds[Step]);
+        CHECK(Lods.GetTriangleCount() == StepTriangles[Step]);
+        size_t Mismatches = 0u;
+        for (size_t j = 0; j < VisibleCount; j++)
+        {
+            const uint32_t i = Visible[j];
+            uint32_t Level = 0u;
+            while (Level + 1u < Reached[j].size() && Reached[j][Level + 1u] <= Step)
+            {
+                Level++;
+            }
+            Mismatches += Lods.GetLevels()[i] != Level ? 1u : 0u;
+        }
+        CHECK(Mismatches == 0u);
+        std::copy(Lods.GetLevels(), Lods.GetLevels() + Count, Previous.begin());
+    }
+}
\ No newline at end of file
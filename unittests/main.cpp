@@ -0,0 +1,84 @@
+#include "test_harness.h"
+#include "exceptions.h"
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <string>
+
+// Exit codes like benchcompare's, a failed test is not a broken invocation
+namespace
+{
+    constexpr int Passed = 0;
+    constexpr int Failed = 1;
+    constexpr int Failure = 2;
+
+    bool IsSelected(const std::string& Name, int argc, char* argv[])
+    {
+        if (argc < 2)
+        {
+            return true;
+        }
+        for (int i = 1; i < argc; i++)
+        {
+            if (Name.starts_with(argv[i]))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+// usage: unittests [name prefix ...], runs every test without arguments
+int main(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (argv[i][0] == '-')
+        {
+            std::cerr << "usage: unittests [name prefix ...]" << std::endl;
+            return Failure;
+        }
+    }
+
+    std::vector<Tests::TestCase> Selected;
+    for (const Tests::TestCase& Test : Tests::GetRegistry())
+    {
+        if (IsSelected(Test.Name, argc, argv))
+        {
+            Selected.push_back(Test);
+        }
+    }
+    std::sort(Selected.begin(), Selected.end(), [](const Tests::TestCase& a, const Tests::TestCase& b) { return a.Name < b.Name; });
+
+    unsigned int FailedTests = 0u;
+    for (const Tests::TestCase& Test : Selected)
+    {
+        try
+        {
+            Test.Body();
+        }
+        catch (const Tests::RequireFailed&)
+        {
+        }
+        catch (const MyException& e)
+        {
+            Tests::ReportFailure(__FILE__, __LINE__, std::string(e.GetType()) + " " + e.what());
+        }
+        catch (const std::exception& e)
+        {
+            Tests::ReportFailure(__FILE__, __LINE__, std::string("Unexpected exception ") + e.what());
+        }
+        const bool Ok = Tests::TakeFailures() == 0u;
+        FailedTests += Ok ? 0u : 1u;
+        std::cout << (Ok ? "[  ok  ] " : "[FAILED] ") << Test.Name << std::endl;
+    }
+
+    std::cout << Selected.size() - FailedTests << " of " << Selected.size() << " tests passed" << std::endl;
+    if (Selected.empty())
+    {
+        std::cerr << "No test matches" << std::endl;
+        return Failure;
+    }
+    return FailedTests == 0u ? Passed : Failed;
+}
\ No newline at end of file
@@ -0,0 +1,323 @@
+#include "test_harness.h"
+#include "meshlet.h"
+#include "job_system.h"
+#include "scene_random.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    struct TriangleMesh
+    {
+        std::vector<Vec3> Positions;
+        std::vector<uint32_t> Indices;
+    };
+
+    // Torus around the y axis with its faces wound outwards
+    TriangleMesh MakeTorus(uint32_t Rings, uint32_t Sides)
+    {
+        TriangleMesh Mesh;
+        for (uint32_t a = 0; a < Rings; a++)
+        {
+            for (uint32_t b = 0; b < Sides; b++)
+            {
+                const float u = 6.2831853f * static_cast<float>(a) / static_cast<float>(Rings);
+                const float v = 6.2831853f * static_cast<float>(b) / static_cast<float>(Sides);
+                const float r = 1.0f + 0.4f * std::cos(v);
+                Mesh.Positions.push_back({r * std::cos(u), 0.4f * std::sin(v), r * std::sin(u)});
+            }
+        }
+        for (uint32_t a = 0; a < Rings; a++)
+        {
+            for (uint32_t b = 0; b < Sides; b++)
+            {
+                const uint32_t Next = (a + 1u) % Rings * Sides;
+                const uint32_t Side = (b + 1u) % Sides;
+                Mesh.Indices.insert(Mesh.Indices.end(), {a * Sides + b, a * Sides + Side, Next + b, Next + b, a * Sides + Side, Next + Side});
+            }
+        }
+        return Mesh;
+    }
+
+    // Loose triangles that share no vertices, with a few degenerate ones
+    TriangleMesh MakeSoup(size_t TriangleCount)
+    {
+        TriangleMesh Mesh;
+        SceneRandom Random(TriangleCount);
+        for (size_t t = 0; t < TriangleCount; t++)
+        {
+            const Vec3 c = {Random.NextFloat(-5.0f, 5.0f), Random.NextFloat(-5.0f, 5.0f), Random.NextFloat(-5.0f, 5.0f)};
+            for (int k = 0; k < 3; k++)
+            {
+                Mesh.Indices.push_back(static_cast<uint32_t>(Mesh.Positions.size()));
+                Mesh.Positions.push_back(t % 50u == 49u ? c : Vec3{c.X + Random.NextFloat(-0.5f, 0.5f), c.Y + Random.NextFloat(-0.5f, 0.5f), c.Z + Random.NextFloat(-0.5f, 0.5f)});
+            }
+        }
+        return Mesh;
+    }
+
+    // Rotated so the smallest index comes first, which keeps the winding
+    std::array<uint32_t, 3> Canonical(const uint32_t* t)
+    {
+        const size_t First = std::min_element(t, t + 3) - t;
+        return {t[First], t[(First + 1u) % 3u], t[(First + 2u) % 3u]};
+    }
+
+    // Number of broken promises of BuildMeshlets on Mesh
+    size_t CountBrokenMeshlets(const TriangleMesh& Mesh, const MeshletMesh& Meshlets)
+    {
+        size_t Broken = 0u;
+        std::vector<std::array<uint32_t, 3>> Expected;
+        std::vector<std::array<uint32_t, 3>> Built;
+        for (size_t i = 0; i + 2u < Mesh.Indices.size(); i += 3u)
+        {
+            Expected.push_back(Canonical(&Mesh.Indices[i]));
+        }
+        for (size_t i = 0; i + 2u < Meshlets.Indices.size(); i += 3u)
+        {
+            Built.push_back(Canonical(&Meshlets.Indices[i]));
+        }
+        std::sort(Expected.begin(), Expected.end());
+        std::sort(Built.begin(), Built.end());
+        Broken += Expected == Built ? 0u : 1u;
+
+        const size_t Count = Meshlets.GetMeshletCount();
+        Broken += Meshlets.FirstIndex.size() == Count + 1u && Meshlets.FirstIndex.front() == 0u && Meshlets.FirstIndex.back() == Mesh.Indices.size() ? 0u : 1u;
+        for (size_t m = 0; m < Count; m++)
+        {
+            const uint32_t Begin = Meshlets.FirstIndex[m];
+            const uint32_t End = Meshlets.FirstIndex[m + 1u];
+            Broken += End > Begin && (End - Begin) % 3u == 0u && (End - Begin) / 3u <= MeshletMesh::MaxTriangles ? 0u : 1u;
+            std::vector<uint32_t> Vertices(Meshlets.Indices.begin() + Begin, Meshlets.Indices.begin() + End);
+            std::sort(Vertices.begin(), Vertices.end());
+            Broken += std::unique(Vertices.begin(), Vertices.end()) - Vertices.begin() <= static_cast<ptrdiff_t>(MeshletMesh::MaxVertices) ? 0u : 1u;
+
+            // The sphere holds every vertex and the cone every triangle normal
+            const Vec3 Center = {Meshlets.X[m], Meshlets.Y[m], Meshlets.Z[m]};
+            const Vec3 Axis = {Meshlets.AxisX[m], Meshlets.AxisY[m], Meshlets.AxisZ[m]};
+            for (uint32_t i = Begin; i < End; i++)
+            {
+                Broken += Length(Mesh.Positions[Meshlets.Indices[i]] - Center) <= Meshlets.Radius[m] * 1.0001f + 1e-6f ? 0u : 1u;
+            }
+            if (Meshlets.Cutoff[m] > 1.0f)
+            {
+                continue;
+            }
+            const float MinCosine = std::sqrt(1.0f - Meshlets.Cutoff[m] * Meshlets.Cutoff[m]);
+            for (uint32_t i = Begin; i < End; i += 3u)
+            {
+                const Vec3& a = Mesh.Positions[Meshlets.Indices[i]];
+                const Vec3 n = Cross(Mesh.Positions[Meshlets.Indices[i + 1u]] - a, Mesh.Positions[Meshlets.Indices[i + 2u]] - a);
+                if (Length(n) > 1e-12f)
+                {
+                    Broken += Dot(Normalize(n), Axis) >= MinCosine - 1e-4f ? 0u : 1u;
+                }
+            }
+        }
+        return Broken;
+    }
+
+    // Meshlets kept per placement and index, from the draw ranges
+    std::vector<std::vector<uint8_t>> GetKept(const MeshletCuller& Culler, size_t RangeCount, size_t PlacementCount, size_t IndexCount)
+    {
+        std::vector<std::vector<uint8_t>> Kept(PlacementCount, std::vector<uint8_t>(IndexCount, 0u));
+        for (size_t i = 0; i < RangeCount; i++)
+        {
+            const MeshletCuller::DrawRange& r = Culler.GetRanges()[i];
+            std::fill(Kept[r.Instance].begin() + r.FirstIndex, Kept[r.Instance].begin() + r.FirstIndex + r.IndexCount, uint8_t(1u));
+        }
+        return Kept;
+    }
+
+    // A clip space triangle with every corner past the same plane
+    bool IsOutside(const Vec4* c)
+    {
+        const auto All = [&](auto Past)
+        {
+            return Past(c[0]) && Past(c[1]) && Past(c[2]);
+        };
+        return All([](const Vec4& v) { return v.X < -v.W; }) || All([](const Vec4& v) { return v.X > v.W; }) ||
+            All([](const Vec4& v) { return v.Y < -v.W; }) || All([](const Vec4& v) { return v.Y > v.W; }) ||
+            All([](const Vec4& v) { return v.Z < 0.0f; }) || All([](const Vec4& v) { return v.Z > v.W; });
+    }
+
+    // Off screen, which the occlusion buffer does not answer for, or behind its occluders
+    bool IsHidden(const OcclusionBuffer& Occlusion, const Mat4& ViewProjection, const Vec3& Low, const Vec3& High)
+    {
+        uint32_t Past[4] = {};
+        for (uint32_t k = 0; k < 8u; k++)
+        {
+            const Vec4 v = Transform({(k & 1u) ? High.X : Low.X, (k & 2u) ? High.Y : Low.Y, (k & 4u) ? High.Z : Low.Z, 1.0f}, ViewProjection);
+            Past[0] += v.X < -v.W ? 1u : 0u;
+            Past[1] += v.X > v.W ? 1u : 0u;
+            Past[2] += v.Y < -v.W ? 1u : 0u;
+            Past[3] += v.Y > v.W ? 1u : 0u;
+        }
+        return std::find(Past, Past + 4, 8u) != Past + 4 || Occlusion.IsOccluded(Low, High);
+    }
+}
+
+TEST(meshlet, build_keeps_every_triangle_within_limits)
+{
+    const TriangleMesh Torus = MakeTorus(128u, 48u);
+    const MeshletMesh TorusMeshlets = BuildMeshlets(Torus.Positions.data(), Torus.Positions.size(), Torus.Indices.data(), Torus.Indices.size());
+    CHECK(CountBrokenMeshlets(Torus, TorusMeshlets) == 0u);
+    // A closed grid fills its meshlets well
+    CHECK(TorusMeshlets.GetMeshletCount() * MeshletMesh::MaxTriangles < Torus.Indices.size() / 3u * 2u);
+
+    // No triangle shares a vertex, so every meshlet needs a new seed
+    const TriangleMesh Soup = MakeSoup(1000u);
+    const MeshletMesh SoupMeshlets = BuildMeshlets(Soup.Positions.data(), Soup.Positions.size(), Soup.Indices.data(), Soup.Indices.size());
+    CHECK(CountBrokenMeshlets(Soup, SoupMeshlets) == 0u);
+
+    const TriangleMesh One = MakeSoup(1u);
+    CHECK(BuildMeshlets(One.Positions.data(), One.Positions.size(), One.Indices.data(), One.Indices.size()).GetMeshletCount() == 1u);
+    CHECK(BuildMeshlets(Torus.Positions.data(), Torus.Positions.size(), nullptr, 0u).GetMeshletCount() == 0u);
+
+    const uint32_t Partial[] = {0u, 1u};
+    CHECK_THROWS(BuildMeshlets(Torus.Positions.data(), Torus.Positions.size(), Partial, 2u), std::invalid_argument);
+    const uint32_t PastEnd[] = {0u, 1u, static_cast<uint32_t>(Torus.Positions.size())};
+    CHECK_THROWS(BuildMeshlets(Torus.Positions.data(), Torus.Positions.size(), PastEnd, 3u), std::invalid_argument);
+}
+
+TEST(meshlet, culling_drops_only_invisible_meshlets)
+{
+    const TriangleMesh Torus = MakeTorus(128u, 48u);
+    const MeshletMesh Meshlets = BuildMeshlets(Torus.Positions.data(), Torus.Positions.size(), Torus.Indices.data(), Torus.Indices.size());
+    const size_t MeshletCount = Meshlets.GetMeshletCount();
+    const size_t IndexCount = Torus.Indices.size();
+    SceneRandom Random(3u);
+    JobSystem Jobs(3u);
+    size_t TotalHidden = 0u;
+    for (int Trial = 0; Trial < 10; Trial++)
+    {
+        const Vec3 Eye = {Random.NextFloat(-10.0f, 10.0f), Random.NextFloat(-10.0f, 10.0f), Random.NextFloat(-25.0f, -15.0f)};
+        const Mat4 ViewProjection = Multiply(Mat4::LookAt(Eye, {Random.NextFloat(-3.0f, 3.0f), Random.NextFloat(-3.0f, 3.0f), 0.0f}, {0.0f, 1.0f, 0.0f}), Mat4::Perspective(0.8f, 16.0f / 9.0f, 0.5f, 100.0f));
+        // Placement 4 is mirrored, which turns its front faces back
+        std::vector<Mat4> Worlds;
+        for (int k = 0; k < 9; k++)
+        {
+            const Vec3 Axis = Normalize(Vec3{Random.NextFloat(-1.0f, 1.0f), Random.NextFloat(-1.0f, 1.0f), Random.NextFloat(-1.0f, 1.0f)});
+            const float s = Random.NextFloat(0.5f, 1.5f);
+            const Vec3 Scale = {k == 4 ? -s : s, s * Random.NextFloat(0.7f, 1.3f), s};
+            Worlds.push_back(Mat4::Compose({Random.NextFloat(-8.0f, 8.0f), Random.NextFloat(-8.0f, 8.0f), Random.NextFloat(-8.0f, 8.0f)}, Quat::FromAxisAngle(Axis, Random.NextFloat(-3.0f, 3.0f)), Scale));
+        }
+
+        MeshletCuller Serial;
+        MeshletCuller Jobbed;
+        const size_t RangeCount = Serial.Cull(Meshlets, Worlds.data(), Worlds.size(), ViewProjection, Eye);
+        REQUIRE(Jobbed.Cull(Meshlets, Worlds.data(), Worlds.size(), ViewProjection, Eye, nullptr, &Jobs) == RangeCount);
+        bool Same = true;
+        bool Ordered = true;
+        for (size_t i = 0; i < RangeCount; i++)
+        {
+            const MeshletCuller::DrawRange& a = Serial.GetRanges()[i];
+            const MeshletCuller::DrawRange& b = Jobbed.GetRanges()[i];
+            Same = Same && a.Instance == b.Instance && a.FirstIndex == b.FirstIndex && a.IndexCount == b.IndexCount;
+            // Ranges that touch would have been joined
+            if (i > 0u)
+            {
+                const MeshletCuller::DrawRange& p = Serial.GetRanges()[i - 1u];
+                Ordered = Ordered && (p.Instance < a.Instance || (p.Instance == a.Instance && p.FirstIndex + p.IndexCount < a.FirstIndex));
+            }
+        }
+        CHECK(Same);
+        CHECK(Ordered);
+
+        // Every triangle of a dropped meshlet faces away or lies outside one frustum plane
+        const std::vector<std::vector<uint8_t>> Kept = GetKept(Serial, RangeCount, Worlds.size(), IndexCount);
+        size_t Wrong = 0u;
+        size_t Split = 0u;
+        uint64_t Triangles = 0u;
+        for (size_t w = 0; w < Worlds.size(); w++)
+        {
+            for (size_t m = 0; m < MeshletCount; m++)
+            {
+                const uint32_t Begin = Meshlets.FirstIndex[m];
+                const uint32_t End = Meshlets.FirstIndex[m + 1u];
+                const bool IsKept = Kept[w][Begin] != 0u;
+                Split += std::any_of(Kept[w].begin() + Begin, Kept[w].begin() + End, [&](uint8_t k) { return (k != 0u) != IsKept; }) ? 1u : 0u;
+                if (IsKept)
+                {
+                    Triangles += (End - Begin) / 3u;
+                    continue;
+                }
+                for (uint32_t i = Begin; i < End; i += 3u)
+                {
+                    Vec3 p[3];
+                    Vec4 Clip[3];
+                    for (uint32_t k = 0; k < 3u; k++)
+                    {
+                        p[k] = TransformPoint(Torus.Positions[Meshlets.Indices[i + k]], Worlds[w]);
+                        Clip[k] = Transform({p[k].X, p[k].Y, p[k].Z, 1.0f}, ViewProjection);
+                    }
+                    const Vec3 n = Cross(p[1] - p[0], p[2] - p[0]);
+                    const bool Back = Dot(p[0] - Eye, n) >= -1e-4f * Length(n) * Length(p[0] - Eye);
+                    if (!Back && !IsOutside(Clip))
+                    {
+                        Wrong++;
+                        break;
+                    }
+                }
+            }
+        }
+        const MeshletCuller::Counts& Counts = Serial.GetCounts();
+        CHECK(Wrong == 0u);
+        CHECK(Split == 0u);
+        CHECK(Counts.Meshlets == MeshletCount * Worlds.size());
+        CHECK(Counts.Triangles == Triangles);
+        CHECK(Counts.Unoccluded == Counts.FrontFacing);
+        // Some meshlets are kept and the cones do drop some in view
+        CHECK(Triangles > 0u);
+        CHECK(Counts.FrontFacing < Counts.InFrustum);
+
+        // A wall halfway to the meshes only hides meshlets whose boxes it covers, the sphere
+        // test lets through some whose boxes are off screen
+        OcclusionBuffer Occlusion(256u, 144u);
+        Occlusion.Begin(ViewProjection);
+        const Vec3 WallCorners[] = {{-1.0f, -1.0f, 0.0f}, {1.0f, -1.0f, 0.0f}, {1.0f, 1.0f, 0.0f}, {-1.0f, 1.0f, 0.0f}};
+        const uint32_t WallIndices[] = {0u, 2u, 1u, 0u, 3u, 2u};
+        Occlusion.AddOccluder(WallCorners, WallIndices, 6u, Multiply(Mat4::Scaling(4.0f, 4.0f, 1.0f), Mat4::Translation(Eye.X * 0.5f, Eye.Y * 0.5f, Eye.Z * 0.5f)));
+        Occlusion.Rasterize();
+        MeshletCuller Occluded;
+        const std::vector<std::vector<uint8_t>> Unhidden = GetKept(Occluded, Occluded.Cull(Meshlets, Worlds.data(), Worlds.size(), ViewProjection, Eye, &Occlusion, &Jobs), Worlds.size(), IndexCount);
+        size_t Hidden = 0u;
+        size_t Revived = 0u;
+        size_t WronglyHidden = 0u;
+        for (size_t w = 0; w < Worlds.size(); w++)
+        {
+            for (size_t m = 0; m < MeshletCount; m++)
+            {
+                const uint32_t Begin = Meshlets.FirstIndex[m];
+                Revived += Unhidden[w][Begin] != 0u && Kept[w][Begin] == 0u ? 1u : 0u;
+                if (Unhidden[w][Begin] != 0u || Kept[w][Begin] == 0u)
+                {
+                    continue;
+                }
+                Hidden++;
+                Vec3 Low = TransformPoint(Torus.Positions[Meshlets.Indices[Begin]], Worlds[w]);
+                Vec3 High = Low;
+                for (uint32_t i = Begin; i < Meshlets.FirstIndex[m + 1u]; i++)
+                {
+                    const Vec3 p = TransformPoint(Torus.Positions[Meshlets.Indices[i]], Worlds[w]);
+                    Low = Min(Low, p);
+                    High = Max(High, p);
+                }
+                WronglyHidden += IsHidden(Occlusion, ViewProjection, Low, High) ? 0u : 1u;
+            }
+        }
+        CHECK(Revived == 0u);
+        CHECK(WronglyHidden == 0u);
+        CHECK(Occluded.GetCounts().FrontFacing == Counts.FrontFacing);
+        CHECK(Occluded.GetCounts().Unoccluded == Counts.Unoccluded - Hidden);
+        TotalHidden += Hidden;
+    }
+    CHECK(TotalHidden > 0u);
+
+    MeshletCuller Empty;
+    CHECK(Empty.Cull(Meshlets, nullptr, 0u, Mat4::Identity(), {}) == 0u);
+}
\ No newline at end of file
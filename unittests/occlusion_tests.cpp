@@ -0,0 +1,215 @@
+#include "test_harness.h"
+#include "occlusion.h"
+#include "job_system.h"
+#include "scene_random.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+    constexpr Vec3 QuadPositions[] = {{-1.0f, -1.0f, 0.0f}, {1.0f, -1.0f, 0.0f}, {1.0f, 1.0f, 0.0f}, {-1.0f, 1.0f, 0.0f}};
+    constexpr uint32_t QuadIndices[] = {0u, 1u, 2u, 0u, 2u, 3u};
+    const Vec3 Eye = {0.0f, 0.0f, -10.0f};
+
+    // Whether the segment from the eye to p passes through triangle abc before p
+    bool IsBlocked(const Vec3& p, const Vec3& a, const Vec3& b, const Vec3& c)
+    {
+        const Vec3 d = p - Eye;
+        const Vec3 e1 = b - a;
+        const Vec3 e2 = c - a;
+        const Vec3 h = Cross(d, e2);
+        const float Det = Dot(e1, h);
+        if (std::fabs(Det) < 1e-9f)
+        {
+            return false;
+        }
+        const Vec3 s = Eye - a;
+        const float u = Dot(s, h) / Det;
+        const Vec3 q = Cross(s, e1);
+        const float v = Dot(d, q) / Det;
+        const float t = Dot(e2, q) / Det;
+        return u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t > 0.0f && t < 1.0f;
+    }
+
+    struct Scene
+    {
+        Mat4 ViewProjection;
+        std::vector<Mat4> Worlds;
+        // Every occluder triangle in world space
+        std::vector<Vec3> Corners;
+        std::vector<float> X;
+        std::vector<float> Y;
+        std::vector<float> Z;
+        std::vector<float> EX;
+        std::vector<float> EY;
+        std::vector<float> EZ;
+
+        explicit Scene(size_t BoxCount)
+        {
+            ViewProjection = Multiply(Mat4::LookAt(Eye, {0.0f, 0.0f, 10.0f}, {0.0f, 1.0f, 0.0f}), Mat4::Perspective(1.0f, 4.0f / 3.0f, 0.5f, 300.0f));
+            SceneRandom Random(7u);
+            for (int i = 0; i < 40; i++)
+            {
+                const Vec3 Axis = Normalize(Vec3{Random.NextFloat(-0.5f, 0.5f), Random.NextFloat(-0.5f, 0.5f), Random.NextFloat(-0.5f, 0.5f)});
+                const Vec3 Position = {Random.NextFloat(-20.0f, 20.0f), Random.NextFloat(-15.0f, 15.0f), Random.NextFloat(5.0f, 25.0f)};
+                const Vec3 Scale = {Random.NextFloat(1.0f, 5.0f), Random.NextFloat(1.0f, 5.0f), 1.0f};
+                Worlds.push_back(Mat4::Compose(Position, Quat::FromAxisAngle(Axis, Random.NextFloat(-0.6f, 0.6f)), Scale));
+            }
+            // A quad through the camera plane must not occlude anything
+            Worlds.push_back(Mat4::Compose(Eye, Quat::FromAxisAngle({0.0f, 1.0f, 0.0f}, 1.5f), {3.0f, 3.0f, 1.0f}));
+            for (const Mat4& World : Worlds)
+            {
+                for (const uint32_t i : QuadIndices)
+                {
+                    const Vec4 p = Transform({QuadPositions[i].X, QuadPositions[i].Y, QuadPositions[i].Z, 1.0f}, World);
+                    Corners.push_back({p.X, p.Y, p.Z});
+                }
+            }
+
+            X.resize(BoxCount);
+            Y.resize(BoxCount);
+            Z.resize(BoxCount);
+            EX.resize(BoxCount);
+            EY.resize(BoxCount);
+            EZ.resize(BoxCount);
+            for (size_t i = 0; i < BoxCount; i++)
+            {
+                Z[i] = Random.NextFloat(-12.0f, 190.0f);
+                const float Spread = (Z[i] + 10.0f) * 0.6f;
+                X[i] = Random.NextFloat(-Spread, Spread);
+                Y[i] = Random.NextFloat(-0.75f * Spread, 0.75f * Spread);
+                EX[i] = Random.NextFloat(0.05f, 0.55f);
+                EY[i] = Random.NextFloat(0.05f, 0.55f);
+                EZ[i] = Random.NextFloat(0.05f, 0.55f);
+            }
+        }
+        BoxStreams Boxes() const noexcept
+        {
+            return {X.data(), Y.data(), Z.data(), EX.data(), EY.data(), EZ.data()};
+        }
+        void Rasterize(OcclusionBuffer& Buffer, JobSystem* Jobs) const
+        {
+            Buffer.Begin(ViewProjection);
+            for (const Mat4& World : Worlds)
+            {
+                Buffer.AddOccluder(QuadPositions, QuadIndices, std::size(QuadIndices), World);
+            }
+            Buffer.Rasterize(Jobs);
+        }
+        // A point off screen cannot be seen, one on screen must be behind some occluder
+        bool IsHidden(const Vec3& p) const
+        {
+            const Vec4 Clip = Transform({p.X, p.Y, p.Z, 1.0f}, ViewProjection);
+            if (!(Clip.W > 0.0f && std::fabs(Clip.X) <= Clip.W && std::fabs(Clip.Y) <= Clip.W))
+            {
+                return true;
+            }
+            for (size_t t = 0; t + 2u < Corners.size(); t += 3u)
+            {
+                if (IsBlocked(p, Corners[t], Corners[t + 1u], Corners[t + 2u]))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+}
+
+TEST(occlusion, culled_boxes_are_hidden_by_occluders)
+{
+    constexpr size_t Count = 20000u;
+    const Scene Test(Count);
+    OcclusionBuffer Buffer(256u, 192u);
+    Test.Rasterize(Buffer, nullptr);
+    std::vector<uint32_t> Candidates(Count);
+    for (uint32_t i = 0; i < Count; i++)
+    {
+        Candidates[i] = i;
+    }
+    std::vector<uint32_t> Visible(Count);
+    const size_t VisibleCount = Buffer.CullBoxes(Test.Boxes(), Candidates.data(), Count, Visible.data());
+
+    // Corners and random points of every culled box must be hidden from the eye
+    SceneRandom Random(3u);
+    size_t Culled = 0u;
+    size_t Wrong = 0u;
+    size_t Next = 0u;
+    for (uint32_t i = 0; i < Count; i++)
+    {
+        if (Next < VisibleCount && Visible[Next] == i)
+        {
+            Next++;
+            continue;
+        }
+        Culled++;
+        bool Hidden = true;
+        for (uint32_t s = 0; s < 32u && Hidden; s++)
+        {
+            const Vec3 Offset = s < 8u
+                ? Vec3{(s & 1u) ? 1.0f : -1.0f, (s & 2u) ? 1.0f : -1.0f, (s & 4u) ? 1.0f : -1.0f}
+                : Vec3{Random.NextFloat(-1.0f, 1.0f), Random.NextFloat(-1.0f, 1.0f), Random.NextFloat(-1.0f, 1.0f)};
+            Hidden = Test.IsHidden({Test.X[i] + Test.EX[i] * Offset.X, Test.Y[i] + Test.EY[i] * Offset.Y, Test.Z[i] + Test.EZ[i] * Offset.Z});
+        }
+        Wrong += Hidden ? 0u : 1u;
+    }
+    CHECK(Next == VisibleCount);
+    CHECK(Wrong == 0u);
+    // The walls do hide a good part of the boxes, so the check above is not vacuous
+    CHECK(Culled > Count / 20u);
+}
+
+TEST(occlusion, jobs_and_single_box_tests_agree)
+{
+    constexpr size_t Count = 3u * OcclusionBuffer::Grain + 100u;
+    const Scene Test(Count);
+    JobSystem Jobs(3u);
+    OcclusionBuffer Serial(256u, 192u);
+    OcclusionBuffer Banded(256u, 192u);
+    Test.Rasterize(Serial, nullptr);
+    Test.Rasterize(Banded, &Jobs);
+    CHECK(std::equal(Serial.GetDepth(), Serial.GetDepth() + 256u * 192u, Banded.GetDepth()));
+
+    // Every other box as candidates, culled serially, over jobs and in place
+    std::vector<uint32_t> Candidates;
+    for (uint32_t i = 0; i < Count; i += 2u)
+    {
+        Candidates.push_back(i);
+    }
+    std::vector<uint32_t> First(Candidates.size());
+    std::vector<uint32_t> Second(Candidates.size());
+    std::vector<uint32_t> InPlace = Candidates;
+    const size_t n1 = Serial.CullBoxes(Test.Boxes(), Candidates.data(), Candidates.size(), First.data());
+    const size_t n2 = Serial.CullBoxes(Test.Boxes(), Candidates.data(), Candidates.size(), Second.data(), &Jobs);
+    const size_t n3 = Serial.CullBoxes(Test.Boxes(), InPlace.data(), InPlace.size(), InPlace.data(), &Jobs);
+    REQUIRE(n1 == n2 && n2 == n3);
+    CHECK(std::equal(First.begin(), First.begin() + n1, Second.begin()));
+    CHECK(std::equal(First.begin(), First.begin() + n1, InPlace.begin()));
+
+    size_t Next = 0u;
+    size_t Mismatches = 0u;
+    for (const uint32_t i : Candidates)
+    {
+        const bool Kept = Next < n1 && First[Next] == i;
+        Next += Kept ? 1u : 0u;
+        const Vec3 Min = {Test.X[i] - Test.EX[i], Test.Y[i] - Test.EY[i], Test.Z[i] - Test.EZ[i]};
+        const Vec3 Max = {Test.X[i] + Test.EX[i], Test.Y[i] + Test.EY[i], Test.Z[i] + Test.EZ[i]};
+        Mismatches += Kept == Serial.IsOccluded(Min, Max) ? 1u : 0u;
+    }
+    CHECK(Mismatches == 0u);
+}
+
+TEST(occlusion, boxes_across_the_camera_plane_stay_visible)
+{
+    // A wall right in front of the eye hides a box behind it, but not one around the eye.
+    // The box stays clear of the wall's diagonal, whose pixels neither triangle covers.
+    OcclusionBuffer Buffer(64u, 64u);
+    Buffer.Begin(Multiply(Mat4::LookAt(Eye, {0.0f, 0.0f, 10.0f}, {0.0f, 1.0f, 0.0f}), Mat4::Perspective(1.0f, 1.0f, 0.5f, 300.0f)));
+    Buffer.AddOccluder(QuadPositions, QuadIndices, std::size(QuadIndices), Mat4::Compose({0.0f, 0.0f, -5.0f}, Quat::Identity(), {20.0f, 20.0f, 1.0f}));
+    Buffer.Rasterize();
+    CHECK(Buffer.IsOccluded({2.0f, -4.0f, 10.0f}, {4.0f, -2.0f, 12.0f}));
+    CHECK(!Buffer.IsOccluded({-1.0f, -1.0f, -11.0f}, {1.0f, 1.0f, 12.0f}));
+    CHECK(!Buffer.IsOccluded({-1.0f, -1.0f, -7.0f}, {1.0f, 1.0f, -6.0f}));
+}
\ No newline at end of file
@@ -0,0 +1,250 @@
+#include "test_harness.h"
+#include "picking.h"
+#include "job_system.h"
+#include "scene_random.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace
+{
+    struct TriangleMesh
+    {
+        std::vector<Vec3> Positions;
+        std::vector<uint32_t> Indices;
+    };
+
+    // Loose triangles in a 10 unit cube
+    TriangleMesh MakeSoup(SceneRandom& Random, size_t TriangleCount)
+    {
+        TriangleMesh Mesh;
+        for (size_t t = 0; t < TriangleCount; t++)
+        {
+            const Vec3 c = {Random.NextFloat(-5.0f, 5.0f), Random.NextFloat(-5.0f, 5.0f), Random.NextFloat(-5.0f, 5.0f)};
+            for (int k = 0; k < 3; k++)
+            {
+                Mesh.Indices.push_back(static_cast<uint32_t>(Mesh.Positions.size()));
+                Mesh.Positions.push_back({c.X + Random.NextFloat(-0.5f, 0.5f), c.Y + Random.NextFloat(-0.5f, 0.5f), c.Z + Random.NextFloat(-0.5f, 0.5f)});
+            }
+        }
+        return Mesh;
+    }
+
+    // Wavy height field of Size x Size quads over [-2, 2] in x and z
+    TriangleMesh MakeGrid(uint32_t Size)
+    {
+        TriangleMesh Mesh;
+        for (uint32_t y = 0; y <= Size; y++)
+        {
+            for (uint32_t x = 0; x <= Size; x++)
+            {
+                const float u = static_cast<float>(x);
+                const float v = static_cast<float>(y);
+                Mesh.Positions.push_back({u / static_cast<float>(Size) * 4.0f - 2.0f, std::sin(u * 0.3f) * std::cos(v * 0.2f) * 0.3f, v / static_cast<float>(Size) * 4.0f - 2.0f});
+            }
+        }
+        for (uint32_t y = 0; y < Size; y++)
+        {
+            for (uint32_t x = 0; x < Size; x++)
+            {
+                const uint32_t a = y * (Size + 1u) + x;
+                const uint32_t c = a + Size + 1u;
+                Mesh.Indices.insert(Mesh.Indices.end(), {a, c, a + 1u, a + 1u, c, c + 1u});
+            }
+        }
+        return Mesh;
+    }
+
+    // Moller-Trumbore in double on the world space triangle
+    bool Intersect(const Ray& r, const Vec3& a, const Vec3& b, const Vec3& c, double& Distance)
+    {
+        const double e1[3] = {static_cast<double>(b.X) - a.X, static_cast<double>(b.Y) - a.Y, static_cast<double>(b.Z) - a.Z};
+        const double e2[3] = {static_cast<double>(c.X) - a.X, static_cast<double>(c.Y) - a.Y, static_cast<double>(c.Z) - a.Z};
+        const double d[3] = {r.Direction.X, r.Direction.Y, r.Direction.Z};
+        const double p[3] = {d[1] * e2[2] - d[2] * e2[1], d[2] * e2[0] - d[0] * e2[2], d[0] * e2[1] - d[1] * e2[0]};
+        const double Det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+        if (std::fabs(Det) < 1e-20)
+        {
+            return false;
+        }
+        const double s[3] = {static_cast<double>(r.Origin.X) - a.X, static_cast<double>(r.Origin.Y) - a.Y, static_cast<double>(r.Origin.Z) - a.Z};
+        const double u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) / Det;
+        const double q[3] = {s[1] * e1[2] - s[2] * e1[1], s[2] * e1[0] - s[0] * e1[2], s[0] * e1[1] - s[1] * e1[0]};
+        const double v = (d[0] * q[0] + d[1] * q[1] + d[2] * q[2]) / Det;
+        Distance = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) / Det;
+        return u >= 0.0 && v >= 0.0 && u + v <= 1.0 && Distance >= 0.0;
+    }
+
+    // Meshes of every kind, including an empty one, placed at random
+    struct Scene
+    {
+        std::vector<TriangleMesh> Meshes;
+        std::vector<uint32_t> MeshOf;
+        std::vector<Mat4> World;
+        Picker Picks;
+        SceneRandom Random;
+
+        Scene(size_t ObjectCount, JobSystem& Jobs)
+            : Random(ObjectCount)
+        {
+            Meshes = {MakeSoup(Random, 1u), MakeSoup(Random, 3u), MakeSoup(Random, 2000u), MakeGrid(60u), TriangleMesh()};
+            for (const TriangleMesh& Mesh : Meshes)
+            {
+                Picks.AddMesh(Mesh.Positions.data(), Mesh.Indices.data(), Mesh.Indices.size() / 3u, &Jobs);
+            }
+            for (size_t i = 0; i < ObjectCount; i++)
+            {
+                const Vec3 Axis = Normalize(Vec3{Random.NextFloat(-0.5f, 0.5f), Random.NextFloat(-0.5f, 0.5f), Random.NextFloat(-0.5f, 0.5f)});
+                MeshOf.push_back(static_cast<uint32_t>(i % Meshes.size()));
+                World.push_back(Mat4::Compose({Random.NextFloat(-20.0f, 20.0f), Random.NextFloat(-20.0f, 20.0f), Random.NextFloat(-20.0f, 20.0f)},
+                    Quat::FromAxisAngle(Axis, Random.NextFloat(0.0f, 6.0f)), {Random.NextFloat(0.5f, 2.5f), Random.NextFloat(0.5f, 1.5f), Random.NextFloat(0.5f, 1.5f)}));
+            }
+            Picks.SetObjects(MeshOf.data(), World.data(), ObjectCount, &Jobs);
+        }
+        Ray NextRay()
+        {
+            const Vec3 Origin = {Random.NextFloat(-30.0f, 30.0f), Random.NextFloat(-30.0f, 30.0f), Random.NextFloat(-30.0f, 30.0f)};
+            const Vec3 Target = {Random.NextFloat(-20.0f, 20.0f), Random.NextFloat(-20.0f, 20.0f), Random.NextFloat(-20.0f, 20.0f)};
+            return {Origin, Normalize(Target - Origin)};
+        }
+        // Nearest hit over every triangle of every object, Object stays ~0u on a miss
+        Picker::Hit BruteForce(const Ray& r) const
+        {
+            Picker::Hit Nearest = {~0u, ~0u, 0.0f};
+            double NearestDistance = std::numeric_limits<double>::infinity();
+            for (uint32_t o = 0; o < MeshOf.size(); o++)
+            {
+                const TriangleMesh& Mesh = Meshes[MeshOf[o]];
+                for (uint32_t t = 0; t < Mesh.Indices.size() / 3u; t++)
+                {
+                    double Distance = 0.0;
+                    const Vec3 a = TransformPoint(Mesh.Positions[Mesh.Indices[3u * t]], World[o]);
+                    const Vec3 b = TransformPoint(Mesh.Positions[Mesh.Indices[3u * t + 1u]], World[o]);
+                    const Vec3 c = TransformPoint(Mesh.Positions[Mesh.Indices[3u * t + 2u]], World[o]);
+                    if (Intersect(r, a, b, c, Distance) && Distance < NearestDistance)
+                    {
+                        NearestDistance = Distance;
+                        Nearest = {o, t, static_cast<float>(Distance)};
+                    }
+                }
+            }
+            return Nearest;
+        }
+        size_t CountWrongPicks(size_t RayCount, size_t& Hits)
+        {
+            size_t Wrong = 0u;
+            for (size_t i = 0; i < RayCount; i++)
+            {
+                const Ray r = NextRay();
+                const Picker::Hit Expected = BruteForce(r);
+                const Picker::Result Picked = Picks.Pick(r);
+                if (Expected.Object == ~0u)
+                {
+                    Wrong += Picked.State == Picker::Status::Miss ? 0u : 1u;
+                    continue;
+                }
+                Hits++;
+                Wrong += Picked.State == Picker::Status::Hit && std::fabs(Picked.Nearest.Distance - Expected.Distance) <= 1e-3f * std::max(1.0f, Expected.Distance) ? 0u : 1u;
+            }
+            return Wrong;
+        }
+    };
+
+    bool SameHit(const Picker::Result& a, const Picker::Result& b)
+    {
+        return a.State == b.State && (a.State != Picker::Status::Hit ||
+            (a.Nearest.Object == b.Nearest.Object && a.Nearest.Triangle == b.Nearest.Triangle && a.Nearest.Distance == b.Nearest.Distance));
+    }
+}
+
+TEST(picking, nearest_hit_matches_brute_force)
+{
+    JobSystem Jobs(3u);
+    Scene Test(50u, Jobs);
+    size_t Hits = 0u;
+    CHECK(Test.CountWrongPicks(300u, Hits) == 0u);
+
+    // Moving a third of the objects refits the object tree
+    std::vector<uint32_t> Moved;
+    std::vector<Mat4> World;
+    for (uint32_t i = 0; i < Test.World.size(); i += 3u)
+    {
+        Test.World[i] = Multiply(Test.World[i], Mat4::Translation(Test.Random.NextFloat(0.0f, 5.0f), 0.0f, Test.Random.NextFloat(0.0f, 5.0f)));
+        Moved.push_back(i);
+        World.push_back(Test.World[i]);
+    }
+    Test.Picks.MoveObjects(Moved.data(), World.data(), Moved.size());
+    CHECK(Test.CountWrongPicks(300u, Hits) == 0u);
+    // Enough rays hit something for the distances to be checked
+    CHECK(Hits > 100u);
+}
+
+TEST(picking, budgeted_picks_resume_to_the_same_hit)
+{
+    JobSystem Jobs(3u);
+    Scene Test(200u, Jobs);
+    Picker Reference;
+    for (const TriangleMesh& Mesh : Test.Meshes)
+    {
+        Reference.AddMesh(Mesh.Positions.data(), Mesh.Indices.data(), Mesh.Indices.size() / 3u);
+    }
+    Reference.SetObjects(Test.MeshOf.data(), Test.World.data(), Test.MeshOf.size());
+
+    size_t Resumed = 0u;
+    for (int i = 0; i < 100; i++)
+    {
+        const Ray r = Test.NextRay();
+        const Picker::Result Expected = Reference.Pick(r);
+
+        // Without time every pick stops at the first clock read, so it takes several
+        Picker::Result Picked = {};
+        size_t Rounds = 0u;
+        do
+        {
+            Picked = Test.Picks.Pick(r, 0.0);
+            Rounds++;
+        } while (Picked.State == Picker::Status::Pending && Rounds < 100000u);
+        CHECK(SameHit(Picked, Expected));
+        Resumed += Rounds > 1u ? 1u : 0u;
+        // A finished pick of the same ray is answered without walking
+        CHECK(SameHit(Test.Picks.Pick(r, 0.0), Expected));
+
+        // Another ray stopped halfway is dropped for the first, which starts over
+        const Ray Other = Test.NextRay();
+        Test.Picks.Pick(Other, 0.0);
+        CHECK(SameHit(Test.Picks.Pick(r), Expected));
+        CHECK(SameHit(Test.Picks.Pick(Other), Reference.Pick(Other)));
+    }
+    CHECK(Resumed > 10u);
+
+    // Moving objects drops a pick in progress
+    const Ray r = Test.NextRay();
+    Test.Picks.Pick(r, 0.0);
+    std::vector<uint32_t> Moved(Test.MeshOf.size());
+    for (uint32_t i = 0; i < Moved.size(); i++)
+    {
+        Moved[i] = i;
+        Test.World[i] = Multiply(Test.World[i], Mat4::Translation(1.0f, 2.0f, 3.0f));
+    }
+    Test.Picks.MoveObjects(Moved.data(), Test.World.data(), Moved.size());
+    Reference.SetObjects(Test.MeshOf.data(), Test.World.data(), Test.MeshOf.size());
+    CHECK(SameHit(Test.Picks.Pick(r), Reference.Pick(r)));
+}
+
+TEST(picking, screen_ray_passes_through_the_projected_point)
+{
+    const Mat4 ViewProjection = Multiply(Mat4::LookAt({1.0f, 2.0f, -10.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}), Mat4::Perspective(1.0f, 1.5f, 0.5f, 100.0f));
+    const Vec3 Points[] = {{3.0f, 1.0f, 2.0f}, {0.0f, 0.0f, 0.0f}, {-4.0f, -2.0f, 20.0f}};
+    for (const Vec3& p : Points)
+    {
+        const Vec4 Clip = Transform({p.X, p.Y, p.Z, 1.0f}, ViewProjection);
+        const float X = (Clip.X / Clip.W + 1.0f) * 0.5f * 300.0f;
+        const float Y = (1.0f - Clip.Y / Clip.W) * 0.5f * 200.0f;
+        const Ray r = Picker::ScreenRay(X, Y, 300u, 200u, ViewProjection);
+        CHECK(std::fabs(Length(r.Direction) - 1.0f) < 1e-5f);
+        CHECK(Length(Cross(Normalize(p - r.Origin), r.Direction)) < 1e-4f);
+        CHECK(Dot(p - r.Origin, r.Direction) > 0.0f);
+    }
+}
\ No newline at end of file
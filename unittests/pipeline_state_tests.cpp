@@ -0,0 +1,91 @@
+#include "test_harness.h"
+#include "pipeline_state.h"
+#include <cstdint>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace
+{
+    PipelineStateDesc MakeDesc(uint32_t Seed)
+    {
+        PipelineStateDesc Desc;
+        Desc.VertexShader = VertexShaderHandle::Make(Seed % 7u + 1u, 1u);
+        Desc.PixelShader = PixelShaderHandle::Make(Seed / 7u % 11u + 1u, 1u);
+        Desc.InputLayout = InputLayoutHandle::Make(Seed / 77u + 1u, 2u);
+        Desc.Blend = static_cast<BlendMode>(Seed % static_cast<uint32_t>(BlendMode::Count));
+        Desc.Depth = static_cast<DepthMode>(Seed / 3u % static_cast<uint32_t>(DepthMode::Count));
+        return Desc;
+    }
+}
+
+TEST(pipeline_state, every_field_changes_the_hash)
+{
+    // Seed 9 has opaque blending and no depth, every variant below differs from it
+    const PipelineStateDesc Base = MakeDesc(9u);
+    std::vector<PipelineStateDesc> Variants(9u, Base);
+    Variants[0].VertexShader = VertexShaderHandle::Make(Base.VertexShader.GetIndex(), 2u);
+    Variants[1].PixelShader = {};
+    Variants[2].InputLayout = InputLayoutHandle::Make(99u, 1u);
+    Variants[3].PrimitiveTopology = Topology::LineList;
+    Variants[4].Blend = BlendMode::Additive;
+    Variants[5].Cull = CullMode::None;
+    Variants[6].Fill = FillMode::Wireframe;
+    Variants[7].Depth = DepthMode::TestWrite;
+    Variants[8].Sampler = SamplerMode::Point;
+    CHECK(HashPipelineState(Base) == HashPipelineState(MakeDesc(9u)));
+    for (const PipelineStateDesc& Variant : Variants)
+    {
+        CHECK(!(Variant == Base));
+        CHECK(HashPipelineState(Variant) != HashPipelineState(Base));
+    }
+}
+
+TEST(pipeline_state, cache_deduplicates_across_growth)
+{
+    PipelineStateCache Cache(8u);
+    for (uint32_t i = 0; i < 500u; i++)
+    {
+        const PipelineStateDesc Desc = MakeDesc(i);
+        REQUIRE(Cache.Find(Desc, HashPipelineState(Desc)) == PipelineStateCache::InvalidIndex);
+        Cache.Insert(Desc, HashPipelineState(Desc), i);
+    }
+    CHECK(Cache.GetSize() == 500u);
+    for (uint32_t i = 0; i < 500u; i++)
+    {
+        const PipelineStateDesc Desc = MakeDesc(i);
+        CHECK(Cache.Find(Desc, HashPipelineState(Desc)) == i);
+    }
+}
+
+TEST(pipeline_state, remove_keeps_probe_runs_intact)
+{
+    // Hashes with only 4 distinct values pile every entry into long probe runs that
+    // wrap around the table, so removal has to shift the right entries back
+    PipelineStateCache Cache(64u);
+    std::map<uint32_t, uint32_t> Expected;
+    std::mt19937 Random(30u);
+    const auto Hash = [](uint32_t Seed) { return HashPipelineState(MakeDesc(Seed)) % 4u * 16u + 60u; };
+    for (int Step = 0; Step < 5000; Step++)
+    {
+        const uint32_t Seed = Random() % 40u;
+        const PipelineStateDesc Desc = MakeDesc(Seed);
+        if (Expected.contains(Seed))
+        {
+            CHECK(Cache.Remove(Desc, Hash(Seed)) == Expected[Seed]);
+            Expected.erase(Seed);
+            CHECK(Cache.Remove(Desc, Hash(Seed)) == PipelineStateCache::InvalidIndex);
+        }
+        else
+        {
+            Cache.Insert(Desc, Hash(Seed), static_cast<uint32_t>(Step));
+            Expected[Seed] = static_cast<uint32_t>(Step);
+        }
+        REQUIRE(Cache.GetSize() == Expected.size());
+        for (uint32_t s = 0; s < 40u; s++)
+        {
+            const uint32_t Found = Cache.Find(MakeDesc(s), Hash(s));
+            REQUIRE(Found == (Expected.contains(s) ? Expected[s] : PipelineStateCache::InvalidIndex));
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include "test_harness.h"
+#include "regression_gate.h"
+#include "quantile_test.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Frame times in ms around a median of Median. Box-Muller on mt19937, whose output is
+    // fixed by the standard, so every library draws the same frames.
+    std::vector<double> LogNormalFrames(std::mt19937& Random, size_t Count, double Median, double Sigma)
+    {
+        constexpr double TwoPi = 6.283185307179586;
+        std::vector<double> Frames;
+        while (Frames.size() < Count)
+        {
+            const double u1 = (static_cast<double>(Random()) + 1.0) / 4294967296.0;
+            const double u2 = static_cast<double>(Random()) / 4294967296.0;
+            const double Normal = std::sqrt(-2.0 * std::log(u1)) * std::cos(TwoPi * u2);
+            Frames.push_back(Median * std::exp(Sigma * Normal));
+        }
+        return Frames;
+    }
+
+    JsonValue MakeReport(const std::vector<double>& Frames, int Version = 2)
+    {
+        std::ostringstream Json;
+        Json.precision(17);
+        Json << "{\"version\": " << Version << ", \"settings\": {}, \"runs\": [{\"scene\": \"frames\", "
+            << "\"allocations\": {\"tracking\": false}, \"counters\": {}, \"samples\": {\"frame_time_ms\": [";
+        for (size_t i = 0; i < Frames.size(); i++)
+        {
+            Json << (i > 0u ? ", " : "") << Frames[i];
+        }
+        Json << "]}}]}";
+        return JsonValue::Parse(Json.str());
+    }
+
+    const RegressionGate::Finding* FindMetric(const RegressionGate& Gate, const std::string& Metric)
+    {
+        for (const RegressionGate::Finding& f : Gate.GetFindings())
+        {
+            if (f.Metric == Metric)
+            {
+                return &f;
+            }
+        }
+        return nullptr;
+    }
+}
+
+TEST(regression_gate, identical_lognormal_runs_do_not_alarm)
+{
+    // Runs of 500 frames from one distribution. Their p99 alone moves past the 10%
+    // threshold in several pairs, the gate must not call any of them a regression. The
+    // median has a test of its own at the same alpha and is not checked here.
+    std::mt19937 Random(2024u);
+    size_t PastThreshold = 0u;
+    for (int Pair = 0; Pair < 50; Pair++)
+    {
+        const std::vector<double> Baseline = LogNormalFrames(Random, 500u, 16.0, 0.4);
+        const std::vector<double> Current = LogNormalFrames(Random, 500u, 16.0, 0.4);
+        RegressionGate Gate(RegressionGate::Settings{});
+        Gate.Compare(MakeReport(Baseline), MakeReport(Current));
+
+        const RegressionGate::Finding* Tail = FindMetric(Gate, "frame_time_p99");
+        REQUIRE(Tail != nullptr);
+        CHECK(Tail->Result != RegressionGate::Verdict::Regressed);
+        PastThreshold += Tail->ChangePercent > 10.0 ? 1u : 0u;
+    }
+    CHECK(PastThreshold > 0u);
+}
+
+TEST(regression_gate, heavier_tail_regresses_p99_only)
+{
+    // Every 20th frame hitches to three times its time, the median stays where it was
+    std::mt19937 Random(7u);
+    const std::vector<double> Baseline = LogNormalFrames(Random, 500u, 16.0, 0.4);
+    std::vector<double> Current = LogNormalFrames(Random, 500u, 16.0, 0.4);
+    for (size_t i = 0; i < Current.size(); i += 20u)
+    {
+        Current[i] *= 3.0;
+    }
+    RegressionGate Gate(RegressionGate::Settings{});
+    Gate.Compare(MakeReport(Baseline), MakeReport(Current));
+
+    const RegressionGate::Finding* Tail = FindMetric(Gate, "frame_time_p99");
+    const RegressionGate::Finding* Median = FindMetric(Gate, "frame_time");
+    REQUIRE(Tail != nullptr);
+    REQUIRE(Median != nullptr);
+    CHECK(Tail->Result == RegressionGate::Verdict::Regressed);
+    CHECK(Tail->PValue >= 0.0 && Tail->PValue < 0.01);
+    CHECK(Median->Result == RegressionGate::Verdict::Unchanged);
+}
+
+TEST(regression_gate, quantile_test_is_exact_for_separated_tails)
+{
+    // All ten values above the pooled p99 come from the second sample
+    std::vector<double> First(500u, 1.0);
+    std::vector<double> Second(500u, 1.0);
+    for (size_t i = 0; i < 10u; i++)
+    {
+        Second[i] = 2.0;
+    }
+    const QuantileTestResult Test = QuantileTest(First, Second, 0.99);
+    CHECK(Test.FirstAbove == 0u);
+    CHECK(Test.SecondAbove == 10u);
+    // C(500, 10) / C(1000, 10)
+    double Expected = 1.0;
+    for (int i = 0; i < 10; i++)
+    {
+        Expected *= (500.0 - i) / (1000.0 - i);
+    }
+    CHECK(std::abs(Test.PGreater - Expected) < 1e-9 * Expected);
+    CHECK(Test.PLess == 1.0);
+}
+
+TEST(regression_gate, report_versions_are_checked)
+{
+    // Version 2 only added peaks, so it compares against a version 1 baseline
+    const std::vector<double> Frames(100u, 16.0);
+    RegressionGate Gate({});
+    Gate.Compare(MakeReport(Frames, 1), MakeReport(Frames, 2));
+    CHECK(std::none_of(Gate.GetWarnings().begin(), Gate.GetWarnings().end(), [](const std::string& w) { return w.find("version") != std::string::npos; }));
+    CHECK(!Gate.HasRegressions());
+
+    CHECK_THROWS(Gate.Compare(MakeReport(Frames, 2), MakeReport(Frames, 3)), std::runtime_error);
+    CHECK_THROWS(Gate.Compare(MakeReport(Frames, 0), MakeReport(Frames, 2)), std::runtime_error);
+    CHECK_THROWS(Gate.Compare(JsonValue::Parse("{\"settings\": {}, \"runs\": []}"), MakeReport(Frames, 2)), std::runtime_error);
+}
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include "test_harness.h"
+#include "ring_allocator.h"
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+TEST(ring_allocator, first_use_renames)
+{
+    RingAllocator Ring(1024u, 2u);
+    const auto First = Ring.Allocate(100u);
+    REQUIRE(First.has_value());
+    CHECK(First->Offset == 0u);
+    CHECK(First->Mode == RingAllocator::MapMode::Discard);
+    const auto Second = Ring.Allocate(100u);
+    REQUIRE(Second.has_value());
+    CHECK(Second->Mode == RingAllocator::MapMode::NoOverwrite);
+    CHECK(Ring.GetDiscardCount() == 0u);
+}
+
+TEST(ring_allocator, rejects_sizes_that_never_fit)
+{
+    RingAllocator Ring(1024u, 2u);
+    CHECK(!Ring.Allocate(0u).has_value());
+    CHECK(!Ring.Allocate(1025u).has_value());
+    CHECK(Ring.Allocate(1024u).has_value());
+}
+
+TEST(ring_allocator, aligns_to_vertex_strides)
+{
+    RingAllocator Ring(1024u, 2u);
+    Ring.Allocate(5u);
+    const auto Vertices = Ring.Allocate(24u, 12u);
+    REQUIRE(Vertices.has_value());
+    CHECK(Vertices->Offset == 12u);
+    const auto Indices = Ring.Allocate(6u, 4u);
+    REQUIRE(Indices.has_value());
+    CHECK(Indices->Offset == 36u);
+}
+
+TEST(ring_allocator, wraps_once_the_oldest_frame_retires)
+{
+    // Frames 0 and 1 fill [0, 800), once frame 0 retires its 400 bytes come back
+    RingAllocator Ring(1000u, 1u);
+    Ring.Allocate(400u);
+    Ring.EndFrame();
+    CHECK(Ring.Allocate(400u)->Offset == 400u);
+    Ring.EndFrame();
+    CHECK(Ring.GetInFlightBytes() == 400u);
+    const auto Wrapped = Ring.Allocate(300u);
+    REQUIRE(Wrapped.has_value());
+    CHECK(Wrapped->Offset == 0u);
+    CHECK(Wrapped->Mode == RingAllocator::MapMode::NoOverwrite);
+    CHECK(Ring.GetDiscardCount() == 0u);
+    // [300, 400) is free but the write position may not catch up with the tail
+    const auto Full = Ring.Allocate(100u);
+    REQUIRE(Full.has_value());
+    CHECK(Full->Mode == RingAllocator::MapMode::Discard);
+    CHECK(Full->Offset == 0u);
+    CHECK(Ring.GetDiscardCount() == 1u);
+    CHECK(Ring.GetInFlightBytes() == 100u);
+}
+
+TEST(ring_allocator, discards_when_frames_in_flight_fill_the_ring)
+{
+    RingAllocator Ring(1000u, 2u);
+    Ring.Allocate(400u);
+    Ring.EndFrame();
+    Ring.Allocate(400u);
+    Ring.EndFrame();
+    // Both frames are still in flight, so 400 more bytes cannot go anywhere
+    const auto Third = Ring.Allocate(400u);
+    REQUIRE(Third.has_value());
+    CHECK(Third->Mode == RingAllocator::MapMode::Discard);
+    CHECK(Ring.GetDiscardCount() == 1u);
+}
+
+TEST(ring_allocator, never_overwrites_frames_in_flight)
+{
+    // Every byte remembers the frame that wrote it last. A NoOverwrite allocation may only
+    // cover bytes of frames that FramesInFlight newer frames have ended since.
+    constexpr size_t Capacity = 4096u;
+    for (unsigned int FramesInFlight = 1u; FramesInFlight <= 3u; FramesInFlight++)
+    {
+        RingAllocator Ring(Capacity, FramesInFlight);
+        std::vector<int64_t> Writer(Capacity, -1);
+        std::mt19937 Random(FramesInFlight);
+        std::uniform_int_distribution<size_t> Sizes(1u, 64u);
+        std::uniform_int_distribution<size_t> Alignments(1u, 32u);
+        std::uniform_int_distribution<int> Allocations(0, 20);
+        unsigned int Discards = 0u;
+        for (int64_t Frame = 0; Frame < 2000; Frame++)
+        {
+            // Heavier frames now and then force renames
+            const int Count = Frame % 97 == 96 ? 200 : Allocations(Random);
+            for (int a = 0; a < Count; a++)
+            {
+                const size_t Size = Sizes(Random);
+                const size_t Alignment = Alignments(Random);
+                const auto Result = Ring.Allocate(Size, Alignment);
+                REQUIRE(Result.has_value());
+                REQUIRE(Result->Offset + Size <= Capacity);
+                if (Result->Mode == RingAllocator::MapMode::Discard)
+                {
+                    Discards++;
+                    CHECK(Result->Offset == 0u);
+                    std::fill(Writer.begin(), Writer.end(), -1);
+                }
+                else
+                {
+                    CHECK(Result->Offset % Alignment == 0u);
+                }
+                for (size_t i = Result->Offset; i < Result->Offset + Size; i++)
+                {
+                    REQUIRE(Writer[i] < 0 || Writer[i] == Frame || Writer[i] + FramesInFlight < Frame);
+                    Writer[i] = Frame;
+                }
+            }
+            Ring.EndFrame();
+        }
+        CHECK(Ring.GetDiscardCount() + 1u == Discards);
+        // The first use plus at most about one rename per heavy frame
+        CHECK(Discards <= 2000u / 97u * 2u + 1u);
+    }
+}
\ No newline at end of file
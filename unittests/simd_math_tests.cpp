@@ -0,0 +1,90 @@
+#include "test_harness.h"
+#include "simd_math.h"
+#include "scene_random.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    constexpr MathPath Paths[] = {MathPath::Native, MathPath::Sse, MathPath::Scalar};
+
+    // Largest difference relative to the entry, or absolute below 1
+    float GetError(const Mat4& a, const Mat4& b)
+    {
+        float Error = 0.0f;
+        for (int r = 0; r < 4; r++)
+        {
+            for (int c = 0; c < 4; c++)
+            {
+                Error = std::max(Error, std::fabs(a.M[r][c] - b.M[r][c]) / std::max(1.0f, std::fabs(b.M[r][c])));
+            }
+        }
+        return Error;
+    }
+}
+
+TEST(simd_math, compose_transforms_match_single_matrices)
+{
+    // Not a multiple of any width, so every path ends with a scalar remainder
+    constexpr size_t Count = 83u;
+    SceneRandom Random(11u);
+    std::vector<float> Streams[10];
+    for (std::vector<float>& s : Streams)
+    {
+        s.resize(Count);
+    }
+    std::vector<Mat4> Expected(Count);
+    for (size_t i = 0; i < Count; i++)
+    {
+        const Vec3 Position = {Random.NextFloat(-100.0f, 100.0f), Random.NextFloat(-100.0f, 100.0f), Random.NextFloat(-100.0f, 100.0f)};
+        const Quat Rotation = Normalize(Quat{Random.NextFloat(-1.0f, 1.0f), Random.NextFloat(-1.0f, 1.0f), Random.NextFloat(-1.0f, 1.0f), Random.NextFloat(-1.0f, 1.0f)});
+        const Vec3 Scale = {Random.NextFloat(0.1f, 10.0f), Random.NextFloat(0.1f, 10.0f), Random.NextFloat(0.1f, 10.0f)};
+        const float Values[10] = {Position.X, Position.Y, Position.Z, Rotation.X, Rotation.Y, Rotation.Z, Rotation.W, Scale.X, Scale.Y, Scale.Z};
+        for (size_t s = 0; s < 10u; s++)
+        {
+            Streams[s][i] = Values[s];
+        }
+        Expected[i] = Mat4::Compose(Position, Rotation, Scale);
+    }
+    const TransformStreams In = {Streams[0].data(), Streams[1].data(), Streams[2].data(), Streams[3].data(), Streams[4].data(),
+        Streams[5].data(), Streams[6].data(), Streams[7].data(), Streams[8].data(), Streams[9].data()};
+
+    for (const MathPath Path : Paths)
+    {
+        std::vector<Mat4> Out(Count);
+        ComposeTransforms(In, Out.data(), Count, Path);
+        float Error = 0.0f;
+        for (size_t i = 0; i < Count; i++)
+        {
+            Error = std::max(Error, GetError(Out[i], Expected[i]));
+        }
+        CHECK(Error < 1e-5f);
+    }
+}
+
+TEST(simd_math, compose_transforms_2d_match_single_matrices)
+{
+    constexpr size_t Count = 83u;
+    SceneRandom Random(12u);
+    std::vector<float> X(Count), Y(Count), Scale(Count), Angle(Count);
+    for (size_t i = 0; i < Count; i++)
+    {
+        X[i] = Random.NextFloat(-100.0f, 100.0f);
+        Y[i] = Random.NextFloat(-100.0f, 100.0f);
+        Scale[i] = Random.NextFloat(0.1f, 10.0f);
+        Angle[i] = Random.NextFloat(-100.0f, 100.0f);
+    }
+
+    for (const MathPath Path : Paths)
+    {
+        std::vector<Mat4> Out(Count);
+        ComposeTransforms2D(X.data(), Y.data(), Scale.data(), Angle.data(), Out.data(), Count, Path);
+        float Error = 0.0f;
+        for (size_t i = 0; i < Count; i++)
+        {
+            Error = std::max(Error, GetError(Out[i], Mat4::Transform2D(X[i], Y[i], Scale[i], Angle[i])));
+        }
+        CHECK(Error < 1e-5f);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#include "test_harness.h"
+#include <iostream>
+
+namespace Tests
+{
+    namespace
+    {
+        unsigned int Failures = 0u;
+    }
+
+    std::vector<TestCase>& GetRegistry()
+    {
+        // Function local so registrations in other files never see it unconstructed
+        static std::vector<TestCase> Registry;
+        return Registry;
+    }
+
+    Registration::Registration(const char* Name, void (*Body)())
+    {
+        GetRegistry().push_back({Name, Body});
+    }
+
+    void ReportFailure(const char* File, int Line, const std::string& Message)
+    {
+        std::cerr << File << "(" << Line << "): " << Message << " failed" << std::endl;
+        Failures++;
+    }
+
+    unsigned int TakeFailures() noexcept
+    {
+        const unsigned int Result = Failures;
+        Failures = 0u;
+        return Result;
+    }
+}
\ No newline at end of file
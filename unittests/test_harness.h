@@ -0,0 +1,73 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Just enough of a test framework for the portable modules. TEST(Suite, Name) defines
+// and registers a test called "Suite.Name". CHECK records a failure and carries on,
+// REQUIRE stops the test. An exception escaping a test fails it as well.
+#define TEST(Suite, Name) \
+    static void Suite##_##Name(); \
+    static const Tests::Registration Suite##_##Name##_Registration(#Suite "." #Name, Suite##_##Name); \
+    static void Suite##_##Name()
+
+#define CHECK(Condition) \
+    do \
+    { \
+        if (!(Condition)) \
+        { \
+            Tests::ReportFailure(__FILE__, __LINE__, "CHECK(" #Condition ")"); \
+        } \
+    } while (false)
+
+#define REQUIRE(Condition) \
+    do \
+    { \
+        if (!(Condition)) \
+        { \
+            Tests::ReportFailure(__FILE__, __LINE__, "REQUIRE(" #Condition ")"); \
+            throw Tests::RequireFailed{}; \
+        } \
+    } while (false)
+
+#define CHECK_THROWS(Expression, Type) \
+    do \
+    { \
+        bool Thrown = false; \
+        try \
+        { \
+            Expression; \
+        } \
+        catch (const Type&) \
+        { \
+            Thrown = true; \
+        } \
+        if (!Thrown) \
+        { \
+            Tests::ReportFailure(__FILE__, __LINE__, "CHECK_THROWS(" #Expression ", " #Type ")"); \
+        } \
+    } while (false)
+
+namespace Tests
+{
+    struct TestCase
+    {
+        std::string Name;
+        void (*Body)();
+    };
+
+    std::vector<TestCase>& GetRegistry();
+
+    struct Registration
+    {
+        Registration(const char* Name, void (*Body)());
+    };
+
+    // Thrown by REQUIRE, only the runner catches it
+    struct RequireFailed
+    {
+    };
+
+    void ReportFailure(const char* File, int Line, const std::string& Message);
+    // Failures reported since the last call
+    unsigned int TakeFailures() noexcept;
+}
\ No newline at end of file
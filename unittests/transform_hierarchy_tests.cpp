@@ -0,0 +1,162 @@
+#include "test_harness.h"
+#include "transform_hierarchy.h"
+#include "job_system.h"
+#include "scene_random.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    TransformHierarchy::Local RandomLocal(SceneRandom& Random)
+    {
+        TransformHierarchy::Local Transform;
+        Transform.Position = {Random.NextFloat(-1.0f, 1.0f), Random.NextFloat(-1.0f, 1.0f), Random.NextFloat(-1.0f, 1.0f)};
+        Transform.Rotation = Normalize(Quat{Random.NextFloat(-1.0f, 1.0f), Random.NextFloat(-1.0f, 1.0f), Random.NextFloat(-1.0f, 1.0f), Random.NextFloat(-1.0f, 1.0f)});
+        Transform.Scale = {Random.NextFloat(0.9f, 1.1f), 1.0f, Random.NextFloat(0.9f, 1.1f)};
+        return Transform;
+    }
+
+    // A forest built in random order: a quarter roots, the rest under any earlier node,
+    // so adds keep landing deeper than the last level
+    struct Forest
+    {
+        TransformHierarchy Hierarchy;
+        std::vector<TransformHierarchy::Node> Nodes;
+        std::vector<uint32_t> ParentOf;
+        std::vector<TransformHierarchy::Local> Locals;
+        SceneRandom Random;
+
+        explicit Forest(size_t Count)
+            : Random(Count)
+        {
+            while (Nodes.size() < Count)
+            {
+                Add(Nodes.empty() || Random.Next() % 4u == 0u ? TransformHierarchy::NoParent : static_cast<uint32_t>(Random.Next() % Nodes.size()));
+            }
+        }
+        void Add(uint32_t Parent)
+        {
+            Locals.push_back(RandomLocal(Random));
+            Nodes.push_back(Hierarchy.Add(Parent == TransformHierarchy::NoParent ? TransformHierarchy::NoParent : Nodes[Parent], Locals.back()));
+            ParentOf.push_back(Parent);
+        }
+        // Every world matrix from the locals alone, parents always come first
+        std::vector<Mat4> GetExpected() const
+        {
+            std::vector<Mat4> Expected(Nodes.size());
+            for (size_t i = 0; i < Nodes.size(); i++)
+            {
+                const Mat4 Own = Mat4::Compose(Locals[i].Position, Locals[i].Rotation, Locals[i].Scale);
+                Expected[i] = ParentOf[i] == TransformHierarchy::NoParent ? Own : Multiply(Own, Expected[ParentOf[i]]);
+            }
+            return Expected;
+        }
+        size_t CountWrongWorlds() const
+        {
+            const std::vector<Mat4> Expected = GetExpected();
+            size_t Wrong = 0u;
+            for (size_t i = 0; i < Nodes.size(); i++)
+            {
+                const Mat4& World = Hierarchy.GetWorld(Nodes[i]);
+                float Error = 0.0f;
+                for (int r = 0; r < 4; r++)
+                {
+                    for (int c = 0; c < 4; c++)
+                    {
+                        Error = std::max(Error, std::fabs(World.M[r][c] - Expected[i].M[r][c]) / std::max(1.0f, std::fabs(Expected[i].M[r][c])));
+                    }
+                }
+                const uint32_t Parent = ParentOf[i] == TransformHierarchy::NoParent ? TransformHierarchy::NoParent : Nodes[ParentOf[i]];
+                Wrong += Error < 1e-4f && Hierarchy.GetParent(Nodes[i]) == Parent ? 0u : 1u;
+            }
+            return Wrong;
+        }
+        // Node i and everything below it
+        std::vector<uint8_t> GetSubtree(size_t Root) const
+        {
+            std::vector<uint8_t> Below(Nodes.size(), 0u);
+            Below[Root] = 1u;
+            for (size_t i = Root + 1u; i < Nodes.size(); i++)
+            {
+                Below[i] = ParentOf[i] != TransformHierarchy::NoParent ? Below[ParentOf[i]] : uint8_t(0u);
+            }
+            return Below;
+        }
+    };
+}
+
+TEST(transform_hierarchy, world_matrices_match_composed_parents)
+{
+    // The root level alone is past the job grain
+    constexpr size_t Count = 5u * TransformHierarchy::Grain;
+    JobSystem Jobs(3u);
+    Forest Serial(Count);
+    Forest Jobbed(Count);
+    Serial.Hierarchy.Update();
+    Jobbed.Hierarchy.Update(&Jobs);
+    CHECK(Serial.Hierarchy.GetNodeCount() == Count);
+    CHECK(Serial.Hierarchy.GetChangedCount() == Count);
+    CHECK(Serial.Hierarchy.GetDepthCount() > 5u);
+    CHECK(Serial.CountWrongWorlds() == 0u);
+    size_t Different = 0u;
+    for (size_t i = 0; i < Count; i++)
+    {
+        const Mat4& a = Serial.Hierarchy.GetWorld(Serial.Nodes[i]);
+        const Mat4& b = Jobbed.Hierarchy.GetWorld(Jobbed.Nodes[i]);
+        Different += std::equal(&a.M[0][0], &a.M[0][0] + 16, &b.M[0][0]) ? 0u : 1u;
+    }
+    CHECK(Different == 0u);
+
+    // Nodes added after an update, deeper than the last level, keep every id valid
+    for (int i = 0; i < 100; i++)
+    {
+        Jobbed.Add(static_cast<uint32_t>(Jobbed.Random.Next() % Jobbed.Nodes.size()));
+    }
+    Jobbed.Hierarchy.Update(&Jobs);
+    CHECK(Jobbed.Hierarchy.GetChangedCount() == 100u);
+    CHECK(Jobbed.CountWrongWorlds() == 0u);
+
+    CHECK_THROWS(Serial.Hierarchy.Add(static_cast<TransformHierarchy::Node>(Count), {}), std::invalid_argument);
+}
+
+TEST(transform_hierarchy, only_dirty_subtrees_are_recomputed)
+{
+    JobSystem Jobs(3u);
+    Forest Test(20000u);
+    Test.Hierarchy.Update(&Jobs);
+    Test.Hierarchy.Update(&Jobs);
+    CHECK(Test.Hierarchy.GetChangedCount() == 0u);
+
+    for (int Round = 0; Round < 20; Round++)
+    {
+        // A few nodes anywhere in the forest, possibly inside each other's subtrees
+        std::vector<uint8_t> Expected(Test.Nodes.size(), 0u);
+        for (int k = 0; k < 1 + Round % 4; k++)
+        {
+            const size_t n = Test.Random.Next() % Test.Nodes.size();
+            Test.Locals[n] = RandomLocal(Test.Random);
+            Test.Hierarchy.SetLocal(Test.Nodes[n], Test.Locals[n]);
+            const std::vector<uint8_t> Below = Test.GetSubtree(n);
+            std::transform(Expected.begin(), Expected.end(), Below.begin(), Expected.begin(), [](uint8_t a, uint8_t b) { return uint8_t(a | b); });
+        }
+        Test.Hierarchy.Update(Round % 2 == 0 ? &Jobs : nullptr);
+
+        size_t Mismatches = 0u;
+        size_t ExpectedCount = 0u;
+        for (size_t i = 0; i < Test.Nodes.size(); i++)
+        {
+            Mismatches += Test.Hierarchy.WasChanged(Test.Nodes[i]) == (Expected[i] != 0u) ? 0u : 1u;
+            ExpectedCount += Expected[i];
+        }
+        CHECK(Mismatches == 0u);
+        CHECK(Test.Hierarchy.GetChangedCount() == ExpectedCount);
+        CHECK(Test.CountWrongWorlds() == 0u);
+    }
+
+    // Reading a node back gives what was set
+    const TransformHierarchy::Local Read = Test.Hierarchy.GetLocal(Test.Nodes[7]);
+    CHECK(Read.Position.X == Test.Locals[7].Position.X && Read.Rotation.W == Test.Locals[7].Rotation.W && Read.Scale.Z == Test.Locals[7].Scale.Z);
+}
\ No newline at end of file